@@ -0,0 +1,63 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BanList.h"
+
+#include "stringUtils.h"
+
+#include "tnlPlatform.h"
+#include "tnlLog.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static const string Current = "|20990101T000000|60";     // Starts in the far future, so is always in force
+
+
+// Admission checks against a ban list that has grown during a flood
+TEST(BanListTest, FloodBenchmark)
+{
+   const S32 Bans = 20000;
+   const S32 Checks = 100000;
+
+   BanList banList("");
+
+   Vector<string> networks;
+   for(S32 i = 0; i < 100; i++)
+      networks.push_back("172." + itos(i) + ".0.0/16|*" + Current);
+   banList.loadBanList(networks);
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   for(S32 i = 0; i < Bans; i++)
+   {
+      Address address;
+      address.netNum[0] = (10 << 24) | i;
+      banList.addToBanList(address, 60);
+   }
+   F64 addMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   S32 banned = 0;
+   start = Platform::getHighPrecisionTimerValue();
+   for(S32 i = 0; i < Checks; i++)
+   {
+      Address address;
+      address.netNum[0] = (i & 1) ? (10 << 24) | (i % Bans) : (12 << 24) | i;
+      if(banList.isBanned(address, "Player", false))
+         banned++;
+   }
+   F64 checkMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   logprintf("BanList benchmark: %d bans added in %g ms; %d checks in %g ms", Bans, addMs, Checks, checkMs);
+
+   EXPECT_EQ(Checks / 2, banned);
+}
+
+
+};
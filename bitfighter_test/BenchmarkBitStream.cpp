@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlBitStream.h"
+#include "tnlPlatform.h"
+#include "tnlLog.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Roughly the fields a Ship and a Projectile put in each update: flags, ranged ids and health, and compressed
+// positions and velocities
+static void writeShipUpdate(BitStream &stream, U32 i)
+{
+   stream.writeFlag(i & 1);
+   stream.writeRangedU32(i % 200, 0, 200);      // Ship id
+   stream.writeFlag(i & 2);
+   stream.writeSignedFloat(((i % 100) - 50) / 50.0f, 12);
+   stream.writeSignedFloat(((i % 80) - 40) / 40.0f, 12);
+   stream.writeInt(i & 0xFFFF, 16);              // Position
+   stream.writeInt((i * 7) & 0xFFFF, 16);
+   stream.writeFloat((i % 64) / 63.0f, 6);       // Health
+   stream.writeFlag(i & 4);
+   stream.writeEnum(i % 9, 9);                   // Active weapon
+   stream.writeFlag(i & 8);
+}
+
+
+static void readShipUpdate(BitStream &stream)
+{
+   stream.readFlag();
+   stream.readRangedU32(0, 200);
+   stream.readFlag();
+   stream.readSignedFloat(12);
+   stream.readSignedFloat(12);
+   stream.readInt(16);
+   stream.readInt(16);
+   stream.readFloat(6);
+   stream.readFlag();
+   stream.readEnum(9);
+   stream.readFlag();
+}
+
+
+static void writeProjectileUpdate(BitStream &stream, U32 i)
+{
+   stream.writeFlag(true);
+   stream.writeEnum(i % 16, 16);                 // Weapon type
+   stream.writeInt(i & 0xFFFF, 16);
+   stream.writeInt((i * 3) & 0xFFFF, 16);
+   stream.writeSignedInt((S32)(i % 1000) - 500, 11);
+   stream.writeSignedInt((S32)(i % 900) - 450, 11);
+   stream.writeFlag(i & 1);
+}
+
+
+static void readProjectileUpdate(BitStream &stream)
+{
+   stream.readFlag();
+   stream.readEnum(16);
+   stream.readInt(16);
+   stream.readInt(16);
+   stream.readSignedInt(11);
+   stream.readSignedInt(11);
+   stream.readFlag();
+}
+
+
+// Fills packet-sized streams with typical update fields and reports how long packing and unpacking take
+TEST(BitStreamTest, UpdatePatternBenchmark)
+{
+   const S32 Packets = 20000;
+   U8 buffer[MaxPacketDataSize];
+
+   U32 bitsWritten = 0;
+   S64 start = Platform::getHighPrecisionTimerValue();
+
+   for(S32 p = 0; p < Packets; p++)
+   {
+      BitStream stream(buffer, MaxPacketDataSize);
+      for(U32 i = 0; stream.getBitPosition() + 200 < MaxPacketDataSize * 8; i++)
+      {
+         writeShipUpdate(stream, p + i);
+         writeProjectileUpdate(stream, p + i);
+      }
+      bitsWritten += stream.getBitPosition();
+   }
+
+   F64 writeMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   start = Platform::getHighPrecisionTimerValue();
+
+   U32 bitsRead = 0;
+   for(S32 p = 0; p < Packets; p++)
+   {
+      BitStream stream(buffer, MaxPacketDataSize);
+      while(stream.getBitPosition() + 200 < MaxPacketDataSize * 8)
+      {
+         readShipUpdate(stream);
+         readProjectileUpdate(stream);
+      }
+      bitsRead += stream.getBitPosition();
+   }
+
+   F64 readMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   logprintf("BitStream benchmark: %d packets, %u bits: write %g ms, read %g ms", Packets, bitsWritten, writeMs, readMs);
+
+   EXPECT_GT(bitsWritten, 0u);
+   EXPECT_GT(bitsRead, 0u);
+}
+
+
+// The same chat line sent to 32 clients, then read back by each of them, timing the Huffman string coder
+TEST(BitStreamTest, ChatBroadcastBenchmark)
+{
+   const S32 Broadcasts = 5000;
+   const S32 Clients = 32;
+   const char *message = "Watusimoto: Somebody grab the flag, their base is wide open!";
+
+   U8 buffer[MaxPacketDataSize];
+   char readBuffer[256];
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   for(S32 i = 0; i < Broadcasts * Clients; i++)
+   {
+      BitStream stream(buffer, MaxPacketDataSize);
+      stream.writeString(message);
+   }
+   F64 writeMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   start = Platform::getHighPrecisionTimerValue();
+   for(S32 i = 0; i < Broadcasts * Clients; i++)
+   {
+      BitStream stream(buffer, MaxPacketDataSize);
+      stream.readString(readBuffer);
+   }
+   F64 readMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   logprintf("Huffman benchmark: %d strings: write %g ms, read %g ms", Broadcasts * Clients, writeMs, readMs);
+
+   EXPECT_STREQ(message, readBuffer);
+}
+
+
+};
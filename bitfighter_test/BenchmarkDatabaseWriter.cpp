@@ -0,0 +1,35 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "DatabaseWriterTestUtils.h"
+
+#include "tnlLog.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+
+// A local load generator for the stats pipeline, writing to sqlite through the worker pool
+TEST_F(DatabaseWriterTest, StatsLoadBenchmark)
+{
+   const S32 Games = 200;
+
+   {
+      DatabaseWriter writer(DatabaseFile);
+   }
+
+   F64 ms = replayGames(Games, 4);
+
+   logprintf("Database benchmark: %d games (%d rows each) in %g ms; %g games/sec", Games,
+             1 + TeamsPerGame * (1 + PlayersPerTeam * (1 + WeaponsPerPlayer + LoadoutsPerPlayer)), ms, Games * 1000 / ms);
+
+   DatabaseWriter writer(DatabaseFile);
+   EXPECT_EQ(Games, countRows(writer, "stats_game"));
+}
+
+
+};
@@ -0,0 +1,51 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlLog.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static const char *LogFileName = "BenchmarkFileLogConsumer.log";
+
+
+// How long the logging thread spends on a burst of verbose logging, and how long until it's all on disk
+TEST(FileLogConsumerTest, BurstBenchmark)
+{
+   const S32 Lines = 20000;
+   F64 logMs, totalMs;
+   U32 dropped;
+
+   {
+      FileLogConsumer log;
+      log.setMsgTypes(LogConsumer::LogNone);
+      log.init(LogFileName, "w");
+
+      S64 start = Platform::getHighPrecisionTimerValue();
+      for(S32 i = 0; i < Lines; i++)
+         log.logprintf("Server filter: client %d at 192.168.0.%d sent a message the filter looked at", i, i % 256);
+      logMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+      log.flush();
+      totalMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+      dropped = log.getDroppedLineCount();
+   }
+
+   logprintf("FileLogConsumer benchmark: %d lines: %g ms on the logging thread, %g ms until on disk (%u dropped)",
+             Lines, logMs, totalMs, dropped);
+
+   remove(LogFileName);
+}
+
+
+};
@@ -0,0 +1,65 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "GridDatabaseTestUtils.h"
+
+#include "tnlPlatform.h"
+#include "tnlLog.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Replays the same recorded query mix against each index type, on a small and a large level, and logs how long each
+// takes.  Compare these numbers when tuning the spatial index.
+TEST(GridDatabaseTest, QueryMixBenchmark)
+{
+   struct LevelSpec { const char *name; S32 objectCount; F32 worldSize; };
+   const LevelSpec levels[] = { { "small", 300, 3000 }, { "large", 5000, 60000 } };
+
+   for(S32 l = 0; l < (S32)ARRAYSIZE(levels); l++)
+   {
+      Vector<RecordedQuery> queries;
+      TestRng queryRng(99);
+      recordQueryMix(queries, queryRng, 20000, levels[l].worldSize);
+
+      for(S32 t = 0; t < IndexTypeCount; t++)
+      {
+         TestRng rng(42);
+         GridDatabase db(IndexTypes[t]);
+         Vector<TestDbObject *> objects;
+
+         populate(db, objects, rng, levels[l].objectCount, levels[l].worldSize);
+         db.setSpatialIndexExtents(db.getExtents());
+
+         Vector<DatabaseObject *> found;
+         S32 totalFound = 0;
+
+         S64 start = Platform::getHighPrecisionTimerValue();
+
+         for(S32 i = 0; i < queries.size(); i++)
+         {
+            found.clear();
+            db.findObjects(queries[i].typeNumber, found, queries[i].extents);
+            totalFound += found.size();
+         }
+
+         F64 ms = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+         logprintf("GridDatabase benchmark: %s level, %s index: %d queries, %d hits, %g ms", levels[l].name,
+                   IndexTypes[t] == SpatialIndex::SparseHashGrid ? "hash grid" : "quadtree", queries.size(), totalFound, ms);
+
+         EXPECT_GT(totalFound, 0);
+      }
+   }
+}
+
+
+
+};
@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelPreloader.h"
+
+#include "Level.h"
+
+#include "LevelFilesForTesting.h"
+
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+#include "tnlNetBase.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Coordinates in current-format levels aren't scaled by the grid size
+static string getHeader()
+{
+   return "LevelFormat 2\n" + getGenericHeader();
+}
+
+
+// A grid of short walls, big enough that loading it takes a while
+static string getLargeLevelCode(S32 gridSize)
+{
+   string code = getHeader();
+
+   for(S32 x = 0; x < gridSize; x++)
+      for(S32 y = 0; y < gridSize; y++)
+      {
+         S32 left = x * 200;
+         S32 top = y * 200;
+         code += "BarrierMaker 20 " + itos(left) + " " + itos(top) + " " + itos(left + 100) + " " + itos(top + 50) + "\n";
+      }
+
+   return code;
+}
+
+
+class LevelPreloaderTest : public testing::Test
+{
+protected:
+   void SetUp()
+   {
+      NetClassRep::initialize();    // Normally done when the game creates its NetInterface, long before any preloading
+   }
+};
+
+
+// How long the game thread spends getting a large level ready, loading it the usual way and claiming it from
+// the preloader after the previous level has been played for a while
+TEST_F(LevelPreloaderTest, LevelSwitchBenchmark)
+{
+   string code = getLargeLevelCode(30);
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   Level *level = new Level();
+   level->loadLevelFromString(code, "");
+   F64 parseMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+   delete level;
+
+   LevelPreloader preloader;
+   ASSERT_TRUE(preloader.start(0, "", code, true, false));
+
+   Platform::sleep(2000);     // Current level being played
+
+   LevelLoadStats stats;
+   start = Platform::getHighPrecisionTimerValue();
+   level = preloader.claim(0, "", code, stats);
+   F64 claimMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   ASSERT_TRUE(level);
+
+   logprintf("LevelPreloader benchmark: parse on game thread %g ms; preloaded: parse %g ms and %d bot zones %g ms "
+             "in background, claim %g ms", parseMs, stats.parseTime, stats.botZoneStats.zoneCount,
+             stats.botZoneStats.getTotalTime(), claimMs);
+
+   delete level;
+}
+
+
+};
@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelSource.h"
+#include "LevelFilesForTesting.h"
+
+#include "stringUtils.h"
+
+#include "tnlNetInterface.h"
+#include "tnlPlatform.h"
+#include "tnlLog.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+
+static const string CacheFile = "BenchmarkLevelSource.cache";
+
+
+static string levelPath(S32 index)
+{
+   return "BenchmarkLevelSource" + itos(index) + ".level";
+}
+
+
+static void writeLevelFiles(const Vector<string> &codes, S32 count, Vector<string> &paths)
+{
+   for(S32 i = 0; i < count; i++)
+   {
+      paths.push_back(levelPath(i));
+      writeFile(paths.last(), codes[i % codes.size()]);
+   }
+}
+
+
+static void removeFiles(const Vector<string> &paths)
+{
+   for(S32 i = 0; i < paths.size(); i++)
+      remove(paths[i].c_str());
+
+   remove(CacheFile.c_str());
+}
+
+
+// Level info for a big level folder, first with no cache, then with a warm one
+TEST(TestLevelSource, LevelInfoCacheBenchmark)
+{
+   Address addr;
+   NetInterface net(addr);
+
+   const S32 Levels = 1500;
+
+   pair<Vector<string>, Vector<LevelInfo> > levels = getLevels();
+   Vector<string> paths;
+   writeLevelFiles(levels.first, Levels, paths);
+   remove(CacheFile.c_str());
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   {
+      LevelInfoCache cache(CacheFile);
+      cache.load();
+      EXPECT_EQ(Levels, cache.refresh(paths, 4));
+      cache.save();
+   }
+   F64 coldMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   start = Platform::getHighPrecisionTimerValue();
+   {
+      LevelInfoCache cache(CacheFile);
+      cache.load();
+      EXPECT_EQ(0, cache.refresh(paths, 4));
+   }
+   F64 warmMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   logprintf("LevelInfoCache benchmark: %d levels: %g ms cold, %g ms warm", Levels, coldMs, warmMs);
+
+   removeFiles(paths);
+}
+
+
+};
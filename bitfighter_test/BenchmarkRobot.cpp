@@ -0,0 +1,61 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "TestUtils.h"
+#include "LevelFilesForTesting.h"
+
+#include "../zap/ServerGame.h"
+#include "../zap/EventManager.h"
+#include "../zap/stringUtils.h"
+
+#include "tnlLog.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace std;
+using namespace TNL;
+
+
+// Reports per-tick script time for a level full of bots, first with every bot in the shared Lua VM, then with each
+// bot in its own VM and onTick spread over worker threads
+TEST(RobotTest, ScriptTickBenchmark)
+{
+   const S32 BotCount = 16;
+   const U32 ScriptThreads[] = { 0, 3 };
+
+   for(U32 i = 0; i < ARRAYSIZE(ScriptThreads); i++)
+   {
+      GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+      settings->setSetting(IniKey::AddRobots, No);
+      settings->setSetting(IniKey::RobotScriptThreads, ScriptThreads[i]);
+
+      GamePair gamePair(settings, getLevelCode1());
+
+      for(S32 j = 0; j < BotCount; j++)
+         gamePair.addBotClient("Bot" + itos(j), 0);
+
+      gamePair.server->unsuspendGame(false);    // No humans here, but we want the bots to play anyway
+      gamePair.idle(10, 20);     // Let the bots spawn and settle in
+      EventManager::get()->resetTickStats();
+
+      gamePair.idle(10, 330);    // Bots tick every 33ms
+
+      const EventManager::TickStats &stats = EventManager::get()->getTickStats();
+      ASSERT_GT(stats.ticks, 0u);
+
+      logprintf("Robot tick benchmark: %d bots, %d script threads: %d ticks, %g ms per tick", BotCount, 
+                EventManager::get()->getScriptThreadCount(), stats.ticks, stats.scriptTime / stats.ticks);
+
+      EXPECT_EQ(ScriptThreads[i], EventManager::get()->getScriptThreadCount());
+      EXPECT_EQ(BotCount, gamePair.server->getRobotCount());
+      EXPECT_EQ(BotCount * stats.ticks, stats.handlers);      // No bot was shut down by a script error
+   }
+}
+
+
+};
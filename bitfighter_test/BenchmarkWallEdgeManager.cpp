@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "WallEdgeManager.h"
+
+#include "Level.h"
+#include "WallItem.h"
+
+#include "LevelFilesForTesting.h"
+
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+#include "tnlNetBase.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Coordinates in current-format levels aren't scaled by the grid size
+static string getHeader()
+{
+   return "LevelFormat 2\n" + getGenericHeader();
+}
+
+
+// A grid of short walls, with a turret on each
+static string getLargeLevelCode(S32 gridSize)
+{
+   string code = getHeader();
+
+   for(S32 x = 0; x < gridSize; x++)
+      for(S32 y = 0; y < gridSize; y++)
+      {
+         S32 left = x * 200;
+         S32 top = y * 200;
+         code += "BarrierMaker 20 " + itos(left) + " " + itos(top) + " " + itos(left + 100) + " " + itos(top + 50) + "\n";
+         code += "Turret 0 " + itos(left + 50) + " " + itos(top + 30) + "\n";
+      }
+
+   return code;
+}
+
+
+static WallItem *getWall(Level *level, S32 index)
+{
+   return static_cast<WallItem *>(level->findObjects_fast(WallItemTypeNumber)->get(index));
+}
+
+
+class WallEdgeManagerTest : public testing::Test
+{
+protected:
+   void SetUp()
+   {
+      NetClassRep::initialize();    // Normally done when the game creates its NetInterface
+   }
+};
+
+
+// How long it takes to bring a big level's edges up to date after moving one wall vertex, rebuilding everything
+// and updating just what has changed
+TEST_F(WallEdgeManagerTest, MoveVertexBenchmark)
+{
+   const S32 Moves = 20;
+
+   Level level(getLargeLevelCode(40));
+   WallItem *wall = getWall(&level, 0);
+   Vector<Point> wallEdgePoints;
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   for(S32 i = 0; i < Moves; i++)
+   {
+      wall->setVert(Point(100, 50 + (F32)(i % 2) * 20), 1);
+      wall->onGeomChanged();
+
+      level.buildWallEdgeGeometry(wallEdgePoints);
+      level.snapAllEngineeredItems(false);
+   }
+   F64 rebuildMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   start = Platform::getHighPrecisionTimerValue();
+   for(S32 i = 0; i < Moves; i++)
+   {
+      wall->setVert(Point(100, 50 + (F32)(i % 2) * 20), 1);
+      wall->onGeomChanged();
+
+      level.updateWallEdgeGeometry(wallEdgePoints);
+   }
+   F64 updateMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   logprintf("WallEdgeManager benchmark: %d walls, %d edges; full rebuild %g ms per move, incremental update %g ms per move",
+             level.findObjects_fast(WallItemTypeNumber)->size(), wallEdgePoints.size() / 2, rebuildMs / Moves, updateMs / Moves);
+}
+
+
+};
@@ -0,0 +1,155 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _DATABASE_WRITER_TEST_UTILS_H_
+#define _DATABASE_WRITER_TEST_UTILS_H_
+
+// Stats and a database fixture shared by the DatabaseWriter tests and benchmark
+
+#include "../master/database.h"
+
+#include "stringUtils.h"
+
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace Zap
+{
+
+using namespace DbWriter;
+using namespace Master;
+
+
+static const char *DatabaseFile = "TestDatabaseWriter.db";
+
+static const S32 TeamsPerGame = 2;
+static const S32 PlayersPerTeam = 4;
+static const S32 WeaponsPerPlayer = 3;
+static const S32 LoadoutsPerPlayer = 2;
+
+
+// Synthetic end-of-game stats, shaped like what a busy server reports
+static GameStats makeGameStats(S32 gameIndex)
+{
+   GameStats stats;
+   stats.serverName = "Load test server " + itos(gameIndex % 5);
+   stats.serverIP = "10.0.0." + itos(gameIndex % 5);
+   stats.gameType = "CTF";
+   stats.levelName = "Level " + itos(gameIndex) + " with an 'apostrophe'";
+   stats.isOfficial = true;
+   stats.isTeamGame = true;
+   stats.playerCount = TeamsPerGame * PlayersPerTeam;
+   stats.duration = 600;
+
+   for(S32 t = 0; t < TeamsPerGame; t++)
+   {
+      TeamStats team;
+      team.name = "Team " + itos(t);
+      team.hexColor = "ff0000";
+      team.score = t;
+      team.gameResult = t == 0 ? 'L' : 'W';
+
+      for(S32 p = 0; p < PlayersPerTeam; p++)
+      {
+         PlayerStats player;
+         player.name = "Player " + itos(gameIndex) + "-" + itos(t) + "-" + itos(p);
+         player.gameResult = team.gameResult;
+         player.points = p;
+         player.kills = p * 2;
+
+         for(S32 w = 0; w < WeaponsPerPlayer; w++)
+         {
+            WeaponStats weapon;
+            weapon.weaponType = WeaponType(w);
+            weapon.shots = 10 + w;
+            weapon.hits = w;
+            weapon.hitBy = 0;
+            player.weaponStats.push_back(weapon);
+         }
+
+         for(S32 l = 0; l < LoadoutsPerPlayer; l++)
+         {
+            LoadoutStats loadout;
+            loadout.loadoutHash = l;
+            player.loadoutStats.push_back(loadout);
+         }
+
+         team.playerStats.push_back(player);
+      }
+
+      stats.teamStats.push_back(team);
+   }
+
+   return stats;
+}
+
+
+static S32 countRows(DatabaseWriter &writer, const string &table)
+{
+   Vector<Vector<string> > results;
+   writer.selectHandler("SELECT count(*) FROM " + table + ";", 1, results);
+
+   return results.size() == 1 ? atoi(results[0][0].c_str()) : -1;
+}
+
+
+// Replays stats through the database worker pool, the way the master does
+class InsertStatsEntry : public ThreadEntry
+{
+public:
+   GameStats mStats;
+
+   void run()
+   {
+      DatabaseWriter writer(DatabaseFile);
+      writer.insertStats(mStats);
+   }
+};
+
+
+class DatabaseWriterTest : public testing::Test
+{
+protected:
+   void SetUp()
+   {
+      DatabaseWriter::closeThreadConnection();
+      DatabaseWriter::clearServerCache();    // Server ids from the last test's database are no good in this one
+      remove(DatabaseFile);
+   }
+
+   void TearDown()
+   {
+      DatabaseWriter::closeThreadConnection();
+      remove(DatabaseFile);
+   }
+
+   // Returns elapsed time in ms
+   F64 replayGames(S32 games, U32 threads)
+   {
+      DatabaseWriterThread pool(threads);
+
+      S64 start = Platform::getHighPrecisionTimerValue();
+
+      for(S32 i = 0; i < games; i++)
+      {
+         RefPtr<InsertStatsEntry> entry = new InsertStatsEntry();
+         entry->mStats = makeGameStats(i);
+         pool.addEntry(entry);
+      }
+
+      pool.terminate();    // Waits for the queue to drain
+
+      return Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+   }
+};
+
+
+};
+
+#endif
@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _GRID_DATABASE_TEST_UTILS_H_
+#define _GRID_DATABASE_TEST_UTILS_H_
+
+// Objects and query mixes shared by the GridDatabase tests and benchmark
+
+#include "gridDB.h"
+#include "BfObject.h"      // For type numbers
+
+#include "tnlVector.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Minimal object we can put into a database
+class TestDbObject : public DatabaseObject
+{
+public:
+   TestDbObject(U8 typeNumber, const Rect &extents)
+   {
+      mObjectTypeNumber = typeNumber;
+      setExtent(extents);
+   }
+};
+
+
+// Simple deterministic generator, so failures and benchmark runs are repeatable
+class TestRng
+{
+   U32 mState;
+
+public:
+   TestRng(U32 seed) { mState = seed; }
+
+   U32 next()         { mState = mState * 1664525u + 1013904223u; return mState >> 8; }
+   F32 nextF(F32 max) { return F32(next() % 1000000) / 1000000.0f * max; }
+};
+
+
+static Rect randomRect(TestRng &rng, F32 worldSize, F32 maxObjSize)
+{
+   Point p(rng.nextF(worldSize) - worldSize / 2, rng.nextF(worldSize) - worldSize / 2);
+   return Rect(p, p + Point(rng.nextF(maxObjSize) + 1, rng.nextF(maxObjSize) + 1));
+}
+
+
+static const U8 TestTypes[] = { PlayerShipTypeNumber, BulletTypeNumber, AsteroidTypeNumber, BarrierTypeNumber };
+static const S32 TestTypeCount = (S32)ARRAYSIZE(TestTypes);
+
+
+// One query, as a game would issue it
+struct RecordedQuery
+{
+   Rect extents;
+   U8 typeNumber;
+};
+
+
+// Build a level's worth of objects -- mostly small, with a sprinkling of huge ones like big walls or zones
+static void populate(GridDatabase &db, Vector<TestDbObject *> &objects, TestRng &rng, S32 count, F32 worldSize)
+{
+   for(S32 i = 0; i < count; i++)
+   {
+      F32 maxSize = (i % 50 == 0) ? worldSize / 4 : 100;
+      TestDbObject *obj = new TestDbObject(TestTypes[i % TestTypeCount], randomRect(rng, worldSize, maxSize));
+      db.addToDatabase(obj);
+      objects.push_back(obj);
+   }
+}
+
+
+// A mix of ship-sized scoping queries, short rays, and the occasional whole-screen query
+static void recordQueryMix(Vector<RecordedQuery> &queries, TestRng &rng, S32 count, F32 worldSize)
+{
+   for(S32 i = 0; i < count; i++)
+   {
+      RecordedQuery query;
+      F32 size = (i % 10 == 0) ? 1600 : (i % 3 == 0) ? 400 : 50;
+      query.extents = randomRect(rng, worldSize, size);
+      query.typeNumber = TestTypes[i % TestTypeCount];
+      queries.push_back(query);
+   }
+}
+
+
+static const SpatialIndex::IndexType IndexTypes[] = { SpatialIndex::SparseHashGrid, SpatialIndex::LooseQuadtree };
+static const S32 IndexTypeCount = (S32)ARRAYSIZE(IndexTypes);
+
+};
+
+#endif
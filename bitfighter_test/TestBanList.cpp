@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BanList.h"
+
+#include "stringUtils.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static const string Current = "|20990101T000000|60";     // Starts in the far future, so is always in force
+static const string Expired = "|20000101T000000|60";
+
+
+static bool isBanned(BanList &banList, const char *address, const string &nickname, bool isAuthenticated = false)
+{
+   return banList.isBanned(Address(address), nickname, isAuthenticated);
+}
+
+
+TEST(BanListTest, AddressNetworkAndNicknameBans)
+{
+   Vector<string> lines;
+   lines.push_back("10.0.0.5|*" + Current);
+   lines.push_back("192.168.0.0/16|*" + Current);
+   lines.push_back("*|Griefer" + Current);
+   lines.push_back("172.16.0.9|*NonAuthenticated" + Current);
+   lines.push_back("172.17.0.9|Spammer" + Current);
+
+   BanList banList("");
+   banList.loadBanList(lines);
+
+   EXPECT_TRUE (isBanned(banList, "10.0.0.5", "anyone"));
+   EXPECT_FALSE(isBanned(banList, "10.0.0.6", "anyone"));
+
+   EXPECT_TRUE (isBanned(banList, "192.168.0.1", "anyone"));
+   EXPECT_TRUE (isBanned(banList, "192.168.255.255", "anyone"));
+   EXPECT_FALSE(isBanned(banList, "192.169.0.1", "anyone"));
+
+   EXPECT_TRUE (isBanned(banList, "1.2.3.4", "Griefer"));
+   EXPECT_FALSE(isBanned(banList, "1.2.3.4", "griefer"));       // Names are case sensitive
+
+   EXPECT_TRUE (isBanned(banList, "172.16.0.9", "anyone", false));
+   EXPECT_FALSE(isBanned(banList, "172.16.0.9", "anyone", true));
+
+   EXPECT_TRUE (isBanned(banList, "172.17.0.9", "Spammer"));
+   EXPECT_FALSE(isBanned(banList, "172.17.0.9", "SomeoneElse"));
+   EXPECT_FALSE(isBanned(banList, "1.2.3.4", "Spammer"));
+
+   // Bans are written out just as they were read
+   Vector<string> written = banList.banListToString();
+   ASSERT_EQ(lines.size(), written.size());
+   for(S32 i = 0; i < lines.size(); i++)
+      EXPECT_EQ(lines[i], written[i]);
+}
+
+
+TEST(BanListTest, MalformedLinesAreRejected)
+{
+   Vector<string> lines;
+   lines.push_back("10.0.0.0/33|*" + Current);
+   lines.push_back("10.0.0.0/|*" + Current);
+   lines.push_back("10.0.0.0/x|*" + Current);
+   lines.push_back("not an address|*" + Current);
+   lines.push_back("10.0.0.1|*|notadate|60");
+   lines.push_back("10.0.0.1|*|20990101T000000|0");
+   lines.push_back("10.0.0.1|*");
+
+   BanList banList("");
+   banList.loadBanList(lines);
+
+   EXPECT_EQ(0, banList.banListToString().size());
+   EXPECT_FALSE(isBanned(banList, "10.0.0.1", "anyone"));
+}
+
+
+TEST(BanListTest, ExpiredBansDontApply)
+{
+   Vector<string> lines;
+   lines.push_back("10.0.0.5|*" + Expired);
+   lines.push_back("*|Griefer" + Expired);
+
+   BanList banList("");
+   banList.loadBanList(lines);
+
+   EXPECT_FALSE(isBanned(banList, "10.0.0.5", "anyone"));
+   EXPECT_FALSE(isBanned(banList, "1.2.3.4", "Griefer"));
+
+   banList.updateKickList(100);
+   EXPECT_EQ(2, banList.banListToString().size());     // Still written out, as before
+}
+
+
+TEST(BanListTest, NewBansApplyImmediately)
+{
+   BanList banList("");
+
+   banList.addToBanList(Address("10.0.0.5"), 10);
+   banList.addToBanList(Address("10.0.0.6"), 10, true);
+   banList.addPlayerNameToBanList("Griefer", 10);
+
+   EXPECT_TRUE (isBanned(banList, "10.0.0.5", "anyone", true));
+   EXPECT_TRUE (isBanned(banList, "10.0.0.6", "anyone", false));
+   EXPECT_FALSE(isBanned(banList, "10.0.0.6", "anyone", true));
+   EXPECT_TRUE (isBanned(banList, "1.2.3.4", "Griefer"));
+
+   // Reloading what we wrote gives the same bans
+   BanList reloaded("");
+   reloaded.loadBanList(banList.banListToString());
+   EXPECT_EQ(3, reloaded.banListToString().size());
+   EXPECT_TRUE(isBanned(reloaded, "10.0.0.5", "anyone", true));
+}
+
+
+TEST(BanListTest, KicksExpire)
+{
+   BanList banList("");
+   U32 duration = banList.getKickDuration();
+
+   banList.kickHost(Address("10.0.0.5"));
+   EXPECT_TRUE (banList.isAddressKicked(Address("10.0.0.5")));
+   EXPECT_FALSE(banList.isAddressKicked(Address("10.0.0.6")));
+
+   banList.updateKickList(duration / 2);
+   banList.kickHost(Address("10.0.0.6"));
+
+   banList.updateKickList(duration / 2);
+   EXPECT_TRUE(banList.isAddressKicked(Address("10.0.0.5")));       // Right at the end, but not past it
+
+   banList.updateKickList(1);
+   EXPECT_FALSE(banList.isAddressKicked(Address("10.0.0.5")));
+   EXPECT_TRUE (banList.isAddressKicked(Address("10.0.0.6")));
+
+   // Kicking again starts the clock over
+   banList.kickHost(Address("10.0.0.6"));
+   banList.updateKickList(duration / 2 + 10);
+   EXPECT_TRUE (banList.isAddressKicked(Address("10.0.0.6")));
+
+   banList.updateKickList(duration);
+   EXPECT_FALSE(banList.isAddressKicked(Address("10.0.0.6")));
+}
+
+
+};
@@ -0,0 +1,208 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlBitStream.h"
+#include "tnlPlatform.h"
+#include "tnlLog.h"
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Small LCG so every run writes the same fields
+static U32 nextRandom(U32 &seed)
+{
+   seed = seed * 1664525 + 1013904223;
+   return seed;
+}
+
+
+static U32 maskToBits(U32 value, U32 bitCount)
+{
+   return bitCount == 32 ? value : value & ((1 << bitCount) - 1);
+}
+
+
+// writeInt() must produce exactly what the byte-at-a-time writeBits() produces, including when fields run
+// into the last few bytes of the buffer where the word-at-a-time path can't be used
+TEST(BitStreamTest, WriteIntMatchesWriteBits)
+{
+   const U32 BufferSize = 64;
+   U8 fastBuffer[BufferSize];
+   U8 referenceBuffer[BufferSize];
+
+   U32 seed = 12345;
+
+   for(S32 pass = 0; pass < 200; pass++)
+   {
+      memset(fastBuffer, 0xA5, BufferSize);     // Bits past the end of the stream must be left alone
+      memset(referenceBuffer, 0xA5, BufferSize);
+
+      BitStream fast(fastBuffer, BufferSize);
+      BitStream reference(referenceBuffer, BufferSize);
+
+      while(true)
+      {
+         U32 bitCount = nextRandom(seed) % 33;
+         if(fast.getBitPosition() + bitCount > BufferSize * 8)
+            break;
+
+         U32 value = nextRandom(seed);    // High bits beyond bitCount must be ignored
+         fast.writeInt(value, bitCount);
+
+         U32 littleEndianValue = convertHostToLEndian(value);
+         reference.writeBits(bitCount, &littleEndianValue);
+
+         ASSERT_EQ(reference.getBitPosition(), fast.getBitPosition());
+      }
+
+      ASSERT_EQ(0, memcmp(fastBuffer, referenceBuffer, BufferSize)) << "Pass " << pass;
+   }
+}
+
+
+TEST(BitStreamTest, ReadIntMatchesWrittenValues)
+{
+   const U32 BufferSize = 64;
+   U8 buffer[BufferSize];
+
+   Vector<U32> values;
+   Vector<U32> bitCounts;
+
+   U32 seed = 54321;
+
+   BitStream writer(buffer, BufferSize);
+   while(true)
+   {
+      U32 bitCount = nextRandom(seed) % 33;
+      if(writer.getBitPosition() + bitCount > BufferSize * 8)
+         break;
+
+      U32 value = nextRandom(seed);
+      writer.writeInt(value, bitCount);
+
+      values.push_back(maskToBits(value, bitCount));
+      bitCounts.push_back(bitCount);
+   }
+
+   BitStream reader(buffer, BufferSize);
+   for(S32 i = 0; i < values.size(); i++)
+      ASSERT_EQ(values[i], reader.readInt(bitCounts[i])) << "Field " << i << " of " << bitCounts[i] << " bits";
+
+   EXPECT_TRUE(reader.isValid());
+   EXPECT_EQ(writer.getBitPosition(), reader.getBitPosition());
+
+   // Reading past the end is still caught
+   reader.setBitPosition(BufferSize * 8 - 4);
+   reader.readInt(8);
+   EXPECT_FALSE(reader.isValid());
+}
+
+
+// A stream that must grow still goes through the resizing path
+TEST(BitStreamTest, WriteIntGrowsStream)
+{
+   BitStream stream;
+
+   for(U32 i = 0; i < 4000; i++)
+      stream.writeInt(i, 13);
+
+   ASSERT_TRUE(stream.isValid());
+
+   stream.setBitPosition(0);
+   for(U32 i = 0; i < 4000; i++)
+      ASSERT_EQ(i & 0x1FFF, stream.readInt(13));
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Encodings written by the original bit-at-a-time Huffman coder; the wire format must not change
+TEST(BitStreamTest, WriteStringMatchesOriginalEncoding)
+{
+   const char *compressed = "ChrisEykamp has been terminated by a turret";
+   const U8 compressedBytes[] = { 0xAE, 0xAC, 0x36, 0x1B, 0xB7, 0x78, 0x65, 0x92, 0xA8, 0xBE, 0x39, 0xDB, 0xED, 0xFE,
+                                  0xE9, 0xE0, 0x0D, 0x31, 0x25, 0x7C, 0xB8, 0x5D, 0xE5, 0xF2, 0xC0, 0x9B, 0x3D, 0x00 };
+
+   const char *uncompressed = "~{|}\x01\x02\x7f";    // Rare characters are sent as plain bytes
+   const U8 uncompressedBytes[] = { 0x1C, 0xF8, 0xED, 0xF1, 0xF5, 0x05, 0x08, 0xFC, 0x01 };
+
+   const char *shortString = "Hello, world!";
+   const U8 shortStringBytes[] = { 0x36, 0x38, 0xFD, 0x31, 0x34, 0xDA, 0x57, 0xA8, 0x8D, 0x50, 0x05 };
+
+   const char *strings[]  = { compressed, uncompressed, shortString };
+   const U8 *expected[]   = { compressedBytes, uncompressedBytes, shortStringBytes };
+   const U32 bitCounts[]  = { 218, 66, 85 };
+
+   for(U32 i = 0; i < ARRAYSIZE(strings); i++)
+   {
+      // Twice each, so the second write comes from the encoding cache
+      for(S32 pass = 0; pass < 2; pass++)
+      {
+         U8 buffer[64];
+         memset(buffer, 0, sizeof(buffer));
+
+         BitStream stream(buffer, sizeof(buffer));
+         stream.writeString(strings[i]);
+
+         ASSERT_EQ(bitCounts[i], stream.getBitPosition()) << strings[i];
+         EXPECT_EQ(0, memcmp(expected[i], buffer, stream.getBytePosition())) << strings[i];
+      }
+   }
+}
+
+
+TEST(BitStreamTest, ReadStringRoundTrip)
+{
+   Vector<std::string> strings;
+   strings.push_back("");
+   strings.push_back("a");
+   strings.push_back("Player has joined the game.");
+   strings.push_back("Player has joined the game!");      // Shares a prefix with the previous string
+   strings.push_back(std::string(255, 'x'));
+
+   std::string everyCharacter;
+   for(S32 c = 1; c < 256; c++)
+      everyCharacter += char(c);
+   strings.push_back(everyCharacter);
+
+   U32 seed = 999;
+   for(S32 i = 0; i < 200; i++)
+   {
+      std::string s;
+      U32 len = nextRandom(seed) % 120;
+      for(U32 j = 0; j < len; j++)
+         s += char(' ' + (nextRandom(seed) >> 8) % 95);
+      strings.push_back(s);
+   }
+
+   BitStream writer;
+   for(S32 i = 0; i < strings.size(); i++)
+   {
+      writer.writeString(strings[i].c_str());
+      writer.writeInt(i, 9);                  // Keep the following fields at odd bit offsets
+   }
+
+   BitStream reader(writer.getBuffer(), writer.getBytePosition());
+   char buffer[256];
+   for(S32 i = 0; i < strings.size(); i++)
+   {
+      reader.readString(buffer);
+      ASSERT_STREQ(strings[i].c_str(), buffer) << "String " << i;
+      ASSERT_EQ(U32(i), reader.readInt(9));
+   }
+
+   EXPECT_TRUE(reader.isValid());
+}
+
+
+};
@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "BotNavMeshZone.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Builds zones as 100x100 squares at the specified grid positions; links are added separately
+static void makeZones(const Point *cells, S32 count, Vector<BotNavMeshZone *> &zones)
+{
+   for(S32 i = 0; i < count; i++)
+   {
+      BotNavMeshZone *zone = new BotNavMeshZone(i);
+      Point corner = cells[i] * 100;
+      zone->setExtent(Rect(corner, corner + Point(100, 100)));
+      zones.push_back(zone);
+   }
+}
+
+
+// One-way link from zone "from" to zone "to"
+static void linkZones(Vector<BotNavMeshZone *> &zones, S32 from, S32 to)
+{
+   NeighboringZone neighbor;
+   neighbor.zoneID = to;
+   neighbor.center = zones[to]->getCenter();
+   neighbor.borderCenter = (zones[from]->getCenter() + zones[to]->getCenter()) * 0.5f;
+   neighbor.distTo = zones[from]->getCenter().distanceTo(zones[to]->getCenter());
+
+   zones[from]->mNeighbors.push_back(neighbor);
+}
+
+
+static void linkZonesBothWays(Vector<BotNavMeshZone *> &zones, S32 a, S32 b)
+{
+   linkZones(zones, a, b);
+   linkZones(zones, b, a);
+}
+
+
+static void deleteZones(Vector<BotNavMeshZone *> &zones)
+{
+   for(S32 i = 0; i < zones.size(); i++)
+      delete zones[i];
+   zones.clear();
+}
+
+
+// Every route in a tree-shaped mesh is unique, so the table and AStar must agree exactly
+TEST(BotNavMeshZoneTest, NextHopTableMatchesAStar)
+{
+   //  0 - 1 - 2 - 3
+   //      |       |
+   //      4       5 -> 6   (6 is a one-way drop; nothing leads back out)
+   const Point cells[] = { Point(0,0), Point(1,0), Point(2,0), Point(3,0), Point(1,1), Point(3,1), Point(4,1) };
+
+   Vector<BotNavMeshZone *> zones;
+   makeZones(cells, (S32)ARRAYSIZE(cells), zones);
+
+   linkZonesBothWays(zones, 0, 1);
+   linkZonesBothWays(zones, 1, 2);
+   linkZonesBothWays(zones, 2, 3);
+   linkZonesBothWays(zones, 1, 4);
+   linkZonesBothWays(zones, 3, 5);
+   linkZones(zones, 5, 6);
+
+   ZoneNextHopTable table;
+   table.build(zones);
+   ASSERT_TRUE(table.isValid());
+
+   Point target(12, 34);
+
+   for(S32 from = 0; from < zones.size(); from++)
+      for(S32 to = 0; to < zones.size(); to++)
+      {
+         Vector<Point> searched = AStar::findPath(&zones, from, to, target);
+         Vector<Point> looked   = table.findPath(&zones, from, to, target);
+
+         ASSERT_EQ(searched.size(), looked.size()) << "From " << from << " to " << to;
+         for(S32 i = 0; i < searched.size(); i++)
+            EXPECT_EQ(searched[i], looked[i]) << "From " << from << " to " << to << ", point " << i;
+      }
+
+   // Nothing leads out of 6
+   EXPECT_EQ(0, table.findPath(&zones, 6, 0, target).size());
+   EXPECT_NE(0, table.findPath(&zones, 0, 6, target).size());
+
+   deleteZones(zones);
+}
+
+
+TEST(BotNavMeshZoneTest, NextHopTableSkipsLargeMeshes)
+{
+   Vector<Point> cells;
+   for(S32 i = 0; i <= ZoneNextHopTable::MaxZones; i++)
+      cells.push_back(Point(i, 0));
+
+   Vector<BotNavMeshZone *> zones;
+   makeZones(cells.address(), cells.size(), zones);
+
+   ZoneNextHopTable table;
+   table.build(zones);
+   EXPECT_FALSE(table.isValid());
+
+   deleteZones(zones);
+}
+
+
+TEST(BotNavMeshZoneTest, FlightPlanCacheEvictsLeastRecentlyUsed)
+{
+   const S32 capacity = 4;
+   FlightPlanCache cache(capacity);
+
+   Vector<Point> path;
+   for(S32 i = 0; i < capacity; i++)
+   {
+      path.clear();
+      path.push_back(Point(i, i));
+      cache.insert(i, i + 1, path);
+   }
+
+   EXPECT_EQ(capacity, cache.getSize());
+
+   // Touch the oldest plan, so the next insert pushes out plan 1 instead
+   ASSERT_TRUE(cache.find(0, 1, path));
+   EXPECT_EQ(Point(0, 0), path[0]);
+
+   path.clear();
+   path.push_back(Point(99, 99));
+   cache.insert(50, 51, path);
+
+   EXPECT_EQ(capacity, cache.getSize());
+   EXPECT_TRUE (cache.find(0, 1, path));
+   EXPECT_FALSE(cache.find(1, 2, path));
+   EXPECT_TRUE (cache.find(2, 3, path));
+   EXPECT_TRUE (cache.find(3, 4, path));
+   EXPECT_TRUE (cache.find(50, 51, path));
+   EXPECT_EQ(Point(99, 99), path[0]);
+
+   // Keys are directional
+   EXPECT_FALSE(cache.find(51, 50, path));
+
+   // Reinserting an existing plan replaces it without growing the cache
+   path.clear();
+   path.push_back(Point(7, 7));
+   cache.insert(2, 3, path);
+   EXPECT_EQ(capacity, cache.getSize());
+   ASSERT_TRUE(cache.find(2, 3, path));
+   EXPECT_EQ(Point(7, 7), path[0]);
+
+   cache.clear();
+   EXPECT_EQ(0, cache.getSize());
+   EXPECT_FALSE(cache.find(0, 1, path));
+}
+
+
+};
@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "DatabaseWriterTestUtils.h"
+
+#include "stringUtils.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace Zap
+{
+
+
+TEST_F(DatabaseWriterTest, InsertStatsWritesEveryRow)
+{
+   DatabaseWriter writer(DatabaseFile);
+
+   const S32 Games = 3;
+   for(S32 i = 0; i < Games; i++)
+      writer.insertStats(makeGameStats(i));
+
+   EXPECT_EQ(Games, countRows(writer, "stats_game"));
+   EXPECT_EQ(Games, countRows(writer, "server"));
+   EXPECT_EQ(Games * TeamsPerGame, countRows(writer, "stats_team"));
+   EXPECT_EQ(Games * TeamsPerGame * PlayersPerTeam, countRows(writer, "stats_player"));
+   EXPECT_EQ(Games * TeamsPerGame * PlayersPerTeam * WeaponsPerPlayer, countRows(writer, "stats_player_shots"));
+   EXPECT_EQ(Games * TeamsPerGame * PlayersPerTeam * LoadoutsPerPlayer, countRows(writer, "stats_player_loadout"));
+
+   // Bound values go in exactly as they are, quotes and all
+   Vector<Vector<string> > results;
+   writer.selectHandler("SELECT level_name FROM stats_game WHERE stats_game_id = 1;", 1, results);
+   ASSERT_EQ(1, results.size());
+   EXPECT_EQ("Level 0 with an 'apostrophe'", results[0][0]);
+}
+
+
+TEST_F(DatabaseWriterTest, WorkerPoolRunsEveryEntry)
+{
+   const S32 Games = 20;
+
+   {
+      DatabaseWriter writer(DatabaseFile);    // Creates the database
+   }
+
+   replayGames(Games, 4);
+
+   DatabaseWriter writer(DatabaseFile);
+   EXPECT_EQ(Games, countRows(writer, "stats_game"));
+   EXPECT_EQ(5, countRows(writer, "server"));      // Servers are shared between games, and never duplicated
+   EXPECT_EQ(Games * TeamsPerGame * PlayersPerTeam, countRows(writer, "stats_player"));
+}
+
+
+TEST_F(DatabaseWriterTest, MySqlTemplateNumbersEachPlaceholder)
+{
+   EXPECT_EQ("INSERT INTO t(a, b, c) VALUES(%0q, %1q, %2q);", 
+             DbStatement::getMySqlTemplate("INSERT INTO t(a, b, c) VALUES(?, ?, ?);"));
+   EXPECT_EQ("SELECT 1;", DbStatement::getMySqlTemplate("SELECT 1;"));
+}
+
+
+#ifdef BF_WRITE_TO_MYSQL
+// Needs a MySQL database with master/schema/bitfighter.innoDB.sql loaded into it; set BF_TEST_MYSQL to
+// "database,server,user,password" to run it.  Rows already in the database are left alone.
+TEST_F(DatabaseWriterTest, InsertStatsWritesEveryRowToMySql)
+{
+   const char *connection = getenv("BF_TEST_MYSQL");
+
+   if(!connection)
+   {
+      printf("BF_TEST_MYSQL not set; skipping\n");
+      return;
+   }
+
+   Vector<string> args;
+   parseString(connection, args, ',');
+   ASSERT_EQ(4, args.size()) << "BF_TEST_MYSQL should be database,server,user,password";
+
+   DatabaseWriter writer(args[1].c_str(), args[0].c_str(), args[2].c_str(), args[3].c_str());
+
+   const char *tables[] = { "stats_game", "stats_team", "stats_player", "stats_player_shots", "stats_player_loadout" };
+   const S32 rowsPerGame[] = { 1, TeamsPerGame, TeamsPerGame * PlayersPerTeam, 
+                               TeamsPerGame * PlayersPerTeam * WeaponsPerPlayer, 
+                               TeamsPerGame * PlayersPerTeam * LoadoutsPerPlayer };
+
+   S32 before[ARRAYSIZE(tables)];
+   for(U32 i = 0; i < ARRAYSIZE(tables); i++)
+   {
+      before[i] = countRows(writer, tables[i]);
+      ASSERT_LE(0, before[i]) << "Can't read " << tables[i];
+   }
+
+   const S32 Games = 2;
+   for(S32 i = 0; i < Games; i++)
+      writer.insertStats(makeGameStats(i));
+
+   for(U32 i = 0; i < ARRAYSIZE(tables); i++)
+      EXPECT_EQ(before[i] + Games * rowsPerGame[i], countRows(writer, tables[i])) << tables[i];
+
+   // Quotes come through the template parameters intact
+   Vector<Vector<string> > results;
+   writer.selectHandler("SELECT level_name FROM stats_game ORDER BY stats_game_id DESC LIMIT 1;", 1, results);
+   ASSERT_EQ(1, results.size());
+   EXPECT_EQ("Level 1 with an 'apostrophe'", results[0][0]);
+}
+#endif
+
+
+};
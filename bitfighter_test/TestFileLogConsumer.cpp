@@ -0,0 +1,141 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+#include "tnlPlatform.h"
+#include "tnlThread.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static const char *LogFileName = "TestFileLogConsumer.log";
+
+
+class LogLinesTask : public WorkerTask
+{
+public:
+   FileLogConsumer *log;
+   S32 linesPerTask;
+
+   void runTask(S32 index)
+   {
+      for(S32 i = 0; i < linesPerTask; i++)
+         log->logprintf("Task %d line %d", index, i);
+   }
+};
+
+
+// Lines logged from several threads at once all reach the file, each one intact
+TEST(FileLogConsumerTest, LinesFromManyThreads)
+{
+   const S32 Tasks = 8;
+   const S32 LinesPerTask = 500;
+
+   {
+      FileLogConsumer log;
+      log.setMsgTypes(LogConsumer::LogNone);    // Only our direct logprintf calls
+      log.init(LogFileName, "w");
+
+      WorkerPool pool(3);
+      LogLinesTask task;
+      task.log = &log;
+      task.linesPerTask = LinesPerTask;
+      pool.run(&task, Tasks);
+
+      log.flush();
+      EXPECT_EQ(0, log.getDroppedLineCount());
+   }
+
+   string contents;
+   ASSERT_TRUE(readFile(LogFileName, contents));
+   remove(LogFileName);
+
+   Vector<string> lines;
+   parseString(contents, lines, '\n');
+   if(lines.size() > 0 && lines.last() == "")      // After the final newline
+      lines.erase(lines.size() - 1);
+   ASSERT_EQ(Tasks * LinesPerTask, lines.size());
+
+   // Each task's lines are in the order it logged them
+   S32 nextLine[Tasks] = { 0 };
+   for(S32 i = 0; i < lines.size(); i++)
+   {
+      S32 taskIndex = -1, lineIndex = -1;
+      ASSERT_EQ(2, sscanf(lines[i].c_str(), "Task %d line %d", &taskIndex, &lineIndex)) << lines[i];
+      ASSERT_TRUE(taskIndex >= 0 && taskIndex < Tasks);
+      EXPECT_EQ(nextLine[taskIndex], lineIndex);
+      nextLine[taskIndex] = lineIndex + 1;
+   }
+}
+
+
+// Lines logged before the file is closed are written even if the writer thread hasn't gotten to them
+TEST(FileLogConsumerTest, CloseWritesPendingLines)
+{
+   {
+      FileLogConsumer log;
+      log.setMsgTypes(LogConsumer::LogNone);
+      log.init(LogFileName, "w");
+      log.logprintf("Last words");
+   }
+
+   string contents;
+   ASSERT_TRUE(readFile(LogFileName, contents));
+   remove(LogFileName);
+
+   EXPECT_EQ("Last words\n", contents);
+}
+
+
+// The writer thread sleeps until there's something to write, and gets it onto the disk without anyone asking
+TEST(FileLogConsumerTest, WriterWakesForNewLines)
+{
+   FileLogConsumer log;
+   log.setMsgTypes(LogConsumer::LogNone);
+   log.init(LogFileName, "w");
+
+   Platform::sleep(FileLogConsumer::FlushIntervalMs * 3);     // Let the writer go idle
+   log.logprintf("Wake up");
+
+   string contents;
+   for(U32 waited = 0; waited < 5000 && contents == ""; waited += 10)
+   {
+      Platform::sleep(10);
+      readFile(LogFileName, contents);
+   }
+
+   EXPECT_EQ("Wake up\n", contents);
+   remove(LogFileName);
+}
+
+
+// What the crash handler uses; must get pending lines out when nobody's holding the locks
+TEST(FileLogConsumerTest, FlushForCrash)
+{
+   FileLogConsumer log;
+   log.setMsgTypes(LogConsumer::LogNone);
+   log.init(LogFileName, "w");
+
+   log.logprintf("Crashing now");
+   FileLogConsumer::flushAllForCrash();
+
+   string contents;
+   ASSERT_TRUE(readFile(LogFileName, contents));
+   EXPECT_EQ("Crashing now\n", contents);
+
+   remove(LogFileName);
+}
+
+
+};
@@ -0,0 +1,447 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "GameRecorder.h"
+
+#include "ClientGame.h"
+#include "GameManager.h"
+#include "GameRecorderPlayback.h"
+#include "gameType.h"
+#include "LineItem.h"
+#include "ServerGame.h"
+#include "Spawn.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+#include "tnlNetBase.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static string getLevelCode()
+{
+   return "LevelFormat 2\n" + getGenericHeader() +
+      "BarrierMaker 40 -500 -500 500 -500 500 500 -500 500 -500 -500\n"
+      "Turret 0 -100 -490 1\n"
+      "ResourceItem 0 0\n"
+      "ResourceItem 100 100\n"
+      "FlagItem 0 200 200\n";
+}
+
+
+// Asteroids never stop moving, so there's always something new to record
+static string getAsteroidLevelCode(bool twoTeams = false, bool extras = false)
+{
+   string code = "LevelFormat 2\n" + getGenericHeader() + (twoTeams ? "Team Red 1 0 0\n" : "") +
+      "BarrierMaker 40 -2000 -2000 2000 -2000 2000 2000 -2000 2000 -2000 -2000\n";
+
+   // Objects that send some of their state in the RPCs they send when first ghosted, rather than in their updates
+   if(extras)
+      code += "LineItem 1 2 -500 -500 -300 -400 -100 -500\n"
+              "AsteroidSpawn 1000 1000 7\n";
+
+   for(S32 i = 0; i < 40; i++)
+      code += "Asteroid " + itos(i * 90 - 1800) + " " + itos((i * 373) % 3000 - 1500) + "\n";
+
+   return code;
+}
+
+
+// Records a game for recordTime ms, and returns the file it went into
+static string recordGame(U32 recordTime, const string &levelCode = getLevelCode())
+{
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   settings->setSetting(IniKey::GameRecording, Yes);
+
+   GamePair gamePair(settings, levelCode);
+
+   ServerGame *serverGame = GameManager::getServerGame();
+   serverGame->unsuspendGame(false);      // Nobody is playing, but we want something to record
+
+   GameRecorderServer *recorder = serverGame->getGameRecorder();
+   if(!recorder)
+      return "";
+
+   string filename = joindir(settings->getFolderManager()->getRecordDir(), recorder->mFileName);
+
+   gamePair.idle(10, recordTime / 10);      // About as often as a real server
+
+   return filename;    // Recorder finishes the file when the game goes away
+}
+
+
+static bool readFileBytes(const string &filename, Vector<U8> &bytes)
+{
+   FILE *file = fopen(filename.c_str(), "rb");
+   if(!file)
+      return false;
+
+   fseek(file, 0, SEEK_END);
+   bytes.resize(ftell(file));
+   fseek(file, 0, SEEK_SET);
+
+   bool ok = fread(bytes.address(), 1, bytes.size(), file) == U32(bytes.size());
+   fclose(file);
+
+   return ok;
+}
+
+
+class GameRecorderTest : public testing::Test
+{
+protected:
+   string mFilename;
+
+   void SetUp()
+   {
+      NetClassRep::initialize();    // Normally done when the game creates its NetInterface
+   }
+
+   void TearDown()
+   {
+      if(mFilename != "")
+         remove(mFilename.c_str());
+   }
+};
+
+
+TEST_F(GameRecorderTest, KeyframesAreIndexed)
+{
+   mFilename = recordGame(35000);
+   ASSERT_NE("", mFilename);
+
+   FILE *file = fopen(mFilename.c_str(), "rb");
+   ASSERT_TRUE(file);
+
+   U8 header[4];
+   ASSERT_EQ(4, fread(header, 1, 4, file));
+   EXPECT_TRUE(((U32(header[3]) << 8) & GameRecorderServer::KeyframesFlag) != 0);
+   EXPECT_TRUE(((U32(header[3]) << 8) & GameRecorderServer::BlocksFlag) != 0);
+
+   Vector<RecordingKeyframe> keyframes;
+   U32 totalTime = 0;
+   ASSERT_TRUE(readRecordingSeekIndex(file, true, keyframes, totalTime));
+
+   EXPECT_GE(totalTime, 34000u);
+   EXPECT_LE(totalTime, 35100u);      // GamePair idles a bit on its own
+   ASSERT_EQ(3, keyframes.size());
+
+   RecordingReader reader(file, true);
+
+   for(S32 i = 0; i < keyframes.size(); i++)
+   {
+      U32 lastTime = i == 0 ? 0 : keyframes[i - 1].time;
+      EXPECT_GE(keyframes[i].time - lastTime, GameRecorderServer::KeyframeInterval) << "Keyframe " << i;
+      EXPECT_LT(keyframes[i].time - lastTime, GameRecorderServer::KeyframeInterval + 1000) << "Keyframe " << i;
+
+      // Each entry points at a block that starts with a keyframe record
+      U8 record[3];
+      ASSERT_TRUE(reader.seek(keyframes[i].offset));
+      ASSERT_TRUE(reader.read(record, 3));
+      EXPECT_EQ(0, record[0]);
+      EXPECT_EQ(0, record[1]);
+      EXPECT_EQ(RecordKeyframe, record[2]);
+   }
+
+   // Reading through the file finds the same ones
+   Vector<RecordingKeyframe> scannedKeyframes;
+   U32 scannedTime = 0;
+   reader.seek(4);
+   scanRecording(reader, true, scannedKeyframes, scannedTime);
+
+   EXPECT_EQ(totalTime, scannedTime);
+   ASSERT_EQ(keyframes.size(), scannedKeyframes.size());
+
+   for(S32 i = 0; i < keyframes.size(); i++)
+   {
+      EXPECT_EQ(keyframes[i].time, scannedKeyframes[i].time);
+      EXPECT_EQ(keyframes[i].offset, scannedKeyframes[i].offset);
+   }
+
+   fclose(file);
+}
+
+
+TEST_F(GameRecorderTest, UnfinishedRecordingsAreScanned)
+{
+   mFilename = recordGame(25000);
+   ASSERT_NE("", mFilename);
+
+   Vector<U8> bytes;
+   ASSERT_TRUE(readFileBytes(mFilename, bytes));
+
+   // Everything up to where the seek index would be, as if the server died partway through
+   FILE *file = fopen(mFilename.c_str(), "rb");
+   ASSERT_TRUE(file);
+
+   Vector<RecordingKeyframe> keyframes;
+   U32 totalTime = 0;
+   ASSERT_TRUE(readRecordingSeekIndex(file, true, keyframes, totalTime));
+   fclose(file);
+
+   U32 indexOffset = getRecordingU32(&bytes[bytes.size() - 8]);
+   ASSERT_LT(indexOffset, U32(bytes.size()));
+
+   file = fopen(mFilename.c_str(), "wb");
+   ASSERT_TRUE(file);
+   fwrite(bytes.address(), 1, indexOffset, file);
+   fclose(file);
+
+   file = fopen(mFilename.c_str(), "rb");
+   ASSERT_TRUE(file);
+
+   Vector<RecordingKeyframe> scannedKeyframes;
+   U32 scannedTime = 0;
+   EXPECT_FALSE(readRecordingSeekIndex(file, true, scannedKeyframes, scannedTime));
+
+   RecordingReader reader(file, true);
+   reader.seek(4);
+   scanRecording(reader, true, scannedKeyframes, scannedTime);
+   fclose(file);
+
+   EXPECT_EQ(totalTime, scannedTime);
+   ASSERT_EQ(2, scannedKeyframes.size());
+   EXPECT_EQ(keyframes[0].offset, scannedKeyframes[0].offset);
+   EXPECT_EQ(keyframes[1].offset, scannedKeyframes[1].offset);
+}
+
+
+// A server that dies mid-game should lose at most the last FlushInterval or so of its recording
+TEST_F(GameRecorderTest, RecordingReachesDiskWhileRecording)
+{
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   settings->setSetting(IniKey::GameRecording, Yes);
+
+   GamePair gamePair(settings, getAsteroidLevelCode());
+
+   ServerGame *serverGame = GameManager::getServerGame();
+   serverGame->unsuspendGame(false);
+
+   GameRecorderServer *recorder = serverGame->getGameRecorder();
+   ASSERT_TRUE(recorder);
+
+   mFilename = joindir(settings->getFolderManager()->getRecordDir(), recorder->mFileName);
+
+   const U32 recordTime = 15000;
+   gamePair.idle(10, recordTime / 10);
+
+   // Give the writer thread a moment, then read the file as a crashed server would have left it
+   U32 scannedTime = 0;
+   Vector<RecordingKeyframe> keyframes;
+
+   for(S32 tries = 0; tries < 100; tries++)
+   {
+      Platform::sleep(10);
+
+      FILE *file = fopen(mFilename.c_str(), "rb");
+      ASSERT_TRUE(file);
+
+      keyframes.clear();
+      RecordingReader reader(file, true);
+      reader.seek(4);
+      scanRecording(reader, true, keyframes, scannedTime);
+      fclose(file);
+
+      if(scannedTime + GameRecorderServer::FlushInterval + 500 >= recordTime)
+         break;
+   }
+
+   EXPECT_GE(scannedTime + GameRecorderServer::FlushInterval + 500, recordTime);
+   EXPECT_EQ(1, keyframes.size());
+}
+
+
+// Starts playing filename on game, which takes ownership of the playback
+static GameRecorderPlayback *startPlayback(ClientGame *game, const string &filename)
+{
+   game->getClientInfo()->setName("Viewer");      // The playback connection wants a player name
+
+   GameRecorderPlayback *playback = new GameRecorderPlayback(game, filename.c_str());
+   game->setConnectionToServer(playback);
+
+   return playback;
+}
+
+
+// Jumping to a keyframe and playing on from there has to leave the client just where playing from the start would
+TEST_F(GameRecorderTest, SeekingMatchesPlayingThrough)
+{
+   const U32 recordTime = 35000;
+   const U32 seekTime = 25500;      // Past two keyframes, with deltas to play after the second
+
+   {
+      GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+      settings->setSetting(IniKey::GameRecording, Yes);
+
+      GamePair gamePair(settings, getAsteroidLevelCode(true, true));
+
+      ServerGame *serverGame = GameManager::getServerGame();
+      serverGame->unsuspendGame(false);
+
+      GameRecorderServer *recorder = serverGame->getGameRecorder();
+      ASSERT_TRUE(recorder);
+      mFilename = joindir(settings->getFolderManager()->getRecordDir(), recorder->mFileName);
+
+      // Give the teams different scores that change as we go, staying short of the level's winning score
+      for(U32 second = 1; second <= recordTime / 1000; second++)
+      {
+         gamePair.idle(10, 100);
+
+         if(second % 3 == 0)
+            serverGame->getGameType()->updateScore(0, KillEnemy, 0);
+         if(second % 5 == 0)
+            serverGame->getGameType()->updateScore(1, KillEnemy, 0);
+      }
+   }     // Recorder finishes the file when the game goes away
+
+   ClientGame *seekingGame = newClientGame();
+   ClientGame *playingGame = newClientGame();
+
+   GameRecorderPlayback *seeking = startPlayback(seekingGame, mFilename);
+   GameRecorderPlayback *playing = startPlayback(playingGame, mFilename);
+   ASSERT_TRUE(seeking->isValid());
+   ASSERT_TRUE(playing->isValid());
+
+   seeking->seek(seekTime);
+
+   // Same frame length as seeking uses; where things bounce, the client's own idea of where they've got to between
+   // updates depends on it
+   for(U32 time = 0; time < seekTime; time += GameRecorderPlayback::SeekStep)
+      playing->processMoreData(min(GameRecorderPlayback::SeekStep, seekTime - time));
+
+   ASSERT_EQ(playing->mCurrentTime, seeking->mCurrentTime);
+
+   // Same ghosts in the same slots, in the same places, with the same state
+   S32 ghosts = 0;
+   S32 lineItems = 0;
+   S32 asteroidSpawns = 0;
+   for(S32 i = 0; i < GhostConnection::MaxGhostCount; i++)
+   {
+      NetObject *seekingGhost = seeking->resolveGhost(i);
+      NetObject *playingGhost = playing->resolveGhost(i);
+
+      ASSERT_EQ(playingGhost == NULL, seekingGhost == NULL) << "Ghost " << i;
+      if(!playingGhost)
+         continue;
+
+      ghosts++;
+      ASSERT_EQ(playingGhost->getClassId(NetClassGroupGame), seekingGhost->getClassId(NetClassGroupGame)) << "Ghost " << i;
+
+      BfObject *seekingObject = dynamic_cast<BfObject *>(seekingGhost);
+      BfObject *playingObject = dynamic_cast<BfObject *>(playingGhost);
+
+      if(!playingObject)
+         continue;
+
+      EXPECT_EQ(playingObject->getTeam(), seekingObject->getTeam()) << "Ghost " << i;
+
+      // A LineItem's position is its first point, so it has none until it gets its geometry
+      if(playingObject->getObjectTypeNumber() == LineTypeNumber)
+      {
+         lineItems++;
+
+         const Vector<Point> &playingLine = *static_cast<LineItem *>(playingObject)->getOutline();
+         const Vector<Point> &seekingLine = *static_cast<LineItem *>(seekingObject)->getOutline();
+
+         EXPECT_EQ(3, playingLine.size()) << "Ghost " << i;
+         ASSERT_EQ(playingLine.size(), seekingLine.size()) << "Ghost " << i;
+         for(S32 j = 0; j < playingLine.size(); j++)
+            EXPECT_EQ(playingLine[j], seekingLine[j]) << "Ghost " << i << ", point " << j;
+
+         continue;
+      }
+
+      EXPECT_NEAR(playingObject->getPos().x, seekingObject->getPos().x, 0.01f) << "Ghost " << i;
+      EXPECT_NEAR(playingObject->getPos().y, seekingObject->getPos().y, 0.01f) << "Ghost " << i;
+
+      if(playingObject->getObjectTypeNumber() == AsteroidSpawnTypeNumber)
+      {
+         asteroidSpawns++;
+
+         U32 playingTime = static_cast<AsteroidSpawn *>(playingObject)->getTimeUntilSpawn();
+         U32 seekingTime = static_cast<AsteroidSpawn *>(seekingObject)->getTimeUntilSpawn();
+
+         EXPECT_GE(7000u, playingTime);
+         EXPECT_NEAR(F32(playingTime), F32(seekingTime), F32(GameRecorderPlayback::SeekStep));
+      }
+   }
+
+   EXPECT_LT(40, ghosts);     // Asteroids and a GameType, at least
+   EXPECT_EQ(1, lineItems);
+   EXPECT_EQ(1, asteroidSpawns);
+
+   // Same teams, with the same scores
+   ASSERT_TRUE(seekingGame->getGameType());
+   ASSERT_EQ(2, playingGame->getTeamCount());
+   ASSERT_EQ(playingGame->getTeamCount(), seekingGame->getTeamCount());
+
+   for(S32 i = 0; i < playingGame->getTeamCount(); i++)
+   {
+      AbstractTeam *seekingTeam = seekingGame->getTeam(i);
+      AbstractTeam *playingTeam = playingGame->getTeam(i);
+
+      EXPECT_EQ(playingTeam->getName(), seekingTeam->getName()) << "Team " << i;
+      EXPECT_EQ(playingTeam->getColor(), seekingTeam->getColor()) << "Team " << i;
+      EXPECT_EQ(playingTeam->getScore(), seekingTeam->getScore()) << "Team " << i;
+   }
+
+   EXPECT_EQ(8, playingGame->getTeam(0)->getScore());     // Every 3 seconds
+   EXPECT_EQ(5, playingGame->getTeam(1)->getScore());     // Every 5 seconds
+
+   EXPECT_EQ(playingGame->getClientCount(), seekingGame->getClientCount());
+
+   delete seekingGame;
+   delete playingGame;
+}
+
+
+TEST_F(GameRecorderTest, BlocksAreCompressed)
+{
+   mFilename = recordGame(20000, getAsteroidLevelCode());
+   ASSERT_NE("", mFilename);
+
+   Vector<U8> bytes;
+   ASSERT_TRUE(readFileBytes(mFilename, bytes));
+
+   // Walk the blocks between the header and the seek index's trailer
+   U32 end = bytes.size() - 8;
+   U32 pos = 4;
+   U32 blocks = 0;
+   U32 size = 0;
+
+   while(pos < end)
+   {
+      ASSERT_LE(pos + 8, end);
+      U32 compressedSize = getRecordingU32(&bytes[pos]);
+      U32 blockSize = getRecordingU32(&bytes[pos + 4]);
+
+      EXPECT_LE(blockSize, GameRecorderServer::BlockSize);
+      EXPECT_LE(compressedSize, blockSize);
+
+      size += blockSize;
+      pos += 8 + compressedSize;
+      blocks++;
+   }
+
+   EXPECT_EQ(end, pos);
+   EXPECT_LT(bytes.size() * 3, size);
+
+   logprintf("GameRecorder: %d ms recorded in %d blocks, %d bytes compressed to %d", 20000, blocks, size, bytes.size());
+}
+
+
+};
@@ -0,0 +1,532 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "GridDatabaseTestUtils.h"
+
+#include "tnlPlatform.h"
+#include "tnlLog.h"
+#include "tnlThread.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+namespace Zap
+{
+
+using namespace std;
+using namespace TNL;
+
+
+static void bruteForce(const Vector<TestDbObject *> &objects, U8 typeNumber, const Rect &extents, Vector<DatabaseObject *> &found)
+{
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      Rect objExtents = objects[i]->getExtent();
+      if(objects[i]->getObjectTypeNumber() == typeNumber && objExtents.intersects(extents))
+         found.push_back(objects[i]);
+   }
+}
+
+
+static void sortResults(Vector<DatabaseObject *> &results)
+{
+   std::sort(results.getStlVector().begin(), results.getStlVector().end());
+}
+
+
+// Returns number of queries that did not match brute force; safe to run on any thread
+static S32 countBadQueries(const GridDatabase &db, DatabaseQuery &query, const Vector<TestDbObject *> &objects, 
+                           const Vector<RecordedQuery> &queries)
+{
+   Vector<DatabaseObject *> found, expected;
+   S32 badQueries = 0;
+
+   for(S32 i = 0; i < queries.size(); i++)
+   {
+      found.clear();
+      expected.clear();
+
+      db.findObjects(query, queries[i].typeNumber, found, queries[i].extents);
+      bruteForce(objects, queries[i].typeNumber, queries[i].extents, expected);
+
+      sortResults(found);
+      sortResults(expected);
+
+      if(found.size() != expected.size() || !std::equal(found.getStlVector().begin(), found.getStlVector().end(), 
+                                                        expected.getStlVector().begin()))
+         badQueries++;
+   }
+
+   return badQueries;
+}
+
+
+static void checkQueries(const GridDatabase &db, const Vector<TestDbObject *> &objects, const Vector<RecordedQuery> &queries)
+{
+   Vector<DatabaseObject *> found, expected;
+
+   for(S32 i = 0; i < queries.size(); i++)
+   {
+      found.clear();
+      expected.clear();
+
+      db.findObjects(queries[i].typeNumber, found, queries[i].extents);
+      bruteForce(objects, queries[i].typeNumber, queries[i].extents, expected);
+
+      sortResults(found);
+      sortResults(expected);
+
+      ASSERT_EQ(expected.size(), found.size()) << "Query " << i << " " << queries[i].extents.toString();
+      for(S32 j = 0; j < found.size(); j++)
+         ASSERT_EQ(expected[j], found[j]);
+   }
+}
+
+
+TEST(GridDatabaseTest, QueriesMatchBruteForce)
+{
+   for(S32 t = 0; t < IndexTypeCount; t++)
+   {
+      TestRng rng(1234);
+      GridDatabase db(IndexTypes[t]);
+      Vector<TestDbObject *> objects;
+      Vector<RecordedQuery> queries;
+
+      const F32 worldSize = 20000;
+
+      populate(db, objects, rng, 1000, worldSize);
+      recordQueryMix(queries, rng, 500, worldSize);
+      checkQueries(db, objects, queries);
+
+      // Resizing the index should not change what we find
+      db.setSpatialIndexExtents(db.getExtents());
+      checkQueries(db, objects, queries);
+
+      // Move a bunch of objects around, some a little, some a lot
+      for(S32 i = 0; i < objects.size(); i += 3)
+      {
+         Rect extents = objects[i]->getExtent();
+         if(i % 2 == 0)
+            extents.offset(Point(rng.nextF(40) - 20, rng.nextF(40) - 20));
+         else
+            extents = randomRect(rng, worldSize, 100);
+
+         objects[i]->setExtent(extents);
+      }
+      checkQueries(db, objects, queries);
+
+      // And remove some
+      for(S32 i = objects.size() - 1; i >= 0; i -= 4)
+      {
+         db.removeFromDatabase(objects[i], true);
+         objects.erase_fast(i);
+      }
+      checkQueries(db, objects, queries);
+
+      // Switching index type in place should also be transparent
+      db.setSpatialIndexType(IndexTypes[(t + 1) % IndexTypeCount]);
+      checkQueries(db, objects, queries);
+   }
+}
+
+
+// Objects roaming around a big world should not leave empty cells behind them
+TEST(GridDatabaseTest, HashGridReleasesEmptyCells)
+{
+   TestRng rng(2468);
+   SparseHashGrid grid;
+   Vector<TestDbObject *> objects;
+
+   const F32 worldSize = 100000;
+   const S32 objectCount = 50;
+
+   for(S32 i = 0; i < objectCount; i++)
+   {
+      TestDbObject *obj = new TestDbObject(BulletTypeNumber, randomRect(rng, worldSize, 100));
+      grid.insert(obj, obj->getExtent());
+      objects.push_back(obj);
+   }
+
+   for(S32 step = 0; step < 200; step++)
+      for(S32 i = 0; i < objects.size(); i++)
+      {
+         Rect oldExtents = objects[i]->getExtent();
+         Rect newExtents = randomRect(rng, worldSize, 100);
+
+         grid.update(objects[i], oldExtents, newExtents);
+         objects[i]->setExtent(newExtents);
+      }
+
+   // Objects are smaller than a cell, so each touches at most 4
+   EXPECT_LE(grid.getUsedCellCount(), objectCount * 4);
+
+   // Moving cells around in the table must not lose anybody
+   Vector<const SpatialCell *> cells;
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      cells.clear();
+      grid.findCells(objects[i]->getExtent(), cells);
+
+      bool found = false;
+      for(S32 j = 0; j < cells.size() && !found; j++)
+         for(S32 k = 0; k < cells[j]->size() && !found; k++)
+            found = (*cells[j])[k] == objects[i];
+
+      EXPECT_TRUE(found) << "Object " << i;
+   }
+
+   for(S32 i = 0; i < objects.size(); i++)
+      grid.remove(objects[i], objects[i]->getExtent());
+
+   EXPECT_EQ(0, grid.getUsedCellCount());
+
+   objects.deleteAndClear();
+}
+
+
+TEST(GridDatabaseTest, TypeListsAndOrderedView)
+{
+   TestRng rng(5678);
+   GridDatabase db;
+   Vector<TestDbObject *> objects;
+
+   populate(db, objects, rng, 200, 5000);
+
+   // Remove objects from all over the list, which will shuffle findObjects_fast()
+   for(S32 i = objects.size() - 1; i >= 0; i -= 3)
+   {
+      db.removeFromDatabase(objects[i], true);
+      objects.erase(i);       // Keep objects in insertion order
+   }
+
+   ASSERT_EQ(objects.size(), db.getObjectCount());
+
+   // Ordered view should still return everything in the order it was added
+   const Vector<DatabaseObject *> *ordered = db.findObjects_ordered();
+   ASSERT_EQ(objects.size(), ordered->size());
+   for(S32 i = 0; i < objects.size(); i++)
+   {
+      ASSERT_EQ(objects[i], ordered->get(i));
+      ASSERT_EQ(objects[i], db.getObjectByIndex(i));
+   }
+
+   // Each type list should hold exactly the objects of that type
+   S32 total = 0;
+   for(S32 t = 0; t < TestTypeCount; t++)
+   {
+      Vector<DatabaseObject *> found, expected;
+
+      db.findObjects(TestTypes[t], found);
+      for(S32 i = 0; i < objects.size(); i++)
+         if(objects[i]->getObjectTypeNumber() == TestTypes[t])
+            expected.push_back(objects[i]);
+
+      sortResults(found);
+      sortResults(expected);
+
+      ASSERT_EQ(expected.size(), found.size());
+      ASSERT_EQ(expected.size(), db.getObjectCount(TestTypes[t]));
+      ASSERT_EQ(expected.size(), db.findObjects_fast(TestTypes[t])->size());
+      EXPECT_EQ(expected.size() > 0, db.hasObjectOfType(TestTypes[t]));
+
+      for(S32 i = 0; i < found.size(); i++)
+         ASSERT_EQ(expected[i], found[i]);
+
+      total += found.size();
+   }
+
+   EXPECT_EQ(objects.size(), total);
+   EXPECT_FALSE(db.hasObjectOfType(FlagTypeNumber));
+   EXPECT_EQ(0, db.getObjectCount(FlagTypeNumber));
+}
+
+
+static bool isAnyTestType(U8 typeNumber)
+{
+   for(S32 i = 0; i < TestTypeCount; i++)
+      if(TestTypes[i] == typeNumber)
+         return true;
+
+   return false;
+}
+
+
+// Runs the query mix against a shared database on its own thread, with its own DatabaseQuery
+class QueryThread : public Thread
+{
+   const GridDatabase *mDatabase;
+   const Vector<TestDbObject *> *mObjects;
+   const Vector<RecordedQuery> *mQueries;
+   Semaphore *mDone;
+
+public:
+   S32 badQueries;
+
+   QueryThread(const GridDatabase *db, const Vector<TestDbObject *> *objects, const Vector<RecordedQuery> *queries, 
+               Semaphore *done)
+   {
+      mDatabase = db;
+      mObjects = objects;
+      mQueries = queries;
+      mDone = done;
+      badQueries = -1;
+   }
+
+   U32 run()
+   {
+      DatabaseQuery query;
+      badQueries = 0;
+
+      for(S32 i = 0; i < 5; i++)
+         badQueries += countBadQueries(*mDatabase, query, *mObjects, *mQueries);
+
+      mDone->increment();
+      return 0;
+   }
+};
+
+
+TEST(GridDatabaseTest, ConcurrentQueries)
+{
+   const S32 ThreadCount = 4;
+
+   for(S32 t = 0; t < IndexTypeCount; t++)
+   {
+      TestRng rng(4321);
+      GridDatabase db(IndexTypes[t]);
+      Vector<TestDbObject *> objects;
+      Vector<RecordedQuery> queries;
+
+      populate(db, objects, rng, 1000, 20000);
+      recordQueryMix(queries, rng, 500, 20000);
+
+      // Two queries interleaved on one thread must not interfere with each other's de-duplication
+      DatabaseQuery query1, query2;
+      Vector<DatabaseObject *> found1, found2;
+      Rect everything = db.getExtents();
+
+      db.findObjects(query1, isAnyTestType, found1, everything, false);
+      db.findObjects(query2, isAnyTestType, found2, everything, false);
+      db.findObjects(query1, isAnyTestType, found1, everything, true);     // Continues query1; finds nothing new
+
+      EXPECT_EQ(objects.size(), found1.size());
+      EXPECT_EQ(objects.size(), found2.size());
+
+      // Now hammer the database from several threads at once
+      Semaphore done;
+      Vector<RefPtr<QueryThread> > threads;
+
+      for(S32 i = 0; i < ThreadCount; i++)
+      {
+         threads.push_back(new QueryThread(&db, &objects, &queries, &done));
+         ASSERT_TRUE(threads.last()->start());
+      }
+
+      for(S32 i = 0; i < ThreadCount; i++)
+         done.wait();
+
+      for(S32 i = 0; i < ThreadCount; i++)
+         EXPECT_EQ(0, threads[i]->badQueries);
+   }
+}
+
+
+// Uses its thread's default query, then exits
+class ShortLivedQueryThread : public Thread
+{
+public:
+   Semaphore mDone;
+   bool mHadSlot;
+
+   U32 run()
+   {
+      mHadSlot = DatabaseQuery::getThreadQuery().hasSlot();
+      mDone.increment();
+      return 0;
+   }
+};
+
+
+// Threads come and go -- level preloaders, autosavers, shards -- and must give their query slot back when they do
+TEST(GridDatabaseTest, ExitingThreadsReleaseQuerySlots)
+{
+   for(S32 i = 0; i < DatabaseQuery::MaxSlots * 2; i++)
+   {
+      RefPtr<ShortLivedQueryThread> thread = new ShortLivedQueryThread();
+      ASSERT_TRUE(thread->start());
+      thread->mDone.wait();
+
+      EXPECT_TRUE(thread->mHadSlot) << "Thread " << i;
+
+      Platform::sleep(10);    // Exit cleanup runs after run() returns
+   }
+}
+
+
+// More threads than slots -- shards, each with robot script workers -- leaves some queries keeping their own visited set
+TEST(GridDatabaseTest, QueriesWithoutSlotsMatchBruteForce)
+{
+   Vector<DatabaseQuery *> slotHogs;
+
+   while(slotHogs.size() < DatabaseQuery::MaxSlots)
+   {
+      slotHogs.push_back(new DatabaseQuery());
+
+      if(!slotHogs.last()->hasSlot())
+         break;
+   }
+
+   for(S32 t = 0; t < IndexTypeCount; t++)
+   {
+      TestRng rng(2468);
+      GridDatabase db(IndexTypes[t]);
+      Vector<TestDbObject *> objects;
+      Vector<RecordedQuery> queries;
+
+      populate(db, objects, rng, 1000, 20000);
+      recordQueryMix(queries, rng, 500, 20000);
+
+      DatabaseQuery query1, query2;
+      EXPECT_FALSE(query1.hasSlot());
+
+      EXPECT_EQ(0, countBadQueries(db, query1, objects, queries));
+
+      // Same checks as with slots: interleaved queries don't interfere, and a continued query finds nothing new
+      Vector<DatabaseObject *> found1, found2;
+      Rect everything = db.getExtents();
+
+      db.findObjects(query1, isAnyTestType, found1, everything, false);
+      db.findObjects(query2, isAnyTestType, found2, everything, false);
+      db.findObjects(query1, isAnyTestType, found1, everything, true);
+
+      EXPECT_EQ(objects.size(), found1.size());
+      EXPECT_EQ(objects.size(), found2.size());
+
+      // And several threads without slots at once; no ASSERTs, so the slots always get handed back
+      const S32 ThreadCount = 4;
+      Semaphore done;
+      Vector<RefPtr<QueryThread> > threads;
+
+      for(S32 i = 0; i < ThreadCount; i++)
+      {
+         threads.push_back(new QueryThread(&db, &objects, &queries, &done));
+
+         if(!threads.last()->start())
+         {
+            ADD_FAILURE() << "Couldn't start query thread " << i;
+            threads.erase(i);
+            break;
+         }
+      }
+
+      for(S32 i = 0; i < threads.size(); i++)
+         done.wait();
+
+      for(S32 i = 0; i < threads.size(); i++)
+         EXPECT_EQ(0, threads[i]->badQueries);
+   }
+
+   for(S32 i = 0; i < slotHogs.size(); i++)
+      delete slotHogs[i];
+}
+
+
+static void checkExtents(GridDatabase &db, const Vector<TestDbObject *> &objects)
+{
+   if(objects.size() == 0)
+   {
+      EXPECT_TRUE(db.getExtents() == Rect());
+      return;
+   }
+
+   Rect expected = objects[0]->getExtent();
+   for(S32 i = 1; i < objects.size(); i++)
+      expected.unionRect(objects[i]->getExtent());
+
+   Rect extents = db.getExtents();
+   EXPECT_EQ(expected.min.x, extents.min.x);
+   EXPECT_EQ(expected.min.y, extents.min.y);
+   EXPECT_EQ(expected.max.x, extents.max.x);
+   EXPECT_EQ(expected.max.y, extents.max.y);
+}
+
+
+// Cached extents must always match the union of every object's extents, however objects come, go and move
+TEST(GridDatabaseTest, ExtentsMatchBruteForce)
+{
+   TestRng rng(2468);
+   GridDatabase db;
+   Vector<TestDbObject *> objects;
+
+   const F32 worldSize = 10000;
+
+   checkExtents(db, objects);
+
+   populate(db, objects, rng, 500, worldSize);
+   checkExtents(db, objects);
+
+   for(S32 round = 0; round < 40; round++)
+   {
+      // Halfway through, pretend the level has finished loading
+      if(round == 20)
+      {
+         db.markAllObjectsStatic();
+         checkExtents(db, objects);
+      }
+
+      // Move some objects, often the ones on the edge of the world, which are the ones that matter
+      for(S32 i = 0; i < 20 && objects.size() > 0; i++)
+      {
+         S32 index = rng.next() % objects.size();
+         Rect extents = objects[index]->getExtent();
+
+         if(i % 4 == 0)
+            extents = randomRect(rng, worldSize * 1.5f, 100);     // Sometimes outside the original world
+         else if(i % 4 == 1)
+            extents.set(extents);                                 // Same extents; shouldn't change anything
+         else
+            extents.offset(Point(rng.nextF(200) - 100, rng.nextF(200) - 100));
+
+         objects[index]->setExtent(extents);
+      }
+      checkExtents(db, objects);
+
+      // Remove some, including, sometimes, whatever defines an edge
+      for(S32 i = 0; i < 8 && objects.size() > 0; i++)
+      {
+         S32 index = rng.next() % objects.size();
+         if(i == 0)
+            for(S32 j = 0; j < objects.size(); j++)
+               if(objects[j]->getExtent().max.x > objects[index]->getExtent().max.x)
+                  index = j;
+
+         db.removeFromDatabase(objects[index], true);
+         objects.erase_fast(index);
+      }
+      checkExtents(db, objects);
+
+      // And add a few
+      for(S32 i = 0; i < 5; i++)
+      {
+         TestDbObject *obj = new TestDbObject(TestTypes[i % TestTypeCount], randomRect(rng, worldSize, 100));
+         db.addToDatabase(obj);
+         objects.push_back(obj);
+      }
+      checkExtents(db, objects);
+   }
+
+   // Empty it out completely
+   while(objects.size() > 0)
+   {
+      db.removeFromDatabase(objects.last(), true);
+      objects.pop_back();
+      if(objects.size() % 50 == 0)
+         checkExtents(db, objects);
+   }
+}
+
+
+};
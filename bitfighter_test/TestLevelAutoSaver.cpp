@@ -0,0 +1,232 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelAutoSaver.h"
+
+#include "BfObject.h"
+#include "Level.h"
+
+#include "LevelFilesForTesting.h"
+
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+#include "tnlNetBase.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static const char *SaveFileName = "TestLevelAutoSaver.save";
+
+
+// Coordinates in current-format levels aren't scaled by the grid size
+static string getHeader()
+{
+   return "LevelFormat 2\n" + getGenericHeader();
+}
+
+
+// A grid of short walls, each with a turret and some other bits and pieces
+static string getLevelCode(S32 gridSize)
+{
+   string code = getHeader();
+
+   for(S32 x = 0; x < gridSize; x++)
+      for(S32 y = 0; y < gridSize; y++)
+      {
+         S32 left = x * 200;
+         S32 top = y * 200;
+         code += "BarrierMaker 20 " + itos(left) + " " + itos(top) + " " + itos(left + 100) + " " + itos(top + 50) + "\n";
+         code += "Turret 0 " + itos(left + 50) + " " + itos(top + 30) + "\n";
+         code += "ResourceItem " + itos(left + 150) + " " + itos(top + 150) + "\n";
+         code += "TextItem 0 " + itos(left) + " " + itos(top + 100) + " " + itos(left + 100) + " " + itos(top + 100) +
+                 " 20 \"Spot " + itos(x) + "," + itos(y) + "\"\n";
+      }
+
+   return code;
+}
+
+
+// Copies of the level's objects, walls first, the way the editor hands them over
+static Vector<BfObject *> copyObjects(Level *level)
+{
+   const Vector<DatabaseObject *> *objList = level->findObjects_ordered();
+   Vector<BfObject *> objects(objList->size());
+
+   for(S32 j = 0; j < 2; j++)
+      for(S32 i = 0; i < objList->size(); i++)
+      {
+         BfObject *obj = static_cast<BfObject *>(objList->get(i));
+
+         if(isWallType(obj->getObjectTypeNumber()) == (j == 0))
+            objects.push_back(obj->clone());
+      }
+
+   return objects;
+}
+
+
+// What the editor would write if it saved the level in one go
+static string getLevelText(Level *level)
+{
+   string text = level->toLevelCode();
+   const Vector<DatabaseObject *> *objList = level->findObjects_ordered();
+
+   for(S32 j = 0; j < 2; j++)
+      for(S32 i = 0; i < objList->size(); i++)
+      {
+         BfObject *obj = static_cast<BfObject *>(objList->get(i));
+
+         if(isWallType(obj->getObjectTypeNumber()) == (j == 0))
+            text += obj->toLevelCode() + "\n";
+      }
+
+   return text;
+}
+
+
+class LevelAutoSaverTest : public testing::Test
+{
+protected:
+   void SetUp()
+   {
+      NetClassRep::initialize();    // Normally done when the game creates its NetInterface
+      remove(SaveFileName);
+   }
+
+   void TearDown()
+   {
+      remove(SaveFileName);
+   }
+};
+
+
+TEST_F(LevelAutoSaverTest, SavedFileMatchesLevelText)
+{
+   Level level(getLevelCode(3));
+
+   LevelAutoSaver saver;
+   saver.save(SaveFileName, level.toLevelCode(), copyObjects(&level));
+   saver.flush();
+
+   EXPECT_TRUE(saver.getLastWriteSucceeded());
+   EXPECT_FALSE(fileExists(string(SaveFileName) + ".tmp"));    // Swapped into place
+
+   string contents;
+   ASSERT_TRUE(readFile(SaveFileName, contents));
+   EXPECT_EQ(getLevelText(&level), contents);
+
+   // Reads back as the same level
+   Level reloaded(contents);
+   EXPECT_EQ(level.findObjects_fast()->size(), reloaded.findObjects_fast()->size());
+
+   // A later save replaces the earlier one
+   level.removeFromDatabase(level.findObjects_fast(TurretTypeNumber)->get(0), true);
+
+   saver.save(SaveFileName, level.toLevelCode(), copyObjects(&level));
+   saver.flush();
+
+   ASSERT_TRUE(readFile(SaveFileName, contents));
+   EXPECT_EQ(getLevelText(&level), contents);
+}
+
+
+TEST_F(LevelAutoSaverTest, FailedWriteLeavesNothingBehind)
+{
+   Level level(getLevelCode(1));
+   string filename = joindir("no_such_folder_for_autosave_test", SaveFileName);
+
+   LevelAutoSaver saver;
+   saver.save(filename, level.toLevelCode(), copyObjects(&level));
+   saver.flush();
+
+   EXPECT_FALSE(saver.getLastWriteSucceeded());
+   EXPECT_FALSE(fileExists(filename));
+   EXPECT_FALSE(fileExists(filename + ".tmp"));
+}
+
+
+TEST_F(LevelAutoSaverTest, BurstsOfChangesAreSavedOnce)
+{
+   LevelAutoSaver saver(100, 1000);
+
+   EXPECT_FALSE(saver.idle(500));                // Nothing to save
+
+   saver.levelChanged();
+   EXPECT_TRUE(saver.hasUnsavedChanges());
+   EXPECT_FALSE(saver.idle(60));
+
+   saver.levelChanged();                          // Still changing, so keep waiting...
+   EXPECT_FALSE(saver.idle(60));
+   EXPECT_TRUE(saver.idle(40));                   // ...until things have been quiet for long enough
+
+   Level level(getLevelCode(1));
+   saver.save(SaveFileName, level.toLevelCode(), copyObjects(&level));
+   EXPECT_FALSE(saver.hasUnsavedChanges());
+   EXPECT_FALSE(saver.idle(500));
+   saver.flush();                                 // Nothing is due while a save is being written
+
+   // Changes that never let up are still saved now and then
+   S32 elapsed = 0;
+   bool due = false;
+
+   while(!due && elapsed < 2000)
+   {
+      saver.levelChanged();
+      due = saver.idle(50);
+      elapsed += 50;
+   }
+
+   EXPECT_TRUE(due);
+   EXPECT_EQ(1000, elapsed);
+
+   EXPECT_TRUE(saver.idle(0));                    // Stays due until the editor gets around to saving
+}
+
+
+// Not a pass/fail timing test -- how long the editor is held up by an autosave of a large level, saving it in one go
+// and handing a copy to the autosaver
+TEST_F(LevelAutoSaverTest, AutoSaveBenchmark)
+{
+   const S32 Saves = 5;
+
+   Level level(getLevelCode(50));
+
+   S64 start = Platform::getHighPrecisionTimerValue();
+   for(S32 i = 0; i < Saves; i++)
+      writeFile(SaveFileName, getLevelText(&level));
+   F64 syncMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   LevelAutoSaver saver;
+   F64 handoffMs = 0;
+   F64 writeMs = 0;
+
+   for(S32 i = 0; i < Saves; i++)
+   {
+      start = Platform::getHighPrecisionTimerValue();
+      saver.save(SaveFileName, level.toLevelCode(), copyObjects(&level));
+      handoffMs += Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+      saver.flush();    // Editor would carry on while this happens
+      writeMs += saver.getLastWriteTime();
+   }
+
+   EXPECT_TRUE(saver.getLastWriteSucceeded());
+
+   logprintf("LevelAutoSaver benchmark: %d objects; synchronous save %g ms; autosave holds up editor %g ms, "
+             "writes in background %g ms", level.findObjects_fast()->size(), syncMs / Saves, handoffMs / Saves,
+             writeMs / Saves);
+}
+
+
+};
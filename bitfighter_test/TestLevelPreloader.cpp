@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelPreloader.h"
+
+#include "GameManager.h"
+#include "gameType.h"
+#include "Level.h"
+#include "ServerGame.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "stringUtils.h"
+
+#include "tnlNetBase.h"
+#include "tnlPlatform.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static const char *LevelFileName = "TestLevelPreloader.level";
+
+
+// Coordinates in current-format levels aren't scaled by the grid size
+static string getHeader()
+{
+   return "LevelFormat 2\n" + getGenericHeader();
+}
+
+
+// A small arena with some walls, a turret, and a teleporter to give the zones something to work around
+static string getZoneTestLevelCode()
+{
+   return getHeader() +
+      "BarrierMaker 40 -500 -500 500 -500 500 500 -500 500 -500 -500\n"
+      "BarrierMaker 20 -200 -100 200 -100\n"
+      "BarrierMaker 20 0 100 0 300\n"
+      "Turret 0 -100 -90 1\n"
+      "Teleporter -300 200 300 -200\n";
+}
+
+
+class LevelPreloaderTest : public testing::Test
+{
+protected:
+   void SetUp()
+   {
+      NetClassRep::initialize();    // Normally done when the game creates its NetInterface, long before any preloading
+   }
+};
+
+
+TEST_F(LevelPreloaderTest, PreloadedZonesMatchSynchronousBuild)
+{
+   string code = getZoneTestLevelCode();
+
+   LevelPreloader preloader;
+   ASSERT_TRUE(preloader.start(0, "", code, true, true));
+
+   LevelLoadStats stats;
+   Level *level = preloader.claim(0, "", code, stats);
+   ASSERT_TRUE(level);
+
+   EXPECT_TRUE(stats.preloaded);
+   EXPECT_TRUE(stats.preloadedBotZones);
+   EXPECT_FALSE(level->getGameType()->mBotZoneCreationFailed);
+
+   // The server builds its zones on the game thread when it starts with a level, so it gives us the zones
+   // we'd have gotten without preloading
+   GamePair gamePair(code, 0);
+   ServerGame *serverGame = GameManager::getServerGame();
+
+   const Vector<BotNavMeshZone *> &expected = serverGame->getLevel()->getBotZoneList();
+   const Vector<BotNavMeshZone *> &zones = level->getBotZoneList();
+
+   ASSERT_GT(expected.size(), 0);
+   ASSERT_EQ(expected.size(), zones.size());
+   EXPECT_EQ(expected.size(), stats.botZoneStats.zoneCount);
+
+   for(S32 i = 0; i < zones.size(); i++)
+   {
+      EXPECT_EQ(expected[i]->getCenter(), zones[i]->getCenter()) << "Zone " << i;
+      EXPECT_EQ(expected[i]->mNeighbors.size(), zones[i]->mNeighbors.size()) << "Zone " << i;
+   }
+
+   delete level;
+}
+
+
+TEST_F(LevelPreloaderTest, LevelgensDeferZones)
+{
+   string code = getZoneTestLevelCode() + "Script some_levelgen.levelgen\n";
+
+   LevelPreloader preloader;
+   ASSERT_TRUE(preloader.start(0, "", code, true, true));
+
+   LevelLoadStats stats;
+   Level *level = preloader.claim(0, "", code, stats);
+   ASSERT_TRUE(level);
+
+   EXPECT_TRUE(stats.preloaded);
+   EXPECT_FALSE(stats.preloadedBotZones);
+   EXPECT_EQ(0, level->getBotZoneList().size());
+
+   delete level;
+
+   // Same goes when we're told not to build them
+   ASSERT_TRUE(preloader.start(0, "", getZoneTestLevelCode(), false, true));
+   level = preloader.claim(0, "", getZoneTestLevelCode(), stats);
+   ASSERT_TRUE(level);
+   EXPECT_FALSE(stats.preloadedBotZones);
+
+   delete level;
+}
+
+
+TEST_F(LevelPreloaderTest, OnlyTheRequestedLevelIsHandedOver)
+{
+   string code = getZoneTestLevelCode();
+   LevelLoadStats stats;
+
+   LevelPreloader preloader;
+   EXPECT_FALSE(preloader.claim(0, "", code, stats));     // Nothing preloaded yet
+
+   ASSERT_TRUE(preloader.start(3, "", code, false, false));
+   EXPECT_EQ(3, preloader.getLevelIndex());
+   EXPECT_FALSE(preloader.claim(2, "", code, stats));     // Wrong index...
+   EXPECT_EQ(-1, preloader.getLevelIndex());              // ...and the preloaded level is gone
+   EXPECT_FALSE(preloader.claim(3, "", code, stats));
+
+   ASSERT_TRUE(preloader.start(3, "", code, false, false));
+   EXPECT_FALSE(preloader.claim(3, "", code + "Turret 0 0 0 1\n", stats));    // Level at that index has changed
+
+   // Starting again throws out whatever was there; cancelling throws out everything
+   ASSERT_TRUE(preloader.start(3, "", code, false, false));
+   ASSERT_TRUE(preloader.start(4, "", code, false, false));
+   EXPECT_FALSE(preloader.claim(3, "", code, stats));
+
+   ASSERT_TRUE(preloader.start(4, "", code, false, false));
+   preloader.cancel();
+   EXPECT_FALSE(preloader.claim(4, "", code, stats));
+
+   // Nothing to load
+   EXPECT_FALSE(preloader.start(-1, "", code, false, false));
+   EXPECT_FALSE(preloader.start(0, "", "", false, false));
+}
+
+
+TEST_F(LevelPreloaderTest, ChangedFilesAreReloaded)
+{
+   string code = getZoneTestLevelCode();
+   LevelLoadStats stats;
+
+   LevelPreloader preloader;
+
+   ASSERT_TRUE(writeFile(LevelFileName, code));
+   ASSERT_TRUE(preloader.start(0, LevelFileName, "", false, false));
+
+   Level *level = preloader.claim(0, LevelFileName, "", stats);
+   ASSERT_TRUE(level);
+   EXPECT_EQ(1, level->findObjects_fast(TurretTypeNumber)->size());
+   delete level;
+
+   // Rewritten after being read
+   ASSERT_TRUE(preloader.start(0, LevelFileName, "", false, false));
+   Platform::sleep(100);
+   ASSERT_TRUE(writeFile(LevelFileName, code + "Turret 0 -100 -110 1\n"));
+   EXPECT_FALSE(preloader.claim(0, LevelFileName, "", stats));
+
+   // Missing files just aren't preloaded
+   remove(LevelFileName);
+   ASSERT_TRUE(preloader.start(0, LevelFileName, "", false, false));
+   EXPECT_FALSE(preloader.claim(0, LevelFileName, "", stats));
+}
+
+
+};
@@ -9,8 +9,11 @@
 #include "stringUtils.h"
 
 #include "tnlNetInterface.h"
+
 #include "gtest/gtest.h"
 
+#include <stdio.h>
+
 namespace Zap
 {
 
@@ -41,5 +44,103 @@ TEST(TestLevelSource, tests)
 }
 
 
-};
+static const string CacheFile = "TestLevelSource.cache";
+
+
+static string levelPath(S32 index)
+{
+   return "TestLevelSource" + itos(index) + ".level";
+}
+
 
+static void writeLevelFiles(const Vector<string> &codes, S32 count, Vector<string> &paths)
+{
+   for(S32 i = 0; i < count; i++)
+   {
+      paths.push_back(levelPath(i));
+      writeFile(paths.last(), codes[i % codes.size()]);
+   }
+}
+
+
+static void removeFiles(const Vector<string> &paths)
+{
+   for(S32 i = 0; i < paths.size(); i++)
+      remove(paths[i].c_str());
+
+   remove(CacheFile.c_str());
+}
+
+
+TEST(TestLevelSource, LevelInfoCache)
+{
+   Address addr;
+   NetInterface net(addr);
+
+   pair<Vector<string>, Vector<LevelInfo> > levels = getLevels();
+   Vector<string> paths;
+   writeLevelFiles(levels.first, levels.first.size(), paths);
+   remove(CacheFile.c_str());
+
+   {
+      LevelInfoCache cache(CacheFile);
+      EXPECT_FALSE(cache.load());      // No cache file yet
+
+      EXPECT_EQ(paths.size(), cache.refresh(paths, 2));
+      EXPECT_EQ(paths.size(), cache.getEntryCount());
+
+      // Headers are the same as what a direct parse finds
+      for(S32 i = 0; i < paths.size(); i++)
+      {
+         SCOPED_TRACE("i = " + itos(i));
+         LevelHeader header;
+         ASSERT_TRUE(cache.lookup(paths[i], header));
+
+         EXPECT_EQ(levels.second[i].mLevelName.getString(), header.levelName);
+         EXPECT_EQ(levels.second[i].mLevelType,             header.levelType);
+         EXPECT_EQ(levels.second[i].minRecPlayers,          header.minRecPlayers);
+         EXPECT_EQ(levels.second[i].maxRecPlayers,          header.maxRecPlayers);
+         EXPECT_EQ(levels.second[i].mScriptFileName,        header.scriptFileName);
+      }
+
+      EXPECT_TRUE(cache.save());
+   }
+
+   // A fresh cache reads nothing for files that haven't changed
+   {
+      LevelInfoCache cache(CacheFile);
+      EXPECT_TRUE(cache.load());
+      EXPECT_EQ(0, cache.refresh(paths, 2));
+
+      LevelHeader header;
+      ASSERT_TRUE(cache.lookup(paths[0], header));
+      EXPECT_EQ(levels.second[0].mLevelName.getString(), header.levelName);
+
+      // A changed file is read again
+      writeFile(paths[0], "GameType 10 8\nLevelName Renamed level with a longer name\nMaxPlayers 12\n");
+      EXPECT_EQ(1, cache.refresh(paths, 2));
+      ASSERT_TRUE(cache.lookup(paths[0], header));
+      EXPECT_EQ("Renamed level with a longer name", header.levelName);
+      EXPECT_EQ(12, header.maxRecPlayers);
+
+      // Files that go away are forgotten
+      remove(paths[1].c_str());
+      cache.refresh(paths, 2);
+      EXPECT_EQ(paths.size() - 1, cache.getEntryCount());
+      EXPECT_FALSE(cache.lookup(paths[1], header));
+
+      EXPECT_TRUE(cache.save());
+   }
+
+   {
+      LevelInfoCache cache(CacheFile);
+      EXPECT_TRUE(cache.load());
+      EXPECT_EQ(paths.size() - 1, cache.getEntryCount());
+      EXPECT_EQ(0, cache.refresh(paths, 2));
+   }
+
+   removeFiles(paths);
+}
+
+
+};
@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LzUtils.h"
+
+#include "tnlRandom.h"
+#include "tnlVector.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Returns the compressed size
+static U32 roundTrip(const U8 *data, U32 size)
+{
+   Vector<U8> compressed;
+   compressed.resize(Lz::getMaxCompressedSize(size));
+
+   U32 compressedSize = Lz::compress(data, size, compressed.address());
+   EXPECT_LE(compressedSize, U32(compressed.size()));
+
+   Vector<U8> decompressed;
+   decompressed.resize(size + 1);    // So even an empty block has somewhere to go
+   EXPECT_TRUE(Lz::decompress(compressed.address(), compressedSize, decompressed.address(), size));
+   EXPECT_EQ(0, memcmp(data, decompressed.address(), size));
+
+   return compressedSize;
+}
+
+
+TEST(LzUtilsTest, RoundTrip)
+{
+   const char *text = "abcabcabcabcabcabcabcabcabcabcabcabc, and some more text to finish up";
+
+   roundTrip((const U8 *)text, 0);
+   roundTrip((const U8 *)text, 3);
+   EXPECT_LT(roundTrip((const U8 *)text, strlen(text)), strlen(text));
+
+   // Long runs need extra length bytes
+   Vector<U8> data;
+   for(S32 i = 0; i < 100000; i++)
+      data.push_back(i < 50000 ? 7 : U8(i / 1000));
+   EXPECT_LT(roundTrip(data.address(), data.size()), U32(data.size()) / 20);
+
+   // Noise doesn't compress, but mustn't grow past what we said it might
+   data.clear();
+   for(S32 i = 0; i < 65536; i++)
+      data.push_back(U8(Random::readI()));
+   EXPECT_LE(roundTrip(data.address(), data.size()), Lz::getMaxCompressedSize(data.size()));
+}
+
+
+TEST(LzUtilsTest, DamagedBlocksAreRejected)
+{
+   Vector<U8> data;
+   for(S32 i = 0; i < 10000; i++)
+      data.push_back(U8(i % 37 + i / 500));
+
+   Vector<U8> compressed;
+   compressed.resize(Lz::getMaxCompressedSize(data.size()));
+   U32 compressedSize = Lz::compress(data.address(), data.size(), compressed.address());
+
+   Vector<U8> decompressed;
+   decompressed.resize(data.size());
+
+   EXPECT_FALSE(Lz::decompress(compressed.address(), compressedSize / 2, decompressed.address(), data.size()));
+   EXPECT_FALSE(Lz::decompress(compressed.address(), compressedSize, decompressed.address(), data.size() - 1));
+
+   // A match reaching back before the start of the block
+   U8 badOffset[] = { 0x10, 'x', 0x20, 0x00, 0x00 };
+   EXPECT_FALSE(Lz::decompress(badOffset, sizeof(badOffset), decompressed.address(), 5));
+}
+
+
+};
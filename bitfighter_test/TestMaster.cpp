@@ -41,5 +41,130 @@ TEST(MasterTest, Sanity)
 
    delete clientGame;
 }
-	
+
+
+static Master::MasterServerConnection *newClient(MasterServer &master, const char *name, U8 idByte)
+{
+   Master::MasterServerConnection *client = new Master::MasterServerConnection();
+   client->mPlayerOrServerName = name;
+
+   U8 id[Nonce::NonceSize] = { idByte };
+   client->mPlayerId = Nonce(id);
+
+   master.addClient(client);
+   return client;
+}
+
+
+static Master::MasterServerConnection *newServer(MasterServer &master, U32 protocolVersion, bool hostMode)
+{
+   Master::MasterServerConnection *server = new Master::MasterServerConnection();
+   server->mCSProtocolVersion = protocolVersion;
+   server->mInfoFlags = hostMode ? HostModeFlag : 0;
+
+   master.addServer(server);
+   return server;
+}
+
+
+static S32 countServers(const ServerListChunks &chunks)
+{
+   S32 count = 0;
+   for(S32 i = 0; i < chunks.addresses.size(); i++)
+   {
+      EXPECT_EQ(chunks.addresses[i].size(), chunks.serverIds[i].size());
+      count += chunks.addresses[i].size();
+   }
+
+   return count;
+}
+
+
+TEST(MasterTest, ClientIndexes)
+{
+   MasterSettings masterSettings("");
+   MasterServer master(&masterSettings);
+
+   Master::MasterServerConnection *alice = newClient(master, "Alice", 1);
+   Master::MasterServerConnection *bob   = newClient(master, "bob",   2);
+   Master::MasterServerConnection *bob2  = newClient(master, "BOB",   3);
+
+   U8 id[Nonce::NonceSize] = { 2 };
+   EXPECT_EQ(bob, master.findClientByPlayerId(Nonce(id)));
+   id[0] = 4;
+   EXPECT_EQ(NULL, master.findClientByPlayerId(Nonce(id)));
+   EXPECT_EQ(NULL, master.findClientByPlayerId(Nonce()));
+
+   Vector<Master::MasterServerConnection *> found;
+   master.findClientsByName("Bob", found);      // Case insensitive, and names aren't unique
+   EXPECT_EQ(2, found.size());
+
+   // Removing from the front of the list moves the last client; it must still be removable afterwards
+   master.removeClient(alice);
+   EXPECT_EQ(2, master.getClientList()->size());
+   master.removeClient(bob2);
+   ASSERT_EQ(1, master.getClientList()->size());
+   EXPECT_EQ(bob, master.getClientList()->get(0));
+
+   found.clear();
+   master.findClientsByName("alice", found);
+   EXPECT_EQ(0, found.size());
+
+   StringTableEntry oldName = bob->mPlayerOrServerName;
+   bob->mPlayerOrServerName = "Carol";
+   master.onClientRenamed(bob, oldName);
+
+   found.clear();
+   master.findClientsByName("bob", found);
+   EXPECT_EQ(0, found.size());
+   master.findClientsByName("CAROL", found);
+   ASSERT_EQ(1, found.size());
+   EXPECT_EQ(bob, found[0]);
+
+   master.removeClient(bob);
+   delete alice;
+   delete bob;
+   delete bob2;
+}
+
+
+TEST(MasterTest, ServerListChunks)
+{
+   MasterSettings masterSettings("");
+   MasterServer master(&masterSettings);
+
+   Vector<Master::MasterServerConnection *> servers;
+   for(S32 i = 0; i < IP_MESSAGE_ADDRESS_COUNT + 5; i++)
+      servers.push_back(newServer(master, 40, false));
+
+   servers.push_back(newServer(master, 40, true));
+   servers.push_back(newServer(master, 39, false));
+
+   const ServerListChunks &chunks = master.getServerListChunks(40, false);
+   ASSERT_EQ(2, chunks.addresses.size());
+   EXPECT_EQ(IP_MESSAGE_ADDRESS_COUNT, chunks.addresses[0].size());
+   EXPECT_EQ(5, chunks.addresses[1].size());
+   EXPECT_EQ(servers[0]->getClientId(), chunks.serverIds[0][0]);
+
+   EXPECT_EQ(1, countServers(master.getServerListChunks(40, true)));
+   EXPECT_EQ(1, countServers(master.getServerListChunks(39, false)));
+   EXPECT_EQ(0, countServers(master.getServerListChunks(41, false)));
+
+   // Hidden servers drop out of the list once the master hears about it
+   servers[0]->mIsIgnoredFromList = true;
+   master.onServerListChanged();
+   EXPECT_EQ(IP_MESSAGE_ADDRESS_COUNT + 4, countServers(master.getServerListChunks(40, false)));
+
+   master.removeServer(servers.last());
+   EXPECT_EQ(0, countServers(master.getServerListChunks(39, false)));
+
+   for(S32 i = 0; i < servers.size() - 1; i++)
+      master.removeServer(servers[i]);
+
+   EXPECT_EQ(0, countServers(master.getServerListChunks(40, false)));
+
+   for(S32 i = 0; i < servers.size(); i++)
+      delete servers[i];
+}
+
 };
@@ -4,9 +4,18 @@
 //------------------------------------------------------------------------------
 
 #include "move.h"
+#include "ship.h"
+#include "ServerGame.h"
+#include "Level.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
 #include "tnlBitStream.h"
 #include "gtest/gtest.h"
 
+#include <cstring>
+
 namespace Zap
 {
 
@@ -102,5 +111,225 @@ TEST_F(MoveTest, LargeAngleWrapAround)
    move1.prepare();
    ASSERT_EQ(move1.angle, 0);
 }
-   
+
+
+// A ship heading between two others, placed so it touches both at exactly the same instant.  Which one it hits must
+// not depend on how the spatial index happens to order them.  The two sit in different grid cells, so the index hands
+// them back in the same order whichever was added first.
+TEST(MoveObjectTest, TiedCollisionsDontDependOnQueryOrder)
+{
+   const S32 IndexTypeCount = 2;
+   const SpatialIndex::IndexType IndexTypes[IndexTypeCount] = { SpatialIndex::SparseHashGrid, SpatialIndex::LooseQuadtree };
+
+   GamePair gamePair(getGenericHeader(), 0);
+   ServerGame *serverGame = gamePair.server;
+   serverGame->unsuspendGame(false);
+   Level *level = serverGame->getLevel();
+
+   for(S32 t = 0; t < IndexTypeCount; t++)
+      for(S32 firstAbove = 0; firstAbove < 2; firstAbove++)
+      {
+         level->setSpatialIndexType(IndexTypes[t]);
+
+         // Centers 36 px either side of the mover's path along a cell boundary; ship radius is 24
+         Ship *above = new Ship(NULL, TEAM_NEUTRAL, Point(100, 256 - 36));
+         Ship *below = new Ship(NULL, TEAM_NEUTRAL, Point(100, 256 + 36));
+
+         Ship *first  = firstAbove ? above : below;
+         Ship *second = firstAbove ? below : above;
+
+         first->addToGame(serverGame, level);
+         second->addToGame(serverGame, level);
+
+         Ship *mover = new Ship(NULL, TEAM_NEUTRAL, Point(0, 256));
+         mover->addToGame(serverGame, level);
+         mover->setVel(ActualState, Point(100, 0));
+
+         F32 collisionTime = 1;
+         Point collisionPoint;
+         BfObject *hit = mover->findFirstCollision(ActualState, collisionTime, collisionPoint);
+
+         // The oldest of the tied objects wins, as it did with the old bucket grid
+         EXPECT_EQ(first, hit) << "index type " << t << ", first above: " << firstAbove;
+         EXPECT_LT(0, collisionTime);
+         EXPECT_GT(1, collisionTime);
+
+         mover->deleteObject();
+         first->deleteObject();
+         second->deleteObject();
+         serverGame->idle(10);      // Deleted objects are cleaned up here
+      }
+}
+
+
+// A small walled arena with a barrier down the middle, so ships crowd into walls and shove each other around
+static string getLevelCodeForMoveReplay()
+{
+   return getGenericHeader() + 
+      "BarrierMaker 40 -1 -1 1 -1\n"
+      "BarrierMaker 40 1 -1 1 1\n"
+      "BarrierMaker 40 1 1 -1 1\n"
+      "BarrierMaker 40 -1 1 -1 -1\n"
+      "BarrierMaker 20 0 -0.4 0 0.4\n";
+}
+
+
+static const S32 ReplayShipCount = 6;
+static const S32 ReplayTickCount = 300;
+
+
+// Positions and velocities (x, y, vx, vy) every 50 ticks of the replay below, captured from the original tree, before
+// GridDatabase or MoveObject::move were reworked (gcc, x86-64).  Nothing since was meant to change the physics, so
+// they are compared bit for bit.
+//
+// When two candidates are hit at the same instant, the later one in findFirstCollision's candidate order wins; that
+// order is fixed by collisionCandidateSort(), not by the order the database returns objects in.
+struct ReplayCheckpoint
+{
+   S32 tick;
+   S32 ship;
+   F32 state[4];
+};
+
+static const ReplayCheckpoint ReplayGolden[] = {
+   {  49, 0, {     -76.8264618f,     -48.3755074f,     -23.4583817f,     -64.2995605f } },
+   {  49, 1, {     -32.6390038f,     -74.7540131f,     -18.7232189f,     -15.0624256f } },
+   {  49, 2, {      43.0630836f,     -27.6166573f,    -0.109604836f,       4.7038269f } },
+   {  49, 3, {     -99.1244965f,      47.5790901f,     -122.037125f,     -35.9359245f } },
+   {  49, 4, {      -39.338913f,      23.7135925f,     -76.4425964f,     0.442451477f } },
+   {  49, 5, {      35.3078613f,      44.3449745f,      14.1347122f,     -87.7631149f } },
+   {  99, 0, {     -80.5340042f,     -58.0712433f,      84.1576996f,     -204.464096f } },
+   {  99, 1, {     -42.8262787f,     -92.7137985f,     -33.7757492f,     -39.7464371f } },
+   {  99, 2, {      41.9904175f,     -40.6089058f,       3.3037529f,      3.66451454f } },
+   {  99, 3, {     -128.738266f,      29.6098232f,     -137.667511f,     -91.0183182f } },
+   {  99, 4, {     -82.9749298f,     -4.47237539f,      148.287643f,    -0.381704807f } },
+   {  99, 5, {       67.007637f,      10.5146341f,       51.036747f,      11.6536636f } },
+   { 149, 0, {      -71.834198f,     -73.8463364f,      77.6703796f,      29.0692596f } },
+   { 149, 1, {     -39.4641838f,     -128.980484f,     -33.4842529f,     -101.879509f } },
+   { 149, 2, {      39.3947449f,     -76.6479568f,      82.9033203f,     -109.324173f } },
+   { 149, 3, {     -148.605804f,      59.9955673f,     -140.402573f,      47.2353973f } },
+   { 149, 4, {     -39.4862747f,      30.4139614f,     -2.25896454f,      264.252197f } },
+   { 149, 5, {      55.1895218f,      38.0954819f,     -55.3161087f,      3.78003693f } },
+   { 199, 0, {     -53.4101143f,     -48.3749352f,     -12.6842499f,     -25.1088409f } },
+   { 199, 1, {     -61.9457588f,     -115.929382f,     -5.91051865f,      24.5129757f } },
+   { 199, 2, {       42.829792f,     -78.2632141f,      70.6200409f,      82.2815399f } },
+   { 199, 3, {     -132.955536f,      100.551369f,      49.0398865f,     -1.69068813f } },
+   { 199, 4, {     -74.3595734f,      76.7555618f,       50.332653f,       52.443737f } },
+   { 199, 5, {      73.2493362f,      75.7811127f,       133.07254f,      80.7719574f } },
+   { 249, 0, {     -72.7852325f,      1.98076236f,      125.363747f,      71.1139984f } },
+   { 249, 1, {     -104.236725f,     -83.8724976f,     -136.616806f,      149.381577f } },
+   { 249, 2, {      90.9169617f,      -57.095993f,      67.8167343f,     -30.6883469f } },
+   { 249, 3, {     -112.977882f,      61.3329811f,        6.653965f,     -166.119049f } },
+   { 249, 4, {     -54.8014603f,       52.600338f,      71.6812515f,     -43.2384796f } },
+   { 249, 5, {      71.5430603f,      58.0801849f,     -71.6090012f,     -213.842728f } },
+   { 299, 0, {     -55.6651459f,     -42.9838905f,     -87.2373505f,      18.4291916f } },
+   { 299, 1, {     -114.441162f,     -67.1136856f,      25.4621849f,      9.08291626f } },
+   { 299, 2, {      115.397209f,       -24.62047f,      62.7231369f,     -100.661285f } },
+   { 299, 3, {     -126.492554f,     -3.67729187f,       5.8697319f,     -73.7165375f } },
+   { 299, 4, {     -59.4597931f,      27.9954624f,       31.876194f,     -95.8525467f } },
+   { 299, 5, {      66.0834885f,      26.2356014f,     -63.7856979f,      112.408417f } },
+};
+
+// Moves for every ship on every tick, generated once from a fixed seed so both replays see the same input
+static void recordMoves(Vector<Move> &moves)
+{
+   U32 seed = 0x5eed1234;
+
+   for(S32 i = 0; i < ReplayShipCount * ReplayTickCount; i++)
+   {
+      seed = seed * 1664525 + 1013904223;
+      F32 x = F32((seed >> 8) & 0xFF) / 127.5f - 1;
+      F32 y = F32((seed >> 16) & 0xFF) / 127.5f - 1;
+      moves.push_back(Move(x, y, F32(seed >> 24) * Float2Pi / 256));
+   }
+}
+
+
+// Plays moves against a fresh game, appending each ship's position and velocity after every tick
+static void replayMoves(const Vector<Move> &moves, Vector<Point> &states)
+{
+   GamePair gamePair(getLevelCodeForMoveReplay(), 0);
+   ServerGame *serverGame = gamePair.server;
+   serverGame->unsuspendGame(false);
+
+   // Packed in a tight cluster so displacement chains happen right from the start
+   Vector<SafePtr<Ship> > ships;
+   for(S32 i = 0; i < ReplayShipCount; i++)
+   {
+      Ship *ship = new Ship(NULL, TEAM_NEUTRAL, Point(-60 + (i % 3) * 45, -20 + (i / 3) * 45));
+      ship->addToGame(serverGame, serverGame->getLevel());
+      ships.push_back(ship);
+   }
+
+   for(S32 tick = 0; tick < ReplayTickCount; tick++)
+   {
+      for(S32 i = 0; i < ships.size(); i++)
+         if(ships[i].isValid())
+            ships[i]->setMove(moves[tick * ReplayShipCount + i]);
+
+      serverGame->idle(15);
+
+      for(S32 i = 0; i < ships.size(); i++)
+      {
+         ASSERT_TRUE(ships[i].isValid());
+         states.push_back(ships[i]->getActualPos());
+         states.push_back(ships[i]->getActualVel());
+      }
+   }
+}
+
+
+// MoveObject::move keeps a lot of scratch state between calls; make sure none of it leaks from one run into the
+// next.  Results are compared bit for bit, not within a tolerance.
+TEST(MoveObjectTest, ReplayIsDeterministic)
+{
+   Vector<Move> moves;
+   recordMoves(moves);
+
+   Vector<Point> firstRun, secondRun;
+   replayMoves(moves, firstRun);
+   replayMoves(moves, secondRun);
+
+   ASSERT_EQ(firstRun.size(), secondRun.size());
+   ASSERT_EQ(ReplayShipCount * ReplayTickCount * 2, firstRun.size());
+
+   for(S32 i = 0; i < firstRun.size(); i++)
+   {
+      EXPECT_EQ(0, memcmp(&firstRun[i].x, &secondRun[i].x, sizeof(F32))) << "State " << i << " differs";
+      EXPECT_EQ(0, memcmp(&firstRun[i].y, &secondRun[i].y, sizeof(F32))) << "State " << i << " differs";
+   }
+
+   // Ships were actually pushed around; a replay where nothing moves is deterministic but proves nothing
+   bool moved = false;
+   for(S32 i = 0; i < ReplayShipCount; i++)
+      if(firstRun[(ReplayTickCount - 1) * ReplayShipCount * 2 + i * 2] != firstRun[i * 2])
+         moved = true;
+
+   ASSERT_TRUE(moved);
+}
+
+
+// Same replay, checked against the positions the original tree produced
+TEST(MoveObjectTest, ReplayMatchesBaseline)
+{
+   Vector<Move> moves;
+   recordMoves(moves);
+
+   Vector<Point> states;
+   replayMoves(moves, states);
+   ASSERT_EQ(ReplayShipCount * ReplayTickCount * 2, states.size());
+
+   for(S32 i = 0; i < (S32)ARRAYSIZE(ReplayGolden); i++)
+   {
+      const ReplayCheckpoint &golden = ReplayGolden[i];
+      S32 index = (golden.tick * ReplayShipCount + golden.ship) * 2;
+
+      EXPECT_EQ(golden.state[0], states[index].x)     << "Tick " << golden.tick << ", ship " << golden.ship;
+      EXPECT_EQ(golden.state[1], states[index].y)     << "Tick " << golden.tick << ", ship " << golden.ship;
+      EXPECT_EQ(golden.state[2], states[index + 1].x) << "Tick " << golden.tick << ", ship " << golden.ship;
+      EXPECT_EQ(golden.state[3], states[index + 1].y) << "Tick " << golden.tick << ", ship " << golden.ship;
+   }
+}
+
+
 };
@@ -0,0 +1,112 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "PlaybackBenchmark.h"
+
+#include "ClientGame.h"
+#include "GameManager.h"
+#include "GameRecorder.h"
+#include "ServerGame.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "stringUtils.h"
+
+#include "tnlNetBase.h"
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static string getLevelCode()
+{
+   return "LevelFormat 2\n" + getGenericHeader() +
+      "Team Red 1 0 0\n"       // The bots are split between two teams
+      "BarrierMaker 40 -500 -500 500 -500 500 500 -500 500 -500 -500\n"
+      "Turret 0 -100 -490 1\n"
+      "Turret 1 100 490 1\n"
+      "ResourceItem 0 0\n"
+      "ResourceItem 100 100\n"
+      "FlagItem 0 200 200\n";
+}
+
+
+class PlaybackBenchmarkTest : public testing::Test
+{
+protected:
+   string mFilename;
+
+   void SetUp()
+   {
+      NetClassRep::initialize();    // Normally done when the game creates its NetInterface
+   }
+
+   void TearDown()
+   {
+      if(mFilename != "")
+         remove(mFilename.c_str());
+   }
+};
+
+
+// Not a pass/fail timing test -- how fast the client chews through a recorded game with a few bots flying around in it;
+// bitfighter_playback_benchmark does the same for real recordings
+TEST_F(PlaybackBenchmarkTest, PlaybackBenchmark)
+{
+   const S32 BotCount = 4;
+
+   {
+      GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+      settings->setSetting(IniKey::GameRecording, Yes);
+      settings->setSetting(IniKey::AddRobots, No);
+
+      GamePair gamePair(settings, getLevelCode());
+
+      for(S32 i = 0; i < BotCount; i++)
+         gamePair.addBotClient("Bot" + itos(i), i % 2);
+
+      ServerGame *serverGame = GameManager::getServerGame();
+      serverGame->unsuspendGame(false);
+
+      GameRecorderServer *recorder = serverGame->getGameRecorder();
+      ASSERT_TRUE(recorder);
+      mFilename = joindir(settings->getFolderManager()->getRecordDir(), recorder->mFileName);
+
+      gamePair.idle(100, 150);
+   }     // Recorder finishes the file when the game goes away
+
+   ClientGame *game = newClientGame();
+   game->getClientInfo()->setName("PlaybackBenchmark");      // The playback connection wants a player name
+
+   PlaybackBenchmark benchmark(game);
+   PlaybackBenchmarkResults results;
+   ASSERT_TRUE(benchmark.run(mFilename, results));
+
+   EXPECT_GT(results.recordedTime, 14000u);
+   EXPECT_GT(results.ticks, results.recordedTime / PlaybackBenchmark::DefaultTickLength);
+   EXPECT_GT(results.packets, 0u);
+   EXPECT_GT(results.bytes, 0u);
+   EXPECT_EQ(-1, results.allocations);       // Nobody was counting
+   ASSERT_NE(0, results.classCosts.size());  // Ghosts at least
+
+   for(S32 i = 1; i < results.classCosts.size(); i++)
+      EXPECT_GE(results.classCosts[i - 1].time, results.classCosts[i].time);
+
+   EXPECT_FALSE(NetClassRep::mCollectUnpackStats);
+
+   results.log();
+
+   delete game;
+}
+
+
+};
@@ -4,11 +4,14 @@
 //------------------------------------------------------------------------------
 
 #include "TestUtils.h"
+#include "LevelFilesForTesting.h"
 
 #include "../zap/ClientGame.h"
 #include "../zap/ServerGame.h"
 #include "../zap/gameType.h"
 #include "../zap/luaLevelGenerator.h"
+#include "../zap/EventManager.h"
+#include "../zap/stringUtils.h"
 
 #include "gtest/gtest.h"
 
@@ -77,6 +80,35 @@ TEST(RobotTest, luaRobotNew)
 }
 
 
+// With script threads, each bot gets its own Lua VM and onTick runs on the workers; every bot should still tick
+TEST(RobotTest, ScriptThreadsTickEveryBot)
+{
+   const S32 BotCount = 4;
+
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   settings->setSetting(IniKey::AddRobots, No);
+   settings->setSetting(IniKey::RobotScriptThreads, 3u);
+
+   GamePair gamePair(settings, getLevelCode1());
+
+   for(S32 i = 0; i < BotCount; i++)
+      gamePair.addBotClient("Bot" + itos(i), 0);
+
+   gamePair.server->unsuspendGame(false);    // No humans here, but we want the bots to play anyway
+   gamePair.idle(10, 20);     // Let the bots spawn and settle in
+   EventManager::get()->resetTickStats();
+
+   gamePair.idle(10, 50);     // Bots tick every 33ms
+
+   const EventManager::TickStats &stats = EventManager::get()->getTickStats();
+
+   EXPECT_EQ(3u, EventManager::get()->getScriptThreadCount());
+   EXPECT_GT(stats.ticks, 0u);
+   EXPECT_EQ(BotCount, gamePair.server->getRobotCount());
+   EXPECT_EQ(BotCount * stats.ticks, stats.handlers);      // No bot was shut down by a script error
+}
+
+
 /** onShipSpawned doesn't fire?
 
 TEST(RobotTest, RemoveFromGameDuringInitialOnShipSpawn)
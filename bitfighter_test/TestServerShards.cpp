@@ -0,0 +1,274 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "ClientGame.h"
+#include "EventManager.h"
+#include "GameContext.h"
+#include "GameManager.h"
+#include "gridDB.h"
+#include "Level.h"
+#include "LuaScriptRunner.h"
+#include "ServerGame.h"
+#include "ServerShard.h"
+
+#include "LevelFilesForTesting.h"
+#include "TestUtils.h"
+
+#include "tnlNetStringTable.h"
+#include "tnlPlatform.h"
+#include "tnlThread.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static ThreadLocalVector<S32> gTestVector;
+
+// Looks at, then scribbles on, its own copy of gTestVector
+class FillVectorThread : public Thread
+{
+public:
+   Semaphore mDone;
+   S32 mSizeSeen;
+
+   U32 run()
+   {
+      mSizeSeen = gTestVector.size();
+
+      gTestVector.push_back(1);
+      gTestVector.push_back(2);
+
+      mDone.increment();
+      return 0;
+   }
+};
+
+
+TEST(ServerShardsTest, ThreadLocalVectorsAreSeparate)
+{
+   gTestVector.clear();
+   gTestVector.push_back(7);
+
+   RefPtr<FillVectorThread> thread = new FillVectorThread();
+   ASSERT_TRUE(thread->start());
+   thread->mDone.wait();
+
+   EXPECT_EQ(0, thread->mSizeSeen);       // Other thread started with an empty vector...
+   ASSERT_EQ(1, gTestVector.size());      // ...and didn't touch ours
+   EXPECT_EQ(7, gTestVector[0]);
+}
+
+
+// Records which context each index was run in
+class RecordContextTask : public WorkerTask
+{
+public:
+   enum {
+      TaskCount = 64
+   };
+
+   ThreadContext *mContexts[TaskCount];
+
+   void runTask(S32 index)
+   {
+      mContexts[index] = ThreadContext::getCurrent();
+   }
+};
+
+
+TEST(ServerShardsTest, WorkersUseCallersContext)
+{
+   GameContext context;
+   WorkerPool pool(3);
+   RecordContextTask task;
+
+   ThreadContext::setCurrent(&context);
+   pool.run(&task, RecordContextTask::TaskCount);
+   ThreadContext::setCurrent(NULL);
+
+   for(S32 i = 0; i < RecordContextTask::TaskCount; i++)
+      EXPECT_EQ(&context, task.mContexts[i]) << "index " << i;
+
+   EXPECT_EQ(ThreadContext::getDefault(), ThreadContext::getCurrent());
+}
+
+
+TEST(ServerShardsTest, GameStateIsPerContext)
+{
+   GameContext context;
+
+   EventManager *defaultEventManager = EventManager::get();
+   GameManager::HostingModePhase defaultPhase = GameManager::getHostingModePhase();
+
+   ThreadContext::setCurrent(&context);
+   EXPECT_EQ(&context, GameContext::get());
+   EXPECT_TRUE(GameManager::getServerGame() == NULL);
+
+   GameManager::setHostingModePhase(GameManager::Hosting);
+   EXPECT_NE(defaultEventManager, EventManager::get());
+   EventManager::shutdown();
+   ThreadContext::setCurrent(NULL);
+
+   // Nothing we did above leaked into the default context
+   EXPECT_EQ(defaultPhase, GameManager::getHostingModePhase());
+   EXPECT_EQ(defaultEventManager, EventManager::get());
+}
+
+
+// Hosts a ServerGame in a context of its own, like a ServerShard does
+class HostThread : public Thread
+{
+public:
+   GameContext mContext;
+   Semaphore mHosting;
+   Semaphore mStop;
+   Semaphore mDone;
+
+   ServerGame *mServerGame;
+   EventManager *mEventManager;
+
+   U32 run()
+   {
+      ThreadContext::setCurrent(&mContext);
+
+      GameManager::setServerGame(newServerGame());
+      mServerGame = GameManager::getServerGame();
+      mEventManager = EventManager::get();
+
+      fillVector.clear();
+      mServerGame->getLevel()->findObjects(fillVector);
+
+      mHosting.increment();
+      mStop.wait();
+
+      GameManager::deleteServerGame();
+      EventManager::shutdown();
+
+      ThreadContext::setCurrent(NULL);
+
+      mDone.increment();
+      return 0;
+   }
+};
+
+
+TEST(ServerShardsTest, TwoServerGamesAtOnce)
+{
+   StringTable::beginThreadedUse();
+
+   RefPtr<HostThread> thread = new HostThread();
+   ASSERT_TRUE(thread->start());
+   thread->mHosting.wait();
+
+   // A second ServerGame on this thread, while the other is still alive, would trip the one-at-a-time assert if it
+   // were still per process
+   ServerGame *serverGame = newServerGame();
+
+   EXPECT_NE(serverGame, thread->mServerGame);
+   EXPECT_NE(EventManager::get(), thread->mEventManager);
+
+   thread->mStop.increment();
+   thread->mDone.wait();
+
+   delete serverGame;
+
+   StringTable::endThreadedUse();
+}
+
+
+// Each shard ticks itself on its own thread; here we only tick the clients, each of which talks to its shard over
+// a real socket.  A client only gets a GameType once its shard has accepted the connection and ghosted it over.
+TEST(ServerShardsTest, ShardsHostOnTheirOwnPorts)
+{
+   const S32 ShardCount = 2;
+   const U16 BasePort = 28350;      // Stands in for the main game's port; the shards use the ports above it
+
+   LuaScriptRunner::startLua(GameSettings::getFolderManager()->getLuaDir());     // For our clients
+   StringTable::beginThreadedUse();
+
+   GameSettingsPtr settings = GameSettingsPtr(new GameSettings());
+   LevelSourcePtr levelSource = LevelSourcePtr(new StringLevelSource(getLevelCode1()));
+
+   ServerShard *shards[ShardCount];
+   ClientGame *clients[ShardCount];
+
+   // No ASSERTs until everything below is torn down, or a failure would leave shard threads running
+   S32 created = 0;
+   for(S32 i = 0; i < ShardCount; i++)
+   {
+      // Named Localhost doesn't survive the trip to a socket address, so spell out the loopback address
+      Address address("IP:127.0.0.1:0");
+      address.port = U16(BasePort + i + 1);
+
+      shards[i] = new ServerShard(i + 1, address, settings, levelSource);
+      created++;
+
+      if(!shards[i]->start())
+      {
+         ADD_FAILURE() << "shard " << i << " didn't start";
+         clients[i] = NULL;
+         break;
+      }
+
+      clients[i] = newClientGame();
+      clients[i]->userEnteredLoginCredentials("ShardPlayer" + itos(i), "password", false);
+      clients[i]->activateMainMenuUI();
+      clients[i]->joinRemoteGame(address, false);
+   }
+
+   bool allStarted = (created == ShardCount && clients[ShardCount - 1] != NULL);
+
+   bool allJoined = false;
+   for(S32 tick = 0; tick < 500 && allStarted && !allJoined; tick++)
+   {
+      allJoined = true;
+
+      for(S32 i = 0; i < ShardCount; i++)
+      {
+         clients[i]->idle(10);
+         if(!clients[i]->getGameType())
+            allJoined = false;
+      }
+
+      Platform::sleep(10);
+   }
+
+   for(S32 i = 0; i < ShardCount && allStarted; i++)
+   {
+      GameConnection *connection = clients[i]->getConnectionToServer();
+
+      EXPECT_TRUE(connection != NULL) << "client " << i;
+      if(!connection)
+         continue;
+
+      EXPECT_TRUE(connection->isEstablished()) << "client " << i;
+      EXPECT_EQ(BasePort + i + 1, connection->getNetAddress().port) << "client " << i;
+      EXPECT_TRUE(clients[i]->getGameType() != NULL) << "client " << i << " never got its game";
+   }
+
+   for(S32 i = 0; i < created; i++)
+   {
+      if(clients[i] && clients[i]->getConnectionToServer())
+         clients[i]->getConnectionToServer()->disconnect(NetConnection::ReasonSelfDisconnect, "");
+      if(clients[i])
+         clients[i]->idle(10);
+   }
+
+   for(S32 i = 0; i < created; i++)
+   {
+      delete clients[i];
+      delete shards[i];          // Stops the shard, and waits for its thread to finish
+   }
+
+   StringTable::endThreadedUse();
+   LuaScriptRunner::shutdown();
+}
+
+
+};
@@ -0,0 +1,192 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "tnlUDP.h"
+#include "tnlPlatform.h"
+#include "tnlLog.h"
+#include "tnlVector.h"
+
+#include "gtest/gtest.h"
+
+#include <string.h>
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+static const S32 PacketSize = 200;
+
+
+// Named Localhost doesn't survive the trip to a socket address, so spell out the loopback address
+static Address getLoopbackAddress(Socket &socket)
+{
+   Address address("IP:127.0.0.1:0");
+   address.port = socket.getBoundAddress().port;
+   return address;
+}
+
+
+// Fills packet number index with bytes that say which packet it is
+static void fillPacket(U8 *data, S32 index, S32 size)
+{
+   for(S32 i = 0; i < size; i++)
+      data[i] = U8(index * 7 + i);
+}
+
+
+TEST(SocketTest, BatchesRoundTrip)
+{
+   Socket sender(Address(IPProtocol, Address::Any, 0));
+   Socket receiver(Address(IPProtocol, Address::Any, 0));
+   ASSERT_TRUE(sender.isValid() && receiver.isValid());
+
+   Address destination = getLoopbackAddress(receiver);
+   U16 senderPort = sender.getBoundAddress().port;
+
+   const S32 count = 20;
+   Vector<U8> data;
+   data.resize(count * PacketSize);
+
+   Vector<Address> addresses;
+   Vector<const U8 *> buffers;
+   Vector<S32> sizes;
+
+   for(S32 i = 0; i < count; i++)
+   {
+      fillPacket(&data[i * PacketSize], i, PacketSize);
+      addresses.push_back(destination);
+      buffers.push_back(&data[i * PacketSize]);
+      sizes.push_back(PacketSize - i);      // Every packet a different size
+   }
+
+   EXPECT_EQ(count, sender.sendtoBatch(addresses.address(), buffers.address(), sizes.address(), count));
+
+   Vector<U8> received;
+   received.resize(Socket::MaxBatchSize * MaxPacketDataSize);
+   Vector<Address> sources;
+   sources.resize(Socket::MaxBatchSize);
+   Vector<S32> receivedSizes;
+   receivedSizes.resize(Socket::MaxBatchSize);
+
+   // Loopback delivers as we send, so everything is already waiting
+   S32 got = receiver.recvfromBatch(sources.address(), received.address(), MaxPacketDataSize,
+                                    receivedSizes.address(), Socket::MaxBatchSize);
+   ASSERT_EQ(count, got);
+
+   for(S32 i = 0; i < count; i++)
+   {
+      EXPECT_EQ(PacketSize - i, receivedSizes[i]);
+      EXPECT_EQ(senderPort, sources[i].port);
+      EXPECT_EQ(0, memcmp(&data[i * PacketSize], &received[i * MaxPacketDataSize], PacketSize - i));
+   }
+
+   // Nothing more to read
+   EXPECT_EQ(0, receiver.recvfromBatch(sources.address(), received.address(), MaxPacketDataSize,
+                                       receivedSizes.address(), Socket::MaxBatchSize));
+
+   EXPECT_EQ(U32(count), sender.getStats().sendPackets);
+   EXPECT_EQ(U32(count), receiver.getStats().recvPackets);
+   EXPECT_GE(sender.getStats().sendCalls, 1u);
+   EXPECT_LE(sender.getStats().sendCalls, U32(count));
+
+   // Stats can be cleared between measurements
+   sender.resetStats();
+   EXPECT_EQ(0u, sender.getStats().sendPackets);
+}
+
+
+// Not a pass/fail timing test -- compares the cost of moving packets one system call at a time with moving them a
+// batch at a time, over loopback.  Loopback time is mostly kernel CPU, so it stands in for CPU per packet.
+TEST(SocketTest, SocketBatchingBenchmark)
+{
+   Socket sender(Address(IPProtocol, Address::Any, 0));
+   Socket receiver(Address(IPProtocol, Address::Any, 0));
+   ASSERT_TRUE(sender.isValid() && receiver.isValid());
+
+   Address destination = getLoopbackAddress(receiver);
+
+   const S32 burst = Socket::MaxBatchSize;      // Small enough not to overflow the receive buffer
+   const S32 rounds = 10000 / burst;
+   const S32 packets = rounds * burst;
+
+   Vector<U8> data;
+   data.resize(burst * PacketSize);
+   Vector<Address> addresses;
+   Vector<const U8 *> buffers;
+   Vector<S32> sizes;
+
+   for(S32 i = 0; i < burst; i++)
+   {
+      fillPacket(&data[i * PacketSize], i, PacketSize);
+      addresses.push_back(destination);
+      buffers.push_back(&data[i * PacketSize]);
+      sizes.push_back(PacketSize);
+   }
+
+   Vector<U8> received;
+   received.resize(burst * MaxPacketDataSize);
+   Vector<Address> sources;
+   sources.resize(burst);
+   Vector<S32> receivedSizes;
+   receivedSizes.resize(burst);
+
+   // One at a time
+   S32 singleReceived = 0;
+   S64 start = Platform::getHighPrecisionTimerValue();
+
+   for(S32 round = 0; round < rounds; round++)
+   {
+      for(S32 i = 0; i < burst; i++)
+         sender.sendto(destination, buffers[i], sizes[i]);
+
+      Address source;
+      S32 size;
+      while(receiver.recvfrom(&source, received.address(), MaxPacketDataSize, &size) == NoError)
+         singleReceived++;
+   }
+
+   F64 singleMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+   Socket::Stats singleSend = sender.getStats();
+   Socket::Stats singleRecv = receiver.getStats();
+
+   // A batch at a time
+   sender.resetStats();
+   receiver.resetStats();
+   S32 batchReceived = 0;
+   start = Platform::getHighPrecisionTimerValue();
+
+   for(S32 round = 0; round < rounds; round++)
+   {
+      sender.sendtoBatch(addresses.address(), buffers.address(), sizes.address(), burst);
+
+      S32 got;
+      do
+      {
+         got = receiver.recvfromBatch(sources.address(), received.address(), MaxPacketDataSize,
+                                      receivedSizes.address(), burst);
+         batchReceived += got;
+      } while(got == burst);
+   }
+
+   F64 batchMs = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+   Socket::Stats batchSend = sender.getStats();
+   Socket::Stats batchRecv = receiver.getStats();
+
+   logprintf("Socket batching, %d packets of %d bytes:", packets, PacketSize);
+   logprintf("  one at a time:  %d received, %u send calls, %u recv calls, %.2f us/packet",
+             singleReceived, singleSend.sendCalls, singleRecv.recvCalls, singleMs * 1000 / packets);
+   logprintf("  batched:        %d received, %u send calls, %u recv calls, %.2f us/packet",
+             batchReceived, batchSend.sendCalls, batchRecv.recvCalls, batchMs * 1000 / packets);
+
+   // Loopback shouldn't drop anything at this rate
+   EXPECT_EQ(packets, singleReceived);
+   EXPECT_EQ(packets, batchReceived);
+   EXPECT_LE(batchSend.sendCalls, singleSend.sendCalls);
+}
+
+
+};
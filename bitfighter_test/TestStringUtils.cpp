@@ -123,6 +123,22 @@ static void wouldOneMoreWordMakeTheLineTooLong(const Vector<string> &lines, S32
 }
 
 
+TEST(StringUtilsTest, writeFileAtomically)
+{
+   const string path = "TestStringUtils.tmpfile";
+
+   EXPECT_TRUE(writeFileAtomically(path, "first"));
+   EXPECT_TRUE(writeFileAtomically(path, "second"));     // Replaces an existing file
+
+   string contents;
+   EXPECT_TRUE(readFile(path, contents));
+   EXPECT_EQ("second", contents);
+   EXPECT_FALSE(fileExists(path + ".tmp"));
+
+   remove(path.c_str());
+}
+
+
 TEST(StringUtilsTest, ParseStringTests)
 {
    Vector<string> words;
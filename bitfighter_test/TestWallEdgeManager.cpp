@@ -0,0 +1,257 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "WallEdgeManager.h"
+
+#include "EngineeredItem.h"
+#include "Level.h"
+#include "WallItem.h"
+
+#include "LevelFilesForTesting.h"
+
+#include "stringUtils.h"
+
+#include "tnlNetBase.h"
+
+#include "gtest/gtest.h"
+
+namespace Zap
+{
+
+using namespace TNL;
+
+
+// Coordinates in current-format levels aren't scaled by the grid size
+static string getHeader()
+{
+   return "LevelFormat 2\n" + getGenericHeader();
+}
+
+
+// Some crossing and touching walls, and some items mounted on them
+static string getWallTestLevelCode()
+{
+   return getHeader() +
+      "BarrierMaker 40 -500 -500 500 -500 500 500 -500 500 -500 -500\n"
+      "BarrierMaker 20 -200 -100 200 -100\n"
+      "BarrierMaker 20 0 -300 0 100\n"
+      "BarrierMaker 20 300 200 400 300\n"
+      "BarrierMaker 20 -400 300 -300 300\n"
+      "Turret 0 -100 -90\n"
+      "Turret 0 350 240\n"
+      "ForceFieldProjector 0 -350 310\n"
+      "ForceFieldProjector 0 -450 0\n";
+}
+
+
+// A grid of short walls, with a turret on each
+static string getLargeLevelCode(S32 gridSize)
+{
+   string code = getHeader();
+
+   for(S32 x = 0; x < gridSize; x++)
+      for(S32 y = 0; y < gridSize; y++)
+      {
+         S32 left = x * 200;
+         S32 top = y * 200;
+         code += "BarrierMaker 20 " + itos(left) + " " + itos(top) + " " + itos(left + 100) + " " + itos(top + 50) + "\n";
+         code += "Turret 0 " + itos(left + 50) + " " + itos(top + 30) + "\n";
+      }
+
+   return code;
+}
+
+
+static WallItem *getWall(Level *level, S32 index)
+{
+   return static_cast<WallItem *>(level->findObjects_fast(WallItemTypeNumber)->get(index));
+}
+
+
+static Vector<Point> getItemPositions(Level *level)
+{
+   Vector<DatabaseObject *> items;
+   level->findObjects((TestFunc)isEngineeredType, items);
+
+   Vector<Point> positions;
+   for(S32 i = 0; i < items.size(); i++)
+      positions.push_back(static_cast<EngineeredItem *>(items[i])->getPos());
+
+   return positions;
+}
+
+
+static S32 QSORT_CALLBACK edgeSort(pair<Point, Point> *a, pair<Point, Point> *b)
+{
+   if(a->first.x != b->first.x)   return a->first.x < b->first.x ? -1 : 1;
+   if(a->first.y != b->first.y)   return a->first.y < b->first.y ? -1 : 1;
+   if(a->second.x != b->second.x) return a->second.x < b->second.x ? -1 : 1;
+   if(a->second.y != b->second.y) return a->second.y < b->second.y ? -1 : 1;
+   return 0;
+}
+
+
+// Edges in wallEdgePoints, each with its endpoints in a consistent order, sorted so lists can be compared
+static Vector<pair<Point, Point> > getSortedEdges(const Vector<Point> &wallEdgePoints)
+{
+   Vector<pair<Point, Point> > edges;
+
+   for(S32 i = 0; i < wallEdgePoints.size(); i += 2)
+   {
+      Point p1 = wallEdgePoints[i];
+      Point p2 = wallEdgePoints[i + 1];
+
+      if(p2.x < p1.x || (p2.x == p1.x && p2.y < p1.y))
+         edges.push_back(pair<Point, Point>(p2, p1));
+      else
+         edges.push_back(pair<Point, Point>(p1, p2));
+   }
+
+   edges.sort(edgeSort);
+   return edges;
+}
+
+
+// Updates the level's edges incrementally, then checks that rebuilding everything from scratch gives the same edges
+// and puts the engineered items in the same places
+static void checkUpdateMatchesFullRebuild(Level *level)
+{
+   Vector<Point> updatedEdgePoints;
+   level->updateWallEdgeGeometry(updatedEdgePoints);
+   Vector<Point> updatedPositions = getItemPositions(level);
+
+   Vector<Point> rebuiltEdgePoints;
+   level->buildWallEdgeGeometry(rebuiltEdgePoints);
+   level->snapAllEngineeredItems(false);
+   Vector<Point> rebuiltPositions = getItemPositions(level);
+
+   Vector<pair<Point, Point> > updatedEdges = getSortedEdges(updatedEdgePoints);
+   Vector<pair<Point, Point> > rebuiltEdges = getSortedEdges(rebuiltEdgePoints);
+
+   ASSERT_GT(rebuiltEdges.size(), 0);
+   ASSERT_EQ(rebuiltEdges.size(), updatedEdges.size());
+
+   for(S32 i = 0; i < rebuiltEdges.size(); i++)
+   {
+      EXPECT_NEAR(rebuiltEdges[i].first.x,  updatedEdges[i].first.x,  0.01) << "Edge " << i;
+      EXPECT_NEAR(rebuiltEdges[i].first.y,  updatedEdges[i].first.y,  0.01) << "Edge " << i;
+      EXPECT_NEAR(rebuiltEdges[i].second.x, updatedEdges[i].second.x, 0.01) << "Edge " << i;
+      EXPECT_NEAR(rebuiltEdges[i].second.y, updatedEdges[i].second.y, 0.01) << "Edge " << i;
+   }
+
+   ASSERT_EQ(rebuiltPositions.size(), updatedPositions.size());
+
+   for(S32 i = 0; i < rebuiltPositions.size(); i++)
+   {
+      EXPECT_NEAR(rebuiltPositions[i].x, updatedPositions[i].x, 0.1) << "Item " << i;
+      EXPECT_NEAR(rebuiltPositions[i].y, updatedPositions[i].y, 0.1) << "Item " << i;
+   }
+}
+
+
+class WallEdgeManagerTest : public testing::Test
+{
+protected:
+   void SetUp()
+   {
+      NetClassRep::initialize();    // Normally done when the game creates its NetInterface
+   }
+};
+
+
+TEST_F(WallEdgeManagerTest, MovedWallsMatchFullRebuild)
+{
+   Level level(getWallTestLevelCode());
+
+   // Move the wall the first turret is mounted on, so it no longer crosses the other one
+   WallItem *wall = getWall(&level, 1);
+   wall->setVert(Point(-200, -200), 0);
+   wall->setVert(Point(-100, -200), 1);
+   wall->onGeomChanged();
+
+   checkUpdateMatchesFullRebuild(&level);
+
+   // Move it right onto the outer wall
+   wall->setVert(Point(-510, 0), 0);
+   wall->setVert(Point(-300, 0), 1);
+   wall->onGeomChanged();
+
+   checkUpdateMatchesFullRebuild(&level);
+
+   // Drag a single vertex into the beam of a forcefield
+   wall = getWall(&level, 4);
+   wall->setVert(Point(-350, 400), 1);
+   wall->onGeomChanged();
+
+   checkUpdateMatchesFullRebuild(&level);
+}
+
+
+TEST_F(WallEdgeManagerTest, AddedAndRemovedWallsMatchFullRebuild)
+{
+   Level level(getWallTestLevelCode());
+
+   WallItem *wall = new WallItem();
+   wall->addVert(Point(250, 150));
+   wall->addVert(Point(450, 150));
+   wall->addVert(Point(450, 350));
+   level.addWallItem(wall);
+
+   checkUpdateMatchesFullRebuild(&level);
+
+   level.removeFromDatabase(getWall(&level, 2), true);
+
+   checkUpdateMatchesFullRebuild(&level);
+
+   // Nothing changed
+   checkUpdateMatchesFullRebuild(&level);
+}
+
+
+TEST_F(WallEdgeManagerTest, DistantEdgesAreLeftAlone)
+{
+   Level level(getLargeLevelCode(5));
+
+   Vector<Point> wallEdgePoints;
+   level.updateWallEdgeGeometry(wallEdgePoints);
+
+   // Edges and items at the far corner from the wall we'll be moving
+   Rect farCorner(Point(700, 700), Point(900, 900));
+
+   Vector<DatabaseObject *> farEdges;
+   level.getWallEdgeDatabase()->findObjects(WallEdgeTypeNumber, farEdges, farCorner);
+   ASSERT_GT(farEdges.size(), 0);
+
+   Vector<DatabaseObject *> farTurrets;
+   level.findObjects(TurretTypeNumber, farTurrets, farCorner);
+   ASSERT_EQ(1, farTurrets.size());
+
+   // Knock it off its wall; only a full rebuild would put it back
+   Turret *farTurret = static_cast<Turret *>(farTurrets[0]);
+   Point farTurretPos = farTurret->getPos();
+   farTurret->setPos(farTurretPos + Point(0, 10));
+
+   WallItem *wall = getWall(&level, 0);
+   wall->setVert(Point(20, 80), 1);
+   wall->onGeomChanged();
+
+   level.updateWallEdgeGeometry(wallEdgePoints);
+
+   Vector<DatabaseObject *> stillThere;
+   level.getWallEdgeDatabase()->findObjects(WallEdgeTypeNumber, stillThere, farCorner);
+   ASSERT_EQ(farEdges.size(), stillThere.size());
+
+   for(S32 i = 0; i < farEdges.size(); i++)
+      EXPECT_TRUE(stillThere.contains(farEdges[i]));
+
+   EXPECT_EQ(farTurretPos + Point(0, 10), farTurret->getPos());
+
+   // Everything else is just as a full rebuild would have it
+   farTurret->setPos(farTurretPos);
+   checkUpdateMatchesFullRebuild(&level);
+}
+
+
+};
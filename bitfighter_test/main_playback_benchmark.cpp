@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+// Bitfighter playback benchmark -- plays recorded games through the client as fast as it can, with no window, sound,
+// or waiting, and reports what that cost.
+//
+// Usage: bitfighter_playback_benchmark [-tick <ms>] <recording> [<recording> ...]
+
+#include "ClientGame.h"
+#include "DisplayManager.h"
+#include "FontManager.h"
+#include "GameManager.h"
+#include "GameSettings.h"
+#include "InputCode.h"
+#include "PlaybackBenchmark.h"
+#include "RenderManager.h"
+#include "UIManager.h"
+
+#include "tnlLog.h"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if __cplusplus >= 201103L
+#  define THROWS_BAD_ALLOC
+#  define THROWS_NOTHING noexcept
+#else
+#  define THROWS_BAD_ALLOC throw(std::bad_alloc)
+#  define THROWS_NOTHING throw()
+#endif
+
+namespace Zap
+{
+void exitToOs()            { TNLAssert(false, "Should never be called!"); }
+void exitToOs(S32 errcode) { TNLAssert(false, "Should never be called!"); }
+}
+
+using namespace Zap;
+
+
+// Every allocation goes through here, so we can say how many each playback made
+static U64 allocationCount = 0;
+
+static void *allocate(size_t size)
+{
+   allocationCount++;
+
+   void *ptr = malloc(size ? size : 1);
+   if(!ptr)
+      throw std::bad_alloc();
+
+   return ptr;
+}
+
+void *operator new(size_t size) THROWS_BAD_ALLOC   { return allocate(size); }
+void *operator new[](size_t size) THROWS_BAD_ALLOC { return allocate(size); }
+void operator delete(void *ptr) THROWS_NOTHING     { free(ptr); }
+void operator delete[](void *ptr) THROWS_NOTHING   { free(ptr); }
+
+
+static void printUsage()
+{
+   printf("Usage: bitfighter_playback_benchmark [-tick <ms>] <recording> [<recording> ...]\n");
+   printf("Plays each recorded game through the client with nothing rendered, and reports how long it took.\n");
+   printf("  -tick <ms>   Game time per client tick (default %d)\n", PlaybackBenchmark::DefaultTickLength);
+}
+
+
+int main(int argc, char **argv)
+{
+   U32 tickLength = PlaybackBenchmark::DefaultTickLength;
+   Vector<string> filenames;
+
+   for(S32 i = 1; i < argc; i++)
+   {
+      if(!strcmp(argv[i], "-tick") && i + 1 < argc)
+         tickLength = atoi(argv[++i]);
+      else if(argv[i][0] == '-')
+      {
+         printUsage();
+         return 1;
+      }
+      else
+         filenames.push_back(argv[i]);
+   }
+
+   if(filenames.size() == 0 || tickLength == 0)
+   {
+      printUsage();
+      return 1;
+   }
+
+   StdoutLogConsumer stdoutLog;
+   stdoutLog.setMsgTypes(LogConsumer::AllErrorTypes);
+
+   // What the client needs that doesn't involve a window
+   InputCodeManager::initializeKeyNames();
+   RenderManager::init();
+   GameSettings settings;
+   FontManager::initialize(&settings, false);
+   GameManager::initialize();
+   DisplayManager::initialize();
+
+   S32 failures = 0;
+
+   for(S32 i = 0; i < filenames.size(); i++)
+   {
+      // A fresh game for each recording, so one can't leave anything behind for the next
+      Address addr;
+      ClientGame *game = new ClientGame(addr, GameSettingsPtr(new GameSettings()), new UIManager());
+      game->getClientInfo()->setName("PlaybackBenchmark");      // The playback connection wants a player name
+
+      PlaybackBenchmark benchmark(game, tickLength);
+      benchmark.setAllocationCounter(&allocationCount);
+
+      PlaybackBenchmarkResults results;
+
+      if(benchmark.run(filenames[i], results))
+         results.log();
+      else
+      {
+         logprintf(LogConsumer::LogError, "Could not play %s -- missing, or recorded by another version",
+                   filenames[i].c_str());
+         failures++;
+      }
+
+      delete game;
+   }
+
+   FontManager::cleanup();
+   DisplayManager::cleanup();
+
+   return failures == 0 ? 0 : 1;
+}
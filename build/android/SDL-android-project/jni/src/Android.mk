@@ -85,6 +85,7 @@ $(ZAP_PATH)/SlipZone.cpp \
 $(ZAP_PATH)/soccerGame.cpp \
 $(ZAP_PATH)/SoundEffect.cpp \
 $(ZAP_PATH)/SoundSystem.cpp \
+$(ZAP_PATH)/SpatialIndex.cpp \
 $(ZAP_PATH)/Spawn.cpp \
 $(ZAP_PATH)/speedZone.cpp \
 $(ZAP_PATH)/statistics.cpp \
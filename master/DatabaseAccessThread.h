@@ -22,102 +22,179 @@ public:
    virtual void finish() {};  // finishes the entry on primary thread after "run()" is done to avoid 2 threads crashing in to the same network TNL and others.
 };
 
-class DatabaseAccessThread : public TNL::Thread
+
+// Runs ThreadEntries on a pool of worker threads.  addEntry() and idle() must be called from the primary thread;
+// with more than one worker, entries may run, and be finished, in a different order than they were added.
+//
+// The queue is unbounded -- we'd rather fall behind than lose stats -- but we complain when it gets long.
+class DatabaseAccessThread
 {
 private:
-   U32 mEntryStart;
-   U32 mEntryThread;
-   U32 mEntryEnd;
-
+   class WorkerThread : public TNL::Thread
+   {
+      DatabaseAccessThread *mOwner;
+
+   public:
+      WorkerThread(DatabaseAccessThread *owner) { mOwner = owner; }    // Constructor
+      U32 run() { mOwner->runWorker(); return 0; }
+   };
+
+   U32 mThreadCount;
+   Vector<RefPtr<WorkerThread> > mThreads;      // Started when the first entry is added
+
+   // Entries are referenced with raw pointers here, so that only the primary thread touches their reference counts;
+   // addEntry() adds a reference, and idle() releases it
+   Mutex mLock;                           // Protects everything below
+   Semaphore mWorkAvailable;              // Incremented once per queued entry, and once per worker when terminating
+   Vector<ThreadEntry *> mQueue;          // Entries waiting to run; mQueue[mQueueHead] is next
+   S32 mQueueHead;
+   Vector<ThreadEntry *> mFinished;       // Entries that have run, waiting for idle() to call finish()
+   Semaphore mWorkerExited;               // Incremented by each worker as the last thing it does
    bool mRunning;
-   bool mThreadActive;
+   bool mOverloadReported;
+
+   void runWorker()
+   {
+      threadStart();
+
+      while(true)
+      {
+         mWorkAvailable.wait();
+
+         mLock.lock();
 
-   static const U32 mEntrySize = 128;
+         if(mQueueHead == mQueue.size())     // Nothing queued means we're being terminated
+         {
+            mLock.unlock();
+            break;
+         }
 
-   RefPtr<ThreadEntry> mEntry[mEntrySize];
+         ThreadEntry *entry = mQueue[mQueueHead];
+         mQueueHead++;
+
+         if(mQueueHead == mQueue.size())
+         {
+            mQueue.clear();
+            mQueueHead = 0;
+         }
+
+         mLock.unlock();
+
+         entry->run();
+
+         mLock.lock();
+         mFinished.push_back(entry);
+         mLock.unlock();
+      }
+
+      threadEnd();
+
+      mWorkerExited.increment();
+   }
+
+protected:
+   // Called on each worker thread when it starts, and just before it exits, for per-thread setup such as opening
+   // database connections.  Subclasses overriding these must call terminate() from their own destructors.
+   virtual void threadStart() { }
+   virtual void threadEnd() { }
 
 public:
-   DatabaseAccessThread() // Constructor
+   static const S32 QueueWarningSize = 1000;
+
+   DatabaseAccessThread(U32 threadCount = 1) : mWorkAvailable(0, S32_MAX), mWorkerExited(0, S32_MAX)   // Constructor
    {
-      mEntryStart = 0;
-      mEntryThread = 0;
-      mEntryEnd = 0;
+      mThreadCount = threadCount > 0 ? threadCount : 1;
+      mQueueHead = 0;
 
       mRunning = true;
-      mThreadActive = false;
+      mOverloadReported = false;
    }
 
 
    void addEntry(ThreadEntry *entry)
    {
-      U32 entryEnd = mEntryEnd + 1;
+      if(!mRunning)
+         return;
 
-      if(entryEnd >= mEntrySize)
-         entryEnd = 0;
+      entry->incRef();
 
-      if(entryEnd == mEntryStart)      // Too many entries
+      mLock.lock();
+
+      mQueue.push_back(entry);
+      S32 queueSize = mQueue.size() - mQueueHead;
+
+      if(mThreads.size() == 0)
       {
-         logprintf(LogConsumer::LogError, "Database thread overloaded - database access too slow?");
-         return;
+         for(U32 i = 0; i < mThreadCount; i++)
+         {
+            mThreads.push_back(new WorkerThread(this));
+            if(!mThreads.last()->start())
+               mThreads.erase(mThreads.size() - 1);     // terminate() would wait forever for it
+         }
       }
 
-      mEntry[mEntryEnd] = entry;
-      mEntryEnd = entryEnd;
-      if(!mThreadActive)
+      mLock.unlock();
+
+      if(queueSize >= QueueWarningSize && !mOverloadReported)
       {
-         mThreadActive = true;
-         start();
+         logprintf(LogConsumer::LogWarning, "Database queue has %d entries waiting - database access too slow?", queueSize);
+         mOverloadReported = true;
       }
+      else if(queueSize < QueueWarningSize / 2)
+         mOverloadReported = false;
+
+      mWorkAvailable.increment();
    }
 
 
-   U32 run()
+   void idle()
    {
-      mThreadActive = true;
-      while(mRunning)
+      mLock.lock();
+      Vector<ThreadEntry *> finished = mFinished;
+      mFinished.clear();
+      mLock.unlock();
+
+      for(S32 i = 0; i < finished.size(); i++)
       {
-         if(mEntryThread != mEntryEnd)
-         {
-            mEntry[mEntryThread]->run();
-            mEntryThread++;
-            if(mEntryThread >= mEntrySize)
-               mEntryThread = 0;
-         }
-         else
-            Platform::sleep(50);
+         finished[i]->finish();
+         finished[i]->decRef();
       }
-
-      mThreadActive = false;
-
-      return 0;
    }
 
 
-   void idle()
+   S32 getQueueSize()
    {
-      while(mEntryStart != mEntryThread)
-      {
-         mEntry[mEntryStart]->finish();
-         mEntry[mEntryStart].set(NULL);  // RefPtr, we can just set to NULL and it will delete itself
-         mEntryStart++;
+      mLock.lock();
+      S32 size = mQueue.size() - mQueueHead;
+      mLock.unlock();
 
-         if(mEntryStart >= mEntrySize)
-            mEntryStart = 0;
-      }
+      return size;
    }
 
+
+   // Lets the workers run everything already queued, then shuts them down
    void terminate()
    {
+      if(!mRunning)
+         return;
+
       mRunning = false;
-      while(mThreadActive)
-         Platform::sleep(50);
+      mWorkAvailable.increment(mThreads.size());
+
+      // TNL threads are detached, so there's nothing to join; each worker signals on its way out instead
+      for(S32 i = 0; i < mThreads.size(); i++)
+         mWorkerExited.wait();
    }
 
-   ~DatabaseAccessThread()
+
+   virtual ~DatabaseAccessThread()    // Destructor
    {
       terminate();
-   }
 
+      // Entries that ran but were never finished
+      for(S32 i = 0; i < mFinished.size(); i++)
+         mFinished[i]->decRef();
+   }
 };
 
 
@@ -70,6 +70,7 @@ MasterServerConnection::MasterServerConnection()
    mConnectionType = MasterConnectionTypeNone;
 
    mClientId = getNextId();
+   mMasterListIndex = -1;
 }
 
 
@@ -88,18 +89,12 @@ MasterServerConnection::~MasterServerConnection()
 
 
    // Remove this from the client/server lists
-   if(mConnectionType == MasterConnectionTypeClient)
-   {
-      S32 index = mMaster->getClientList()->getIndex(this);
-      if(index > -1)
-         mMaster->removeClient(index);
-
-   }
-   else if(mConnectionType == MasterConnectionTypeServer)
+   if(mMasterListIndex != -1)
    {
-      S32 index = mMaster->getServerList()->getIndex(this);
-      if(index > -1)
-         mMaster->removeServer (index);
+      if(mConnectionType == MasterConnectionTypeClient)
+         mMaster->removeClient(this);
+      else if(mConnectionType == MasterConnectionTypeServer)
+         mMaster->removeServer(this);
    }
 
    if(mLoggingStatus != "")
@@ -281,7 +276,9 @@ void MasterServerConnection::processAutentication(StringTableEntry newName, PHPB
                }
             }
          }
+         StringTableEntry oldName = mPlayerOrServerName;
          mPlayerOrServerName = newName;
+         mMaster->onClientRenamed(this, oldName);
       }
 
       mBadges = badges;
@@ -337,51 +334,17 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mQueryHostServers, (U32 que
 
 void MasterServerConnection::c2mQueryServersOption(U32 queryId, bool hostonly)
 {
-   Vector<IPAddress> addresses(IP_MESSAGE_ADDRESS_COUNT);
-   Vector<S32> serverIdList(IP_MESSAGE_ADDRESS_COUNT);
-   
-
-   const Vector<MasterServerConnection *> *serverList = mMaster->getServerList();
-
-   for(S32 i = 0; i < serverList->size(); i++)
-   {
-      // Hide hidden servers
-      if(serverList->get(i)->mIsIgnoredFromList)  
-         continue;
-
-      // Skip servers with incompatible versions
-      if(serverList->get(i)->mCSProtocolVersion != mCSProtocolVersion)  
-         continue;
+   // Packets were put together when the server list last changed; every client using the same protocol shares them
+   const ServerListChunks &chunks = mMaster->getServerListChunks(mCSProtocolVersion, hostonly);
 
-      // Skip servers with host mode
-      if(((serverList->get(i)->mInfoFlags & HostModeFlag) != 0) != hostonly)
-         continue;
-
-      // Add us to the results list
-      addresses.push_back(serverList->get(i)->getNetAddress().toIPAddress());
-      serverIdList.push_back(serverList->get(i)->getClientId());
+   for(S32 i = 0; i < chunks.addresses.size(); i++)
+      sendM2cQueryServersResponse(queryId, chunks.addresses[i], chunks.serverIds[i]);
 
-      // If we get a packet's worth, send it to the client and empty our buffer...
-      if(addresses.size() == IP_MESSAGE_ADDRESS_COUNT)
-      {
-         sendM2cQueryServersResponse(queryId, addresses, serverIdList);
-         
-         addresses.clear();
-         serverIdList.clear();
-      }
-   }
-
-   // Send the final packet
-   sendM2cQueryServersResponse(queryId, addresses, serverIdList);
-
-   // If we sent any with the previous message, send another list with no servers
-   if(addresses.size())
-   {
-      addresses.clear();
-      serverIdList.clear();
+   // A final empty list tells the client we're done
+   static const Vector<IPAddress> noAddresses;
+   static const Vector<S32> noServerIds;
 
-      sendM2cQueryServersResponse(queryId, addresses, serverIdList);
-   }
+   sendM2cQueryServersResponse(queryId, noAddresses, noServerIds);
 }
 
 
@@ -478,18 +441,9 @@ GameConnectRequest *MasterServerConnection::findAndRemoveRequest(U32 requestId)
 }
 
 
-MasterServerConnection *MasterServerConnection::findClient(Nonce &clientId)   // Should be const, but that won't compile for reasons not yet determined!!
+MasterServerConnection *MasterServerConnection::findClient(const Nonce &clientId) const
 {
-   if(!clientId.isValid())
-      return NULL;
-
-   const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
-
-   for(S32 i = 0; i < clientList->size(); i++)
-      if(clientList->get(i)->mPlayerId == clientId)
-         return clientList->get(i);
-
-   return NULL;
+   return mMaster->findClientByPlayerId(clientId);
 }
 
 
@@ -515,71 +469,82 @@ void MasterServerConnection::writeClientServerList_JSON()
    if(jsonfile == "")
       return;
 
+   // Build the whole thing in memory, then swap it in so the web side never sees a half-written file
+   static string json;     // Kept between calls so its buffer is already big enough
+   json.clear();
+
    bool first = true;
    S32 playerCount = 0;
    S32 serverCount = 0;
 
-   FILE *f = fopen(jsonfile.c_str(), "w");
-   if(f)
-   {
-      // First the servers
-      fprintf(f, "{\n\t\"servers\": [");
+   // First the servers
+   json += "{\n\t\"servers\": [";
 
-      const Vector<MasterServerConnection *> *serverList = mMaster->getServerList();
+   const Vector<MasterServerConnection *> *serverList = mMaster->getServerList();
 
-      for(S32 i = 0; i < serverList->size(); i++)
-      {
-         MasterServerConnection *server = serverList->get(i);
+   for(S32 i = 0; i < serverList->size(); i++)
+   {
+      MasterServerConnection *server = serverList->get(i);
 
-         if(server->mIsIgnoredFromList)
-            continue;
+      if(server->mIsIgnoredFromList)
+         continue;
 
-         fprintf(f, "%s\n\t\t{\n\t\t\t\"serverName\": \"%s\",\n\t\t\t\"protocolVersion\": %d,\n\t\t\t\"currentLevelName\": \"%s\",\n\t\t\t\"currentLevelType\": \"%s\",\n\t\t\t\"playerCount\": %d\n\t\t}",
-                     first ? "" : ", ", sanitizeForJson(server->mPlayerOrServerName.getString()).c_str(),
-                     server->mCSProtocolVersion, server->mLevelName.getString(), server->mLevelType.getString(), server->mPlayerCount);
-         playerCount += server->mPlayerCount;
-         serverCount++;
-         first = false;
-      }
+      json += first ? "\n\t\t{\n\t\t\t\"serverName\": \"" : ", \n\t\t{\n\t\t\t\"serverName\": \"";
+      json += sanitizeForJson(server->mPlayerOrServerName.getString());
+      json += "\",\n\t\t\t\"protocolVersion\": ";
+      json += itos(server->mCSProtocolVersion);
+      json += ",\n\t\t\t\"currentLevelName\": \"";
+      json += server->mLevelName.getString();
+      json += "\",\n\t\t\t\"currentLevelType\": \"";
+      json += server->mLevelType.getString();
+      json += "\",\n\t\t\t\"playerCount\": ";
+      json += itos(server->mPlayerCount);
+      json += "\n\t\t}";
+
+      playerCount += server->mPlayerCount;
+      serverCount++;
+      first = false;
+   }
 
-      // Next the player names      // "players": [ "chris", "colin", "fred", "george", "Peter99" ],
-      fprintf(f, "\n\t],\n\t\"players\": [");
-      first = true;
+   // Next the player names      // "players": [ "chris", "colin", "fred", "george", "Peter99" ],
+   json += "\n\t],\n\t\"players\": [";
+   first = true;
 
-      const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
+   const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
 
-      for(S32 i = 0; i < clientList->size(); i++)
+   for(S32 i = 0; i < clientList->size(); i++)
+   {
+      if(listClient(clientList->get(i)))
       {
-         if(listClient(clientList->get(i)))
-         {
-            fprintf(f, "%s\"%s\"", first ? "" : ", ", sanitizeForJson(clientList->get(i)->mPlayerOrServerName.getString()).c_str());
-            first = false;
-         }
+         json += first ? "\"" : ", \"";
+         json += sanitizeForJson(clientList->get(i)->mPlayerOrServerName.getString());
+         json += "\"";
+         first = false;
       }
+   }
 
-      // Authentication status      // "authenticated": [ true, false, false, true, true ],
-      fprintf(f, "],\n\t\"authenticated\": [");
-      first = true;
+   // Authentication status      // "authenticated": [ true, false, false, true, true ],
+   json += "],\n\t\"authenticated\": [";
+   first = true;
 
-      for(S32 i = 0; i < clientList->size(); i++)
+   for(S32 i = 0; i < clientList->size(); i++)
+   {
+      if(listClient(clientList->get(i)))
       {
-         if(listClient(clientList->get(i)))
-         {
-            fprintf(f, "%s%s", first ? "" : ", ", clientList->get(i)->mAuthenticated ? "true" : "false");
-            first = false;
-         }
+         if(!first)
+            json += ", ";
+         json += clientList->get(i)->mAuthenticated ? "true" : "false";
+         first = false;
       }
+   }
 
-      // Finally, the player and server counts
-      fprintf(f, "],\n\t\"serverCount\": %d,\n\t\"playerCount\": %d,\n", serverCount, playerCount);
+   // Finally, the player and server counts
+   json += "],\n\t\"serverCount\": " + itos(serverCount) + ",\n\t\"playerCount\": " + itos(playerCount) + ",\n";
 
-      // And the message-of-the-day
-      fprintf(f, "\t\"motd\": \"%s\"\n}\n", sanitizeForJson(mMaster->getSettings()->getMotd().c_str()).c_str());
+   // And the message-of-the-day
+   json += "\t\"motd\": \"" + sanitizeForJson(mMaster->getSettings()->getMotd().c_str()) + "\"\n}\n";
 
-      fflush(f);
-      fclose(f);
-   }
-   else
+   if(!writeFileAtomically(jsonfile, json))
       logprintf(LogConsumer::LogError, "Could not write to JSON file \"%s\"", jsonfile.c_str());
 }
 
@@ -752,6 +717,8 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, s2mUpdateServerStatus, (Strin
       mMaxPlayers  = maxPlayers;
       mInfoFlags   = infoFlags;
 
+      mMaster->onServerListChanged();     // Host mode may have changed
+
       // Check to ensure we're not getting flooded with these requests
       checkActivityTime(FOUR_SECONDS);
 
@@ -1240,12 +1207,13 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, s2mAcheivementAchieved, (U8 a
 
    GameJolt::onPlayerAwardedAchievement(mMaster->getSettings(), playerNick.getString(), achievementId);
 
-   const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
+   Vector<MasterServerConnection *> clients;
+   mMaster->findClientsByName(playerNick.getString(), clients);
 
-   for(S32 i = 0; i < clientList->size(); i++)
-      if(clientList->get(i)->mPlayerOrServerName == playerNick)
+   for(S32 i = 0; i < clients.size(); i++)
+      if(clients[i]->mPlayerOrServerName == playerNick)
       {
-         clientList->get(i)->mBadges = mBadges | BIT(achievementId); // Add to local variable without needing to reload from database
+         clients[i]->mBadges = mBadges | BIT(achievementId); // Add to local variable without needing to reload from database
          break;
       }
 }
@@ -1446,33 +1414,27 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, s2mRequestAuthentication, (Ve
 {
    Nonce clientId(id);     // Reconstitute our id
 
-   const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
+   MasterServerConnection *client = findClient(clientId);
+   if(!client)
+      return;
 
-   for(S32 i = 0; i < clientList->size(); i++)
-   {
-      MasterServerConnection *client = clientList->get(i);
-      if(client->mPlayerId == clientId)
-      {
-         AuthenticationStatus status;
+   AuthenticationStatus status;
 
-         // Need case insensitive comparison here
-         if(!stricmp(name.getString(), client->mPlayerOrServerName.getString()) && client->isAuthenticated())
-            status = AuthenticationStatusAuthenticatedName;
+   // Need case insensitive comparison here
+   if(!stricmp(name.getString(), client->mPlayerOrServerName.getString()) && client->isAuthenticated())
+      status = AuthenticationStatusAuthenticatedName;
 
-         // If server just restarted, clients will need to reauthenticate, and that may take some time.
-         // We'll give them 90 seconds.
-         else if(Platform::getRealMilliseconds() - mMaster->getStartTime() < 90 * 1000)
-            status = AuthenticationStatusTryAgainLater;
-         else
-            status = AuthenticationStatusUnauthenticatedName;
+   // If server just restarted, clients will need to reauthenticate, and that may take some time.
+   // We'll give them 90 seconds.
+   else if(Platform::getRealMilliseconds() - mMaster->getStartTime() < 90 * 1000)
+      status = AuthenticationStatusTryAgainLater;
+   else
+      status = AuthenticationStatusUnauthenticatedName;
 
-         if(mCMProtocolVersion <= 6)      // 018a ==> 6, 019 ==> 7
-            m2sSetAuthenticated(id, client->mPlayerOrServerName, status, client->getBadges());
-         else
-            m2sSetAuthenticated_019(id, client->mPlayerOrServerName, status, client->getBadges(), client->getGamesPlayed());
-         break;
-      }
-   }
+   if(mCMProtocolVersion <= 6)      // 018a ==> 6, 019 ==> 7
+      m2sSetAuthenticated(id, client->mPlayerOrServerName, status, client->getBadges());
+   else
+      m2sSetAuthenticated_019(id, client->mPlayerOrServerName, status, client->getBadges(), client->getGamesPlayed());
 }
 
 
@@ -1592,21 +1554,20 @@ bool MasterServerConnection::readConnectRequest(BitStream *bstream, NetConnectio
 
          mPlayerId.read(bstream);
 
-         // Probably redundant, but let's cycle through all our clients and make sure the playerId is unique.
+         // Probably redundant, but let's make sure the playerId is unique.
          // With 2^64 possibilities, it most likely will be.
-         const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
+         MasterServerConnection *duplicate = findClient(mPlayerId);
 
-         for(S32 i = 0; i < clientList->size(); i++)
-            if(clientList->get(i) != this && clientList->get(i)->mPlayerId == mPlayerId)
-            {
-               logprintf(LogConsumer::LogConnection, "User %s provided duplicate id to %s", mPlayerOrServerName.getString(),
-                                                     clientList->get(i)->mPlayerOrServerName.getString());
-               disconnect(ReasonDuplicateId, "");
-               reason = ReasonDuplicateId;
+         if(duplicate && duplicate != this)
+         {
+            logprintf(LogConsumer::LogConnection, "User %s provided duplicate id to %s", mPlayerOrServerName.getString(),
+                                                  duplicate->mPlayerOrServerName.getString());
+            disconnect(ReasonDuplicateId, "");
+            reason = ReasonDuplicateId;
 
-               mLoggingStatus = "Duplicate ID";
-               return false;
-            }
+            mLoggingStatus = "Duplicate ID";
+            return false;
+         }
 
          // Start the authentication by reading database on seperate thread
          // On clients 017 and older, they completely ignore any disconnect reason once fully connected,
@@ -1790,6 +1751,9 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSendChat, (StringPtr messa
                }
             }
 
+            if(droppedServer)
+               mMaster->onServerListChanged();
+
             if(!droppedServer)
                m2cSendChat(mPlayerOrServerName, true, "dropserver: address not found");
          }
@@ -1806,17 +1770,20 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSendChat, (StringPtr messa
                   serverList->get(i)->mIsIgnoredFromList = false;
                   m2cSendChat(serverList->get(i)->mPlayerOrServerName, true, "servers restored");
                }
-            if(!broughtBackServer)
+            if(broughtBackServer)
+               mMaster->onServerListChanged();
+            else
                m2cSendChat(mPlayerOrServerName, true, "No server was hidden");
          }
          else if(command == "hideplayer")
          {
             bool found = false;
-            const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
+            Vector<MasterServerConnection *> clients;
+            mMaster->findClientsByName(words[1], clients);
 
-            for(S32 i = 0; i < clientList->size(); i++)
+            for(S32 i = 0; i < clients.size(); i++)
             {
-               MasterServerConnection *client = clientList->get(i);
+               MasterServerConnection *client = clients[i];
                if(strcmp(words[1].c_str(), client->mPlayerOrServerName.getString()) == 0)
                {
                   client->mIsIgnoredFromList = !client->mIsIgnoredFromList;
@@ -1883,16 +1850,11 @@ TNL_IMPLEMENT_RPC_OVERRIDE(MasterServerConnection, c2mSendChat, (StringPtr messa
          strippedMessage = findPointerOfArg(message, argCount);
 
          // Now relay the message and only send to client with the specified nick
-         const Vector<MasterServerConnection *> *clientList = mMaster->getClientList();
+         Vector<MasterServerConnection *> recipients;
+         mMaster->findClientsByName(pmRecipient, recipients);
 
-         for(S32 i = 0; i < clientList->size(); i++)
-         {
-            if(stricmp(clientList->get(i)->mPlayerOrServerName.getString(), pmRecipient.c_str()) == 0)
-            {
-               clientList->get(i)->m2cSendChat(mPlayerOrServerName, isPrivate, strippedMessage);
-               break;
-            }
-         }
+         if(recipients.size() > 0)
+            recipients[0]->m2cSendChat(mPlayerOrServerName, isPrivate, strippedMessage);
       }
       else
          badCommand = true;  // Don't relay bad commands as chat messages
@@ -152,6 +152,7 @@ public:
    Nonce mPlayerId;                             // (Hopefully) unique ID of this player
 
    S32 mClientId;                               // Guranteed unique ID assigned my master
+   S32 mMasterListIndex;                        // Our position in the master's client or server list, -1 if in neither
 
    bool mAuthenticated;                         // True if user was authenticated, false if not
    bool mIsDebugClient;                         // True if client is running from a debug build
@@ -224,7 +225,7 @@ public:
 
    S32 getClientId() const;
 
-   MasterServerConnection *findClient(Nonce &clientId);   // Should be const, but that won't compile for reasons not yet determined!!
+   MasterServerConnection *findClient(const Nonce &clientId) const;
 
 
    // Write a current count of clients/servers for display on a website, using JSON format
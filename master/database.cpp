@@ -8,6 +8,7 @@
 
 #include "tnlTypes.h"
 #include "tnlLog.h"
+#include "tnlThread.h"
 
 #include "../zap/stringUtils.h"            // For replaceString() and itos()
 #include "../zap/WeaponInfo.h"
@@ -28,6 +29,13 @@ namespace DbWriter
 {
 
 string DatabaseWriter::sqliteFile = "stats.db";
+Vector<ServerInfo> DatabaseWriter::cachedServers;
+
+// Each thread's open connection, a DbQuery *
+static ThreadStorage gThreadConnection;
+
+// Held while finding or creating a server record, so two threads can't both create the same server
+static Mutex gServerIdLock;
 
    
 // TODO: Should we be reusing these?
@@ -67,7 +75,7 @@ DatabaseWriter::DatabaseWriter(const char *db, const char *user, const char *pas
 // Sqlite Constructor
 DatabaseWriter::DatabaseWriter(const char *db)
 {
-   strncpy(mDb, db, sizeof(mDb) - 1);
+   initialize("", db, "", "");
 
    if(!fileExists(mDb))
       createStatsDatabase();
@@ -76,6 +84,11 @@ DatabaseWriter::DatabaseWriter(const char *db)
 
 void DatabaseWriter::initialize(const char *server, const char *db, const char *user, const char *password)
 {
+   memset(mServer,   0, sizeof(mServer));
+   memset(mDb,       0, sizeof(mDb));
+   memset(mUser,     0, sizeof(mUser));
+   memset(mPassword, 0, sizeof(mPassword));
+
    strncpy(mServer,   server,   sizeof(mServer)   - 1);   // was const char *, but problems when data in pointer dies.
    strncpy(mDb,       db,       sizeof(mDb)       - 1);
    strncpy(mUser,     user,     sizeof(mUser)     - 1);
@@ -96,64 +109,68 @@ void DatabaseWriter::initialize(const char *server, const char *db, const char *
 #endif
 
 
-static void insertStatsLoadout(const DbQuery &query, U64 playerId, const Vector<LoadoutStats> loadoutStats)
+static const char *InsertLoadoutSql = "INSERT INTO stats_player_loadout(stats_player_id, loadout) VALUES(?, ?);";
+
+static void insertStatsLoadout(DbQuery &query, U64 playerId, const Vector<LoadoutStats> &loadoutStats)
 {
-   for(S32 i = 0; i < loadoutStats.size(); i++)
-   {
-         string sql = "INSERT INTO stats_player_loadout(stats_player_id, loadout) "
-                       "VALUES(" + itos(playerId) + ", " + itos(loadoutStats[i].loadoutHash) + ");";
+   DbStatement *statement = query.prepare(InsertLoadoutSql);
 
-         query.runQuery(sql);
-   }
+   for(S32 i = 0; i < loadoutStats.size(); i++)
+      statement->bind(playerId).bind(loadoutStats[i].loadoutHash).execute();
 }
 
 
-static void insertStatsShots(const DbQuery &query, U64 playerId, const Vector<WeaponStats> weaponStats)
+static const char *InsertShotsSql = "INSERT INTO stats_player_shots(stats_player_id, weapon, shots, shots_struck) "
+                                    "VALUES(?, ?, ?, ?);";
+
+static void insertStatsShots(DbQuery &query, U64 playerId, const Vector<WeaponStats> &weaponStats)
 {
+   DbStatement *statement = query.prepare(InsertShotsSql);
+
    for(S32 i = 0; i < weaponStats.size(); i++)
    {
       if(weaponStats[i].shots > 0)
-      {
-         string sql = "INSERT INTO stats_player_shots(stats_player_id, weapon, shots, shots_struck) "
-                       "VALUES(" + itos(playerId) + ", '" + WeaponInfo::getWeaponName(weaponStats[i].weaponType) + "', " + 
-                                  itos(weaponStats[i].shots) + ", " + itos(weaponStats[i].hits) + ");";
-         
-         query.runQuery(sql);
-      }
+         statement->bind(playerId)
+                   .bind(string(WeaponInfo::getWeaponName(weaponStats[i].weaponType)))
+                   .bind(weaponStats[i].shots)
+                   .bind(weaponStats[i].hits)
+                   .execute();
    }
 }
 
 
+static const char *InsertPlayerSql = "INSERT INTO stats_player(stats_game_id, stats_team_id, player_name, "
+                                                              "is_authenticated,               is_robot, "
+                                                              "result,                         points, "
+                                                              "kill_count,                     death_count, "
+                                                              "suicide_count,                  switched_team_count, "
+                                                              "asteroid_crashes,               flag_drops, "
+                                                              "flag_pickups,                   flag_returns, "
+                                                              "flag_scores,                    teleport_uses, "
+                                                              "turret_kills,                   ff_kills, "
+                                                              "asteroid_kills,                 turrets_engineered, "
+                                                              "ffs_engineered,                 teleports_engineered, "
+                                                              "distance_traveled) "
+                                     "VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+
 // Inserts player and all associated weapon stats
-static U64 insertStatsPlayer(const DbQuery &query, const PlayerStats *playerStats, U64 gameId, const string &teamId)
-{
-   string sql = "INSERT INTO stats_player(stats_game_id, stats_team_id, player_name, "
-                                               "is_authenticated,               is_robot, "
-                                               "result,                         points, "
-                                               "kill_count,                     death_count, "
-                                               "suicide_count,                  switched_team_count, "
-                                               "asteroid_crashes,               flag_drops, "
-                                               "flag_pickups,                   flag_returns, "
-                                               "flag_scores,                    teleport_uses, "
-                                               "turret_kills,                   ff_kills, "
-                                               "asteroid_kills,                 turrets_engineered, "
-                                               "ffs_engineered,                 teleports_engineered, "
-                                               "distance_traveled )"                      
-                         "VALUES(" + itos(gameId) + ", " + teamId + ", '"     + sanitizeForSql(playerStats->name)           + "', " +
-                                 btos(playerStats->isAuthenticated)     + ", " + btos(playerStats->isRobot)           + ", " +
-                                 "'" + playerStats->gameResult + "'"    + ", " + itos(playerStats->points)            + ", " + 
-                                 itos(playerStats->kills)               + ", " + itos(playerStats->deaths)            + ", " +
-                                 itos(playerStats->suicides)            + ", " + itos(playerStats->switchedTeamCount) + ", " +
-                                 itos(playerStats->crashedIntoAsteroid) + ", " + itos(playerStats->flagDrop)          + ", " + 
-                                 itos(playerStats->flagPickup)          + ", " + itos(playerStats->flagReturn)        + ", " + 
-                                 itos(playerStats->flagScore)           + ", " + itos(playerStats->teleport)          + ", " + 
-                                 itos(playerStats->turretKills)         + ", " + itos(playerStats->ffKills)           + ", " + 
-                                 itos(playerStats->astKills)            + ", " + itos(playerStats->turretsEngr)       + ", " + 
-                                 itos(playerStats->ffEngr)              + ", " + itos(playerStats->telEngr)           + ", " + 
-                                 itos(playerStats->distTraveled)        + 
-                         ")";
-
-   U64 playerId = query.runQuery(sql);
+static U64 insertStatsPlayer(DbQuery &query, const PlayerStats *playerStats, U64 gameId, U64 teamId)
+{
+   U64 playerId = query.prepare(InsertPlayerSql)->
+         bind(gameId)                              .bind(teamId)
+        .bind(playerStats->name)
+        .bind(playerStats->isAuthenticated)        .bind(playerStats->isRobot)
+        .bind(string(1, playerStats->gameResult))  .bind(playerStats->points)
+        .bind(playerStats->kills)                  .bind(playerStats->deaths)
+        .bind(playerStats->suicides)               .bind(playerStats->switchedTeamCount)
+        .bind(playerStats->crashedIntoAsteroid)    .bind(playerStats->flagDrop)
+        .bind(playerStats->flagPickup)             .bind(playerStats->flagReturn)
+        .bind(playerStats->flagScore)              .bind(playerStats->teleport)
+        .bind(playerStats->turretKills)            .bind(playerStats->ffKills)
+        .bind(playerStats->astKills)               .bind(playerStats->turretsEngr)
+        .bind(playerStats->ffEngr)                 .bind(playerStats->telEngr)
+        .bind(playerStats->distTraveled)
+        .execute();
 
    insertStatsShots(query, playerId, playerStats->weaponStats);
    insertStatsLoadout(query, playerId, playerStats->loadoutStats);
@@ -162,32 +179,34 @@ static U64 insertStatsPlayer(const DbQuery &query, const PlayerStats *playerStat
 }
 
 
+static const char *InsertTeamSql = "INSERT INTO stats_team(stats_game_id, team_name, team_score, result, color_hex) "
+                                   "VALUES(?, ?, ?, ?, ?);";
+
 // Inserts stats of team and all players
-static U64 insertStatsTeam(const DbQuery &query, const TeamStats *teamStats, U64 &gameId)
+static U64 insertStatsTeam(DbQuery &query, const TeamStats *teamStats, U64 gameId)
 {
-   string sql = "INSERT INTO stats_team(stats_game_id, team_name, team_score, result, color_hex) "
-                "VALUES(" + itos(gameId) + ", '" + sanitizeForSql(teamStats->name) + "', " + itos(teamStats->score) + " ,'" + 
-                ctos(teamStats->gameResult) + "' ,'" + teamStats->hexColor + "');";
-
-   U64 teamId = query.runQuery(sql);
+   U64 teamId = query.prepare(InsertTeamSql)->
+         bind(gameId).bind(teamStats->name).bind(teamStats->score).bind(ctos(teamStats->gameResult)).bind(teamStats->hexColor)
+        .execute();
 
    for(S32 i = 0; i < teamStats->playerStats.size(); i++)
-      insertStatsPlayer(query, &teamStats->playerStats[i], gameId, itos(teamId));
+      insertStatsPlayer(query, &teamStats->playerStats[i], gameId, teamId);
 
    return teamId;
 }
 
 
-static U64 insertStatsGame(const DbQuery &query, const GameStats *gameStats, U64 serverId)
-{
-   string sql = "INSERT INTO stats_game(server_id, game_type, is_official, player_count, "
-                                       "duration_seconds, level_name, is_team_game, team_count) "
-                "VALUES( " + itos(serverId) + ", '" + gameStats->gameType + "', " + btos(gameStats->isOfficial) + ", " + 
-                             itos(gameStats->playerCount) + ", " + itos(gameStats->duration) + ", '" + 
-                             sanitizeForSql(gameStats->levelName) + "', " + btos(gameStats->isTeamGame) + ", " + 
-                             itos(gameStats->teamStats.size())  + ");";
+static const char *InsertGameSql = "INSERT INTO stats_game(server_id, game_type, is_official, player_count, "
+                                                          "duration_seconds, level_name, is_team_game, team_count) "
+                                   "VALUES(?, ?, ?, ?, ?, ?, ?, ?);";
 
-   U64 gameId = query.runQuery(sql);
+static U64 insertStatsGame(DbQuery &query, const GameStats *gameStats, U64 serverId)
+{
+   U64 gameId = query.prepare(InsertGameSql)->
+         bind(serverId)                 .bind(gameStats->gameType)     .bind(gameStats->isOfficial)
+        .bind(gameStats->playerCount)   .bind(gameStats->duration)     .bind(gameStats->levelName)
+        .bind(gameStats->isTeamGame)    .bind(gameStats->teamStats.size())
+        .execute();
 
    for(S32 i = 0; i < gameStats->teamStats.size(); i++)
       insertStatsTeam(query, &gameStats->teamStats[i], gameId);
@@ -232,7 +251,7 @@ S32 DatabaseWriter::getServerIdFromDatabase(const DbQuery &query, const string &
 }
 
 
-void DatabaseWriter::addToServerCache(U64 id, const string &serverName, const string &serverIP)
+void DatabaseWriter::addToServerCache(const DbQuery &query, U64 id, const string &serverName, const string &serverIP)
 {
    // Limit cache growth
    static const S32 SERVER_CACHE_SIZE = 20;
@@ -240,7 +259,7 @@ void DatabaseWriter::addToServerCache(U64 id, const string &serverName, const st
    if(cachedServers.size() >= SERVER_CACHE_SIZE) 
       cachedServers.erase(0);
 
-   cachedServers.push_back(ServerInfo(id, serverName, serverIP));
+   cachedServers.push_back(ServerInfo(id, serverName, serverIP, query.getConnectionKey()));
 }
 
 
@@ -248,57 +267,79 @@ void DatabaseWriter::addToServerCache(U64 id, const string &serverName, const st
 // it there, we'll go to the database to retrieve it.
 U64 DatabaseWriter::getServerID(const DbQuery &query, const string &serverName, const string &serverIP)
 {
-   U64 serverId = getServerIDFromCache(serverName, serverIP);
+   gServerIdLock.lock();
+
+   U64 serverId;
 
-   if(serverId == U64_MAX)      // Not found in cache, check database
+   try
    {
-      serverId = getServerIdFromDatabase(query, serverName, serverIP);
+      serverId = getServerIDFromCache(query, serverName, serverIP);
 
-      if(serverId == U64_MAX)   // Not found in database, add to database
-         serverId = insertStatsServer(query, serverName, serverIP);
+      if(serverId == U64_MAX)      // Not found in cache, check database
+      {
+         serverId = getServerIdFromDatabase(query, serverName, serverIP);
+
+         if(serverId == U64_MAX)   // Not found in database, add to database
+            serverId = insertStatsServer(query, serverName, serverIP);
 
-      // Save server info to cache for future use
-      addToServerCache(serverId, serverName, serverIP);     
+         // Save server info to cache for future use
+         addToServerCache(query, serverId, serverName, serverIP);     
+      }
+   }
+   catch(...)
+   {
+      gServerIdLock.unlock();
+      throw;
    }
 
+   gServerIdLock.unlock();
+
    return serverId;
 }
 
 
 // We can save a little wear-and-tear on the database by caching recent server IDs rather than retrieving them from
 // the database each time we need to find one.  Server IDs should be unique for a given pair of server name and IP address.
-U64 DatabaseWriter::getServerIDFromCache(const string &serverName, const string &serverIP)
+U64 DatabaseWriter::getServerIDFromCache(const DbQuery &query, const string &serverName, const string &serverIP)
 {
    for(S32 i = cachedServers.size() - 1; i >= 0; i--)    // Counting backwards to visit newest servers first
-      if(cachedServers[i].ip == serverIP && cachedServers[i].name == serverName)
+      if(cachedServers[i].ip == serverIP && cachedServers[i].name == serverName && 
+         cachedServers[i].database == query.getConnectionKey())
          return cachedServers[i].id;
 
    return U64_MAX;
 }
 
 
+// Each game's stats go in as a single transaction, so a failure part way through leaves nothing behind
 void DatabaseWriter::insertStats(const GameStats &gameStats) 
 {
-   DbQuery query(mDb, mServer, mUser, mPassword);
+   DbQuery &query = *getConnection();
+
+   if(!query.isValid)
+      return;
 
    try
    {
-      if(query.isValid)
-      {
-         U64 serverId = getServerID(query, gameStats.serverName, gameStats.serverIP);
-         insertStatsGame(query, &gameStats, serverId);
-      }
+      // Server records are created outside the transaction, so other threads can see them right away
+      U64 serverId = getServerID(query, gameStats.serverName, gameStats.serverIP);
+
+      query.beginTransaction();
+      insertStatsGame(query, &gameStats, serverId);
+      query.commitTransaction();
    }
    catch(const Exception &ex) 
    {
       logprintf("[%s] Failure writing stats to database: %s", getTimeStamp().c_str(), ex.what());
+      query.rollbackTransaction();
+      closeThreadConnection();      // Start over with a fresh connection, in case this one is broken
    }
 }
 
 
 void DatabaseWriter::insertAchievement(U8 achievementId, const StringTableEntry &playerNick, const string &serverName, const string &serverIP) 
 {
-   DbQuery query(mDb, mServer, mUser, mPassword);
+   DbQuery &query = *getConnection();
 
    try
    {
@@ -323,7 +364,7 @@ void DatabaseWriter::insertAchievement(U8 achievementId, const StringTableEntry
 void DatabaseWriter::insertLevelInfo(const string &hash, const string &levelName, const string &creator, 
                                      const string &gameType, bool hasLevelGen, U8 teamCount, S32 winningScore, S32 gameDurationInSeconds)
 {
-   DbQuery query(mDb, mServer, mUser, mPassword);
+   DbQuery &query = *getConnection();
 
    try
    {
@@ -515,7 +556,7 @@ U16 DatabaseWriter::getGamesPlayed(const char *name)
 
 void DatabaseWriter::selectHandler(const string &sql, S32 cols, Vector<Vector<string> > &values)
 {
-   DbQuery query(mDb, mServer, mUser, mPassword);
+   DbQuery &query = *getConnection();
 
    try
    {
@@ -594,6 +635,81 @@ void DatabaseWriter::setDumpSql(bool dump)
    DbQuery::dumpSql = dump;
 }
 
+
+// Returns this thread's connection, opening a new one if it doesn't have one for our database yet
+DbQuery *DatabaseWriter::getConnection()
+{
+   string key = DbQuery::getConnectionKey(mDb, mServer, mUser, mPassword);
+
+   DbQuery *query = (DbQuery *)gThreadConnection.get();
+
+   if(query && (!query->isValid || query->getConnectionKey() != key))
+   {
+      delete query;
+      query = NULL;
+   }
+
+   if(!query)
+   {
+      query = new DbQuery(mDb, mServer, mUser, mPassword);
+      gThreadConnection.set(query);
+   }
+
+   return query;
+}
+
+
+// Static method
+void DatabaseWriter::closeThreadConnection()
+{
+   delete (DbQuery *)gThreadConnection.get();
+   gThreadConnection.set(NULL);
+}
+
+
+// Static method
+void DatabaseWriter::clearServerCache()
+{
+   gServerIdLock.lock();
+   cachedServers.clear();
+   gServerIdLock.unlock();
+}
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+DatabaseWriterThread::DatabaseWriterThread(U32 threadCount) : Parent(threadCount)
+{
+   // Do nothing
+}
+
+
+// Destructor
+DatabaseWriterThread::~DatabaseWriterThread()
+{
+   terminate();      // Workers must finish while our threadEnd() is still around to be called
+}
+
+
+void DatabaseWriterThread::threadStart()
+{
+#ifdef BF_WRITE_TO_MYSQL
+   Connection::thread_start();
+#endif
+}
+
+
+void DatabaseWriterThread::threadEnd()
+{
+   DatabaseWriter::closeThreadConnection();
+
+#ifdef BF_WRITE_TO_MYSQL
+   Connection::thread_end();
+#endif
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -606,6 +722,8 @@ DbQuery::DbQuery(const char *db, const char *server, const char *user, const cha
    query = NULL;
    sqliteDb = NULL;
    isValid = true;
+   mError = false;
+   mConnectionKey = getConnectionKey(db, server, user, password);
 
    TNLAssert(db && db[0] != 0, "must have a database");
 
@@ -633,13 +751,20 @@ DbQuery::DbQuery(const char *db, const char *server, const char *user, const cha
       {
          logprintf("ERROR: Can't open stats database %s: %s", db, sqlite3_errmsg(sqliteDb));
          sqlite3_close(sqliteDb);
+         sqliteDb = NULL;
          isValid = false;
       }
+      else
+         sqlite3_busy_timeout(sqliteDb, BusyTimeout);    // Other threads may be writing
 }
 
 // Destructor
 DbQuery::~DbQuery()
 {
+   // Statements must be finalized before their connection is closed
+   for(S32 i = 0; i < mStatements.size(); i++)
+      delete mStatements[i].statement;
+
    if(query)
       delete query;
 
@@ -671,7 +796,11 @@ U64 DbQuery::runQuery(const string &sql) const
       sqlite3_exec(sqliteDb, sql.c_str(), NULL, 0, &err);
 
       if(err)
+      {
          logprintf("Database error accessing sqlite databse: %s", err);
+         sqlite3_free(err);
+         mError = true;
+      }
 
 
       return sqlite3_last_insert_rowid(sqliteDb);  
@@ -681,6 +810,205 @@ U64 DbQuery::runQuery(const string &sql) const
 }
 
 
+// Static method
+string DbQuery::getConnectionKey(const char *db, const char *server, const char *user, const char *password)
+{
+   return string(db) + "|" + (server ? server : "") + "|" + (user ? user : "") + "|" + (password ? password : "");
+}
+
+
+const string &DbQuery::getConnectionKey() const
+{
+   return mConnectionKey;
+}
+
+
+DbStatement *DbQuery::prepare(const char *sql)
+{
+   for(S32 i = 0; i < mStatements.size(); i++)
+      if(mStatements[i].sql == sql)
+         return mStatements[i].statement;
+
+   PreparedStatement prepared;
+   prepared.sql = sql;
+   prepared.statement = new DbStatement(this, sql);
+   mStatements.push_back(prepared);
+
+   return prepared.statement;
+}
+
+
+void DbQuery::beginTransaction()
+{
+   mError = false;
+   runQuery("BEGIN;");
+}
+
+
+void DbQuery::commitTransaction()
+{
+   if(mError)
+   {
+      logprintf(LogConsumer::DatabaseFilter, "Rolling back database transaction after an error");
+      rollbackTransaction();
+   }
+   else
+      runQuery("COMMIT;");
+}
+
+
+// Never throws, as this is used to clean up after exceptions
+void DbQuery::rollbackTransaction()
+{
+   try
+   {
+      runQuery("ROLLBACK;");
+   }
+   catch(const Exception &ex)
+   {
+      logprintf(LogConsumer::DatabaseFilter, "Failure rolling back database transaction: %s", ex.what());
+   }
+
+   mError = false;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+DbStatement::DbStatement(const DbQuery *owner, const char *sql)
+{
+   mOwner = owner;
+   mSqliteStatement = NULL;
+   mNextParam = 0;
+
+#ifdef BF_WRITE_TO_MYSQL
+   mMySqlQuery = NULL;
+
+   if(owner->query)
+   {
+      mMySqlQuery = new Query(const_cast<Connection *>(&owner->conn), true, getMySqlTemplate(sql).c_str());
+      mMySqlQuery->parse();
+      return;
+   }
+#endif
+
+   if(owner->sqliteDb)
+      if(sqlite3_prepare_v2(owner->sqliteDb, sql, -1, &mSqliteStatement, NULL) != SQLITE_OK)
+      {
+         logprintf(LogConsumer::DatabaseFilter, "Database error preparing statement: %s", sqlite3_errmsg(owner->sqliteDb));
+         mSqliteStatement = NULL;
+      }
+}
+
+
+// Destructor
+DbStatement::~DbStatement()
+{
+#ifdef BF_WRITE_TO_MYSQL
+   delete mMySqlQuery;
+#endif
+
+   if(mSqliteStatement)
+      sqlite3_finalize(mSqliteStatement);
+}
+
+
+DbStatement &DbStatement::bind(S64 value)
+{
+   mNextParam++;
+
+#ifdef BF_WRITE_TO_MYSQL
+   if(mMySqlQuery)
+   {
+      mMySqlParams << SQLTypeAdapter(sql_bigint(value));    // Not longlong, which MySQL++ can't quote on LP64 platforms
+      return *this;
+   }
+#endif
+
+   if(mSqliteStatement)
+      sqlite3_bind_int64(mSqliteStatement, mNextParam, value);
+
+   return *this;
+}
+
+
+DbStatement &DbStatement::bind(const string &value)
+{
+   mNextParam++;
+
+#ifdef BF_WRITE_TO_MYSQL
+   if(mMySqlQuery)
+   {
+      mMySqlParams << SQLTypeAdapter(value);
+      return *this;
+   }
+#endif
+
+   if(mSqliteStatement)
+      sqlite3_bind_text(mSqliteStatement, mNextParam, value.c_str(), (int)value.length(), SQLITE_TRANSIENT);
+
+   return *this;
+}
+
+
+// Run the statement with the bound values -- throws exceptions on MySQL, like DbQuery::runQuery()
+U64 DbStatement::execute()
+{
+   mNextParam = 0;
+
+#ifdef BF_WRITE_TO_MYSQL
+   if(mMySqlQuery)
+   {
+      U64 id = mMySqlQuery->execute(mMySqlParams).insert_id();
+      mMySqlParams.clear();
+      return id;
+   }
+#endif
+
+   if(!mSqliteStatement)
+   {
+      mOwner->mError = true;
+      return U64_MAX;
+   }
+
+   U64 id = U64_MAX;
+
+   if(sqlite3_step(mSqliteStatement) == SQLITE_DONE)
+      id = sqlite3_last_insert_rowid(mOwner->sqliteDb);
+   else
+   {
+      logprintf("Database error accessing sqlite databse: %s", sqlite3_errmsg(mOwner->sqliteDb));
+      mOwner->mError = true;
+   }
+
+   sqlite3_reset(mSqliteStatement);
+   sqlite3_clear_bindings(mSqliteStatement);
+
+   return id;
+}
+
+
+// Static method -- turns each ? into a MySQL++ template parameter: %0q, %1q, ...  q quotes and escapes strings, and
+// leaves numbers alone.
+string DbStatement::getMySqlTemplate(const char *sql)
+{
+   string templateSql;
+   S32 param = 0;
+
+   for(const char *c = sql; *c; c++)
+   {
+      if(*c == '?')
+         templateSql += "%" + itos(param++) + "q";
+      else
+         templateSql += *c;
+   }
+
+   return templateSql;
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
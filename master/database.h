@@ -10,6 +10,8 @@
 #include "../zap/gameStats.h"
 #include "../zap/SharedConstants.h"
 
+#include "DatabaseAccessThread.h"
+
 #include "tnlTypes.h"
 #include "tnlVector.h"
 #include "tnlNonce.h"
@@ -44,37 +46,97 @@ struct ServerInfo
    U64 id;
    string name;
    string ip;
+   string database;     // Connection key of the database the id came from
 
    // Quickie constructor
-   ServerInfo(U64 id, const string name, const string &ip) 
+   ServerInfo(U64 id, const string name, const string &ip, const string &database) 
    { 
       this->id = id; 
       this->name = name; 
       this->ip = ip;
+      this->database = database;
    }
 };
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+class DbQuery;
+
+// A statement with ? placeholders, prepared once per connection and then run many times.  Bind a value to each
+// placeholder, in order, then execute().
+class DbStatement
+{
+private:
+   const DbQuery *mOwner;
+   sqlite3_stmt *mSqliteStatement;
+   S32 mNextParam;
+
+#ifdef BF_WRITE_TO_MYSQL
+   Query *mMySqlQuery;        // Template query, with %0q, %1q, ... in place of the placeholders
+   SQLQueryParms mMySqlParams;
+#endif
+
+public:
+   DbStatement(const DbQuery *owner, const char *sql);      // Constructor
+   ~DbStatement();                                          // Destructor
+
+   DbStatement &bind(S64 value);
+   DbStatement &bind(const string &value);
+
+   U64 execute();       // Returns id of the inserted row; clears bindings so the statement can be run again
+
+   static string getMySqlTemplate(const char *sql);
+};
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
 class DbQuery
 {
+   friend class DbStatement;
+
 #ifdef BF_WRITE_TO_MYSQL
    Connection conn;
 #endif
 
+   string mConnectionKey;              // Identifies the database and credentials this connection was opened with
+
+   struct PreparedStatement {
+      const char *sql;
+      DbStatement *statement;
+   };
+   Vector<PreparedStatement> mStatements;
+
+   mutable bool mError;                // Set when a statement fails on sqlite, which doesn't throw
+
 public:
    Query *query;
    sqlite3 *sqliteDb;
 
    bool isValid;
    static bool dumpSql;
+
+   static const S32 BusyTimeout = 5000;      // How long an sqlite connection waits for another's lock, in ms
    
    DbQuery(const char *db, const char *server = NULL, const char *user = NULL, const char *password = NULL);     // Constructor
    ~DbQuery();                      // Destructor
 
+   static string getConnectionKey(const char *db, const char *server, const char *user, const char *password);
+   const string &getConnectionKey() const;
+
    U64 runQuery(const string &sql) const;
+
+   // Statements are cached by the address of their sql, which should be a string constant
+   DbStatement *prepare(const char *sql);
+
+   // All the inserts between these are applied together, or not at all.  commitTransaction() rolls back instead if
+   // any statement failed.
+   void beginTransaction();
+   void commitTransaction();
+   void rollbackTransaction();
 };
 
 
@@ -89,7 +151,7 @@ private:
    char mDb[64];
    char mUser[64];
    char mPassword[64];
-   Vector<ServerInfo> cachedServers;
+   static Vector<ServerInfo> cachedServers;       // Shared by all writers; protected by the server ID lock in database.cpp
 
    S32 lastGameID;
 
@@ -99,8 +161,10 @@ private:
 
    U64 getServerID(const DbQuery &query, const string &serverName, const string &serverIP);
 
-   void addToServerCache(U64 id, const string &serverName, const string &serverIPAddr);         // Add database ID to our cache
-   U64 getServerIDFromCache(const string &serverName, const string &serverIPAddr);              // And get it back out again
+   DbQuery *getConnection();
+
+   void addToServerCache(const DbQuery &query, U64 id, const string &serverName, const string &serverIPAddr);   // Add database ID to our cache
+   U64 getServerIDFromCache(const DbQuery &query, const string &serverName, const string &serverIPAddr);        // And get it back out again
 
    S32 getServerIdFromDatabase(const DbQuery &query, const string &serverName, const string &serverIP);
 
@@ -116,6 +180,11 @@ public:
 
    static string sqliteFile;
 
+   // Each thread keeps its connection open between calls; threads should close theirs before exiting
+   static void closeThreadConnection();
+
+   static void clearServerCache();     // For when a database is replaced out from under us
+
    void selectHandler(const string &sql, S32 cols, Vector<Vector<string> > &values);
 
    void setDumpSql(bool dump);
@@ -141,6 +210,24 @@ public:
 
 DatabaseWriter getDatabaseWriter(const Master::MasterSettings *settings);
 
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Runs entries that use DatabaseWriter; each worker keeps its database connection open from one entry to the next
+class DatabaseWriterThread : public Master::DatabaseAccessThread
+{
+   typedef Master::DatabaseAccessThread Parent;
+
+protected:
+   void threadStart();
+   void threadEnd();
+
+public:
+   DatabaseWriterThread(U32 threadCount);    // Constructor
+   ~DatabaseWriterThread();                  // Destructor
+};
+
 }
 
 
@@ -165,10 +165,12 @@ MasterServer::MasterServer(MasterSettings *settings)
    mPingGameJoltTimer.reset(THIRTY_SECONDS);    // Game Jolt recommended frequency... sessions time out after 2 mins
 
    mJsonWritingSuspended = false;
+   mServerListPartitionsValid = false;
 
    mLastMotd = mSettings->getMotd();            // When this changes, we'll broadcast a new MOTD to clients
    
-   mDatabaseAccessThread = new DatabaseAccessThread();    // Deleted in destructor
+   // Deleted in destructor
+   mDatabaseAccessThread = new DbWriter::DatabaseWriterThread(mSettings->getVal<U32>(IniKey::DatabaseThreads));
 
    MasterServerConnection::setMasterServer(this);
 }
@@ -238,27 +240,186 @@ const Vector<MasterServerConnection *> *MasterServer::getClientList() const
 
 void MasterServer::addServer(MasterServerConnection *server)
 {
-   mServerList.push_back(server);
+   addToList(mServerList, server);
+   onServerListChanged();
 }
 
 
 void MasterServer::addClient(MasterServerConnection *client)
 {
-   mClientList.push_back(client);
+   addToList(mClientList, client);
+
+   if(client->mPlayerId.isValid())
+      mClientsByPlayerId[getPlayerIdKey(client->mPlayerId)] = client;
+
+   mClientsByName.insert(ClientsByName::value_type(getNameKey(client->mPlayerOrServerName.getString()), client));
+}
+
+
+void MasterServer::removeServer(MasterServerConnection *server)
+{
+   removeFromList(mServerList, server);
+   onServerListChanged();
+}
+
+
+void MasterServer::removeClient(MasterServerConnection *client)
+{
+   removeFromList(mClientList, client);
+
+   if(client->mPlayerId.isValid())
+   {
+      ClientsByPlayerId::iterator it = mClientsByPlayerId.find(getPlayerIdKey(client->mPlayerId));
+      if(it != mClientsByPlayerId.end() && it->second == client)
+         mClientsByPlayerId.erase(it);
+   }
+
+   removeClientName(client, client->mPlayerOrServerName);
+}
+
+
+// Connections remember where they are in their list, so they can be removed without searching for them
+void MasterServer::addToList(Vector<MasterServerConnection *> &list, MasterServerConnection *conn)
+{
+   TNLAssert(conn->mMasterListIndex == -1, "Connection is already in a list!");
+
+   conn->mMasterListIndex = list.size();
+   list.push_back(conn);
+}
+
+
+void MasterServer::removeFromList(Vector<MasterServerConnection *> &list, MasterServerConnection *conn)
+{
+   S32 index = conn->mMasterListIndex;
+   TNLAssert(index >= 0 && index < list.size() && list[index] == conn, "Connection is not where it thinks it is!");
+
+   list.erase_fast(index);
+   if(index < list.size())
+      list[index]->mMasterListIndex = index;     // erase_fast moved the last connection into the hole
+
+   conn->mMasterListIndex = -1;
+}
+
+
+void MasterServer::removeClientName(MasterServerConnection *client, const StringTableEntry &name)
+{
+   std::pair<ClientsByName::iterator, ClientsByName::iterator> range = mClientsByName.equal_range(getNameKey(name.getString()));
+
+   for(ClientsByName::iterator it = range.first; it != range.second; ++it)
+      if(it->second == client)
+      {
+         mClientsByName.erase(it);
+         return;
+      }
+}
+
+
+// Returns NULL if no client has that id
+MasterServerConnection *MasterServer::findClientByPlayerId(const Nonce &playerId) const
+{
+   if(!playerId.isValid())
+      return NULL;
+
+   ClientsByPlayerId::const_iterator it = mClientsByPlayerId.find(getPlayerIdKey(playerId));
+   return it == mClientsByPlayerId.end() ? NULL : it->second;
+}
+
+
+// Names aren't unique, so this can find more than one client
+void MasterServer::findClientsByName(const string &name, Vector<MasterServerConnection *> &clients) const
+{
+   std::pair<ClientsByName::const_iterator, ClientsByName::const_iterator> range = 
+         mClientsByName.equal_range(getNameKey(name));
+
+   for(ClientsByName::const_iterator it = range.first; it != range.second; ++it)
+      clients.push_back(it->second);
+}
+
+
+// Call after changing a client's name, so we can find it by its new one
+void MasterServer::onClientRenamed(MasterServerConnection *client, const StringTableEntry &oldName)
+{
+   if(client->mMasterListIndex == -1 || mClientList[client->mMasterListIndex] != client)     // Not one of our clients (yet)
+      return;
+
+   removeClientName(client, oldName);
+   mClientsByName.insert(ClientsByName::value_type(getNameKey(client->mPlayerOrServerName.getString()), client));
+}
+
+
+// Call whenever a server comes or goes, or changes anything that affects which lists it appears in
+void MasterServer::onServerListChanged()
+{
+   mServerListPartitionsValid = false;
+}
+
+
+// Returns the servers a client with the specified protocol version should see, ready to send; the result is 
+// reused for every query until the server list changes
+const ServerListChunks &MasterServer::getServerListChunks(U32 protocolVersion, bool hostOnly)
+{
+   if(!mServerListPartitionsValid)
+      buildServerListPartitions();
+
+   static const ServerListChunks noServers;
+
+   ServerListPartitions::const_iterator it = mServerListPartitions.find(getPartitionKey(protocolVersion, hostOnly));
+   return it == mServerListPartitions.end() ? noServers : it->second;
+}
+
+
+// One pass over the servers sorts every listed server into its partition, in the order the servers connected
+void MasterServer::buildServerListPartitions()
+{
+   mServerListPartitions.clear();
+
+   for(S32 i = 0; i < mServerList.size(); i++)
+   {
+      MasterServerConnection *server = mServerList[i];
+
+      // Hide hidden servers
+      if(server->mIsIgnoredFromList)
+         continue;
+
+      bool hostOnly = (server->mInfoFlags & HostModeFlag) != 0;
+      ServerListChunks &chunks = mServerListPartitions[getPartitionKey(server->mCSProtocolVersion, hostOnly)];
+
+      // Start a new packet when the last one is full
+      if(chunks.addresses.size() == 0 || chunks.addresses.last().size() == IP_MESSAGE_ADDRESS_COUNT)
+      {
+         chunks.addresses.push_back(Vector<IPAddress>());
+         chunks.serverIds.push_back(Vector<S32>());
+      }
+
+      chunks.addresses.last().push_back(server->getNetAddress().toIPAddress());
+      chunks.serverIds.last().push_back(server->getClientId());
+   }
+
+   mServerListPartitionsValid = true;
+}
+
+
+// Static method
+U64 MasterServer::getPlayerIdKey(const Nonce &playerId)
+{
+   U64 key;
+   memcpy(&key, playerId.data, sizeof(key));
+
+   return key;
 }
 
 
-void MasterServer::removeServer(S32 index)
+// Static method
+string MasterServer::getNameKey(const string &name)
 {
-   TNLAssert(index >= 0 && index < mServerList.size(), "Index out of range!");
-   mServerList.erase_fast(index);
+   return lcase(name);
 }
 
 
-void MasterServer::removeClient(S32 index)
+// Static method
+U64 MasterServer::getPartitionKey(U32 protocolVersion, bool hostOnly)
 {
-   TNLAssert(index >= 0 && index < mClientList.size(), "Index out of range!");
-   mClientList.erase_fast(index);
+   return (U64(protocolVersion) << 1) | (hostOnly ? 1 : 0);
 }
 
 
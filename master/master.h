@@ -45,6 +45,7 @@ using namespace Zap;
    SETTINGS_ITEM(string,    StatsDatabaseName,          "stats",    "stats_database_name",                  "",                         NULL, NULL, "" ) \
    SETTINGS_ITEM(string,    StatsDatabaseUsername,      "stats",    "stats_database_username",              "",                         NULL, NULL, "" ) \
    SETTINGS_ITEM(string,    StatsDatabasePassword,      "stats",    "stats_database_password",              "",                         NULL, NULL, "" ) \
+   SETTINGS_ITEM(U32,       DatabaseThreads,            "stats",    "database_threads",                     4,                          NULL, NULL, "" ) \
                                                                                                                                                          \
    /* GameJolt settings */                                                                                                                               \
    SETTINGS_ITEM(YesNo,     UseGameJolt,                "GameJolt", "UseGameJolt",                          Yes,                        NULL, NULL, "" ) \
@@ -105,9 +106,21 @@ public:
 
 class DatabaseAccessThread;
 
+// Server list query responses, one packet's worth of servers per entry
+struct ServerListChunks
+{
+   Vector<Vector<IPAddress> > addresses;
+   Vector<Vector<S32> > serverIds;
+};
+
+
 class MasterServer 
 {
 private:
+   typedef map<U64, MasterServerConnection *> ClientsByPlayerId;
+   typedef multimap<string, MasterServerConnection *> ClientsByName;       // Keyed by lowercased name
+   typedef map<U64, ServerListChunks> ServerListPartitions;                  // Keyed by protocol version and host mode
+
    U32 mStartTime;
    MasterSettings *mSettings;
    NetInterface *mNetInterface;
@@ -126,8 +139,23 @@ private:
    Vector<MasterServerConnection *> mServerList;
    Vector<MasterServerConnection *> mClientList;
 
+   ClientsByPlayerId mClientsByPlayerId;
+   ClientsByName mClientsByName;
+
+   ServerListPartitions mServerListPartitions;  // Rebuilt on demand after the server list changes
+   bool mServerListPartitionsValid;
+
    NetInterface *createNetInterface() const;
 
+   static U64 getPlayerIdKey(const Nonce &playerId);
+   static string getNameKey(const string &name);
+   static U64 getPartitionKey(U32 protocolVersion, bool hostOnly);
+
+   void addToList(Vector<MasterServerConnection *> &list, MasterServerConnection *conn);
+   void removeFromList(Vector<MasterServerConnection *> &list, MasterServerConnection *conn);
+   void removeClientName(MasterServerConnection *client, const StringTableEntry &name);
+   void buildServerListPartitions();
+
    bool motdHasChanged() const;
    void broadcastMotd() const;
 
@@ -157,8 +185,15 @@ public:
    void addServer(MasterServerConnection *server);
    void addClient(MasterServerConnection *client);
 
-   void removeServer(S32 index);
-   void removeClient(S32 index);
+   void removeServer(MasterServerConnection *server);
+   void removeClient(MasterServerConnection *client);
+
+   MasterServerConnection *findClientByPlayerId(const Nonce &playerId) const;
+   void findClientsByName(const string &name, Vector<MasterServerConnection *> &clients) const;  // Case insensitive
+   void onClientRenamed(MasterServerConnection *client, const StringTableEntry &oldName);
+
+   void onServerListChanged();
+   const ServerListChunks &getServerListChunks(U32 protocolVersion, bool hostOnly);
 
    void idle(const U32 timeDelta);
 };
@@ -224,19 +224,6 @@ bool BitStream::testBit(U32 bitCount)
    return (*(getBuffer() + (bitCount >> 3)) & (1 << (bitCount & 0x7))) != 0;
 }
 
-bool BitStream::writeFlag(bool val)
-{
-   if(bitNum + 1 > maxWriteBitNum)
-      if(!resizeBits(1))
-         return false;
-   if(val)
-      *(getBuffer() + (bitNum >> 3)) |= (1 << (bitNum & 0x7));
-   else
-      *(getBuffer() + (bitNum >> 3)) &= ~(1 << (bitNum & 0x7));
-   bitNum++;
-   return (val);
-}
-
 bool BitStream::write(const ByteBuffer *theBuffer)
 {
    U32 size = theBuffer->getBufferSize();
@@ -255,9 +242,8 @@ bool BitStream::read(ByteBuffer *theBuffer)
    return read(size, theBuffer->getBuffer());
 }
 
-U32 BitStream::readInt(U8 bitCount)
+U32 BitStream::readIntSlow(U8 bitCount)
 {
-   TNLAssert(bitCount <= 32, "bitCount must be less then 32, for 64 bit, use readInt64");
    U32 ret = 0;
    readBits(bitCount, &ret);
    ret = convertLEndianToHost(ret);
@@ -287,9 +273,8 @@ U64 BitStream::readInt64(U8 bitCount)
 }
 
 
-void BitStream::writeInt(U32 val, U8 bitCount)
+void BitStream::writeIntSlow(U32 val, U8 bitCount)
 {
-   TNLAssert(bitCount <= 32, "bitCount must be less then 32, for 64 bit, use writeInt64");
    val = convertHostToLEndian(val);
    writeBits(bitCount, &val);
 }
@@ -28,11 +28,12 @@
 
 #include "tnlEventConnection.h"
 #include "tnlBitStream.h"
+#include "tnlThread.h"
 
 namespace TNL {
 
 //--------------------------------------------------------------------
-static ClassChunker<ConnectionStringTable::PacketEntry> packetEntryFreeList(4096);
+static ThreadLocal<ClassChunker<ConnectionStringTable::PacketEntry> > packetEntryFreeList;    // One per thread
 
 ConnectionStringTable::ConnectionStringTable(NetConnection *parent)
 {
@@ -96,7 +97,7 @@ void ConnectionStringTable::writeStringTableEntry(BitStream *stream, StringTable
    if(!stream->writeFlag(sendEntry->receiveConfirmed))
    {
       stream->writeString(sendEntry->string.getString());
-      PacketEntry *entry = packetEntryFreeList.alloc();
+      PacketEntry *entry = packetEntryFreeList.get().alloc();
 
       entry->stringTableEntry = sendEntry;
       entry->string = sendEntry->string;
@@ -133,7 +134,7 @@ void ConnectionStringTable::packetReceived(PacketList *note)
       PacketEntry *next = walk->nextInPacket;
       if(walk->stringTableEntry->string == walk->string)
          walk->stringTableEntry->receiveConfirmed = true;
-      packetEntryFreeList.free(walk);
+      packetEntryFreeList.get().free(walk);
       walk = next;
    }
 }
@@ -144,7 +145,7 @@ void ConnectionStringTable::packetDropped(PacketList *note)
    while(walk)
    {
       PacketEntry *next = walk->nextInPacket;
-      packetEntryFreeList.free(walk);
+      packetEntryFreeList.get().free(walk);
       walk = next;
    }
 }
@@ -163,7 +164,7 @@ void ConnectionStringTable::packetRewind(PacketList *note, PacketEntry *p_entry)
    while(walk)
    {
       PacketEntry *next = walk->nextInPacket;
-      packetEntryFreeList.free(walk);
+      packetEntryFreeList.get().free(walk);
       walk = next;
    }
 }
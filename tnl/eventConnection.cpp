@@ -29,10 +29,11 @@
 #include "tnlBitStream.h"
 #include "tnlLog.h"
 #include "tnlNetInterface.h"
+#include "tnlPlatform.h"
 
 namespace TNL {
 
-ClassChunker<EventConnection::EventNote> EventConnection::mEventNoteChunker;
+ThreadLocal<ClassChunker<EventConnection::EventNote> > EventConnection::mEventNoteChunker;
 
 EventConnection::EventConnection()
 {
@@ -50,6 +51,7 @@ EventConnection::EventConnection()
    mEventClassCount = 0;
    mEventClassBitSize = 0;
    mTNLDataBuffer = NULL;
+   mCapturedEvents = NULL;
 }
 
 static const U32 mTNLDataBufferMaxSize = 1024 * 1024 * 4;  // 4 MB
@@ -70,7 +72,7 @@ void EventConnection::clearSendEvents()
       mNotifyEventList = temp->mNextEvent;
       
       temp->mEvent->notifyDelivered(this, true);
-      mEventNoteChunker.free(temp);
+      mEventNoteChunker.get().free(temp);
    }
    while(mUnorderedSendEventQueueHead)
    {
@@ -78,7 +80,7 @@ void EventConnection::clearSendEvents()
       mUnorderedSendEventQueueHead = temp->mNextEvent;
       
       temp->mEvent->notifyDelivered(this, true);
-      mEventNoteChunker.free(temp);
+      mEventNoteChunker.get().free(temp);
    }
    while(mSendEventQueueHead)
    {
@@ -86,7 +88,7 @@ void EventConnection::clearSendEvents()
       mSendEventQueueHead = temp->mNextEvent;
       
       temp->mEvent->notifyDelivered(this, true);
-      mEventNoteChunker.free(temp);
+      mEventNoteChunker.get().free(temp);
    }
    mNextSendEventSeq = FirstValidSendEventSeq;
 }
@@ -97,11 +99,11 @@ void EventConnection::clearRecvEvents()
    {
       EventNote *temp = mWaitSeqEvents;
       mWaitSeqEvents = temp->mNextEvent;
-      mEventNoteChunker.free(temp);
+      mEventNoteChunker.get().free(temp);
    }
    mNextRecvEventSeq = FirstValidSendEventSeq;
-   if(mTNLDataBuffer)
-      delete mTNLDataBuffer;
+   delete mTNLDataBuffer;
+   mTNLDataBuffer = NULL;
 }
 
 void EventConnection::writeConnectRequest(BitStream *stream)
@@ -239,7 +241,7 @@ void EventConnection::packetDropped(PacketNotify *pnotify)
             // it was _not_ delivered and blast it.
             walk->mEvent->notifyDelivered(this, false);
             temp = walk->mNextEvent;
-            mEventNoteChunker.free(walk);
+            mEventNoteChunker.get().free(walk);
             walk = temp;
       }
    }
@@ -260,7 +262,7 @@ void EventConnection::packetReceived(PacketNotify *pnotify)
       if(walk->mEvent->mGuaranteeType != NetEvent::GuaranteedOrdered)
       {
          walk->mEvent->notifyDelivered(this, true);
-         mEventNoteChunker.free(walk);
+         mEventNoteChunker.get().free(walk);
          walk = next;
       }
       else
@@ -280,7 +282,7 @@ void EventConnection::packetReceived(PacketNotify *pnotify)
       EventNote *next = mNotifyEventList->mNextEvent;
       logprintf(LogConsumer::LogEventConnection, "EventConnection %s: NotifyDelivered - %d", getNetAddressString(), mNotifyEventList->mSeqCount);
       mNotifyEventList->mEvent->notifyDelivered(this, true);
-      mEventNoteChunker.free(mNotifyEventList);
+      mEventNoteChunker.get().free(mNotifyEventList);
       mNotifyEventList = next;
    }
 }
@@ -339,7 +341,7 @@ void EventConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
             mUnorderedSendEventQueueHead = ev->mNextEvent;
             ev->mNextEvent = NULL;
             ev->mEvent->notifyDelivered(this, false);
-            mEventNoteChunker.free(ev);
+            mEventNoteChunker.get().free(ev);
             bstream->setBitPosition(start - 1);
             bstream->clearError();
             break;
@@ -418,7 +420,7 @@ void EventConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
             mSendEventQueueHead = ev->mNextEvent;
             ev->mNextEvent = NULL;
             ev->mEvent->notifyDelivered(this, false);
-            mEventNoteChunker.free(ev);
+            mEventNoteChunker.get().free(ev);
             bstream->setBitPosition(eventStart);
             bstream->clearError();
             break;
@@ -486,7 +488,7 @@ void EventConnection::readPacket(BitStream *bstream)
       {
          processEvent(evt);
          delete evt;
-         if(mErrorBuffer[0])
+         if(getErrorBuffer()[0])
             return;
          continue;
       }
@@ -494,7 +496,7 @@ void EventConnection::readPacket(BitStream *bstream)
       if(seq < mNextRecvEventSeq)
          seq += 128;
       
-      EventNote *note = mEventNoteChunker.alloc();
+      EventNote *note = mEventNoteChunker.get().alloc();
       note->mEvent = evt;
       note->mSeqCount = seq;
       logprintf(LogConsumer::LogEventConnection, "EventConnection %s: RecvdGuaranteed %d", getNetAddressString(), seq);
@@ -514,8 +516,8 @@ void EventConnection::readPacket(BitStream *bstream)
       
       logprintf(LogConsumer::LogEventConnection, "EventConnection %s: ProcessGuaranteed %d", getNetAddressString(), temp->mSeqCount);
       processEvent(temp->mEvent);
-      mEventNoteChunker.free(temp);
-      if(mErrorBuffer[0])
+      mEventNoteChunker.get().free(temp);
+      if(getErrorBuffer()[0])
          return;
    }
 }
@@ -538,7 +540,13 @@ bool EventConnection::postNetEvent(NetEvent *theEvent)
 
    theEvent->notifyPosted(this);
 
-   EventNote *event = mEventNoteChunker.alloc();
+   if(mCapturedEvents)
+   {
+      mCapturedEvents->push_back(theEvent);
+      return true;
+   }
+
+   EventNote *event = mEventNoteChunker.get().alloc();
    event->mEvent = theEvent;
    event->mNextEvent = NULL;
 
@@ -586,7 +594,7 @@ bool EventConnection::postNetEvent(NetEvent *theEvent)
             s2rTNLSendDataParts(1, ByteBufferPtr(bytebuffer));
          }
       }
-      mEventNoteChunker.free(event);
+      mEventNoteChunker.get().free(event);
    }
    else
    {
@@ -600,6 +608,46 @@ bool EventConnection::postNetEvent(NetEvent *theEvent)
    return true;
 }
 
+void EventConnection::setEventCapture(Vector<RefPtr<NetEvent> > *events)
+{
+   mCapturedEvents = events;
+}
+
+void EventConnection::writeEventSnapshot(BitStream *bstream, const Vector<RefPtr<NetEvent> > &events)
+{
+   if(mConnectionParameters.mDebugObjectSizes)
+      bstream->writeInt(DebugChecksum, 32);
+
+   for(S32 i = 0; i < events.size(); i++)
+   {
+      bstream->writeFlag(true);
+      S32 start = bstream->getBitPosition();
+
+      if(mConnectionParameters.mDebugObjectSizes)
+         bstream->advanceBitPosition(BitStreamPosBitSize);
+
+      S32 classId = events[i]->getClassId(getNetClassGroup());
+      bstream->writeInt(classId, mEventClassBitSize);
+      events[i]->pack(this, bstream);
+
+      if(mConnectionParameters.mDebugObjectSizes)
+         bstream->writeIntAt(bstream->getBitPosition(), BitStreamPosBitSize, start);
+   }
+
+   bstream->writeFlag(false);    // End of unguaranteed events
+   bstream->writeFlag(false);    // No guaranteed ones
+}
+
+S32 EventConnection::getNextSendEventSeq() const
+{
+   return mSendEventQueueHead ? mSendEventQueueHead->mSeqCount : mNextSendEventSeq;
+}
+
+void EventConnection::setNextRecvEventSeq(S32 seq)
+{
+   mNextRecvEventSeq = seq;
+}
+
 bool EventConnection::isDataToTransmit()
 {
    return mUnorderedSendEventQueueHead || mSendEventQueueHead || Parent::isDataToTransmit();
@@ -637,8 +685,15 @@ NetEvent *EventConnection::unpackNetEvent(BitStream *bstream)
    }
 
 
+   S64 unpackStart = NetClassRep::mCollectUnpackStats ? Platform::getHighPrecisionTimerValue() : 0;
+   U32 unpackStartBit = bstream->getBitPosition();
+
    evt->unpack(this, bstream);
-   if(mErrorBuffer[0])
+
+   if(NetClassRep::mCollectUnpackStats)
+      evt->getClassRep()->addUnpack(bstream->getBitPosition() - unpackStartBit, Platform::getHighPrecisionTimerValue() - unpackStart);
+
+   if(getErrorBuffer()[0])
    {
       delete evt;
       return NULL;
@@ -30,6 +30,7 @@
 #include "tnlNetBase.h"
 #include "tnlNetObject.h"
 #include "tnlNetInterface.h"
+#include "tnlPlatform.h"
 
 namespace TNL {
 
@@ -46,6 +47,10 @@ GhostConnection::GhostConnection()
    mGhostFrom = false;
    mGhostTo = false;
    mClearUnscopedObjects = false;
+
+   mDeferNewGhosts = false;
+   mGhostsPrioritized = false;
+   mPrioritizedMaxIndex = 0;
 }
 
 GhostConnection::~GhostConnection()
@@ -199,6 +204,76 @@ void GhostConnection::prepareWritePacket()
    if(!doesGhostFrom() && !mGhosting)
       return;
 
+   markGhostsForScopeQuery();
+
+   if(mScopeObject)
+      mScopeObject->performScopeQuery(this);
+}
+
+
+void GhostConnection::beginPrepareWritePacket()
+{
+   Parent::beginPrepareWritePacket();
+
+   if(!doesGhostFrom() && !mGhosting)
+      return;
+
+   markGhostsForScopeQuery();
+}
+
+
+void GhostConnection::prepareWritePacketConcurrent()
+{
+   Parent::prepareWritePacketConcurrent();
+
+   if(!doesGhostFrom() && !mGhosting)
+      return;
+
+   mDeferNewGhosts = true;
+
+   if(mScopeObject)
+      mScopeObject->performScopeQuery(this);
+
+   mDeferNewGhosts = false;
+}
+
+
+void GhostConnection::endPrepareWritePacket()
+{
+   Parent::endPrepareWritePacket();
+
+   for(S32 i = 0; i < mDeferredScopeObjects.size(); i++)
+      objectInScope(mDeferredScopeObjects[i]);
+
+   mDeferredScopeObjects.clear();
+}
+
+
+void GhostConnection::beginWritePacket()
+{
+   Parent::beginWritePacket();
+
+   if(!doesGhostFrom() || !mGhosting || !mScopeObject.isValid())
+      return;
+
+   detachUnscopedUpdatingGhosts();
+}
+
+
+void GhostConnection::writePacketConcurrent()
+{
+   Parent::writePacketConcurrent();
+
+   if(!doesGhostFrom() || !mGhosting || !mScopeObject.isValid())
+      return;
+
+   mPrioritizedMaxIndex = prioritizeGhosts();
+   mGhostsPrioritized = true;
+}
+
+
+void GhostConnection::markGhostsForScopeQuery()
+{
    if(mGhostFreeIndex > MaxGhostCount - 10)  // Almost running out of GhostFreeIndex, free some objects not in scope
       descopeAndDetachObjects();
 
@@ -219,9 +294,6 @@ void GhostConnection::prepareWritePacket()
       if(!(walk->flags & (GhostInfo::ScopeLocalAlways)))
          walk->flags &= ~GhostInfo::InScope;
    }
-
-   if(mScopeObject)
-      mScopeObject->performScopeQuery(this);
 }
 
 
@@ -315,6 +387,9 @@ bool GhostConnection::isDataToTransmit()
 
 void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
 {
+   bool ghostsPrioritized = mGhostsPrioritized;
+   mGhostsPrioritized = false;
+
    Parent::writePacket(bstream, pnotify);
    GhostPacketNotify *notify = static_cast<GhostPacketNotify *>(pnotify);
 
@@ -336,48 +411,18 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
    // 3. call updates based on sorted priority until the packet is
    //    full.  set flags to zero for all updated objects
 
-   GhostInfo *walk;
+   U32 maxIndex;
 
-   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
+   if(ghostsPrioritized)
+      maxIndex = mPrioritizedMaxIndex;
+   else
    {
-      if(!(mGhostArray[i]->flags & GhostInfo::InScope))
-         detachObject(mGhostArray[i]);    // Sets KillGhost flags, sets obj to NULL, among other things
+      detachUnscopedUpdatingGhosts();
+      maxIndex = prioritizeGhosts();
    }
 
-   U32 maxIndex = 0;
-   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
-   {
-      walk = mGhostArray[i];
-      if(walk->index > maxIndex)
-         maxIndex = walk->index;
-
-      // Clear out any kill objects that haven't been ghosted yet
-      if((walk->flags & GhostInfo::KillGhost) && (walk->flags & GhostInfo::NotYetGhosted))
-      {
-         freeGhostInfo(walk);
-         continue;
-      }
-      // Don't do any ghost processing on objects that are being killed
-      // or in the process of ghosting
-      else if(!(walk->flags & (GhostInfo::KillingGhost | GhostInfo::Ghosting)))
-      {
-         if(walk->flags & GhostInfo::KillGhost)
-            walk->priority = F32_MAX;
-         else
-            walk->priority = walk->obj->getUpdatePriority(this, walk->updateMask, walk->updateSkipCount);
-      }
-      else
-         walk->priority = 0;
-   }
    GhostRef *updateList = NULL;
 
-   if(mGhostZeroUpdateIndex != 0)
-      qsort(&mGhostArray[0], mGhostZeroUpdateIndex, sizeof(GhostInfo *), prioritySort);
-
-   // Reset the array indices...
-   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
-      mGhostArray[i]->arrayIndex = i;
-
    U8 bitsNeededToSendMaxIndex = 0;
 
    while(maxIndex != 0)
@@ -394,6 +439,8 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
    U32 count = 0;
    bool have_something_to_send = bstream->getBitPosition() >= 256;
 
+   ThreadContext *context = ThreadContext::getCurrent();
+
    for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0 && !bstream->isFull(); i--)
    {
       GhostInfo *walk = mGhostArray[i];
@@ -427,18 +474,28 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
             S32 classId = walk->obj->getClassId(getNetClassGroup());
             TNLAssert(U32(classId) < mGhostClassCount, "classID out of range");
             bstream->writeInt(classId, mGhostClassBitSize);
-            NetObject::mIsInitialUpdate = true;
+            context->mIsInitialUpdate = true;
+         }
+         // update the object, reusing what it wrote for another connection this pass if we can
+         S32 cacheKey = context->mUpdateCacheActive ? walk->obj->getUpdateCacheKey(this) : S32(NetObject::UpdateNotCacheable);
+         bool cacheHit = cacheKey != NetObject::UpdateNotCacheable &&
+                         walk->obj->writeCachedUpdate(cacheKey, updateMask, bstream, retMask);
+         if(!cacheHit)
+         {
+            U32 packStart = bstream->getBitPosition();
+            retMask = walk->obj->packUpdate(this, updateMask, bstream);
+
+            if(cacheKey != NetObject::UpdateNotCacheable && bstream->isValid())
+               walk->obj->cacheUpdate(cacheKey, updateMask, bstream, packStart, retMask);
          }
-         // update the object
-         retMask = walk->obj->packUpdate(this, updateMask, bstream);
 
-         if(NetObject::mIsInitialUpdate)
+         if(context->mIsInitialUpdate)
          {
-            NetObject::mIsInitialUpdate = false;
-            walk->obj->getClassRep()->addInitialUpdate(bstream->getBitPosition() - startPos);
+            context->mIsInitialUpdate = false;
+            walk->obj->getClassRep()->addInitialUpdate(bstream->getBitPosition() - startPos, cacheHit);
          }
          else
-            walk->obj->getClassRep()->addPartialUpdate(bstream->getBitPosition() - startPos);
+            walk->obj->getClassRep()->addPartialUpdate(bstream->getBitPosition() - startPos, cacheHit);
 
          if(mConnectionParameters.mDebugObjectSizes)
             bstream->writeIntAt(bstream->getBitPosition(), BitStreamPosBitSize, startPos - BitStreamPosBitSize);
@@ -512,6 +569,147 @@ void GhostConnection::writePacket(BitStream *bstream, PacketNotify *pnotify)
    notify->ghostList = updateList;
 }
 
+
+void GhostConnection::detachUnscopedUpdatingGhosts()
+{
+   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
+   {
+      if(!(mGhostArray[i]->flags & GhostInfo::InScope))
+         detachObject(mGhostArray[i]);    // Sets KillGhost flags, sets obj to NULL, among other things
+   }
+}
+
+
+// Computes priorities of all ghosts needing updates, and sorts them so the most important are last.  Returns
+// the highest ghost index found.  Only touches this connection's ghosts, so it is safe to run on a worker thread.
+U32 GhostConnection::prioritizeGhosts()
+{
+   GhostInfo *walk;
+
+   U32 maxIndex = 0;
+   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
+   {
+      walk = mGhostArray[i];
+      if(walk->index > maxIndex)
+         maxIndex = walk->index;
+
+      // Clear out any kill objects that haven't been ghosted yet
+      if((walk->flags & GhostInfo::KillGhost) && (walk->flags & GhostInfo::NotYetGhosted))
+      {
+         freeGhostInfo(walk);
+         continue;
+      }
+      // Don't do any ghost processing on objects that are being killed
+      // or in the process of ghosting
+      else if(!(walk->flags & (GhostInfo::KillingGhost | GhostInfo::Ghosting)))
+      {
+         if(walk->flags & GhostInfo::KillGhost)
+            walk->priority = F32_MAX;
+         else
+            walk->priority = walk->obj->getUpdatePriority(this, walk->updateMask, walk->updateSkipCount);
+      }
+      else
+         walk->priority = 0;
+   }
+
+   if(mGhostZeroUpdateIndex != 0)
+      qsort(&mGhostArray[0], mGhostZeroUpdateIndex, sizeof(GhostInfo *), prioritySort);
+
+   // Reset the array indices...
+   for(S32 i = mGhostZeroUpdateIndex - 1; i >= 0; i--)
+      mGhostArray[i]->arrayIndex = i;
+
+   return maxIndex;
+}
+
+
+// Only ghosts the remote host has, and isn't about to lose, go in a snapshot
+static bool isInGhostSnapshot(const GhostInfo *ghost)
+{
+   const U32 skipFlags = GhostInfo::NotYetGhosted | GhostInfo::Ghosting | GhostInfo::KillGhost | GhostInfo::KillingGhost;
+
+   return !(ghost->flags & skipFlags) && ghost->obj;
+}
+
+
+void GhostConnection::writeGhostSnapshot(BitStream *bstream)
+{
+   if(mConnectionParameters.mDebugObjectSizes)
+      bstream->writeInt(DebugChecksum, 32);
+
+   if(!doesGhostFrom())
+      return;
+
+   if(!bstream->writeFlag(mGhosting && mScopeObject.isValid()))
+      return;
+
+   U32 maxIndex = 0;
+   for(S32 i = 0; i < mGhostFreeIndex; i++)
+      if(isInGhostSnapshot(mGhostArray[i]))
+         maxIndex = getMax(maxIndex, U32(mGhostArray[i]->index));
+
+   U8 bitsNeededToSendMaxIndex = 0;
+
+   while(maxIndex != 0)
+   {
+      maxIndex >>= 1;
+      bitsNeededToSendMaxIndex++;
+   }
+
+   if(bitsNeededToSendMaxIndex < ID_BIT_OFFSET)
+      bitsNeededToSendMaxIndex = ID_BIT_OFFSET;
+
+   bool BitSizeWritten = false;
+
+   for(S32 i = 0; i < mGhostFreeIndex; i++)
+   {
+      GhostInfo *walk = mGhostArray[i];
+      if(!isInGhostSnapshot(walk))
+         continue;
+
+      bstream->writeFlag(true);
+
+      if(!BitSizeWritten)
+      {
+         BitSizeWritten = true;
+         TNLAssert(((bitsNeededToSendMaxIndex - ID_BIT_OFFSET) >> ID_BIT_SIZE) == 0, "invalid range");
+         bstream->writeInt(bitsNeededToSendMaxIndex - ID_BIT_OFFSET, ID_BIT_SIZE);
+      }
+      bstream->writeInt(walk->index, bitsNeededToSendMaxIndex);
+      bstream->writeFlag(false);    // Not being killed
+
+      if(mConnectionParameters.mDebugObjectSizes)
+         bstream->advanceBitPosition(BitStreamPosBitSize);
+
+      S32 startPos = bstream->getBitPosition();
+
+      S32 classId = walk->obj->getClassId(getNetClassGroup());
+      TNLAssert(U32(classId) < mGhostClassCount, "classID out of range");
+      bstream->writeInt(classId, mGhostClassBitSize);
+
+      ThreadContext::getCurrent()->mIsInitialUpdate = true;
+      walk->obj->packUpdate(this, 0xFFFFFFFF, bstream);
+      ThreadContext::getCurrent()->mIsInitialUpdate = false;
+
+      if(mConnectionParameters.mDebugObjectSizes)
+         bstream->writeIntAt(bstream->getBitPosition(), BitStreamPosBitSize, startPos - BitStreamPosBitSize);
+   }
+
+   bstream->writeFlag(false);
+}
+
+
+void GhostConnection::getGhostSnapshotObjects(Vector<NetObject *> &objects)
+{
+   if(!doesGhostFrom() || !mGhosting || !mScopeObject.isValid())
+      return;
+
+   for(S32 i = 0; i < mGhostFreeIndex; i++)
+      if(isInGhostSnapshot(mGhostArray[i]))
+         objects.push_back(mGhostArray[i]->obj);
+}
+
+
 void GhostConnection::readPacket(BitStream *bstream)
 {
    Parent::readPacket(bstream);
@@ -582,13 +780,20 @@ void GhostConnection::readPacket(BitStream *bstream)
 
             obj->onGhostAddBeforeUpdate(this);
 
-            NetObject::mIsInitialUpdate = true;
+            S64 unpackStart = NetClassRep::mCollectUnpackStats ? Platform::getHighPrecisionTimerValue() : 0;
+            U32 unpackStartBit = bstream->getBitPosition();
+
+            ThreadContext::getCurrent()->mIsInitialUpdate = true;
             mLocalGhosts[index]->unpackUpdate(this, bstream);
-            NetObject::mIsInitialUpdate = false;
+            ThreadContext::getCurrent()->mIsInitialUpdate = false;
+
+            if(NetClassRep::mCollectUnpackStats)
+               obj->getClassRep()->addUnpack(bstream->getBitPosition() - unpackStartBit,
+                                             Platform::getHighPrecisionTimerValue() - unpackStart);
             
             if(!obj->onGhostAdd(this))    // Runs addToGame() on some objects
             {
-               if(!mErrorBuffer[0])
+               if(!getErrorBuffer()[0])
                   setLastError("Invalid packet.");
                return;
             }
@@ -600,7 +805,14 @@ void GhostConnection::readPacket(BitStream *bstream)
          }
          else
          {
+            S64 unpackStart = NetClassRep::mCollectUnpackStats ? Platform::getHighPrecisionTimerValue() : 0;
+            U32 unpackStartBit = bstream->getBitPosition();
+
             mLocalGhosts[index]->unpackUpdate(this, bstream);
+
+            if(NetClassRep::mCollectUnpackStats)
+               mLocalGhosts[index]->getClassRep()->addUnpack(bstream->getBitPosition() - unpackStartBit,
+                                                             Platform::getHighPrecisionTimerValue() - unpackStart);
          }
 
          if(mConnectionParameters.mDebugObjectSizes)
@@ -610,7 +822,7 @@ void GhostConnection::readPacket(BitStream *bstream)
                mLocalGhosts[index]->getClassName(), endPosition, bstream->getBitPosition()) );
          }
 
-         if(mErrorBuffer[0])
+         if(getErrorBuffer()[0])
             return;
       }
    }
@@ -756,6 +968,14 @@ void GhostConnection::objectInScope(NetObject *obj)
       return;
    }
 
+   // Creating a ghost links it into the object's list of ghosts, which other connections share, so if we're
+   // running on a worker thread, leave that for endPrepareWritePacket()
+   if(mDeferNewGhosts)
+   {
+      mDeferredScopeObjects.push_back(obj);
+      return;
+   }
+
    if(mGhostFreeIndex == MaxGhostCount)      // No more room at the inn... sorry!
       return;
 
@@ -26,6 +26,7 @@
 
 #include "tnlBitStream.h"
 #include "tnlVector.h"
+#include "tnlThread.h"
 #include "tnlHuffmanStringProcessor.h"
 
 namespace TNL {
@@ -46,13 +47,46 @@ namespace HuffmanStringProcessor {
 
       U8  numBits;
       U8  symbol;
-      U32 code;   // no code should be longer than 32 bits.
+      U32 code;   // no code should be longer than 32 bits; stored in host order, first bit in the LSB
    };
 
    Vector<HuffNode> mHuffNodes;
    Vector<HuffLeaf> mHuffLeaves;
 
+   // The decoder looks at DecodeTableBits bits of the stream at a time.  Each entry holds either the leaf reached
+   // within those bits, and how many of them its code used, or the node reached after all of them.
+   enum {
+      DecodeTableBits = 10,
+      DecodeTableSize = 1 << DecodeTableBits,
+   };
+
+   struct DecodeEntry {
+      S16 index;     // Same convention as HuffNode indices: negative values are leaves
+      U8  numBits;
+   };
+
+   DecodeEntry mDecodeTable[DecodeTableSize];
+
+   // Recently written strings keep their encoded bits, so a string broadcast to every client is only encoded once.
+   // Short strings are quicker to encode than to look up.
+   enum {
+      EncodingCacheSize = 32,          // Must be a power of 2
+      MinCachedStringLength = 16,
+      MaxEncodedBytes = (1 + 8 + MAX_SENDABLE_LINE_LENGTH * 8 + 7) / 8,
+   };
+
+   struct CachedEncoding {
+      U32  len;                  // 0 if the slot is empty
+      U32  numBits;
+      char string[MAX_SENDABLE_LINE_LENGTH];
+      U8   bits[MaxEncodedBytes];
+   };
+
+   CachedEncoding mEncodingCache[EncodingCacheSize];
+   Mutex mEncodingCacheMutex;    // Packets may be built on several threads at once
+
    void buildTables();
+   void buildDecodeTable();
 
    // We have to be a bit careful with these, since they are pointers...
    struct HuffWrap {
@@ -72,6 +106,14 @@ namespace HuffmanStringProcessor {
    S16 determineIndex(HuffWrap&);
 
    void generateCodes(BitStream&, S32, S32);
+
+   void encode(BitStream* pStream, const char* string, U32 len);
+
+   // Tables are built once, before main(), so readers and writers on different threads never race to build them
+   struct TableBuilder {
+      TableBuilder() { buildTables(); }
+   };
+   TableBuilder mTableBuilder;
 };
 
 //bool HuffmanStringProcessor::mTablesBuilt = false;
@@ -153,6 +195,8 @@ void HuffmanStringProcessor::buildTables()
    BitStream bs((U8 *) &code, 4);
 
    generateCodes(bs, 0, 0);
+
+   buildDecodeTable();
 }
 
 void HuffmanStringProcessor::generateCodes(BitStream& rBS, S32 index, S32 depth)
@@ -162,7 +206,12 @@ void HuffmanStringProcessor::generateCodes(BitStream& rBS, S32 index, S32 depth)
       HuffLeaf& rLeaf = mHuffLeaves[-(index + 1)];
 
       memcpy(&rLeaf.code, rBS.getBuffer(), sizeof(rLeaf.code));
+      rLeaf.code    = convertLEndianToHost(rLeaf.code);
       rLeaf.numBits = depth;
+
+      // The buffer still holds bits from deeper branches explored earlier
+      if (depth < 32)
+         rLeaf.code &= (U32(1) << depth) - 1;
    } else {
       HuffNode& rNode = mHuffNodes[index];
 
@@ -192,27 +241,49 @@ S16 HuffmanStringProcessor::determineIndex(HuffWrap& rWrap)
    }
 }
 
-bool HuffmanStringProcessor::readHuffBuffer(BitStream* pStream, char* out_pBuffer)
+// Walks the tree for every possible DecodeTableBits-bit window, taking bits LSB-first as they come off the stream
+void HuffmanStringProcessor::buildDecodeTable()
 {
-   if (mTablesBuilt == false)
-      buildTables();
+   for(U32 window = 0; window < DecodeTableSize; window++)
+   {
+      S32 index = 0;
+      U32 bits = 0;
+      while(index >= 0 && bits < DecodeTableBits)
+      {
+         if(window & (1 << bits))
+            index = mHuffNodes[index].index1;
+         else
+            index = mHuffNodes[index].index0;
+         bits++;
+      }
+
+      mDecodeTable[window].index   = S16(index);
+      mDecodeTable[window].numBits = U8(bits);
+   }
+}
 
+bool HuffmanStringProcessor::readHuffBuffer(BitStream* pStream, char* out_pBuffer)
+{
    if (pStream->readFlag()) {
       U32 len = pStream->readInt(8);
       for (U32 i = 0; i < len; i++) {
          S32 index = 0;
-         while (true) {
-            if (index >= 0) {
-               if (pStream->readFlag() == true) {
-                  index = mHuffNodes[index].index1;
-               } else {
-                  index = mHuffNodes[index].index0;
-               }
+
+         // Decode most symbols in one step; long codes, and the last few bits of the stream, finish a bit at a time
+         if (pStream->getBitPosition() + DecodeTableBits <= pStream->getMaxReadBitPosition()) {
+            const DecodeEntry& rEntry = mDecodeTable[pStream->readInt(DecodeTableBits)];
+            pStream->advanceBitPosition(S32(rEntry.numBits) - DecodeTableBits);
+            index = rEntry.index;
+         }
+
+         while (index >= 0) {
+            if (pStream->readFlag() == true) {
+               index = mHuffNodes[index].index1;
             } else {
-               out_pBuffer[i] = mHuffLeaves[-(index+1)].symbol;
-               break;
+               index = mHuffNodes[index].index0;
             }
          }
+         out_pBuffer[i] = mHuffLeaves[-(index+1)].symbol;
       }
       out_pBuffer[len] = '\0';
       return true;
@@ -225,6 +296,41 @@ bool HuffmanStringProcessor::readHuffBuffer(BitStream* pStream, char* out_pBuffe
    }
 }
 
+// Writes the compressed flag, length, and body of the first len characters of string
+void HuffmanStringProcessor::encode(BitStream* pStream, const char* string, U32 len)
+{
+   U32 numBits = 0;
+   U32 i;
+   for (i = 0; i < len; i++)
+      numBits += mHuffLeaves[(unsigned char)string[i]].numBits;
+
+   if (numBits >= (len * 8)) {
+      pStream->writeFlag(false);
+      pStream->writeInt(len, 8);
+      pStream->write(len, string);
+   } else {
+      pStream->writeFlag(true);
+      pStream->writeInt(len, 8);
+
+      // Collect codes into a 64-bit word and hand them to the stream 32 bits at a time
+      U64 pending = 0;
+      U32 pendingBits = 0;
+      for (i = 0; i < len; i++) {
+         const HuffLeaf& rLeaf = mHuffLeaves[((unsigned char)string[i])];
+         pending |= U64(rLeaf.code) << pendingBits;
+         pendingBits += rLeaf.numBits;
+
+         if (pendingBits >= 32) {
+            pStream->writeInt(U32(pending), 32);
+            pending >>= 32;
+            pendingBits -= 32;
+         }
+      }
+      if (pendingBits > 0)
+         pStream->writeInt(U32(pending), pendingBits);
+   }
+}
+
 bool HuffmanStringProcessor::writeHuffBuffer(BitStream* pStream, const char* out_pBuffer, U32 maxLen)
 {
    if (out_pBuffer == NULL) {
@@ -233,31 +339,42 @@ bool HuffmanStringProcessor::writeHuffBuffer(BitStream* pStream, const char* out
       return true;
    }
 
-   if (mTablesBuilt == false)
-      buildTables();
-
    U32 len = out_pBuffer ? strlen(out_pBuffer) : 0;
    TNLAssertV(len <= MAX_SENDABLE_LINE_LENGTH, ("String \"%s\" TOO long for writeString", out_pBuffer));
    if (len > maxLen)
       len = maxLen;
 
-   U32 numBits = 0;
-   U32 i;
-   for (i = 0; i < len; i++)
-      numBits += mHuffLeaves[(unsigned char)out_pBuffer[i]].numBits;
+   if (len < MinCachedStringLength || len > MAX_SENDABLE_LINE_LENGTH) {
+      encode(pStream, out_pBuffer, len);
+      return true;
+   }
 
-   if (numBits >= (len * 8)) {
-      pStream->writeFlag(false);
-      pStream->writeInt(len, 8);
-      pStream->write(len, out_pBuffer);
-   } else {
-      pStream->writeFlag(true);
-      pStream->writeInt(len, 8);
-      for (i = 0; i < len; i++) {
-         HuffLeaf& rLeaf = mHuffLeaves[((unsigned char)out_pBuffer[i])];
-         pStream->writeBits(rLeaf.numBits, &rLeaf.code);
-      }
+   // FNV-1a
+   U32 hash = 2166136261u;
+   for (U32 i = 0; i < len; i++)
+      hash = (hash ^ U8(out_pBuffer[i])) * 16777619u;
+
+   CachedEncoding& rEntry = mEncodingCache[hash & (EncodingCacheSize - 1)];
+
+   mEncodingCacheMutex.lock();
+   if (rEntry.len == len && memcmp(rEntry.string, out_pBuffer, len) == 0) {
+      pStream->writeBits(rEntry.numBits, rEntry.bits);
+      mEncodingCacheMutex.unlock();
+      return true;
    }
+   mEncodingCacheMutex.unlock();
+
+   U8 bits[MaxEncodedBytes];
+   BitStream encoded(bits, sizeof(bits));
+   encode(&encoded, out_pBuffer, len);
+   pStream->writeBits(encoded.getBitPosition(), bits);
+
+   mEncodingCacheMutex.lock();
+   rEntry.len = len;
+   rEntry.numBits = encoded.getBitPosition();
+   memcpy(rEntry.string, out_pBuffer, len);
+   memcpy(rEntry.bits, bits, encoded.getBytePosition());
+   mEncodingCacheMutex.unlock();
 
    return true;
 }
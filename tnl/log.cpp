@@ -26,6 +26,8 @@
 
 #include "tnlLog.h"
 #include "tnlDataChunker.h"
+#include "tnlThread.h"
+#include "tnlPlatform.h"
 
 #include <time.h>
 #include <string.h>
@@ -48,12 +50,24 @@ namespace TNL
 
 LogConsumer *LogConsumer::mLinkedList = NULL;
 
+
+// Serializes delivery of messages and changes to the consumer list, so any thread may log.  Created on first use,
+// because consumers are created during static initialization, and never deleted, because they log during shutdown.
+static Mutex &getConsumerLock()
+{
+   static Mutex *lock = new Mutex;
+   return *lock;
+}
+
+
 // Constructor -- add log to consumer list
 LogConsumer::LogConsumer()    
 {
    //mFilterType = GeneralFilter;
    mMsgTypes = 0xFFFFFFFF;       // All types on by default
 
+   getConsumerLock().lock();
+
    mNextConsumer = mLinkedList;
 
    if(mNextConsumer)
@@ -61,11 +75,15 @@ LogConsumer::LogConsumer()
 
    mPrevConsumer = NULL;
    mLinkedList = this;
+
+   getConsumerLock().unlock();
 }
 
 // Destructor -- remove log from consumer list
 LogConsumer::~LogConsumer()
 {
+   getConsumerLock().lock();
+
    if(mNextConsumer)
       mNextConsumer->mPrevConsumer = mPrevConsumer;
 
@@ -73,6 +91,8 @@ LogConsumer::~LogConsumer()
       mPrevConsumer->mNextConsumer = mNextConsumer;
    else
       mLinkedList = mNextConsumer;
+
+   getConsumerLock().unlock();
 }
 
 
@@ -94,19 +114,30 @@ void LogConsumer::setMsgType(MsgType msgType, bool enable)
 // Find all logs that are listenting to a specified MessageType and forward the message to them.  Static method.
 void LogConsumer::logString(LogConsumer::MsgType msgType, std::string message)
 {
+   getConsumerLock().lock();
+
    for(LogConsumer *walk = LogConsumer::getLinkedList(); walk; walk = walk->getNext())
       if(walk->mMsgTypes & msgType)     // Only log to the requested type of logfile
          walk->prepareAndLogString(message);
+
+   getConsumerLock().unlock();
+
+   // Errors are often the last thing we get to log; make sure they reach the disk
+   if(msgType != All && (msgType & (LogFatalError | LogError)))
+      FileLogConsumer::flushAll();
 }
 
 
-// Create reusable buffer for our logging functions.  Make it big because when we use datadumper 
-// in a script, some messages can get very long
-static char msg[1024 * 8];
+// Size of the buffer our logging functions format into.  Make it big because when we use datadumper 
+// in a script, some messages can get very long.  Each call has its own buffer on the stack, so threads
+// can log at the same time.
+static const S32 MessageBufferSize = 1024 * 8;
 
 
 void LogConsumer::logprintf(const char *format, ...)
 {
+   char msg[MessageBufferSize];
+
    va_list args; 
    va_start(args, format); 
 
@@ -116,7 +147,9 @@ void LogConsumer::logprintf(const char *format, ...)
 
    std::string message(msg);
 
+   getConsumerLock().lock();
    prepareAndLogString(message);
+   getConsumerLock().unlock();
 }
 
 
@@ -149,40 +182,265 @@ void LogConsumer::prepareAndLogString(std::string message)
 ////////////////////////////////////////
 ////////////////////////////////////////
 
+// Writes out the pending lines of every open FileLogConsumer, in batches, so the threads doing the logging never
+// wait on the disk.  Sleeps until a log has something for it, then until that is due to be written.
+class LogWriterThread : public Thread
+{
+public:
+   Mutex mLock;                              // Protects mLogs; held while writing, so a log can't close mid-write
+   Vector<FileLogConsumer *> mLogs;
+   Semaphore mWakeSemaphore;                 // Incremented when a log has lines we may need to schedule a write for
+
+   U32 run()
+   {
+      U32 waitMs = U32_MAX;      // Time until the next log is due to be written; U32_MAX if none have anything
+
+      while(true)
+      {
+         if(waitMs == U32_MAX)
+            mWakeSemaphore.wait();
+         else
+            mWakeSemaphore.wait(waitMs);
+
+         U32 currentTime = Platform::getRealMilliseconds();
+         waitMs = U32_MAX;
+
+         mLock.lock();
+         for(S32 i = 0; i < mLogs.size(); i++)
+            waitMs = getMin(waitMs, mLogs[i]->flushIfDue(currentTime));
+         mLock.unlock();
+      }
+
+      return 0;
+   }
+};
+
+
+// Started when the first log is opened, and never stopped -- it outlives any static FileLogConsumer
+static LogWriterThread *gLogWriter = NULL;
+
+
+static LogWriterThread *getLogWriter()
+{
+   getConsumerLock().lock();
+
+   if(!gLogWriter)
+   {
+      gLogWriter = new LogWriterThread;
+      gLogWriter->incRef();         // Never released
+      gLogWriter->start();
+   }
+
+   getConsumerLock().unlock();
+
+   return gLogWriter;
+}
+
+
 // Constructor -- open the file
 FileLogConsumer::FileLogConsumer()    // Constructor
 {
    f = NULL;
+   mPendingLock = new Mutex;
+   mFileLock = new Mutex;
+   mLastFlushTime = 0;
+   mUnreportedDrops = 0;
+   mDroppedLineCount = 0;
 }
 
 
 // Destructor -- close the file
 FileLogConsumer::~FileLogConsumer()    
 {
+   if(gLogWriter)
+   {
+      gLogWriter->mLock.lock();
+      S32 index = gLogWriter->mLogs.getIndex(this);
+      if(index != -1)
+         gLogWriter->mLogs.erase_fast(index);
+      gLogWriter->mLock.unlock();
+   }
+
+   flush();
+
    if(f)
       fclose(f);
+
+   delete mFileLock;
+   delete mPendingLock;
 }
 
 void FileLogConsumer::init(std::string logFile, const char *mode)
 {
+   LogWriterThread *writer = getLogWriter();
+
+   flush();
+
+   mFileLock->lock();
+
    if(f)
       fclose(f);
 
    f = fopen(logFile.c_str(), mode);
+
+   mFileLock->unlock();
+
+   mPendingLock->lock();
+   mDroppedLineCount = 0;
+   mLastFlushTime = Platform::getRealMilliseconds();
+   mPendingLock->unlock();
+
    if(!f)
       TNLAssert(false, "Can't open log file for writing!");    // TODO: What should we really do?
+
+   writer->mLock.lock();
+   if(writer->mLogs.getIndex(this) == -1)
+      writer->mLogs.push_back(this);
+   writer->mLock.unlock();
 }
 
 
 void FileLogConsumer::writeString(const char *string)
 {
-   if(f)
+   if(!f)
+      return;
+      //TNLAssert(false, "Logfile not initialized!");  // Causes stack overflow
+
+   U32 len = (U32)strlen(string);
+
+   mPendingLock->lock();
+
+   // The writer thread needs to hear about the first line since its last write, so it can schedule the next one,
+   // and about us passing FlushSize, so it can write right away
+   U32 pendingSize = (U32)mPending.size();
+   bool wakeWriter = pendingSize == 0 && mUnreportedDrops == 0;
+
+   if(pendingSize + len > MaxPendingSize)
    {
-      fprintf(f, "%s", string);
+      mUnreportedDrops++;
+      mDroppedLineCount++;
+   }
+   else
+   {
+      mPending.append(string, len);
+      wakeWriter = wakeWriter || (pendingSize < FlushSize && pendingSize + len >= FlushSize);
+   }
+
+   mPendingLock->unlock();
+
+   if(wakeWriter && gLogWriter)
+      gLogWriter->mWakeSemaphore.increment();
+}
+
+
+void FileLogConsumer::flush()
+{
+   // Holding the file lock throughout keeps batches in order when two threads flush at once
+   mFileLock->lock();
+
+   std::string batch;
+   U32 drops;
+
+   mPendingLock->lock();
+   batch.swap(mPending);
+   drops = mUnreportedDrops;
+   mUnreportedDrops = 0;
+   mLastFlushTime = Platform::getRealMilliseconds();
+   mPendingLock->unlock();
+
+   if(f && (batch.size() > 0 || drops > 0))
+   {
+      fwrite(batch.c_str(), 1, batch.size(), f);
+
+      if(drops > 0)
+         fprintf(f, "*** Log writer fell behind; %u lines were dropped ***\n", drops);
+
       fflush(f);
    }
-   //else
-      //TNLAssert(false, "Logfile not initialized!");  // Causes stack overflow
+
+   mFileLock->unlock();
+}
+
+
+U32 FileLogConsumer::flushIfDue(U32 currentTime)
+{
+   mPendingLock->lock();
+   U32 age = currentTime - mLastFlushTime;
+   bool waiting = mPending.size() > 0;
+   bool due = mPending.size() >= FlushSize || mUnreportedDrops > 0 || (waiting && age >= FlushIntervalMs);
+   mPendingLock->unlock();
+
+   if(due)
+   {
+      flush();
+      return U32_MAX;      // Anything logged since will wake the writer again
+   }
+
+   return waiting ? FlushIntervalMs - age : U32_MAX;
+}
+
+
+U32 FileLogConsumer::getDroppedLineCount()
+{
+   mPendingLock->lock();
+   U32 count = mDroppedLineCount;
+   mPendingLock->unlock();
+
+   return count;
+}
+
+
+// Static method
+void FileLogConsumer::flushAll()
+{
+   if(!gLogWriter)
+      return;
+
+   gLogWriter->mLock.lock();
+   for(S32 i = 0; i < gLogWriter->mLogs.size(); i++)
+      gLogWriter->mLogs[i]->flush();
+   gLogWriter->mLock.unlock();
+}
+
+
+// Like flush(), but gives up rather than wait for a lock.  The thread that crashed may be holding any of them, and
+// since they're recursive, we may even get one it holds; the pending lines are written as they are, so this is
+// best effort.  Returns false if a lock was taken.
+bool FileLogConsumer::tryFlush()
+{
+   if(!mFileLock->tryLock())
+      return false;
+
+   if(!mPendingLock->tryLock())
+   {
+      mFileLock->unlock();
+      return false;
+   }
+
+   if(f && mPending.size() > 0)
+   {
+      fwrite(mPending.c_str(), 1, mPending.size(), f);
+      fflush(f);
+      mPending.clear();
+   }
+
+   mPendingLock->unlock();
+   mFileLock->unlock();
+
+   return true;
+}
+
+
+// Static method -- flushAll() for signal handlers, which must not block; logs we can't get at are skipped
+void FileLogConsumer::flushAllForCrash()
+{
+   if(!gLogWriter || !gLogWriter->mLock.tryLock())
+      return;
+
+   for(S32 i = 0; i < gLogWriter->mLogs.size(); i++)
+      gLogWriter->mLogs[i]->tryFlush();
+
+   gLogWriter->mLock.unlock();
 }
 
 
@@ -224,6 +482,8 @@ LogType *LogType::find(const char *name)
 // Logs to logfiles that have subscribed to specified message type
 void logprintf(LogConsumer::MsgType msgType, const char *format, ...)
 {
+   char msg[MessageBufferSize];
+
    va_list args; 
    va_start(args, format); 
 
@@ -240,6 +500,8 @@ void logprintf(LogConsumer::MsgType msgType, const char *format, ...)
 // Logs to general log
 void logprintf(const char *format, ...)
 {
+   char msg[MessageBufferSize];
+
    va_list args; 
    va_start(args, format); 
 
@@ -40,6 +40,7 @@ Vector<NetClassRep *> NetClassRep::mClassTable[NetClassGroupCount][NetClassTypeC
 U32 NetClassRep::mClassCRC[NetClassGroupCount] = {INITIAL_CRC_VALUE, };
 
 bool NetClassRep::mInitialized = false;
+bool NetClassRep::mCollectUnpackStats = false;
 
 NetClassRep::NetClassRep()
 {
@@ -47,6 +48,11 @@ NetClassRep::NetClassRep()
    mInitialUpdateBitsUsed = 0;
    mPartialUpdateCount = 0;
    mPartialUpdateBitsUsed = 0;
+   mInitialUpdateCacheHits = 0;
+   mPartialUpdateCacheHits = 0;
+   mUnpackCount = 0;
+   mUnpackBitsRead = 0;
+   mUnpackTime = 0;
 }
 
 Object* NetClassRep::create(const char* className)
@@ -138,6 +144,17 @@ void NetClassRep::initialize()
 }
 
 
+void NetClassRep::resetUnpackStats()
+{
+   for(NetClassRep *walk = mClassLinkList; walk; walk = walk->mNextClass)
+   {
+      walk->mUnpackCount = 0;
+      walk->mUnpackBitsRead = 0;
+      walk->mUnpackTime = 0;
+   }
+}
+
+
 // Only called on exit
 void NetClassRep::logBitUsage()
 {
@@ -149,17 +166,19 @@ void NetClassRep::logBitUsage()
    {
       if(walk->mInitialUpdateCount)
       {
-         logprintf(LogConsumer::LogNetBase, "%s (Initialized) - Count: %d   Total: %d   Avg Size: %g", 
+         logprintf(LogConsumer::LogNetBase, "%s (Initialized) - Count: %d   Total: %d   Avg Size: %g   Cache Hits: %g%%", 
                walk->mClassName, walk->mInitialUpdateCount, walk->mInitialUpdateBitsUsed, 
-               walk->mInitialUpdateBitsUsed / F32(walk->mInitialUpdateCount));
+               walk->mInitialUpdateBitsUsed / F32(walk->mInitialUpdateCount),
+               walk->mInitialUpdateCacheHits * 100 / F32(walk->mInitialUpdateCount));
          atLeastOne = true;
       }
 
       if(walk->mPartialUpdateCount)
       {
-         logprintf(LogConsumer::LogNetBase, "%s (Updated) - Count: %d   Total: %d   Avg Size: %g", 
+         logprintf(LogConsumer::LogNetBase, "%s (Updated) - Count: %d   Total: %d   Avg Size: %g   Cache Hits: %g%%", 
                walk->mClassName, walk->mPartialUpdateCount, walk->mPartialUpdateBitsUsed, 
-               walk->mPartialUpdateBitsUsed / F32(walk->mPartialUpdateCount));
+               walk->mPartialUpdateBitsUsed / F32(walk->mPartialUpdateCount),
+               walk->mPartialUpdateCacheHits * 100 / F32(walk->mPartialUpdateCount));
          atLeastOne = true;
       }
    }
@@ -205,16 +205,16 @@ void NetConnection::keepAlive()
 
 //--------------------------------------------------------------------
 
-char NetConnection::mErrorBuffer[256];
-
 void NetConnection::setLastError(const char *fmt, ...)
 {
+   char *errorBuffer = getErrorBuffer();
+
    va_list argptr;
    va_start(argptr, fmt);
-   vsnprintf(mErrorBuffer, sizeof(mErrorBuffer), fmt, argptr);
+   vsnprintf(errorBuffer, ThreadContext::ErrorBufferSize, fmt, argptr);
    // setLastErrors assert in debug builds
    
-   TNLAssert(0, mErrorBuffer);
+   TNLAssert(0, errorBuffer);
    va_end(argptr);
 }
 
@@ -264,7 +264,7 @@ void NetConnection::readRawPacket(BitStream *bstream)
    mPacketRecvCount++;
    logprintf(LogConsumer::LogNetConnection, "NetConnection %s: RECV- %d bytes", mNetAddress.toString(), mPacketRecvBytesLast);
 
-   mErrorBuffer[0] = 0;
+   getErrorBuffer()[0] = 0;
 
    if(readPacketHeader(bstream))
    {
@@ -274,13 +274,13 @@ void NetConnection::readRawPacket(BitStream *bstream)
       bstream->setStringTable(mStringTable);
       readPacket(bstream);
 
-      if(!bstream->isValid() && !mErrorBuffer[0])
+      if(!bstream->isValid() && !getErrorBuffer()[0])
          NetConnection::setLastError("Invalid Packet -- broken bstream");
 
-      if(mErrorBuffer[0])
-         getInterface()->handleConnectionError(this, mErrorBuffer);
+      if(getErrorBuffer()[0])
+         getInterface()->handleConnectionError(this, getErrorBuffer());
 
-      mErrorBuffer[0] = 0;
+      getErrorBuffer()[0] = 0;
    }
 }
 
@@ -676,6 +676,23 @@ void NetConnection::handleNotify(U32 sequence, bool recvd)
 //--------------------------------------------------------------------
 
 void NetConnection::checkPacketSend(bool force, U32 curTime)
+{
+   if(!isTimeToSendPacket(force, curTime))
+      return;
+
+   prepareWritePacket();
+
+   if(!isReadyToWritePacket())
+   {
+      // there is nothing to transmit, or the window is full
+      checkAckPacketSend(curTime);
+      return;
+   }
+
+   writeAndSendPacket(curTime);
+}
+
+bool NetConnection::isTimeToSendPacket(bool force, U32 curTime)
 {
    U32 delay = mCurrentPacketSendPeriod;
 
@@ -689,39 +706,47 @@ void NetConnection::checkPacketSend(bool force, U32 curTime)
             delay *= (mLastSendSeq - mHighestAckedSeq - 5) * 2;
 
          if(curTime - mLastUpdateTime + mSendDelayCredit < delay)
-            return;
+            return false;
       
          mSendDelayCredit = curTime - (mLastUpdateTime + delay - mSendDelayCredit);
          if(mSendDelayCredit > 1000)
             mSendDelayCredit = 1000;
       }
    }
-   prepareWritePacket();
-   if(windowFull() || !isDataToTransmit())
+   return true;
+}
+
+bool NetConnection::isReadyToWritePacket()
+{
+   return !windowFull() && isDataToTransmit();
+}
+
+void NetConnection::checkAckPacketSend(U32 curTime)
+{
+   if(isAdaptive())
    {
-      // there is nothing to transmit, or the window is full
-      if(isAdaptive())
-      {
-         // Still, on an adaptive connection, we may need to send an ack here...
-
-         // Check if we should ack. We use a heuristic to do this. (fuzzy logic!)
-         S32 ackDelta = (mLastSeqRecvd - mLastSeqRecvdAck);
-         F32 ack = ackDelta / 4.0f;
-
-         // Multiply by the time since we've acked...
-         // If we're much below 200, we don't want to ack; if we're much over we do.
-         U32 deltaT = (curTime - mLastAckTime);
-         ack = ack *  deltaT / 200.0f;
-
-         if((ack > 1.0f || (ackDelta > (0.75*MaxPacketWindowSize))) && (mLastSeqRecvdAck != mLastSeqRecvd))
-         {         
-            mLastSeqRecvdAck = mLastSeqRecvd;
-            mLastAckTime = curTime;
-            sendAckPacket();
-         }
+      // Still, on an adaptive connection, we may need to send an ack here...
+
+      // Check if we should ack. We use a heuristic to do this. (fuzzy logic!)
+      S32 ackDelta = (mLastSeqRecvd - mLastSeqRecvdAck);
+      F32 ack = ackDelta / 4.0f;
+
+      // Multiply by the time since we've acked...
+      // If we're much below 200, we don't want to ack; if we're much over we do.
+      U32 deltaT = (curTime - mLastAckTime);
+      ack = ack *  deltaT / 200.0f;
+
+      if((ack > 1.0f || (ackDelta > (0.75*MaxPacketWindowSize))) && (mLastSeqRecvdAck != mLastSeqRecvd))
+      {         
+         mLastSeqRecvdAck = mLastSeqRecvd;
+         mLastAckTime = curTime;
+         sendAckPacket();
       }
-      return;
    }
+}
+
+void NetConnection::writeAndSendPacket(U32 curTime)
+{
    PacketStream stream(mCurrentPacketSendSize);
    mLastUpdateTime = curTime;
 
@@ -795,6 +820,26 @@ void NetConnection::prepareWritePacket()
 {
 }
 
+void NetConnection::beginPrepareWritePacket()
+{
+}
+
+void NetConnection::prepareWritePacketConcurrent()
+{
+}
+
+void NetConnection::endPrepareWritePacket()
+{
+}
+
+void NetConnection::beginWritePacket()
+{
+}
+
+void NetConnection::writePacketConcurrent()
+{
+}
+
 void NetConnection::writePacket(BitStream *bstream, PacketNotify *note)
 {
 }
@@ -33,6 +33,7 @@
 #include "tnlNetObject.h"
 #include "tnlClientPuzzle.h"
 #include "tnlCertificate.h"
+#include "tnlThread.h"
 #include <tomcrypt.h>
 
 namespace TNL {
@@ -56,6 +57,14 @@ NetInterface::NetInterface(const Address &bindAddress) : mSocket(bindAddress)
       mConnectionHashTable[i] = NULL;
    mSendPacketList = NULL;
    mCurrentTime = Platform::getRealMilliseconds();
+
+   mWorkerPool = NULL;
+   resetPacketBuildStats();
+
+   mRecvArena.resize(Socket::MaxBatchSize * MaxPacketDataSize);
+   mRecvAddresses.resize(Socket::MaxBatchSize);
+   mRecvSizes.resize(Socket::MaxBatchSize);
+   mQueueSends = false;
 }
 
 NetInterface::~NetInterface()
@@ -73,6 +82,7 @@ NetInterface::~NetInterface()
       free(mSendPacketList);
       mSendPacketList = next;
    }
+   delete mWorkerPool;
 }
 
 Address NetInterface::getFirstBoundInterfaceAddress()
@@ -104,7 +114,46 @@ void NetInterface::setPrivateKey(AsymmetricKey *theKey)
 
 NetError NetInterface::sendto(const Address &address, BitStream *stream)
 {
-   return mSocket.sendto(address, stream->getBuffer(), stream->getBytePosition());
+   return sendPacketData(address, stream->getBuffer(), stream->getBytePosition());
+}
+
+/// Sends now, or queues the packet if processConnections() is running; errors from queued packets aren't reported,
+/// but nothing acts on a send error anyway
+NetError NetInterface::sendPacketData(const Address &address, const U8 *data, S32 size)
+{
+   if(!mQueueSends)
+      return mSocket.sendto(address, data, size);
+
+   U32 offset = mSendArena.size();
+   mSendArena.resize(offset + size);
+   if(size > 0)
+      memcpy(&mSendArena[offset], data, size);
+
+   mSendAddresses.push_back(address);
+   mSendSizes.push_back(size);
+
+   return NoError;
+}
+
+void NetInterface::flushSendQueue()
+{
+   if(mSendSizes.size() == 0)
+      return;
+
+   // Point at each packet only now that the arena has stopped growing
+   U8 *data = mSendArena.address();
+   for(S32 i = 0; i < mSendSizes.size(); i++)
+   {
+      mSendBuffers.push_back(data);
+      data += mSendSizes[i];
+   }
+
+   mSocket.sendtoBatch(mSendAddresses.address(), mSendBuffers.address(), mSendSizes.address(), mSendSizes.size());
+
+   mSendArena.clear();
+   mSendAddresses.clear();
+   mSendSizes.clear();
+   mSendBuffers.clear();
 }
 
 void NetInterface::sendtoDelayed(const Address *address, NetConnection *receiveTo, BitStream *stream, U32 millisecondDelay)
@@ -322,11 +371,133 @@ void NetInterface::addConnection(NetConnection *conn)
 // NetInterface timeout and packet send processing
 //-----------------------------------------------------------------------------
 
+void NetInterface::setWorkerThreadCount(U32 count)
+{
+   if(count == getWorkerThreadCount())
+      return;
+
+   delete mWorkerPool;
+   mWorkerPool = count ? new WorkerPool(count) : NULL;
+   resetPacketBuildStats();
+}
+
+U32 NetInterface::getWorkerThreadCount()
+{
+   return mWorkerPool ? mWorkerPool->getThreadCount() : 0;
+}
+
+void NetInterface::resetPacketBuildStats()
+{
+   mPacketBuildStats.passes = 0;
+   mPacketBuildStats.packets = 0;
+   mPacketBuildStats.prepareTime = 0;
+   mPacketBuildStats.scopeTime = 0;
+   mPacketBuildStats.bookkeepingTime = 0;
+   mPacketBuildStats.prioritizeTime = 0;
+   mPacketBuildStats.writeTime = 0;
+}
+
+/// Runs one phase of processConnectionsInParallel() on every sending connection
+class ConnectionPhaseTask : public WorkerTask
+{
+   NetInterface *mInterface;
+   NetInterface::ConnectionPhase mPhase;
+public:
+   ConnectionPhaseTask(NetInterface *theInterface, NetInterface::ConnectionPhase phase)
+   {
+      mInterface = theInterface;
+      mPhase = phase;
+   }
+   void runTask(S32 index) { mInterface->runConnectionPhase(mPhase, index); }
+};
+
+void NetInterface::runConnectionPhase(ConnectionPhase phase, S32 index)
+{
+   NetConnection *conn = mSendingConnections[index];
+   if(phase == ScopePhase)
+      conn->prepareWritePacketConcurrent();
+   else
+      conn->writePacketConcurrent();
+}
+
+/// Same as calling checkPacketSend() on each connection, except that the work of finding which objects are in
+/// scope and prioritizing ghost updates is spread over our worker threads.  Everything that touches state shared
+/// between connections -- creating ghosts, and writing packets -- still happens here on the main thread.
+void NetInterface::processConnectionsInParallel()
+{
+   S64 phaseStart = Platform::getHighPrecisionTimerValue();
+   S64 now;
+
+   // Hold references so a connection can't go away while we are partway through building its packet
+   mSendingConnections.clear();
+   for(S32 i = 0; i < mConnectionList.size(); i++)
+   {
+      NetConnection *conn = mConnectionList[i];
+      if(conn->isTimeToSendPacket(false, getCurrentTime()))
+      {
+         conn->beginPrepareWritePacket();
+         mSendingConnections.push_back(conn);
+      }
+   }
+
+   now = Platform::getHighPrecisionTimerValue();
+   mPacketBuildStats.prepareTime += Platform::getHighPrecisionMilliseconds(now - phaseStart);
+   phaseStart = now;
+
+   ConnectionPhaseTask scopeTask(this, ScopePhase);
+   mWorkerPool->run(&scopeTask, mSendingConnections.size());
+
+   now = Platform::getHighPrecisionTimerValue();
+   mPacketBuildStats.scopeTime += Platform::getHighPrecisionMilliseconds(now - phaseStart);
+   phaseStart = now;
+
+   for(S32 i = 0; i < mSendingConnections.size(); )
+   {
+      NetConnection *conn = mSendingConnections[i];
+      conn->endPrepareWritePacket();
+
+      if(conn->isReadyToWritePacket())
+      {
+         conn->beginWritePacket();
+         i++;
+      }
+      else
+      {
+         // there is nothing to transmit, or the window is full
+         conn->checkAckPacketSend(getCurrentTime());
+         mSendingConnections.erase(i);
+      }
+   }
+
+   now = Platform::getHighPrecisionTimerValue();
+   mPacketBuildStats.bookkeepingTime += Platform::getHighPrecisionMilliseconds(now - phaseStart);
+   phaseStart = now;
+
+   ConnectionPhaseTask prioritizeTask(this, PrioritizePhase);
+   mWorkerPool->run(&prioritizeTask, mSendingConnections.size());
+
+   now = Platform::getHighPrecisionTimerValue();
+   mPacketBuildStats.prioritizeTime += Platform::getHighPrecisionMilliseconds(now - phaseStart);
+   phaseStart = now;
+
+   for(S32 i = 0; i < mSendingConnections.size(); i++)
+      mSendingConnections[i]->writeAndSendPacket(getCurrentTime());
+
+   now = Platform::getHighPrecisionTimerValue();
+   mPacketBuildStats.writeTime += Platform::getHighPrecisionMilliseconds(now - phaseStart);
+
+   mPacketBuildStats.passes++;
+   mPacketBuildStats.packets += mSendingConnections.size();
+   mSendingConnections.clear();
+}
+
 void NetInterface::processConnections()
 {
    mCurrentTime = Platform::getRealMilliseconds();
    mPuzzleManager.tick(mCurrentTime);
 
+   mQueueSends = true;
+
    // first see if there are any delayed packets that need to be sent...
    while(mSendPacketList && S32(mSendPacketList->sendTime - getCurrentTime()) < 0)
    {
@@ -344,7 +515,7 @@ void NetInterface::processConnections()
       }
       else
       {
-         mSocket.sendto(mSendPacketList->remoteAddress,
+         sendPacketData(mSendPacketList->remoteAddress,
             mSendPacketList->packetData, mSendPacketList->packetSize);
       }
       mSendPacketList->~DelaySendPacket(); // properly free stuff like SafePtr
@@ -353,8 +524,20 @@ void NetInterface::processConnections()
    }
 
    NetObject::collapseDirtyList(); // collapse all the mask bits...
-   for(S32 i = 0; i < mConnectionList.size(); i++)
-      mConnectionList[i]->checkPacketSend(false, getCurrentTime());
+
+   // Nothing changes object state while we send, so objects can share updates between connections
+   NetObject::beginUpdateCachePass();
+
+   if(mWorkerPool)
+      processConnectionsInParallel();
+   else
+      for(S32 i = 0; i < mConnectionList.size(); i++)
+         mConnectionList[i]->checkPacketSend(false, getCurrentTime());
+
+   NetObject::endUpdateCachePass();
+
+   mQueueSends = false;
+   flushSendQueue();
 
    if(U32(getCurrentTime() - mLastTimeoutCheckTime) > TimeoutCheckInterval)
    {
@@ -447,15 +630,23 @@ void NetInterface::processConnections()
 
 void NetInterface::checkIncomingPackets()
 {
-   PacketStream stream;
-   NetError error;
-   Address sourceAddress;
-
    mCurrentTime = Platform::getRealMilliseconds();
 
-   // read out all the available packets:
-   while((error = stream.recvfrom(mSocket, &sourceAddress)) == NoError)
-      processPacket(sourceAddress, &stream);
+   // read out all the available packets, a batch at a time; a short batch means we've emptied the socket
+   S32 count;
+   do
+   {
+      count = mSocket.recvfromBatch(mRecvAddresses.address(), mRecvArena.address(), MaxPacketDataSize,
+                                    mRecvSizes.address(), Socket::MaxBatchSize);
+
+      for(S32 i = 0; i < count; i++)
+      {
+         BitStream stream(&mRecvArena[i * MaxPacketDataSize], mRecvSizes[i]);
+         stream.setMaxSizes(mRecvSizes[i], 0);
+         stream.reset();
+         processPacket(mRecvAddresses[i], &stream);
+      }
+   } while(count == Socket::MaxBatchSize);
 }
 
 void NetInterface::processPacket(const Address &sourceAddress, BitStream *pStream)
@@ -31,10 +31,6 @@
 
 namespace TNL {
 
-GhostConnection *NetObject::mRPCSourceConnection = NULL;
-GhostConnection *NetObject::mRPCDestConnection = NULL;
-bool NetObject::mIsInitialUpdate = false;
-
 NetObject::NetObject()
 {
    // netFlags will clear itself to 0
@@ -66,30 +62,36 @@ NetObject::~NetObject()
       if(mPrevDirtyList)
          mPrevDirtyList->mNextDirtyList = mNextDirtyList;
       else
-         mDirtyList = mNextDirtyList;
+         ThreadContext::getCurrent()->mDirtyList = mNextDirtyList;
       if(mNextDirtyList)
          mNextDirtyList->mPrevDirtyList = mPrevDirtyList;
    }
 }
 
-NetObject *NetObject::mDirtyList = NULL;
-
 void NetObject::setMaskBits(U32 orMask)
 {
    TNLAssert(orMask != 0, "Invalid net mask bits set.");
-   TNLAssert(mDirtyMaskBits == 0 || (mPrevDirtyList != NULL || mNextDirtyList != NULL || mDirtyList == this), "Invalid dirty list state.");
+
+   // Nobody is ghosting this object, so there is nobody to tell; a ghost created later starts with every bit set
+   // anyway.  This also keeps objects being built off the main thread (e.g. preloaded levels) out of the shared list.
+   if(!mFirstObjectRef)
+      return;
+
+   NetObject *&dirtyList = ThreadContext::getCurrent()->mDirtyList;
+
+   TNLAssert(mDirtyMaskBits == 0 || (mPrevDirtyList != NULL || mNextDirtyList != NULL || dirtyList == this), "Invalid dirty list state.");
    if(!mDirtyMaskBits)
    {
       TNLAssert(mNextDirtyList == NULL && mPrevDirtyList == NULL, "Object with zero mask already in list.");
-      if(mDirtyList)
+      if(dirtyList)
       {
-         mNextDirtyList = mDirtyList;
-         mDirtyList->mPrevDirtyList = this;
+         mNextDirtyList = dirtyList;
+         dirtyList->mPrevDirtyList = this;
       }
-      mDirtyList = this;
+      dirtyList = this;
    }
    mDirtyMaskBits |= orMask;
-   TNLAssert(mDirtyMaskBits == 0 || (mPrevDirtyList != NULL || mNextDirtyList != NULL || mDirtyList == this), "Invalid dirty list state.");
+   TNLAssert(mDirtyMaskBits == 0 || (mPrevDirtyList != NULL || mNextDirtyList != NULL || dirtyList == this), "Invalid dirty list state.");
 }
 
 void NetObject::clearMaskBits(U32 orMask)
@@ -102,7 +104,7 @@ void NetObject::clearMaskBits(U32 orMask)
          if(mPrevDirtyList)
             mPrevDirtyList->mNextDirtyList = mNextDirtyList;
          else
-            mDirtyList = mNextDirtyList;
+            ThreadContext::getCurrent()->mDirtyList = mNextDirtyList;
          if(mNextDirtyList)
             mNextDirtyList->mPrevDirtyList = mPrevDirtyList;
          mNextDirtyList = mPrevDirtyList = NULL;
@@ -123,11 +125,13 @@ void NetObject::clearMaskBits(U32 orMask)
 
 void NetObject::collapseDirtyList()
 {
+   NetObject *&dirtyList = ThreadContext::getCurrent()->mDirtyList;
+
    Vector<NetObject *> tempV;
-   for(NetObject *t = mDirtyList; t; t = t->mNextDirtyList)
+   for(NetObject *t = dirtyList; t; t = t->mNextDirtyList)
       tempV.push_back(t);
 
-   for(NetObject *obj = mDirtyList; obj; )
+   for(NetObject *obj = dirtyList; obj; )
    {
       NetObject *next = obj->mNextDirtyList;
       U32 orMask = obj->mDirtyMaskBits;
@@ -151,7 +155,7 @@ void NetObject::collapseDirtyList()
       }
       obj = next;
    }
-   mDirtyList = NULL;
+   dirtyList = NULL;
    for(S32 i = 0; i < tempV.size(); i++)
    {
       TNLAssert(tempV[i]->mNextDirtyList == NULL && tempV[i]->mPrevDirtyList == NULL && tempV[i]->mDirtyMaskBits == 0, "Error in collapse");
@@ -194,6 +198,84 @@ void NetObject::unpackUpdate(GhostConnection*, BitStream*)
    // Do nothing
 }
 
+S32 NetObject::getUpdateCacheKey(GhostConnection*)
+{
+   return UpdateNotCacheable;
+}
+
+void NetObject::beginUpdateCachePass()
+{
+   ThreadContext *context = ThreadContext::getCurrent();
+   context->mUpdateCachePass++;
+   context->mUpdateCacheActive = true;
+}
+
+void NetObject::endUpdateCachePass()
+{
+   ThreadContext::getCurrent()->mUpdateCacheActive = false;
+}
+
+bool NetObject::writeCachedUpdate(S32 key, U32 updateMask, BitStream *stream, U32 &retMask)
+{
+   ThreadContext *context = ThreadContext::getCurrent();
+   if(!context->mUpdateCacheActive)
+      return false;
+
+   for(S32 i = 0; i < mUpdateCache.size(); i++)
+   {
+      CachedUpdate &entry = mUpdateCache[i];
+      if(entry.pass == context->mUpdateCachePass && entry.key == key && entry.updateMask == updateMask &&
+            entry.initialUpdate == context->mIsInitialUpdate)
+      {
+         stream->writeBits(entry.bitCount, entry.bits.address());
+         retMask = entry.retMask;
+         return true;
+      }
+   }
+   return false;
+}
+
+void NetObject::cacheUpdate(S32 key, U32 updateMask, BitStream *stream, U32 startBitPosition, U32 retMask)
+{
+   ThreadContext *context = ThreadContext::getCurrent();
+   if(!context->mUpdateCacheActive)
+      return;
+
+   // Reuse an entry from an earlier pass if there is one, so we don't keep reallocating bits
+   S32 index = -1;
+   for(S32 i = 0; i < mUpdateCache.size(); i++)
+      if(mUpdateCache[i].pass != context->mUpdateCachePass)
+      {
+         index = i;
+         break;
+      }
+
+   if(index == -1)
+   {
+      if(mUpdateCache.size() < MaxCachedUpdates)
+      {
+         index = mUpdateCache.size();
+         mUpdateCache.resize(index + 1);
+      }
+      else
+         index = MaxCachedUpdates - 1;
+   }
+
+   CachedUpdate &entry = mUpdateCache[index];
+   entry.pass = context->mUpdateCachePass;
+   entry.key = key;
+   entry.updateMask = updateMask;
+   entry.initialUpdate = context->mIsInitialUpdate;
+   entry.retMask = retMask;
+   entry.bitCount = stream->getBitPosition() - startBitPosition;
+   entry.bits.resize((entry.bitCount + 7) >> 3);
+
+   // Read the bits back out of the packet with a second stream, so we don't disturb the packet's own
+   BitStream source(stream->getBuffer(), stream->getBufferSize());
+   source.setBitPosition(startBitPosition);
+   source.readBits(entry.bitCount, entry.bits.address());
+}
+
 void NetObject::performScopeQuery(GhostConnection *connection)
 {
    // default behavior - since we have no idea here about
@@ -274,10 +356,10 @@ void NetObjectRPCEvent::process(EventConnection *ps)
 
    Object *thisPointer = (Object *) mDestObject.getPointer();
 
-   NetObject::mRPCSourceConnection = (GhostConnection *) ps;
+   ThreadContext::getCurrent()->mRPCSourceConnection = (GhostConnection *) ps;
    mFunctor->dispatch(thisPointer);
 
-   NetObject::mRPCSourceConnection = NULL;
+   ThreadContext::getCurrent()->mRPCSourceConnection = NULL;
 }
 
 };
@@ -30,6 +30,7 @@
 #include "tnlNetStringTable.h"
 #include "tnlDataChunker.h"
 #include "tnlNetInterface.h"
+#include "tnlThread.h"
 
 namespace TNL {
 
@@ -68,6 +69,9 @@ U32 mItemCount = 0; ///< number of strings in the table
 DataChunker *mMemPool = NULL; ///< memory pool from which string table data is allocated
 U32 mFreeStringDataSize = 0; ///< number of bytes freed by deallocated strings.  When this number exceeds CompactThreshold, the table is compacted.
 
+U32 mThreadedUseCount = 0; ///< While non-zero, other threads may be using the table; only changed with mTableMutex held
+Mutex mTableMutex; ///< Guards the table while mThreadedUseCount is non-zero
+
 // a little note about the free list...
 // the free list is essentially an index linked list encoded in the node
 // list.  The first entry in the list is mNodeListFreeEntry.
@@ -90,6 +94,24 @@ void resizeHashTable(const U32 newSize);
 /// compacts the string data associated with the string table.
 void compact();
 
+/// Locking is only needed while another thread may be using the table.  Returns whether we locked, which must be
+/// passed to the matching unlockTable(): threaded use may begin or end in between, and we must only unlock what we
+/// locked.
+inline bool lockTable()
+{
+   if(!mThreadedUseCount)
+      return false;
+
+   mTableMutex.lock();
+   return true;
+}
+
+inline void unlockTable(bool locked)
+{
+   if(locked)
+      mTableMutex.unlock();
+}
+
 //---------------------------------------------------------------
 //
 // StringTable functions
@@ -226,10 +248,8 @@ void validate()
 }
 
 
-StringTableEntryId insertn(const char* val, S32 len, const bool caseSens)
+static StringTableEntryId insertnUnlocked(const char* val, S32 len, const bool caseSens)
 {
-   if(!val || !*val || len == 0)
-      return 0;
    if(!mBuckets)
       init();
    StringTableEntryId *walk;
@@ -290,8 +310,20 @@ StringTableEntryId insertn(const char* val, S32 len, const bool caseSens)
    return stringNode->masterIndex;
 }
 
+StringTableEntryId insertn(const char* val, S32 len, const bool caseSens)
+{
+   if(!val || !*val || len == 0)
+      return 0;
+
+   bool locked = lockTable();
+   StringTableEntryId id = insertnUnlocked(val, len, caseSens);
+   unlockTable(locked);
+
+   return id;
+}
+
 //--------------------------------------
-StringTableEntryId lookup(const char* val, const bool  caseSens)
+static StringTableEntryId lookupUnlocked(const char* val, const bool  caseSens)
 {
    StringTableEntryId *walk;
    Node *stringNode;
@@ -308,8 +340,17 @@ StringTableEntryId lookup(const char* val, const bool  caseSens)
    return 0;
 }
 
+StringTableEntryId lookup(const char* val, const bool  caseSens)
+{
+   bool locked = lockTable();
+   StringTableEntryId id = lookupUnlocked(val, caseSens);
+   unlockTable(locked);
+
+   return id;
+}
+
 //--------------------------------------
-StringTableEntryId lookupn(const char* val, S32 len, const bool  caseSens)
+static StringTableEntryId lookupnUnlocked(const char* val, S32 len, const bool  caseSens)
 {
    StringTableEntryId *walk;
    Node *stringNode;
@@ -326,6 +367,15 @@ StringTableEntryId lookupn(const char* val, S32 len, const bool  caseSens)
    return 0; 
 }
 
+StringTableEntryId lookupn(const char* val, S32 len, const bool  caseSens)
+{
+   bool locked = lockTable();
+   StringTableEntryId id = lookupnUnlocked(val, len, caseSens);
+   unlockTable(locked);
+
+   return id;
+}
+
 //--------------------------------------
 void resizeHashTable(const U32 newSize)
 {
@@ -396,10 +446,12 @@ void compact()
 
 void incRef(StringTableEntryId index)
 {
-    mNodeList[index]->refCount++;
+   bool locked = lockTable();
+   mNodeList[index]->refCount++;
+   unlockTable(locked);
 }
 
-void decRef(StringTableEntryId index)
+static void decRefUnlocked(StringTableEntryId index)
 {
    Node *theNode = mNodeList[index];
    if(--theNode->refCount)
@@ -423,19 +475,52 @@ void decRef(StringTableEntryId index)
    mNodeList[index] = (Node *) mNodeListFreeEntry;
    mNodeListFreeEntry = (index << 1) | 1;
 
-   if(mFreeStringDataSize > CompactThreshold)
+   // Compacting moves string data, which other threads may be holding pointers to
+   if(mFreeStringDataSize > CompactThreshold && !mThreadedUseCount)
       compact();
    mItemCount--;
    if(!mItemCount)
       destroy();
 }
 
+void decRef(StringTableEntryId index)
+{
+   bool locked = lockTable();
+   decRefUnlocked(index);
+   unlockTable(locked);
+}
+
 const char *getString(StringTableEntryId index)
 {
    if(!index)
       return "";
 
-   return mNodeList[index]->stringData;
+   bool locked = lockTable();
+   const char *string = mNodeList[index]->stringData;
+   unlockTable(locked);
+
+   return string;
+}
+
+void beginThreadedUse()
+{
+   mTableMutex.lock();
+   mThreadedUseCount++;
+   mTableMutex.unlock();
+}
+
+void endThreadedUse()
+{
+   mTableMutex.lock();
+
+   TNLAssert(mThreadedUseCount > 0, "Unbalanced endThreadedUse()!");
+   mThreadedUseCount--;
+
+   // Catch up on any compaction we put off
+   if(!mThreadedUseCount && mBuckets && mFreeStringDataSize > CompactThreshold)
+      compact();
+
+   mTableMutex.unlock();
 }
 
 
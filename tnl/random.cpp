@@ -28,6 +28,7 @@
 #include "tnl.h"
 #include "tnlRandom.h"
 #include "tnlJournal.h"
+#include "tnlThread.h"
 
 namespace TNL {
 
@@ -36,6 +37,7 @@ namespace Random {
 static bool initialized = false;
 static prng_state prng;
 static U32 entropyAdded = 0;
+static Mutex prngMutex;       // Several threads may host games at once
 
 static void initialize()
 {
@@ -56,6 +58,8 @@ void *getState()                                      // Doesn't seem to be call
 // Needs at least 16 bytes of entropy to be effective.  Can call repeated times to accumulate entropy.
 void addEntropy(const U8 *randomData, U32 dataLen)    
 {
+   prngMutex.lock();
+
    if(!initialized)
       initialize();
    yarrow_add_entropy(randomData, dataLen, &prng);
@@ -66,14 +70,20 @@ void addEntropy(const U8 *randomData, U32 dataLen)
       yarrow_ready(&prng);
       entropyAdded = 0;
    }
+
+   prngMutex.unlock();
 }
 
 void read(U8 *outBuffer, U32 randomLen)
 {
+   prngMutex.lock();
+
    if(!initialized)
       initialize();
 
    yarrow_read(outBuffer, randomLen, &prng);
+
+   prngMutex.unlock();
 }
 
 U32 readI()
@@ -27,8 +27,12 @@
 #include "tnlThread.h"
 #include "tnlLog.h"
 
+#include "tnlPlatform.h"
+
 #ifndef TNL_OS_WIN32
 #include "stdint.h"
+#include <errno.h>
+#include <time.h>
 #endif
 
 namespace TNL
@@ -50,6 +54,11 @@ void Semaphore::wait()
    WaitForSingleObject(mSemaphore, INFINITE);
 }
 
+bool Semaphore::wait(U32 timeoutMs)
+{
+   return WaitForSingleObject(mSemaphore, timeoutMs) == WAIT_OBJECT_0;
+}
+
 void Semaphore::increment(U32 count)
 {
    ReleaseSemaphore(mSemaphore, count, NULL);
@@ -77,19 +86,83 @@ void Mutex::unlock()
 
 bool Mutex::tryLock()
 {
-   return false;//   return TryEnterCriticalSection(&mLock);
+   return TryEnterCriticalSection(&mLock) != 0;
 }
 
-ThreadStorage::ThreadStorage()
+// ThreadStorages that have an exit function; Windows won't call them for us
+static Mutex &getExitStorageMutex()
+{
+   static Mutex mutex;
+   return mutex;
+}
+
+static Vector<ThreadStorage *> &getExitStorages()
+{
+   static Vector<ThreadStorage *> storages;
+   return storages;
+}
+
+ThreadStorage::ThreadStorage(ExitFunction exitFunction)
 {
    mTlsIndex = TlsAlloc();
+   mExitFunction = exitFunction;
+
+   if(mExitFunction)
+   {
+      getExitStorageMutex().lock();
+      getExitStorages().push_back(this);
+      getExitStorageMutex().unlock();
+   }
 }
 
 ThreadStorage::~ThreadStorage()
 {
+   if(mExitFunction)
+   {
+      getExitStorageMutex().lock();
+
+      Vector<ThreadStorage *> &storages = getExitStorages();
+      for(S32 i = 0; i < storages.size(); i++)
+         if(storages[i] == this)
+         {
+            storages.erase_fast(i);
+            break;
+         }
+
+      getExitStorageMutex().unlock();
+   }
+
    TlsFree(mTlsIndex);
 }
 
+void ThreadStorage::threadExiting()
+{
+   getExitStorageMutex().lock();
+
+   // An exit function may set a value that was already cleaned up (a ThreadLocal it uses, say), so go round
+   // again until nothing is left, giving up after a few passes as pthreads does
+   Vector<ThreadStorage *> &storages = getExitStorages();
+   bool freedAny = true;
+
+   for(S32 pass = 0; pass < 4 && freedAny; pass++)
+   {
+      freedAny = false;
+
+      for(S32 i = 0; i < storages.size(); i++)
+      {
+         void *data = storages[i]->get();
+         if(data)
+         {
+            storages[i]->set(NULL);
+            storages[i]->mExitFunction(data);
+            freedAny = true;
+         }
+      }
+   }
+
+   getExitStorageMutex().unlock();
+}
+
 void *ThreadStorage::get()
 {
    return TlsGetValue(mTlsIndex);
@@ -102,7 +175,10 @@ void ThreadStorage::set(void *value)
 
 DWORD WINAPI ThreadProc( LPVOID lpParameter )
 {
-   return ((Thread *) lpParameter)->run();
+   U32 result = ((Thread *) lpParameter)->run();   // Thread may be gone once run() returns
+
+   ThreadStorage::threadExiting();
+   return result;
 }
 
 U32 Thread::run()
@@ -144,6 +220,37 @@ void Semaphore::wait()
    sem_wait(&mSemaphore);
 }
 
+bool Semaphore::wait(U32 timeoutMs)
+{
+#ifdef TNL_OS_MAC_OSX
+   // No sem_timedwait() here
+   U32 startTime = Platform::getRealMilliseconds();
+   while(sem_trywait(&mSemaphore) != 0)
+   {
+      if(Platform::getRealMilliseconds() - startTime >= timeoutMs)
+         return false;
+      Platform::sleep(1);
+   }
+   return true;
+#else
+   timespec deadline;
+   clock_gettime(CLOCK_REALTIME, &deadline);
+   deadline.tv_sec += timeoutMs / 1000;
+   deadline.tv_nsec += long(timeoutMs % 1000) * 1000000;
+   if(deadline.tv_nsec >= 1000000000)
+   {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+   }
+
+   while(sem_timedwait(&mSemaphore, &deadline) != 0)
+      if(errno != EINTR)
+         return false;
+
+   return true;
+#endif
+}
+
 void Semaphore::increment(U32 count)
 {
    for(U32 i = 0; i < count; i++)
@@ -182,12 +289,17 @@ void Mutex::unlock()
 
 bool Mutex::tryLock()
 {
-   return false;//   return TryEnterCriticalSection(&mLock);
+   return pthread_mutex_trylock(&mMutex) == 0;
 }
 
-ThreadStorage::ThreadStorage()
+ThreadStorage::ThreadStorage(ExitFunction exitFunction)
 {
-   pthread_key_create(&mThreadKey, NULL);
+   pthread_key_create(&mThreadKey, exitFunction);
+}
+
+void ThreadStorage::threadExiting()
+{
+   // Do nothing -- pthreads calls the exit functions itself, for every thread
 }
 
 ThreadStorage::~ThreadStorage()
@@ -308,4 +420,200 @@ void ThreadQueue::dispatchResponseCalls()
    unlock();
 }
 
+//------------------------------------------------------------------------------
+
+ReadWriteLock::ReadWriteLock()
+{
+   mReaderCount = 0;
+   mWriterWaiting = false;
+}
+
+void ReadWriteLock::lockShared()
+{
+   // Queue behind any writer; the writer mutex is recursive, so this also lets a writer read
+   mWriterMutex.lock();
+
+   mReaderMutex.lock();
+   mReaderCount++;
+   mReaderMutex.unlock();
+
+   mWriterMutex.unlock();
+}
+
+void ReadWriteLock::unlockShared()
+{
+   mReaderMutex.lock();
+   mReaderCount--;
+   if(mReaderCount == 0 && mWriterWaiting)
+   {
+      mWriterWaiting = false;
+      mReadersDone.increment();
+   }
+   mReaderMutex.unlock();
+}
+
+void ReadWriteLock::lockExclusive()
+{
+   mWriterMutex.lock();
+
+   // No new readers can get in now; wait for the ones already in to leave
+   for(;;)
+   {
+      mReaderMutex.lock();
+      if(mReaderCount == 0)
+      {
+         mReaderMutex.unlock();
+         return;
+      }
+      mWriterWaiting = true;
+      mReaderMutex.unlock();
+
+      mReadersDone.wait();
+   }
+}
+
+void ReadWriteLock::unlockExclusive()
+{
+   mWriterMutex.unlock();
+}
+
+
+//------------------------------------------------------------------------------
+
+static ThreadContext gDefaultContext;
+static ThreadStorage gCurrentContext;
+
+ThreadContext::ThreadContext()
+{
+   mDirtyList = NULL;
+   mIsInitialUpdate = false;
+   mUpdateCachePass = 0;
+   mUpdateCacheActive = false;
+   mRPCSourceConnection = NULL;
+   mRPCDestConnection = NULL;
+   mErrorBuffer[0] = 0;
+}
+
+ThreadContext::~ThreadContext()
+{
+}
+
+ThreadContext *ThreadContext::getCurrent()
+{
+   ThreadContext *context = (ThreadContext *) gCurrentContext.get();
+   return context ? context : &gDefaultContext;
+}
+
+void ThreadContext::setCurrent(ThreadContext *context)
+{
+   gCurrentContext.set(context);
+}
+
+ThreadContext *ThreadContext::getDefault()
+{
+   return &gDefaultContext;
+}
+
+//------------------------------------------------------------------------------
+
+WorkerPool::WorkerThread::WorkerThread(WorkerPool *pool)
+{
+   mPool = pool;
+}
+
+U32 WorkerPool::WorkerThread::run()
+{
+   WorkerPool *pool = mPool;     // We may be deleted as soon as we signal we're done shutting down
+
+   for(;;)
+   {
+      pool->mStartSemaphore.wait();
+
+      if(pool->mShuttingDown)
+      {
+         pool->mDoneSemaphore.increment();
+         return 0;
+      }
+
+      ThreadContext::setCurrent(pool->mContext);
+
+      while(pool->runNextIndex())
+         ;
+
+      ThreadContext::setCurrent(NULL);
+      pool->mDoneSemaphore.increment();
+   }
+}
+
+WorkerPool::WorkerPool(U32 threadCount)
+{
+   mTask = NULL;
+   mContext = NULL;
+   mTaskCount = 0;
+   mNextIndex = 0;
+   mShuttingDown = false;
+
+   for(U32 i = 0; i < threadCount; i++)
+   {
+      WorkerThread *theThread = new WorkerThread(this);
+      mThreads.push_back(theThread);
+
+      if(!theThread->start())
+      {
+         logprintf(LogConsumer::LogError, "WorkerPool: unable to start worker thread %d", i);
+         mThreads.pop_back();
+         break;
+      }
+   }
+}
+
+WorkerPool::~WorkerPool()
+{
+   mShuttingDown = true;
+   mStartSemaphore.increment(mThreads.size());
+
+   for(S32 i = 0; i < mThreads.size(); i++)
+      mDoneSemaphore.wait();
+}
+
+bool WorkerPool::runNextIndex()
+{
+   mLock.lock();
+   S32 index = mNextIndex < mTaskCount ? mNextIndex++ : -1;
+   mLock.unlock();
+
+   if(index == -1)
+      return false;
+
+   mTask->runTask(index);
+   return true;
+}
+
+void WorkerPool::run(WorkerTask *task, S32 count)
+{
+   if(mThreads.size() == 0 || count <= 1)
+   {
+      for(S32 i = 0; i < count; i++)
+         task->runTask(i);
+      return;
+   }
+
+   mTask = task;
+   mContext = ThreadContext::getCurrent();
+   mTaskCount = count;
+   mNextIndex = 0;
+
+   mStartSemaphore.increment(mThreads.size());
+
+   while(runNextIndex())      // Pitch in while we wait
+      ;
+
+   for(S32 i = 0; i < mThreads.size(); i++)
+      mDoneSemaphore.wait();
+
+   mTask = NULL;
+   mContext = NULL;
+   mTaskCount = 0;
+}
+
 };
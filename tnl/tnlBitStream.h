@@ -39,6 +39,8 @@
 
 #include "tnl.h"
 
+#include <string.h>     // For memcpy
+
 namespace TNL {
 
 class SymmetricCipher;
@@ -81,6 +83,13 @@ protected:
    char mStringBuffer[256];
 
    bool resizeBits(U32 numBitsNeeded);
+
+   /// Byte-at-a-time versions of writeInt() and readInt(), used near the end of the buffer and when the stream must grow.
+   void writeIntSlow(U32 value, U8 bitCount);
+   U32  readIntSlow(U8 bitCount);
+
+   /// True if the 8 bytes starting at the byte holding the current bit are all inside the buffer.
+   bool hasWordAtBitPosition() const { return (bitNum >> 3) + sizeof(U64) <= getBufferSize(); }
 public:
 
    /// @name Constructors
@@ -341,6 +350,62 @@ inline bool BitStream::read(const U32 in_numBytes,  void* out_pBuffer)
    return readBits(in_numBytes << 3, out_pBuffer);
 }
 
+// writeInt() and readInt() are inline so that the usual constant bitCount folds into the masks.  Away from the end
+// of the buffer, each call moves its bits with one 64-bit load and store instead of a loop over bytes; a field of
+// up to 32 bits starting anywhere in a byte always fits in the 8 bytes starting at that byte.  Bits are packed
+// LSB-first into little-endian bytes, exactly as writeBits() does.
+inline void BitStream::writeInt(U32 value, U8 bitCount)
+{
+   TNLAssert(bitCount <= 32, "bitCount must be less then 32, for 64 bit, use writeInt64");
+
+   if(bitNum + bitCount > maxWriteBitNum || !hasWordAtBitPosition())
+   {
+      writeIntSlow(value, bitCount);
+      return;
+   }
+
+   U8 *dest = getBuffer() + (bitNum >> 3);
+   U32 shift = bitNum & 0x7;
+   U64 mask = ((U64(1) << bitCount) - 1) << shift;
+
+   U64 word;
+   memcpy(&word, dest, sizeof(word));
+   word = convertLEndianToHost(word);
+   word = (word & ~mask) | ((U64(value) << shift) & mask);
+   word = convertHostToLEndian(word);
+   memcpy(dest, &word, sizeof(word));
+
+   bitNum += bitCount;
+}
+
+inline U32 BitStream::readInt(U8 bitCount)
+{
+   TNLAssert(bitCount <= 32, "bitCount must be less then 32, for 64 bit, use readInt64");
+
+   if(bitNum + bitCount > maxReadBitNum || !hasWordAtBitPosition())
+      return readIntSlow(bitCount);
+
+   U64 word;
+   memcpy(&word, getBuffer() + (bitNum >> 3), sizeof(word));
+   word = convertLEndianToHost(word) >> (bitNum & 0x7);
+
+   bitNum += bitCount;
+   return U32(word & ((U64(1) << bitCount) - 1));
+}
+
+inline bool BitStream::writeFlag(bool val)
+{
+   if(bitNum + 1 > maxWriteBitNum)
+      if(!resizeBits(1))
+         return false;
+   if(val)
+      *(getBuffer() + (bitNum >> 3)) |= (1 << (bitNum & 0x7));
+   else
+      *(getBuffer() + (bitNum >> 3)) &= ~(1 << (bitNum & 0x7));
+   bitNum++;
+   return (val);
+}
+
 inline bool BitStream::readFlag()
 {
    if(bitNum > maxReadBitNum)
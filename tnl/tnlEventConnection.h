@@ -109,13 +109,28 @@ protected:
    /// Dispatches an event
    void processEvent(NetEvent *theEvent);
 
+   /// While events is set, posted events are appended to it instead of being queued for sending.  Used to
+   /// collect the events that would bring a new remote host up to date, without sending them to this one.
+   void setEventCapture(Vector<RefPtr<NetEvent> > *events);
+
+   /// Writes the event section of a packet holding just the given events, all sent unguaranteed, so they are
+   /// processed as soon as they're read and don't use up any sequence numbers
+   void writeEventSnapshot(BitStream *bstream, const Vector<RefPtr<NetEvent> > &events);
+
+   /// Sequence number of the first guaranteed event that hasn't been written into a packet yet
+   S32 getNextSendEventSeq() const;
+
+   /// Tells a receiving connection which guaranteed event to expect next, for when it picks up partway
+   /// through a stream of packets
+   void setNextRecvEventSeq(S32 seq);
+
 
 //----------------------------------------------------------------
 // event manager functions/code:
 //----------------------------------------------------------------
 
 private:
-   static ClassChunker<EventNote> mEventNoteChunker; ///< Quick memory allocator for net event notes
+   static ThreadLocal<ClassChunker<EventNote> > mEventNoteChunker; ///< Quick memory allocator for net event notes, one per thread
 
    EventNote *mSendEventQueueHead;          ///< Head of the list of events to be sent to the remote host
    EventNote *mSendEventQueueTail;          ///< Tail of the list of events to be sent to the remote host.  New events are tagged on to the end of this list
@@ -167,6 +182,7 @@ public:
    TNL_DECLARE_RPC(s2rTNLSendDataParts, (U8 type, ByteBufferPtr data));
 private:
    TNL::ByteBuffer *mTNLDataBuffer;
+   Vector<RefPtr<NetEvent> > *mCapturedEvents;    ///< Where posted events go while capturing, or NULL
    NetEvent *unpackNetEvent(BitStream *bstream);
 
 };
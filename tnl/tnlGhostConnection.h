@@ -82,10 +82,19 @@ class GhostConnection : public EventConnection
 private:
    bool mClearUnscopedObjects;
 
+   bool mDeferNewGhosts;                        ///< Set while scoping on a worker thread; see objectInScope()
+   Vector<NetObject *> mDeferredScopeObjects;   ///< Objects that came into scope while mDeferNewGhosts was set
+   bool mGhostsPrioritized;                     ///< Set when writePacketConcurrent() has already sorted our ghosts
+   U32 mPrioritizedMaxIndex;                    ///< Highest ghost index found while prioritizing
+
    void performScopeQuery();
    void markAllObjectsAsOutOfScope(bool updateSkipCount);
    void detatchOutOfScopeObjects();
 
+   void markGhostsForScopeQuery();
+   void detachUnscopedUpdatingGhosts();
+   U32 prioritizeGhosts();
+
 public:
    /// GhostRef tracks an update sent in one packet for the ghost of one NetObject.
    ///
@@ -129,12 +138,30 @@ protected:
    /// Performs the scoping query in order to determine if there is data to send from this GhostConnection.
    void prepareWritePacket();
 
+   /// Same as prepareWritePacket(), but split so the scope query can run on a worker thread.  Objects coming into
+   /// scope for the first time are linked up in endPrepareWritePacket(), since that touches the object.
+   void beginPrepareWritePacket();
+   void prepareWritePacketConcurrent();
+   void endPrepareWritePacket();
+
+   /// Detaches out-of-scope ghosts, then sorts the rest by priority ahead of writePacket().
+   void beginWritePacket();
+   void writePacketConcurrent();
+
    /// Override to write ghost updates into each packet.
    void writePacket(BitStream *bstream, PacketNotify *notify);
 
    /// Override to read updated ghost information from the packet stream.
    void readPacket(BitStream *bstream);
 
+   /// Writes the ghost section of a packet that gives a fresh remote host every ghost the real one already has,
+   /// each as a new ghost with its full state.  Ghost indices are the same, so packets written afterward carry
+   /// on from there.  Leaves the ghosts' update state alone.
+   void writeGhostSnapshot(BitStream *bstream);
+
+   /// Appends the objects writeGhostSnapshot() writes, in the same order.
+   void getGhostSnapshotObjects(Vector<NetObject *> &objects);
+
    /// Override to check if there is data pending on this GhostConnection.
    bool isDataToTransmit();
 
@@ -48,6 +48,10 @@ namespace HuffmanStringProcessor
    /// @note The Huffman encoder uses BitStream::writeString as a fallback.
    ///       WriteString can only write strings of up to 255 characters length.
    ///       Therefore, it is wise not to exceed that limit.
+   ///
+   /// @note Encodings of recently written strings are cached, so the same message
+   ///       sent to many connections is only compressed once.  Safe to call from
+   ///       several threads at once.
    bool writeHuffBuffer(BitStream* pStream, const char* out_pBuffer, U32 maxLen);
 };
 
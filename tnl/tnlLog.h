@@ -129,19 +129,44 @@ private:
 ////////////////////////////////////////
 ////////////////////////////////////////
 
-class FileLogConsumer : public LogConsumer    // Dumps logs to file
+class Mutex;
+
+// Dumps logs to file.  Lines are collected in memory and written in batches by a background thread, so the thread
+// doing the logging never waits on the disk.  If the disk falls far enough behind, new lines are dropped and
+// counted rather than letting the backlog grow without bound.
+class FileLogConsumer : public LogConsumer
 {
 protected:
    FILE *f;
 
+private:
+   Mutex *mPendingLock;       // Protects mPending and the drop counts
+   Mutex *mFileLock;          // Protects f; held while a batch is written
+   std::string mPending;      // Lines waiting to be written
+   U32 mLastFlushTime;
+   U32 mUnreportedDrops;      // Lines dropped since the last batch was written
+   U32 mDroppedLineCount;     // Lines dropped since this log was opened
+
+   void writeString(const char *string);
+
 public:
+   static const U32 FlushIntervalMs = 100;            // Pending lines are written at least this often...
+   static const U32 FlushSize = 16 * 1024;            // ...or as soon as this many bytes are waiting
+   static const U32 MaxPendingSize = 4 * 1024 * 1024; // Lines arriving while this much is waiting are dropped
+
    FileLogConsumer();      // Constructor
    ~FileLogConsumer();     // Destructor
 
    void init(std::string logFile, const char *mode = "a");
 
-private:
-   void writeString(const char *string);
+   void flush();                       // Writes all pending lines now
+   bool tryFlush();                    // Same, unless another thread holds our locks; see flushAllForCrash()
+   U32 flushIfDue(U32 currentTime);    // Writes pending lines if there are enough of them, or they are old enough;
+                                       // returns ms until we'll next need writing, or U32_MAX if nothing is waiting
+   U32 getDroppedLineCount();
+
+   static void flushAll();             // Flushes every open log; use on shutdown
+   static void flushAllForCrash();     // Same, but never blocks, so it's safe in a signal handler
 }; 
 
 
@@ -209,6 +209,12 @@ protected:
    U32 mPartialUpdateBitsUsed; ///< Number of bits used on partial updates of objects of this class.
    U32 mInitialUpdateCount;    ///< Number of objects of this class constructed over a connection.
    U32 mPartialUpdateCount;    ///< Number of objects of this class updated over a connection.
+   U32 mInitialUpdateCacheHits;   ///< Number of initial updates copied from NetObject's update cache.
+   U32 mPartialUpdateCacheHits;   ///< Number of partial updates copied from NetObject's update cache.
+
+   U32 mUnpackCount;          ///< Number of objects or events of this class unpacked, while collecting unpack stats.
+   U32 mUnpackBitsRead;       ///< Number of bits they read.
+   S64 mUnpackTime;           ///< High precision timer ticks spent unpacking them.
 
    /// Next declared NetClassRep.
    ///
@@ -241,20 +247,44 @@ public:
    S32 getClassVersion() const;                    ///< Returns the version of this class.
    const char *getClassName() const;               ///< Returns the string class name.
 
-   /// Records bits used in the initial update of objects of this class.
-   void addInitialUpdate(U32 bitCount)
+   /// Records bits used in the initial update of objects of this class.  cacheHit is true if
+   /// the update was copied from one already written for another connection.
+   void addInitialUpdate(U32 bitCount, bool cacheHit = false)
    {
       mInitialUpdateCount++;
       mInitialUpdateBitsUsed += bitCount;
+      if(cacheHit)
+         mInitialUpdateCacheHits++;
    }
 
    /// Records bits used in a partial update of an object of this class.
-   void addPartialUpdate(U32 bitCount)
+   void addPartialUpdate(U32 bitCount, bool cacheHit = false)
    {
       mPartialUpdateCount++;
       mPartialUpdateBitsUsed += bitCount;
+      if(cacheHit)
+         mPartialUpdateCacheHits++;
    }
 
+   /// When set, connections record how long each ghost update and event they receive takes to unpack.  Off
+   /// normally, since it means reading the timer around every unpack.
+   static bool mCollectUnpackStats;
+
+   /// Records the cost of unpacking a ghost update or event of this class.
+   void addUnpack(U32 bitCount, S64 time)
+   {
+      mUnpackCount++;
+      mUnpackBitsRead += bitCount;
+      mUnpackTime += time;
+   }
+
+   U32 getUnpackCount() const    { return mUnpackCount; }
+   U32 getUnpackBitsRead() const { return mUnpackBitsRead; }
+   S64 getUnpackTime() const     { return mUnpackTime; }
+
+   /// Zeroes the unpack stats of every class
+   static void resetUnpackStats();
+
    virtual Object *create() const = 0;             ///< Creates an instance of the class this represents.
 
    /// Returns the number of classes registered under classGroup and classType.
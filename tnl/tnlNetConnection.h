@@ -47,6 +47,10 @@
 #include "tnlConnectionStringTable.h"
 #endif
 
+#ifndef _TNLTHREAD_H_
+#include "tnlThread.h"
+#endif
+
 namespace TNL {
 
 class NetConnection;
@@ -291,6 +295,17 @@ protected:
                                        ///  Any setup work to determine if there isDataToTransmit() should happen in
                                        ///  this function.  prepareWritePacket should _always_ call the Parent:: function.
 
+   /// The following split prepareWritePacket() and writePacket() into phases, so NetInterface can do the expensive
+   /// parts of building packets for many connections on worker threads.  The *Concurrent methods may run on any
+   /// thread, at the same time as other connections' *Concurrent methods, so must only modify state owned by this
+   /// connection; the others always run on the main thread.  Subclasses overriding prepareWritePacket() should
+   /// override these as well, and as with prepareWritePacket(), always call the Parent:: function.
+   virtual void beginPrepareWritePacket();       ///< Main thread; first part of prepareWritePacket()
+   virtual void prepareWritePacketConcurrent();  ///< Any thread; middle part of prepareWritePacket()
+   virtual void endPrepareWritePacket();         ///< Main thread; last part of prepareWritePacket()
+   virtual void beginWritePacket();              ///< Main thread; called only if a packet will be written
+   virtual void writePacketConcurrent();         ///< Any thread; called only if a packet will be written, before writePacket()
+
    virtual void writePacket(BitStream *bstream, PacketNotify *note); ///< Called to write a subclass's packet data into the packet.
                                                                      ///
                                                                      ///  Information about what the instance wrote into the packet can be attached
@@ -465,10 +480,8 @@ public:
    U32 mConnectSendCount;    ///< Number of challenge or connect requests sent to the remote host.
    U32 mConnectLastSendTime; ///< The send time of the last challenge or connect request.
 
-protected:
-   static char mErrorBuffer[256]; ///< String buffer that errors are written into
 public:
-   static char *getErrorBuffer() { return mErrorBuffer; } ///< returns the current error buffer
+   static char *getErrorBuffer() { return ThreadContext::getCurrent()->mErrorBuffer; } ///< returns the current error buffer, one per ThreadContext
    static void setLastError(const char *fmt,...);         ///< Sets an error string and notifies the currently processing connection that it should terminate.
 
 protected:
@@ -559,6 +572,12 @@ public:
    /// If force is true and there is space in the window, it will always send a packet.
    void checkPacketSend(bool force, U32 currentTime);
 
+   /// Pieces of checkPacketSend(), for NetInterface to use when building packets in phases:
+   bool isTimeToSendPacket(bool force, U32 currentTime);    ///< Returns true if checkPacketSend() would build a packet now.
+   bool isReadyToWritePacket();                            ///< True if there is data to send and room in the window; call after preparing.
+   void checkAckPacketSend(U32 currentTime);               ///< Sends an ack, if needed, when we are not going to write a packet.
+   void writeAndSendPacket(U32 currentTime);               ///< Writes and sends a data packet; call after preparing.
+
    /// Connection state flags for a NetConnection instance.  If this list is modifed, please check if netInterface.cpp needs updates as well
    enum NetConnectionState {
       NotConnected=0,            ///< Initial state of a NetConnection instance - not connected
@@ -140,9 +140,12 @@ struct ConnectionParameters;
 /// of the receiver.
 
 
+class WorkerPool;
+
 class NetInterface : public Object
 {
    friend class NetConnection;
+   friend class ConnectionPhaseTask;
 public:
    /// PacketType is encoded as the first byte of each packet.
    ///
@@ -211,6 +214,47 @@ protected:
    };
    DelaySendPacket *mSendPacketList; /// List of delayed packets pending to send.
 
+   /// Incoming packets are read a batch at a time into here, so draining the socket takes fewer system calls
+   Vector<U8> mRecvArena;
+   Vector<Address> mRecvAddresses;
+   Vector<S32> mRecvSizes;
+
+   /// Packets sent while processConnections() runs wait here, and go out together at the end of it
+   bool mQueueSends;
+   Vector<U8> mSendArena;
+   Vector<Address> mSendAddresses;
+   Vector<S32> mSendSizes;
+   Vector<const U8 *> mSendBuffers;
+
+   NetError sendPacketData(const Address &address, const U8 *data, S32 size);
+   void flushSendQueue();
+
+public:
+   /// Time spent in each phase of processConnections() when building packets on worker threads, in ms.
+   struct PacketBuildStats
+   {
+      U32 passes;             ///< Number of processConnections() calls included
+      U32 packets;            ///< Number of data packets written
+      F64 prepareTime;        ///< Picking connections to send to, and readying their ghosts for scoping (main thread)
+      F64 scopeTime;          ///< Scope queries (worker threads)
+      F64 bookkeepingTime;    ///< Creating and detaching ghosts found by the scope queries (main thread)
+      F64 prioritizeTime;     ///< Computing ghost priorities and sorting (worker threads)
+      F64 writeTime;          ///< Writing and sending packets (main thread)
+   };
+
+protected:
+   WorkerPool *mWorkerPool;                           /// Used to build packets in parallel; NULL if we do everything on the main thread
+   PacketBuildStats mPacketBuildStats;
+   Vector<RefPtr<NetConnection> > mSendingConnections;   /// Connections building a packet this tick
+
+   enum ConnectionPhase {
+      ScopePhase,
+      PrioritizePhase,
+   };
+
+   void runConnectionPhase(ConnectionPhase phase, S32 index);
+   void processConnectionsInParallel();
+
    enum NetInterfaceConstants {
       ChallengeRetryCount = 4,     /// Number of times to send connect challenge requests before giving up.
       ChallengeRetryTime = 2500,   /// Timeout interval in milliseconds before retrying connect challenge.
@@ -373,6 +417,15 @@ public:
    /// and pending connections.
    void processConnections();
 
+   /// Sets the number of worker threads used to scope and prioritize ghosts for our connections.  With 0, the
+   /// default, everything is done on the main thread, one connection at a time.
+   void setWorkerThreadCount(U32 count);
+   U32 getWorkerThreadCount();
+
+   /// Phase timings are only collected while worker threads are in use.
+   const PacketBuildStats &getPacketBuildStats() { return mPacketBuildStats; }
+   void resetPacketBuildStats();
+
    /// Returns the list of connections on this NetInterface.
    Vector<NetConnection *> &getConnectionList() { return mConnectionList; }
 
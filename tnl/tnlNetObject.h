@@ -39,6 +39,10 @@
 #include "tnlRPC.h"
 #endif
 
+#ifndef _TNLTHREAD_H_
+#include "tnlThread.h"
+#endif
+
 namespace TNL {
 //----------------------------------------------------------------------------
 class GhostConnection;
@@ -210,13 +214,34 @@ class NetObject : public Object
    NetObject *mNextDirtyList;
    U32 mDirtyMaskBits;
 
-   static NetObject *mDirtyList;
    U32 mNetIndex;              ///< The index of this ghost on the other side of the connection.
    GhostInfo *mFirstObjectRef; ///< Head of the linked list of GhostInfos for this object.
 
-   static bool mIsInitialUpdate; ///< Managed by GhostConnection - set to true when this is an initial update
    SafePtr<NetObject> mServerObject; ///< Direct pointer to the parent object on the server if it is a local connection
    GhostConnection *mOwningConnection; ///< The connection that owns this ghost, if it's a ghost
+
+   /// Bits written by packUpdate() for one connection, kept so other connections can reuse them in the same send pass.
+   struct CachedUpdate
+   {
+      U32 pass;            ///< Send pass the bits were written in
+      S32 key;             ///< getUpdateCacheKey() for the connection they were written for
+      U32 updateMask;
+      bool initialUpdate;
+      U32 retMask;         ///< What packUpdate() returned
+      U32 bitCount;
+      Vector<U8> bits;
+   };
+
+   Vector<CachedUpdate> mUpdateCache;
+
+   /// The dirty list, initial update flag and update cache pass live in the ThreadContext, so each thread
+   /// running its own NetInterface keeps its own.
+
+   /// Copies a cached update matching key, updateMask and the initial update flag into stream.  Returns false if there isn't one.
+   bool writeCachedUpdate(S32 key, U32 updateMask, BitStream *stream, U32 &retMask);
+
+   /// Saves the bits from startBitPosition to the current position of stream for reuse in this send pass.
+   void cacheUpdate(S32 key, U32 updateMask, BitStream *stream, U32 startBitPosition, U32 retMask);
 protected:
    enum NetFlag
    {
@@ -228,14 +253,8 @@ protected:
 
    BitSet32 mNetFlags;  ///< Flags field describing this object, from NetFlag.
 
-   /// RPC method source connection
-   static GhostConnection *mRPCSourceConnection;
-
-   /// NetObject RPC method destination connection.
-   static GhostConnection *mRPCDestConnection;
-
    /// Returns true if this pack/unpackUpdate is the initial one for the object
-   bool isInitialUpdate() { return mIsInitialUpdate; }
+   bool isInitialUpdate() { return ThreadContext::getCurrent()->mIsInitialUpdate; }
 public:
    NetObject();
    ~NetObject();
@@ -249,15 +268,15 @@ public:
 
    /// Returns the connection from which the current RPC method originated,
    /// or NULL if not currently within the processing of an RPC method call.
-   static GhostConnection *getRPCSourceConnection() { return mRPCSourceConnection; }
+   static GhostConnection *getRPCSourceConnection() { return ThreadContext::getCurrent()->mRPCSourceConnection; }
 
    /// Sets the connection to which all NetObject RPCs will be destined.  Calling this function
    /// with a NULL value will target NetObject RPCs to every connection for which that object is
    /// currently ghosted.
-   static void setRPCDestConnection(GhostConnection *destConnection) { mRPCDestConnection = destConnection; }
+   static void setRPCDestConnection(GhostConnection *destConnection) { ThreadContext::getCurrent()->mRPCDestConnection = destConnection; }
 
    /// Returns the connection that serves as the destination of NetObject RPC method calls.
-   static GhostConnection *getRPCDestConnection() { return mRPCDestConnection; }
+   static GhostConnection *getRPCDestConnection() { return ThreadContext::getCurrent()->mRPCDestConnection; }
 
    /// onGhostAdd is called on the client side of a connection after
    /// the constructor and after the first call to unpackUpdate (the
@@ -307,6 +326,26 @@ public:
    /// one-time initialization information for that object.
    virtual U32  packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream);
 
+   enum {
+      UpdateNotCacheable = -1,   ///< Returned by getUpdateCacheKey() if packUpdate() output can't be shared
+      MaxCachedUpdates = 4,      ///< Most distinct packUpdate() results kept per object per send pass
+   };
+
+   /// Controls sharing of packUpdate() output between connections.
+   ///
+   /// While NetInterface is sending packets, an object's packUpdate() output for one connection is
+   /// kept, and copied into packets for other connections with the same updateMask and cache key rather
+   /// than calling packUpdate() again.  Return a key that captures everything about connection that
+   /// affects what packUpdate() writes (0 if nothing does), or UpdateNotCacheable if it can't be shared:
+   /// for example if packUpdate() writes ghost indices, strings, or positions relative to the connection's
+   /// control object, or has side effects.  The default is UpdateNotCacheable.
+   virtual S32 getUpdateCacheKey(GhostConnection *connection);
+
+   /// Bracket a set of packet sends during which object state does not change; cached updates are only
+   /// reused within a pass.
+   static void beginUpdateCachePass();
+   static void endUpdateCachePass();
+
    /// Unpack data written by packUpdate().
    ///
    /// unpackUpdate is called on the client to read an update out of a
@@ -78,6 +78,14 @@ namespace StringTable
    void incRef(StringTableEntryId index);   
    void decRef(StringTableEntryId index);
    const char *getString(StringTableEntryId index);
+
+   /// The table is normally only touched by the main thread.  While another thread may be creating or destroying
+   /// StringTableEntries (e.g. while a level is being loaded in the background), the main thread brackets that
+   /// period with these calls; all table operations are locked, and compaction is put off, until it ends.
+   /// Calls nest.  They must be made from the main thread, unless the table is already in threaded use (as it
+   /// is for as long as other threads host games of their own), in which case any thread may make them.
+   void beginThreadedUse();
+   void endThreadedUse();
 };
 
 /// The StringTableEntry class encapsulates an entry in the network StringTable.
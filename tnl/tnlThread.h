@@ -68,6 +68,9 @@ public:
    /// will be awakened and the semaphore will decrement.
    void wait();
 
+   /// Same as wait(), but gives up after timeoutMs milliseconds.  Returns false if it timed out.
+   bool wait(U32 timeoutMs);
+
    /// Increments the semaphore's internal count.  This will wake
    /// count threads that are waiting on this semaphore.
    void increment(U32 count = 1);
@@ -105,6 +108,27 @@ public:
    bool tryLock();
 };
 
+/// Lock that any number of threads can hold shared, for reading, or one thread can hold exclusively, for writing.
+/// A thread waiting for the exclusive lock keeps new readers out, so writers aren't starved.  The exclusive lock
+/// is recursive, and its holder may also take the shared lock; a thread holding only the shared lock must not ask
+/// for the exclusive one, or it will wait on itself forever.
+class ReadWriteLock
+{
+   Mutex mWriterMutex;        ///< Held by the writer throughout, and by readers only while they check in
+   Mutex mReaderMutex;        ///< Guards mReaderCount and mWriterWaiting
+   S32 mReaderCount;
+   bool mWriterWaiting;
+   Semaphore mReadersDone;    ///< Incremented by the last reader out when a writer is waiting
+public:
+   ReadWriteLock();
+
+   void lockShared();
+   void unlockShared();
+
+   void lockExclusive();
+   void unlockExclusive();
+};
+
 /// Platform independent Thread class.
 class Thread : public Object
 {
@@ -123,23 +147,157 @@ public:
 /// Platform independent per-thread storage class.
 class ThreadStorage
 {
+public:
+   /// Called with a thread's stored pointer when that thread exits, if the pointer is not NULL.
+   typedef void (*ExitFunction)(void *data);
+
+private:
 #ifdef TNL_OS_WIN32
    DWORD mTlsIndex;
+   ExitFunction mExitFunction;
 #else
    pthread_key_t mThreadKey;
 #endif
 public:
-   /// ThreadStorage constructor.
-   ThreadStorage();
+   /// ThreadStorage constructor.  If exitFunction is given, it is called to clean up each thread's value when
+   /// the thread exits.  On Windows this only happens for threads started with Thread::start().
+   ThreadStorage(ExitFunction exitFunction = NULL);
    /// ThreadStorage destructor.
    ~ThreadStorage();
 
+   /// Runs the exit functions for the calling thread's values; called by Thread::start()'s thread procedure.
+   static void threadExiting();
+
    /// returns the per-thread stored void pointer for this ThreadStorage.  The default value is NULL.
    void *get();
    /// sets the per-thread stored void pointer for this ThreadStorage object.
    void set(void *data);
 };
 
+/// Per-thread storage for a single object of type T, created the first time each thread asks for it.
+/// Each thread's object is deleted when that thread exits (see ThreadStorage for the Windows caveat).
+template <class T> class ThreadLocal
+{
+   ThreadStorage mStorage;
+
+   static void destroyValue(void *data) { delete (T *) data; }
+public:
+   ThreadLocal() : mStorage(&destroyValue) { }
+
+   T &get()
+   {
+      T *value = (T *) mStorage.get();
+      if(!value)
+      {
+         value = new T();
+         mStorage.set(value);
+      }
+      return *value;
+   }
+};
+
+/// Per-thread Vector that can stand in for a global Vector: each thread that uses it works on its own copy.
+template <class T> class ThreadLocalVector : public ThreadLocal<Vector<T> >
+{
+public:
+   operator Vector<T> &() { return this->get(); }
+
+   ThreadLocalVector &operator=(const Vector<T> &v) { this->get() = v; return *this; }
+   T &operator[](S32 index) { return this->get()[index]; }
+
+   S32 size() { return this->get().size(); }
+   bool empty() { return this->get().empty(); }
+   void clear() { this->get().clear(); }
+   void push_back(const T &x) { this->get().push_back(x); }
+   void resize(U32 size) { this->get().resize(size); }
+   T *address() { return this->get().address(); }
+   T &first() { return this->get().first(); }
+   T &last() { return this->get().last(); }
+   void erase(U32 index) { this->get().erase(index); }
+   void sort(typename Vector<T>::compare_func f) { this->get().sort(f); }
+};
+
+class NetObject;
+class GhostConnection;
+
+/// State that TNL used to keep in statics, and that every thread running its own NetInterface needs a
+/// separate copy of.  Threads that never call setCurrent() share a default context, so single-threaded
+/// programs behave exactly as before.  WorkerPool threads use the context of the thread that called run().
+class ThreadContext
+{
+public:
+   enum {
+      ErrorBufferSize = 256
+   };
+
+   NetObject *mDirtyList;                    ///< NetObjects with dirty mask bits
+   bool mIsInitialUpdate;                    ///< Set by GhostConnection while writing an initial update
+   U32 mUpdateCachePass;                     ///< Current or most recent update cache send pass
+   bool mUpdateCacheActive;                  ///< True while in an update cache send pass
+   GhostConnection *mRPCSourceConnection;    ///< Connection a NetObject RPC came from
+   GhostConnection *mRPCDestConnection;      ///< Connection a NetObject RPC is going to
+   char mErrorBuffer[ErrorBufferSize];       ///< NetConnection::setLastError() writes here
+
+   ThreadContext();
+   virtual ~ThreadContext();
+
+   /// Returns the context of the calling thread; never NULL.
+   static ThreadContext *getCurrent();
+
+   /// Makes context the calling thread's context; NULL goes back to the default one.
+   static void setCurrent(ThreadContext *context);
+
+   /// Returns the context used by threads that haven't set one.
+   static ThreadContext *getDefault();
+};
+
+/// A job for a WorkerPool.  runTask() is called once for each index passed to WorkerPool::run(),
+/// possibly on several threads at the same time.
+class WorkerTask
+{
+public:
+   virtual ~WorkerTask() { }
+   virtual void runTask(S32 index) = 0;
+};
+
+/// Fixed set of worker threads for data-parallel jobs.  run() hands out the indices of a job
+/// to the workers and to the calling thread, and returns once every index has been processed.
+/// Only one thread at a time should call run().
+class WorkerPool
+{
+   class WorkerThread : public Thread
+   {
+      WorkerPool *mPool;
+      public:
+      WorkerThread(WorkerPool *);
+      U32 run();
+   };
+   friend class WorkerThread;
+
+   Vector<RefPtr<WorkerThread> > mThreads;
+   Semaphore mStartSemaphore;    ///< Incremented once per worker when a job (or shutdown) is posted
+   Semaphore mDoneSemaphore;     ///< Incremented by each worker when it runs out of work
+   Mutex mLock;                  ///< Protects mNextIndex
+
+   WorkerTask *mTask;
+   ThreadContext *mContext;      ///< Context of the thread that called run(), used by the workers for the job
+   S32 mTaskCount;
+   S32 mNextIndex;
+   bool mShuttingDown;
+
+   /// Runs the next unclaimed index of the current job; returns false if there are none left.
+   bool runNextIndex();
+public:
+   /// WorkerPool constructor.  threadCount may be 0, in which case run() does all the work itself.
+   WorkerPool(U32 threadCount);
+   ~WorkerPool();
+
+   U32 getThreadCount() const { return mThreads.size(); }
+
+   /// Calls task->runTask(i) for every i in [0, count), and waits for them all to finish.
+   void run(WorkerTask *task, S32 count);
+};
+
 /// Managing object for a queue of worker threads that pass
 /// messages back and forth to the main thread.  ThreadQueue
 /// methods declared with the TNL_DECLARE_THREADQ_METHOD macro
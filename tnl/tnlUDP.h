@@ -147,11 +147,25 @@ enum NetError {
 /// The Socket class encapsulates a platform's network socket.
 class Socket
 {
+public:
+   /// Counts of the system calls made to move packets, and of the packets they moved
+   struct Stats
+   {
+      U32 recvCalls;
+      U32 recvPackets;
+      U32 sendCalls;
+      U32 sendPackets;
+   };
+
+private:
    S32 mPlatformSocket;    ///< The OS-level socket
    U32 mTransportProtocol; ///< The transport type this socket uses.
+   Stats mStats;
+
 public:
    enum {
       DefaultBufferSize = 32768, ///< The default send and receive buffer sizes
+      MaxBatchSize = 32,         ///< The most packets one system call will move in recvfromBatch and sendtoBatch
    };
 
    /// Opens a socket on the specified address/port
@@ -177,6 +191,18 @@ public:
    /// @param   bytesRead       Specifies the number of bytes which were actually in the packet.
    NetError recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *bytesRead);
 
+   /// Reads up to maxPackets incoming packets, with as few system calls as the platform allows (recvmmsg on Linux,
+   /// one recvfrom per packet elsewhere).  Packet i goes into buffers + i * bufferSize, and its source and size into
+   /// addresses[i] and sizes[i].  Returns the number of packets read, which is 0 if none were waiting.
+   S32 recvfromBatch(Address *addresses, U8 *buffers, S32 bufferSize, S32 *sizes, S32 maxPackets);
+
+   /// Sends packetCount packets, with as few system calls as the platform allows (sendmmsg on Linux, one sendto
+   /// per packet elsewhere).  Returns the number of packets sent; any that fail are dropped, as with sendto.
+   S32 sendtoBatch(const Address *addresses, const U8 *const *buffers, const S32 *sizes, S32 packetCount);
+
+   const Stats &getStats() const;
+   void resetStats();
+
    /// Returns the Address corresponding to this socket, as bound on the local machine.
    Address getBoundAddress();
 
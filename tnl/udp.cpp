@@ -94,6 +94,11 @@ typedef in_addr IN_ADDR;
 
 #define closesocket close
 
+// recvmmsg and sendmmsg move many packets per system call
+#if defined(TNL_OS_LINUX) && defined(MSG_WAITFORONE)
+#  define TNL_BATCHED_SOCKET_IO
+#endif
+
 #else
 
 #endif
@@ -107,6 +112,7 @@ typedef in_addr IN_ADDR;
 #endif
 
 #include "tnlLog.h"
+#include "tnlThread.h"
 
 namespace TNL {
 
@@ -222,6 +228,7 @@ Socket::Socket(const Address &bindAddress, U32 sendBufferSize, U32 recvBufferSiz
    init();
    mPlatformSocket = INVALID_SOCKET;
    mTransportProtocol = bindAddress.transport;
+   resetStats();
 
    const char *socketType;
 
@@ -352,11 +359,15 @@ NetError Socket::sendto(const Address &address, const U8 *buffer, S32 bufferSize
    socklen_t addressSize;
 
    TNLToSocketAddress(address, &destAddress, &addressSize);
+
+   mStats.sendCalls++;
+
    if(::sendto(mPlatformSocket, (const char*)buffer, bufferSize, 0,
          &destAddress, addressSize) == SOCKET_ERROR)
       return getLastError();
-   else
-      return NoError;
+
+   mStats.sendPackets++;
+   return NoError;
 }
 
 NetError Socket::recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *outSize)
@@ -385,6 +396,8 @@ NetError Socket::recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *out
    S32 bytesRead = SOCKET_ERROR;
 
    bytesRead = ::recvfrom(mPlatformSocket, (char *) buffer, bufferSize, 0, &sa, &addrLen);
+   mStats.recvCalls++;
+
    if(bytesRead == SOCKET_ERROR)
    {
       TNL_JOURNAL_WRITE_BLOCK(Socket::recvfrom,
@@ -393,6 +406,8 @@ NetError Socket::recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *out
       return WouldBlock;
    }
 
+   mStats.recvPackets++;
+
    SocketToTNLAddress(&sa, address);
 
    *outSize = bytesRead;
@@ -411,6 +426,138 @@ NetError Socket::recvfrom(Address *address, U8 *buffer, S32 bufferSize, S32 *out
    return NoError;
 }
 
+S32 Socket::recvfromBatch(Address *addresses, U8 *buffers, S32 bufferSize, S32 *sizes, S32 maxPackets)
+{
+#ifdef TNL_BATCHED_SOCKET_IO
+   // The journal records packets one recvfrom at a time
+   if(Journal::getCurrentMode() == Journal::Inactive)
+   {
+      mmsghdr messages[MaxBatchSize];
+      iovec buffersInfo[MaxBatchSize];
+      SOCKADDR sourceAddresses[MaxBatchSize];
+
+      if(maxPackets > MaxBatchSize)
+         maxPackets = MaxBatchSize;
+
+      memset(messages, 0, sizeof(messages[0]) * maxPackets);
+
+      for(S32 i = 0; i < maxPackets; i++)
+      {
+         buffersInfo[i].iov_base = buffers + i * bufferSize;
+         buffersInfo[i].iov_len = bufferSize;
+         messages[i].msg_hdr.msg_iov = &buffersInfo[i];
+         messages[i].msg_hdr.msg_iovlen = 1;
+         messages[i].msg_hdr.msg_name = &sourceAddresses[i];
+         messages[i].msg_hdr.msg_namelen = sizeof(sourceAddresses[i]);
+      }
+
+      // Blocking sockets wait for the first packet, as recvfrom would, but not for the rest
+      S32 count = recvmmsg(mPlatformSocket, messages, maxPackets, MSG_WAITFORONE, NULL);
+      mStats.recvCalls++;
+
+      if(count <= 0)
+         return 0;
+
+      for(S32 i = 0; i < count; i++)
+      {
+         SocketToTNLAddress(&sourceAddresses[i], &addresses[i]);
+         sizes[i] = messages[i].msg_len;
+      }
+
+      mStats.recvPackets += count;
+      return count;
+   }
+#endif
+
+   S32 count = 0;
+
+   while(count < maxPackets && recvfrom(&addresses[count], buffers + count * bufferSize, bufferSize, &sizes[count]) == NoError)
+      count++;
+
+   return count;
+}
+
+S32 Socket::sendtoBatch(const Address *addresses, const U8 *const *buffers, const S32 *sizes, S32 packetCount)
+{
+   S32 sent = 0;
+
+#ifdef TNL_BATCHED_SOCKET_IO
+   if(Journal::getCurrentMode() == Journal::Inactive)
+   {
+      mmsghdr messages[MaxBatchSize];
+      iovec buffersInfo[MaxBatchSize];
+      SOCKADDR destAddresses[MaxBatchSize];
+
+      S32 next = 0;
+
+      while(next < packetCount)
+      {
+         S32 count = 0;
+
+         // Packets for another transport would fail anyway, so leave them out
+         for(; next < packetCount && count < MaxBatchSize; next++)
+         {
+            if(addresses[next].transport != mTransportProtocol)
+               continue;
+
+            socklen_t addressSize;
+            TNLToSocketAddress(addresses[next], &destAddresses[count], &addressSize);
+
+            buffersInfo[count].iov_base = (void *) buffers[next];
+            buffersInfo[count].iov_len = sizes[next];
+
+            memset(&messages[count], 0, sizeof(messages[count]));
+            messages[count].msg_hdr.msg_iov = &buffersInfo[count];
+            messages[count].msg_hdr.msg_iovlen = 1;
+            messages[count].msg_hdr.msg_name = &destAddresses[count];
+            messages[count].msg_hdr.msg_namelen = addressSize;
+
+            count++;
+         }
+
+         // Stops at the first packet that fails; drop that one and carry on with the rest
+         S32 done = 0;
+
+         while(done < count)
+         {
+            S32 result = sendmmsg(mPlatformSocket, &messages[done], count - done, 0);
+            mStats.sendCalls++;
+
+            if(result <= 0)
+               done++;
+            else
+            {
+               done += result;
+               sent += result;
+               mStats.sendPackets += result;
+            }
+         }
+      }
+
+      return sent;
+   }
+#endif
+
+   for(S32 i = 0; i < packetCount; i++)
+      if(sendto(addresses[i], buffers[i], sizes[i]) == NoError)
+         sent++;
+
+   return sent;
+}
+
+const Socket::Stats &Socket::getStats() const
+{
+   return mStats;
+}
+
+void Socket::resetStats()
+{
+   mStats.recvCalls = 0;
+   mStats.recvPackets = 0;
+   mStats.sendCalls = 0;
+   mStats.sendPackets = 0;
+}
+
 NetError Socket::connect(const Address &theAddress)
 {
    SOCKADDR destAddress;
@@ -854,9 +1001,12 @@ bool Address::set(const char *addressString)
    }
 }
 
+struct AddressStringBuffer { char text[256]; };
+static ThreadLocal<AddressStringBuffer> gAddressStringBuffer;    // So threads hosting their own games don't trample each other
+
 const char *Address::toString() const
 {
-   static char addressBuffer[256];
+   char *addressBuffer = gAddressStringBuffer.get().text;
    if(transport == IPProtocol)
    {
       SOCKADDR_IN ipAddr;
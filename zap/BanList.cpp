@@ -27,6 +27,9 @@ BanList::BanList(const string &iniDir)
 
    defaultBanDurationMinutes = 60;
    kickDurationMilliseconds = 30 * 1000;     // 30 seconds is a good breather
+
+   mPrefixLengthsInUse = 0;
+   mKickClock = 0;
 }
 
 
@@ -60,26 +63,128 @@ string ptimeToIsoString(const ptime &ptime)
 }
 
 
+// Seconds since 1970, in whatever time zone ptime is in
+static S64 ptimeToSeconds(const ptime &ptime)
+{
+   static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+   // Not total_seconds(), which is only 32 bits
+   return (ptime - epoch).ticks() / time_duration::ticks_per_second();
+}
+
+
+static S64 getCurrentTime()
+{
+   return ptimeToSeconds(second_clock::local_time());
+}
+
+
 void BanList::addToBanList(const Address &address, S32 durationMinutes, bool nonAuthenticatedOnly)
 {
+   ptime startTime = second_clock::local_time();
+
    BanItem banItem;
    banItem.durationMinutes = itos(durationMinutes);
    banItem.address = addressToString(address);
    banItem.nickname = nonAuthenticatedOnly ? "*NonAuthenticated" : "*";
-   banItem.startDateTime = ptimeToIsoString(second_clock::local_time());
+   banItem.startDateTime = ptimeToIsoString(startTime);
+   banItem.network = address.netNum[0];
+   banItem.prefixLength = 32;
 
-   serverBanList.push_back(banItem);
+   addBanItem(banItem, ptimeToSeconds(startTime));
 }
 
 void BanList::addPlayerNameToBanList(const char *playerName, S32 durationMinutes)
 {
+   ptime startTime = second_clock::local_time();
+
    BanItem banItem;
    banItem.durationMinutes = itos(durationMinutes);
-   banItem.address = "*";
+   banItem.address = banListWildcardCharater;
    banItem.nickname = playerName;
-   banItem.startDateTime = ptimeToIsoString(second_clock::local_time());
+   banItem.startDateTime = ptimeToIsoString(startTime);
+   banItem.network = 0;
+   banItem.prefixLength = 0;
+
+   addBanItem(banItem, ptimeToSeconds(startTime));
+}
+
+
+// Adds the ban to the list, and to the index where isBanned() will look for it
+void BanList::addBanItem(BanItem &banItem, S64 startTime)
+{
+   banItem.expiryTime = startTime + S64(atoi(banItem.durationMinutes.c_str())) * 60;
 
+   mMutex.lock();
+   S32 index = serverBanList.size();
    serverBanList.push_back(banItem);
+
+   findIndexFor(banItem)->push_back(index);
+   mBanExpiryHeap.push(ExpiryTimer(banItem.expiryTime, index));
+   mMutex.unlock();
+}
+
+
+// Bans on a name from anywhere are found by name; everything else is found by address
+Vector<S32> *BanList::findIndexFor(const BanItem &banItem)
+{
+   if(banItem.address == banListWildcardCharater && banItem.nickname != "*" && banItem.nickname != "*NonAuthenticated")
+      return &mBansByNickname[banItem.nickname];
+
+   mPrefixLengthsInUse |= U64(1) << banItem.prefixLength;
+   return &mBansByNetwork[getNetworkKey(banItem.network, banItem.prefixLength)];
+}
+
+
+// Expired bans stay in serverBanList (and so in the INI), but there's no need to keep checking them
+void BanList::removeExpiredBans(S64 now)
+{
+   while(!mBanExpiryHeap.empty() && mBanExpiryHeap.top().time < now)
+   {
+      S32 index = mBanExpiryHeap.top().key;
+      mBanExpiryHeap.pop();
+
+      Vector<S32> *bans = findIndexFor(serverBanList[index]);
+      S32 position = bans->getIndex(index);
+      if(position != -1)
+         bans->erase_fast(position);
+   }
+}
+
+
+// Understands single addresses, networks in CIDR form (123.123.123.0/24), and the wildcard
+bool BanList::compileAddress(const string &address, U32 &network, U32 &prefixLength) const
+{
+   if(address == banListWildcardCharater)
+   {
+      network = 0;
+      prefixLength = 0;
+      return true;
+   }
+
+   string host = address;
+   prefixLength = 32;
+
+   size_t slash = address.find('/');
+   if(slash != string::npos)
+   {
+      string bits = address.substr(slash + 1);
+      if(bits.length() == 0 || bits.length() > 2 || bits.find_first_not_of("0123456789") != string::npos)
+         return false;
+
+      prefixLength = atoi(bits.c_str());
+      if(prefixLength > 32)
+         return false;
+
+      host = address.substr(0, slash);
+   }
+
+   Address hostAddress(host.c_str());
+   if(!hostAddress.isValid())
+      return false;
+
+   network = hostAddress.netNum[0] & getNetmask(prefixLength);
+   return true;
 }
 
 
@@ -112,7 +217,8 @@ bool BanList::processBanListLine(const string &line)
    string durationMinutes = words[3];
 
    // Validate IP address string
-   if (!(Address(address.c_str()).isValid()) && address.compare(banListWildcardCharater) != 0)
+   BanItem banItem;
+   if(!compileAddress(address, banItem.network, banItem.prefixLength))
       return false;
 
    // nickname could be anything...
@@ -137,13 +243,12 @@ bool BanList::processBanListLine(const string &line)
       return false;
 
    // Now finally add to banList
-   BanItem banItem;
    banItem.address = address;
    banItem.nickname = nickname;
    banItem.startDateTime = startDateTime;
    banItem.durationMinutes = durationMinutes;
 
-   serverBanList.push_back(banItem);
+   addBanItem(banItem, ptimeToSeconds(tempDateTime));
 
    // Phoew! we made it..
    return true;
@@ -162,38 +267,76 @@ string BanList::banItemToString(BanItem *banItem)
 }
 
 
+bool BanList::banApplies(const BanItem &banItem, const string &nickname, bool isAuthenticated, S64 now) const
+{
+   // Check time
+   if(banItem.expiryTime < now)
+      return false;
+
+   // Check if authenticated
+   if(banItem.nickname == "*NonAuthenticated")
+      return !isAuthenticated;
+
+   // Check nickname
+   return banItem.nickname == "*" || banItem.nickname == nickname;
+}
+
+
 bool BanList::isBanned(const Address &address, const string &nickname, bool isAuthenticated)
 {
-   string addressString = addressToString(address);
-   ptime currentTime = second_clock::local_time();
+   S64 now = getCurrentTime();
 
-   for (S32 i = 0; i < serverBanList.size(); i++)
-   {
-      // Check IP
-      if (addressString.compare(serverBanList[i].address) != 0 && serverBanList[i].address.compare("*") != 0)
-         continue;
+   mMutex.lock();
+   removeExpiredBans(now);
+   bool banned = hasApplicableBan(address.netNum[0], nickname, isAuthenticated, now);
+   mMutex.unlock();
 
-      // Check if authenticated
-      if (serverBanList[i].nickname.compare("*NonAuthenticated") == 0 && isAuthenticated)
-         continue;
+   return banned;
+}
 
-      // Check nickname
-      else if (nickname.compare(serverBanList[i].nickname) != 0 && serverBanList[i].nickname.compare("*") != 0)
+
+bool BanList::hasApplicableBan(U32 ip, const string &nickname, bool isAuthenticated, S64 now) const
+{
+   // Look for the address in every size of network anyone has banned
+   for(U32 prefixLength = 0; prefixLength <= 32; prefixLength++)
+   {
+      if(!(mPrefixLengthsInUse & (U64(1) << prefixLength)))
          continue;
 
-      // Check time
-      if (from_iso_string(serverBanList[i].startDateTime) + minutes(atoi(serverBanList[i].durationMinutes.c_str())) < currentTime)
+      BansByNetwork::const_iterator it = mBansByNetwork.find(getNetworkKey(ip & getNetmask(prefixLength), prefixLength));
+      if(it == mBansByNetwork.end())
          continue;
 
-      // If we get here, that means nickname and IP address matched and we are still in the
-      // ban allotted time period
-      return true;
+      for(S32 i = 0; i < it->second.size(); i++)
+         if(banApplies(serverBanList[it->second[i]], nickname, isAuthenticated, now))
+            return true;
    }
 
+   // Then for the name
+   BansByNickname::const_iterator it = mBansByNickname.find(nickname);
+   if(it != mBansByNickname.end())
+      for(S32 i = 0; i < it->second.size(); i++)
+         if(banApplies(serverBanList[it->second[i]], nickname, isAuthenticated, now))
+            return true;
+
    return false;
 }
 
 
+// Static method
+U64 BanList::getNetworkKey(U32 network, U32 prefixLength)
+{
+   return (U64(prefixLength) << 32) | network;
+}
+
+
+// Static method
+U32 BanList::getNetmask(U32 prefixLength)
+{
+   return prefixLength == 0 ? 0 : U32_MAX << (32 - prefixLength);
+}
+
+
 string BanList::getDelimiter()
 {
    return banListTokenDelimiter;
@@ -221,8 +364,11 @@ S32 BanList::getDefaultBanDuration()
 Vector<string> BanList::banListToString()
 {
    Vector<string> banList;
+
+   mMutex.lock();
    for(S32 i = 0; i < serverBanList.size(); i++)
       banList.push_back(banItemToString(&serverBanList[i]));
+   mMutex.unlock();
 
    return banList;
 }
@@ -230,46 +376,69 @@ Vector<string> BanList::banListToString()
 
 void BanList::loadBanList(const Vector<string> &banItemList)
 {
-   serverBanList.clear();  // Clear old list for /loadini command.
+   mMutex.lock();
+
+   // Clear old list for /loadini command.
+   serverBanList.clear();
+   mBansByNetwork.clear();
+   mBansByNickname.clear();
+   mPrefixLengthsInUse = 0;
+   mBanExpiryHeap = ExpiryHeap();
+
+
    for(S32 i = 0; i < banItemList.size(); i++)
       if(!processBanListLine(banItemList[i]))
          logprintf("Ban list item on line %d is malformed: %s", i+1, banItemList[i].c_str());
       else
          logprintf("Loading ban: %s", banItemList[i].c_str());
+
+   mMutex.unlock();
 }
 
 
 void BanList::kickHost(const Address &address)
 {
-   KickedHost h;
-   h.address = address;
-   h.kickTimeRemaining = kickDurationMilliseconds;
-   serverKickList.push_back(h);
+   U32 ip = address.netNum[0];
+
+   mMutex.lock();
+   S64 expiryTime = mKickClock + kickDurationMilliseconds;
+
+   mKickedAddresses[ip] = expiryTime;
+   mKickExpiryHeap.push(ExpiryTimer(expiryTime, ip));
+   mMutex.unlock();
 }
 
 
 bool BanList::isAddressKicked(const Address &address)
 {
-   for(S32 i = 0; i < serverKickList.size(); i++)
-      if(address.isEqualAddress(serverKickList[i].address))
-         return true;
+   mMutex.lock();
+   bool kicked = mKickedAddresses.find(address.netNum[0]) != mKickedAddresses.end();
+   mMutex.unlock();
 
-   return false;
+   return kicked;
 }
 
 
 void BanList::updateKickList(U32 timeElapsed)
 {
-   for(S32 i = 0; i < serverKickList.size(); )
+   mMutex.lock();
+   mKickClock += timeElapsed;
+
+   while(!mKickExpiryHeap.empty() && mKickExpiryHeap.top().time < mKickClock)
    {
-      if(serverKickList[i].kickTimeRemaining < timeElapsed)
-         serverKickList.erase_fast(i);
-      else
-      {
-         serverKickList[i].kickTimeRemaining -= timeElapsed;
-         i++;
-      }
+      map<U32, S64>::iterator it = mKickedAddresses.find(mKickExpiryHeap.top().key);
+
+      // A host kicked again since has a later time, and stays on the list
+      if(it != mKickedAddresses.end() && it->second == mKickExpiryHeap.top().time)
+         mKickedAddresses.erase(it);
+
+      mKickExpiryHeap.pop();
    }
+
+   if(!mBanExpiryHeap.empty())
+      removeExpiredBans(getCurrentTime());
+
+   mMutex.unlock();
 }
 
 
@@ -6,10 +6,13 @@
 #ifndef BANLIST_H_
 #define BANLIST_H_
 
+#include "tnlThread.h"
 #include "tnlTypes.h"
 #include "tnlUDP.h"
 
 #include <string>
+#include <map>
+#include <queue>
 
 using namespace TNL;
 using namespace std;
@@ -17,24 +20,48 @@ using namespace std;
 namespace Zap
 {
 
+// Bans are compiled when they are added, into indexes keyed by network and by nickname, so checking a connecting
+// client costs a few map lookups no matter how long the list gets.  All games hosted by a process share one list,
+// so the public methods take mMutex.
 class BanList
 {
 private:
    struct BanItem
    {
-      string address;
+      // As read from or written to the INI
+      string address;            // A single address, a network like 123.123.0.0/16, or the wildcard
       string nickname;
       string startDateTime;
       string durationMinutes;
+
+      // Compiled from the above
+      U32 network;               // Host byte order, already masked
+      U32 prefixLength;          // Number of significant bits in network; 32 for a single address
+      S64 expiryTime;            // Seconds since 1970, local time, like the start time it came from
    };
 
-   struct KickedHost {
-      Address address;
-      U32 kickTimeRemaining;
+   struct ExpiryTimer
+   {
+      S64 time;
+      U32 key;                   // Ban index or kicked address, depending on the heap
+
+      ExpiryTimer(S64 time, U32 key) { this->time = time; this->key = key; }
+      bool operator>(const ExpiryTimer &other) const { return time > other.time; }
    };
 
-   Vector<BanItem> serverBanList;
-   Vector<KickedHost> serverKickList;
+   typedef map<U64, Vector<S32> > BansByNetwork;      // Keyed by prefix length and network
+   typedef map<string, Vector<S32> > BansByNickname;
+   typedef priority_queue<ExpiryTimer, vector<ExpiryTimer>, greater<ExpiryTimer> > ExpiryHeap;    // Soonest on top
+
+   Vector<BanItem> serverBanList;      // Every ban, including expired ones, in the order they were added
+   BansByNetwork mBansByNetwork;       // Unexpired bans with an address, or with wildcards for both address and nickname
+   BansByNickname mBansByNickname;     // Unexpired bans on a nickname from any address
+   U64 mPrefixLengthsInUse;            // Bit n is set once mBansByNetwork has had a ban on a /n network
+   ExpiryHeap mBanExpiryHeap;
+
+   map<U32, S64> mKickedAddresses;     // Address -> time the kick runs out, on mKickClock
+   ExpiryHeap mKickExpiryHeap;
+   S64 mKickClock;                     // Milliseconds of updateKickList() time
 
    string banListTokenDelimiter;
    string banListWildcardCharater;
@@ -42,9 +69,22 @@ private:
    S32 defaultBanDurationMinutes;
    S32 kickDurationMilliseconds;
 
+   Mutex mMutex;
+
    bool processBanListLine(const string &line);
    string banItemToString(BanItem *banItem);
 
+   bool compileAddress(const string &address, U32 &network, U32 &prefixLength) const;
+   void addBanItem(BanItem &banItem, S64 startTime);    // Fill in everything but the expiry time first
+   void removeExpiredBans(S64 now);
+   bool banApplies(const BanItem &banItem, const string &nickname, bool isAuthenticated, S64 now) const;
+   bool hasApplicableBan(U32 ip, const string &nickname, bool isAuthenticated, S64 now) const;
+
+   Vector<S32> *findIndexFor(const BanItem &banItem);
+
+   static U64 getNetworkKey(U32 network, U32 prefixLength);
+   static U32 getNetmask(U32 prefixLength);
+
 public:
    explicit BanList(const string &iniDir);
    virtual ~BanList();
@@ -65,7 +105,7 @@ public:
 
    void kickHost(const Address &address);       // Add an address to kick list
    bool isAddressKicked(const Address &address);   // Check if address is on the kick list
-   void updateKickList(U32 timeElapsed);              // Check if kick time has expired and update the kick list
+   void updateKickList(U32 timeElapsed);              // Expire kicks and bans whose time is up
 };
 
 } /* namespace Zap */
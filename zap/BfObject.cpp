@@ -25,6 +25,8 @@
 #include "MathUtils.h"           // For sq()
 #include "stringUtils.h"         // For itos()
 
+#include "tnlThread.h"
+
 using namespace TNL;
 
 namespace Zap
@@ -412,11 +414,18 @@ bool EditorObject::isInEditor() const
 // BfObject - the declarations are in GameObject.h
 
 
+// Objects are created on level preloading threads as well as the main thread
+static Mutex gIdMutex;
+
 static S32 getNextDefaultId() 
 {
    static S32 nextId = 0;
-   nextId--;
-   return nextId;
+
+   gIdMutex.lock();
+   S32 id = --nextId;
+   gIdMutex.unlock();
+
+   return id;
 }
 
 
@@ -477,7 +486,9 @@ void BfObject::assignNewSerialNumber()
 {
    static S32 mNextSerialNumber = 0;
 
+   gIdMutex.lock();
    mSerialNumber = mNextSerialNumber++;
+   gIdMutex.unlock();
 }
 
 
@@ -19,6 +19,7 @@
 #include <clipper.hpp>
 
 #include <vector>
+#include <queue>
 #include <math.h>
 
 
@@ -46,6 +47,25 @@ const S32 BotNavMeshZone::BufferRadius = Ship::CollisionRadius;  // Radius to bu
 const S32 BotNavMeshZone::LevelZoneBuffer = MAX(BufferRadius * 2, 50);
 
 
+// Constructor
+BotZoneBuildStats::BotZoneBuildStats()
+{
+   mergeTime = 0;
+   triangulateTime = 0;
+   zoneTime = 0;
+   zoneCount = 0;
+}
+
+
+F64 BotZoneBuildStats::getTotalTime() const
+{
+   return mergeTime + triangulateTime + zoneTime;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
 // Constructor
 BotNavMeshZone::BotNavMeshZone(S32 id)
 {
@@ -260,13 +280,11 @@ bool BotNavMeshZone::buildBotNavMeshZoneConnectionsRecastStyle(const Vector<BotN
 }
 
 
-static Vector<DatabaseObject *> zones;
-
 // Returns index of zone containing specified point
 static BotNavMeshZone *findZoneTouchingCircle(const GridDatabase *botZoneDatabase, const Point &centerPoint, F32 radius)
 {
    Rect rect(centerPoint, radius);
-   zones.clear();
+   Vector<DatabaseObject *> zones;     // Zones may be built on a level preloading thread
    botZoneDatabase->findObjects(BotNavMeshZoneTypeNumber, zones, rect);
 
    const Vector<Point> *poly;
@@ -286,10 +304,6 @@ static BotNavMeshZone *findZoneTouchingCircle(const GridDatabase *botZoneDatabas
 }
 
 
-#ifdef TNL_DEBUG
-#  define LOG_TIMER
-#endif
-
 static bool mergeBotZoneBuffers(const Vector<DatabaseObject *> &barriers,
                                 const Vector<DatabaseObject *> &turrets,
                                 const Vector<DatabaseObject *> &forceFieldProjectors, 
@@ -416,17 +430,24 @@ static void linkTeleportersBotNavMeshZoneConnections(const GridDatabase *botZone
 bool BotNavMeshZone::buildBotMeshZones(GridDatabase &botZoneDatabase, Vector<BotNavMeshZone *> &allZones,
                                        const Rect *worldExtents, const Vector<DatabaseObject *> &barrierList,
                                        const Vector<DatabaseObject *> &turretList, const Vector<DatabaseObject *> &forceFieldProjectorList,
-                                       const Vector<pair<Point, const Vector<Point> *> > &teleporterData, bool triangulateZones)
+                                       const Vector<pair<Point, const Vector<Point> *> > &teleporterData, bool triangulateZones,
+                                       BotZoneBuildStats *stats)
 {
-#ifdef LOG_TIMER
-   U32 starttime = Platform::getRealMilliseconds();
-#endif
+   BotZoneBuildStats localStats;
+   if(!stats)
+      stats = &localStats;
+
+   *stats = BotZoneBuildStats();
+
+   S64 startTime = Platform::getHighPrecisionTimerValue();
 
    Rect bounds(worldExtents);      // Modifiable copy
    allZones.deleteAndClear();
 
    bounds.expandToInt(Point(LevelZoneBuffer, LevelZoneBuffer));      // Provide a little breathing room
 
+   botZoneDatabase.setSpatialIndexExtents(bounds);     // Zones will all fall within bounds
+
    // Make sure level isn't too big for zone generation, which uses 16 bit ints
    if(bounds.getHeight() >= (F32)U16_MAX || bounds.getWidth() >= (F32)U16_MAX)
    {
@@ -443,10 +464,8 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase &botZoneDatabase, Vector<Bot
    if(!mergeBotZoneBuffers(barrierList, turretList, forceFieldProjectorList, (F32)BufferRadius, solution))
       return false;
 
-
-#ifdef LOG_TIMER
-   U32 done1 = Platform::getRealMilliseconds();
-#endif
+   S64 mergeDoneTime = Platform::getHighPrecisionTimerValue();
+   stats->mergeTime = Platform::getHighPrecisionMilliseconds(mergeDoneTime - startTime);
 
    // Tessellate!
    // This will downscale the Clipper output and use poly2tri to triangulate
@@ -454,9 +473,8 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase &botZoneDatabase, Vector<Bot
    if(!Triangulate::processComplex(outputTriangles, bounds, solution))
       return false;
 
-#ifdef LOG_TIMER
-   U32 done2 = Platform::getRealMilliseconds();
-#endif
+   S64 triangulateDoneTime = Platform::getHighPrecisionTimerValue();
+   stats->triangulateTime = Platform::getHighPrecisionMilliseconds(triangulateDoneTime - mergeDoneTime);
 
    bool recastPassed = false;
    rcPolyMesh mesh;
@@ -531,10 +549,6 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase &botZoneDatabase, Vector<Bot
          }
       }
 
-#ifdef LOG_TIMER
-      logprintf("Recast built %d zones!", botZoneDatabase.getObjectCount());
-#endif              
-
       if(addedZones)
          populateZoneList(&botZoneDatabase, &allZones);     // Repopulate allZones with the zones we modified above
 
@@ -572,11 +586,8 @@ bool BotNavMeshZone::buildBotMeshZones(GridDatabase &botZoneDatabase, Vector<Bot
       linkTeleportersBotNavMeshZoneConnections(&botZoneDatabase, teleporterData);
    }
 
-#ifdef LOG_TIMER
-   U32 done3 = Platform::getRealMilliseconds();
-
-   logprintf("Timings: %d %d %d", done1-starttime, done2-done1, done3-done2);
-#endif
+   stats->zoneTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - triangulateDoneTime);
+   stats->zoneCount = botZoneDatabase.getObjectCount();
 
    return true;
 }
@@ -665,12 +676,12 @@ void BotNavMeshZone::buildBotNavMeshZoneConnections(const Vector<BotNavMeshZone
    NeighboringZone neighbor;
 
    // Figure out which zones are adjacent to which, and find the "gateway" between them
-   for(S32 i = 0; i < zones.size() - 1; i++)
+   for(S32 i = 0; i < allZones.size() - 1; i++)
    {
-      for(S32 j = i + 1; j < zones.size(); j++)
+      for(S32 j = i + 1; j < allZones.size(); j++)
       {
          // Do zones i and j touch?  First a quick and dirty bounds check:
-         if(!zones[i]->getExtent().intersectsOrBorders(zones[j]->getExtent()))
+         if(!allZones[i]->getExtent().intersectsOrBorders(allZones[j]->getExtent()))
             continue;
 
          if(zonesTouch(allZones.get(i)->getOutline(), allZones.get(j)->getOutline(), 1.0, bordStart, bordEnd))
@@ -725,22 +736,80 @@ F32 AStar::heuristic(const Vector<BotNavMeshZone *> *zones, S32 fromZone, S32 to
 }
 
 
+static ThreadStorage gThreadSearchState;
+
+// Constructor
+AStar::SearchState::SearchState()
+{
+   onClosedList = 0;
+}
+
+
+// Make sure arrays are big enough for a mesh of zoneCount zones, and bump the list markers for a new search
+void AStar::SearchState::prepare(S32 zoneCount)
+{
+   // Open list items are numbered from 0, one per zone, and the heap in openList starts at index 1
+   if(whichList.size() < zoneCount)
+   {
+      whichList.resize(zoneCount);
+      for(S32 i = 0; i < whichList.size(); i++)
+         whichList[i] = 0;
+      onClosedList = 0;
+
+      openList.resize(zoneCount + 2);
+      openZone.resize(zoneCount + 1);
+      parentZones.resize(zoneCount);
+      Fcost.resize(zoneCount + 1);
+      Gcost.resize(zoneCount);
+      Hcost.resize(zoneCount + 1);
+   }
+
+   // This block here lets us repeatedly reuse the whichList array without resetting it or recreating it
+   // which, for larger numbers of zones should be a real time saver.  It's not clear if it is particularly
+   // more efficient for the zone counts we typically see in Bitfighter levels.
+   if(onClosedList > U16_MAX - 3 ) // Reset whichList when we've run out of headroom
+   {
+      for(S32 i = 0; i < whichList.size(); i++) 
+         whichList[i] = 0;
+      onClosedList = 0;   
+   }
+   onClosedList = onClosedList + 2; // Changing the values of onOpenList and onClosed list is faster than redimming whichList() array
+}
+
+
+AStar::SearchState &AStar::getThreadSearchState()
+{
+   SearchState *state = (SearchState *)gThreadSearchState.get();
+
+   if(!state)
+   {
+      state = new SearchState();
+      gThreadSearchState.set(state);
+   }
+
+   return *state;
+}
+
+
 // Returns a path, including the startZone and targetZone 
 Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, const Point &target)
 {
+   SearchState &state = getThreadSearchState();
+   state.prepare(zones->size());
+
    // Because of these variables...
-   static U16 onClosedList = 0;
-   static U16 onOpenList;
+   const U16 onClosedList = state.onClosedList;
+   const U16 onOpenList = onClosedList - 1;
 
    // ...these arrays can be reused without further initialization
-   static U16 whichList[MAX_ZONES];       // Record whether a zone is on the open or closed list
-   static S16 openList[MAX_ZONES + 1]; 
-   static S16 openZone[MAX_ZONES]; 
-   static S16 parentZones[MAX_ZONES]; 
+   U16 *whichList   = state.whichList.address();
+   S16 *openList    = state.openList.address();
+   S16 *openZone    = state.openZone.address();
+   S16 *parentZones = state.parentZones.address();
 
-   static F32 Fcost[MAX_ZONES];   
-   static F32 Gcost[MAX_ZONES];    
-   static F32 Hcost[MAX_ZONES];   
+   F32 *Fcost = state.Fcost.address();
+   F32 *Gcost = state.Gcost.address();
+   F32 *Hcost = state.Hcost.address();
 
    S16 numberOfOpenListItems = 0;
    bool foundPath;
@@ -749,18 +818,6 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
 
    Vector<Point> path;
 
-   // This block here lets us repeatedly reuse the whichList array without resetting it or recreating it
-   // which, for larger numbers of zones should be a real time saver.  It's not clear if it is particularly
-   // more efficient for the zone counts we typically see in Bitfighter levels.
-   if(onClosedList > U16_MAX - 3 ) // Reset whichList when we've run out of headroom
-   {
-      for(S32 i = 0; i < MAX_ZONES; i++) 
-         whichList[i] = 0;
-      onClosedList = 0;   
-   }
-   onClosedList = onClosedList + 2; // Changing the values of onOpenList and onClosed list is faster than redimming whichList() array
-   onOpenList = onClosedList - 1;
-
    Gcost[startZone] = 0;         // That's the cost of going from the startZone to the startZone!
    Fcost[0] = Hcost[0] = heuristic(zones, startZone, targetZone);
 
@@ -836,11 +893,11 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
          // Add these adjacent child squares to the open list
          //   for later consideration if appropriate.
 
-         Vector<NeighboringZone> neighboringZones = zones->get(parentZone)->mNeighbors;
+         const Vector<NeighboringZone> &neighboringZones = zones->get(parentZone)->mNeighbors;
 
          for(S32 a = 0; a < neighboringZones.size(); a++)
          {
-            NeighboringZone zone = neighboringZones[a];
+            const NeighboringZone &zone = neighboringZones[a];
             S32 zoneID = zone.zoneID;
 
             //   Check if zone is already on the closed list (items on the closed list have
@@ -849,8 +906,8 @@ Vector<Point> AStar::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZo
                continue;
 
             //   Add zone to the open list if it's not already on it
-            TNLAssert(newOpenListItemID < MAX_ZONES, "Too many nav zones... try increasing MAX_ZONES!");
-            if(whichList[zoneID] != onOpenList && newOpenListItemID < MAX_ZONES) 
+            TNLAssert(newOpenListItemID < zones->size(), "More open list items than zones!");
+            if(whichList[zoneID] != onOpenList && newOpenListItemID < zones->size()) 
             {   
                // Create a new open list item in the binary heap
                newOpenListItemID = newOpenListItemID + 1;   // Give each new item a unique id
@@ -978,6 +1035,305 @@ Point AStar::findGateway(const Vector<BotNavMeshZone *> *zones, S32 zone1, S32 z
 }
 
 
-};
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+ZoneNextHopTable::ZoneNextHopTable()
+{
+   mZoneCount = 0;
+}
+
+
+// Runs Dijkstra from every zone, using the same zone-to-zone costs as AStar.  Does nothing for meshes with more
+// than MaxZones zones, where the table would take too long to build and too much memory to hold.
+void ZoneNextHopTable::build(const Vector<BotNavMeshZone *> &zones)
+{
+   clear();
+
+   if(zones.size() == 0 || zones.size() > MaxZones)
+      return;
+
+   mZoneCount = zones.size();
+   mNextHop.resize(mZoneCount * mZoneCount);
+
+   Vector<F32> cost;
+   Vector<bool> done;
+   cost.resize(mZoneCount);
+   done.resize(mZoneCount);
+
+   // Min-heap of (cost, zone); priority_queue is a max-heap, so costs are negated
+   std::priority_queue<pair<F32, S32> > open;
+
+   for(S32 from = 0; from < mZoneCount; from++)
+   {
+      U16 *nextHop = &mNextHop[from * mZoneCount];
+
+      for(S32 i = 0; i < mZoneCount; i++)
+      {
+         nextHop[i] = U16_MAX;
+         cost[i] = F32_MAX;
+         done[i] = false;
+      }
+
+      nextHop[from] = (U16)from;
+      cost[from] = 0;
+      open.push(pair<F32, S32>(0, from));
+
+      while(!open.empty())
+      {
+         S32 zone = open.top().second;
+         open.pop();
+
+         if(done[zone])
+            continue;
+         done[zone] = true;
+
+         const Vector<NeighboringZone> &neighbors = zones[zone]->mNeighbors;
+
+         for(S32 i = 0; i < neighbors.size(); i++)
+         {
+            S32 neighbor = neighbors[i].zoneID;
+            F32 newCost = cost[zone] + neighbors[i].distTo;
+
+            if(done[neighbor] || newCost >= cost[neighbor])
+               continue;
+
+            cost[neighbor] = newCost;
+            nextHop[neighbor] = (zone == from) ? (U16)neighbor : nextHop[zone];    // First step on the way to neighbor
+            open.push(pair<F32, S32>(-newCost, neighbor));
+         }
+      }
+   }
+}
+
+
+void ZoneNextHopTable::clear()
+{
+   mZoneCount = 0;
+   mNextHop.clear();
+}
 
 
+bool ZoneNextHopTable::isValid() const
+{
+   return mZoneCount > 0;
+}
+
+
+Vector<Point> ZoneNextHopTable::findPath(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, 
+                                         const Point &target) const
+{
+   TNLAssert(zones->size() == mZoneCount, "Next hop table is out of date!");
+
+   Vector<Point> path;
+
+   if(mNextHop[startZone * mZoneCount + targetZone] == U16_MAX)
+      return path;
+
+   // Collect the zones along the route, then write them out backwards, ending with the start zone, to match
+   // the layout AStar produces
+   static const S32 MaxRoute = MaxZones + 1;
+   U16 route[MaxRoute];
+   S32 routeLength = 0;
+
+   route[routeLength++] = (U16)startZone;
+
+   while(route[routeLength - 1] != targetZone && routeLength < MaxRoute)
+   {
+      route[routeLength] = mNextHop[route[routeLength - 1] * mZoneCount + targetZone];
+      routeLength++;
+   }
+
+   TNLAssert(route[routeLength - 1] == targetZone, "Next hop table has a loop!");
+
+   path.push_back(target);                               // First point is the actual target itself
+   path.push_back(zones->get(targetZone)->getCenter());  // Second is the center of the target's zone
+
+   for(S32 i = routeLength - 1; i > 0; i--)
+   {
+      path.push_back(AStar::findGateway(zones, route[i - 1], route[i]));
+      path.push_back(zones->get(route[i - 1])->getCenter());
+   }
+
+   path.push_back(zones->get(startZone)->getCenter());
+   return path;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+FlightPlanCache::FlightPlanCache(S32 capacity)
+{
+   TNLAssert(capacity > 0, "Cache needs some room!");
+
+   mCapacity = capacity;
+   mHead = -1;
+   mTail = -1;
+
+   S32 bucketCount = 1;
+   while(bucketCount < capacity * 2)
+      bucketCount <<= 1;
+
+   mBuckets.resize(bucketCount);
+   for(S32 i = 0; i < mBuckets.size(); i++)
+      mBuckets[i] = -1;
+
+   mEntries.reserve(capacity);
+}
+
+
+U32 FlightPlanCache::makeKey(U16 fromZone, U16 toZone)
+{
+   return (U32(fromZone) << 16) | toZone;
+}
+
+
+// Knuth's multiplicative hash; the top bits are the well-mixed ones
+static S32 getBucket(U32 key, S32 bucketCount)
+{
+   return S32((key * 2654435761u) >> 16) & (bucketCount - 1);
+}
+
+
+S32 FlightPlanCache::findEntry(U32 key) const
+{
+   for(S32 i = mBuckets[getBucket(key, mBuckets.size())]; i != -1; i = mEntries[i].nextInBucket)
+      if(mEntries[i].key == key)
+         return i;
+
+   return -1;
+}
+
+
+void FlightPlanCache::unlinkEntry(S32 index)
+{
+   Entry &entry = mEntries[index];
+
+   if(entry.prev != -1)
+      mEntries[entry.prev].next = entry.next;
+   else
+      mHead = entry.next;
+
+   if(entry.next != -1)
+      mEntries[entry.next].prev = entry.prev;
+   else
+      mTail = entry.prev;
+}
+
+
+void FlightPlanCache::linkEntryAtHead(S32 index)
+{
+   Entry &entry = mEntries[index];
+
+   entry.prev = -1;
+   entry.next = mHead;
+
+   if(mHead != -1)
+      mEntries[mHead].prev = index;
+   else
+      mTail = index;
+
+   mHead = index;
+}
+
+
+void FlightPlanCache::removeFromBucket(S32 index)
+{
+   S32 *link = &mBuckets[getBucket(mEntries[index].key, mBuckets.size())];
+
+   while(*link != index)
+      link = &mEntries[*link].nextInBucket;
+
+   *link = mEntries[index].nextInBucket;
+}
+
+
+bool FlightPlanCache::find(U16 fromZone, U16 toZone, Vector<Point> &path)
+{
+   mMutex.lock();
+
+   S32 index = findEntry(makeKey(fromZone, toZone));
+   if(index != -1)
+   {
+      unlinkEntry(index);
+      linkEntryAtHead(index);
+      path = mEntries[index].path;
+   }
+
+   mMutex.unlock();
+
+   return index != -1;
+}
+
+
+void FlightPlanCache::insert(U16 fromZone, U16 toZone, const Vector<Point> &path)
+{
+   mMutex.lock();
+
+   U32 key = makeKey(fromZone, toZone);
+   S32 index = findEntry(key);
+
+   if(index != -1)                           // Another thread got here first; just refresh it
+      unlinkEntry(index);
+   else
+   {
+      if(mEntries.size() < mCapacity)        // Still filling up
+      {
+         index = mEntries.size();
+         mEntries.push_back(Entry());
+      }
+      else                                   // Full -- reuse the least recently used entry
+      {
+         index = mTail;
+         unlinkEntry(index);
+         removeFromBucket(index);
+      }
+
+      S32 bucket = getBucket(key, mBuckets.size());
+      mEntries[index].key = key;
+      mEntries[index].nextInBucket = mBuckets[bucket];
+      mBuckets[bucket] = index;
+   }
+
+   mEntries[index].path = path;
+   linkEntryAtHead(index);
+
+   mMutex.unlock();
+}
+
+
+void FlightPlanCache::clear()
+{
+   mMutex.lock();
+
+   mEntries.clear();
+   mHead = -1;
+   mTail = -1;
+
+   for(S32 i = 0; i < mBuckets.size(); i++)
+      mBuckets[i] = -1;
+
+   mMutex.unlock();
+}
+
+
+S32 FlightPlanCache::getSize()
+{
+   mMutex.lock();
+   S32 size = mEntries.size();
+   mMutex.unlock();
+
+   return size;
+}
+
+
+S32 FlightPlanCache::getCapacity() const
+{
+   return mCapacity;
+}
+
+
+};
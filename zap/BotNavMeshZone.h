@@ -9,6 +9,8 @@
 #include "gridDB.h"            // Parent
 #include "../recast/Recast.h"  // for rcPolyMesh;
 
+#include "tnlThread.h"
+
 namespace Zap
 {
 
@@ -41,6 +43,22 @@ public:
 
 class ServerGame;
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Where buildBotMeshZones() spent its time, in ms
+struct BotZoneBuildStats
+{
+   F64 mergeTime;          // Buffering walls, turrets and forcefield projectors, and merging them with Clipper
+   F64 triangulateTime;    // Triangulating the open space with poly2tri
+   F64 zoneTime;           // Merging triangles into zones with Recast, and linking the zones
+   S32 zoneCount;
+
+   BotZoneBuildStats();    // Constructor
+   F64 getTotalTime() const;
+};
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -82,7 +100,8 @@ public:
    static bool buildBotMeshZones(GridDatabase &botZoneDatabase, Vector<BotNavMeshZone *> &allZones,
                                  const Rect *worldExtents, const Vector<DatabaseObject *> &barrierList,
                                  const Vector<DatabaseObject *> &turretList, const Vector<DatabaseObject *> &forceFieldProjectorList,
-                                 const Vector<pair<Point, const Vector<Point> *> > &teleporterData, bool triangulateZones);
+                                 const Vector<pair<Point, const Vector<Point> *> > &teleporterData, bool triangulateZones,
+                                 BotZoneBuildStats *stats = NULL);
 
    static S32 calcLevelSize     (const Rect *worldExtents, const Vector<DatabaseObject *> &barrierList,
                                  const Vector<pair<Point, const Vector<Point> *> > &teleporterData);
@@ -99,15 +118,100 @@ public:
 class AStar
 {
 private:
+   // Scratch arrays for a single search.  Each thread gets its own, so robots on different threads can plan
+   // paths at the same time.
+   struct SearchState
+   {
+      U16 onClosedList;          // With onOpenList, lets whichList be reused without clearing it each search
+      Vector<U16> whichList;     // Records whether a zone is on the open or closed list
+      Vector<S16> openList;
+      Vector<S16> openZone;
+      Vector<S16> parentZones;
+
+      Vector<F32> Fcost;
+      Vector<F32> Gcost;
+      Vector<F32> Hcost;
+
+      SearchState();             // Constructor
+      void prepare(S32 zoneCount);
+   };
+
+   static SearchState &getThreadSearchState();
+
    static F32 heuristic(const Vector<BotNavMeshZone *> *zones, S32 fromZone, S32 toZone);
-   static Point findGateway(const Vector<BotNavMeshZone *> *zones, S32 zone1, S32 zone2);
 
 public:
    static Vector<Point> findPath (const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, const Point &target);
-   
+   static Point findGateway(const Vector<BotNavMeshZone *> *zones, S32 zone1, S32 zone2);
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Zone-to-zone next hops for every pair of zones, precomputed when the mesh is built so robots on small maps
+// can route without searching.  Large meshes are skipped; the table grows with the square of the zone count.
+class ZoneNextHopTable
+{
+private:
+   S32 mZoneCount;
+   Vector<U16> mNextHop;      // mNextHop[from * mZoneCount + to]; U16_MAX if to can't be reached from from
+
+public:
+   static const S32 MaxZones = 512;
+
+   ZoneNextHopTable();        // Constructor
+
+   void build(const Vector<BotNavMeshZone *> &zones);
+   void clear();
+   bool isValid() const;
+
+   // Same path layout as AStar::findPath: target first, startZone's center last.  Empty if there is no route.
+   Vector<Point> findPath(const Vector<BotNavMeshZone *> *zones, S32 startZone, S32 targetZone, const Point &target) const;
 };
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Zone-to-zone flight plans shared by all robots.  Holds at most a fixed number of plans, discarding the least
+// recently used when full.  Safe to use from several threads at once.
+class FlightPlanCache
+{
+private:
+   struct Entry
+   {
+      U32 key;
+      S32 prev, next;         // Recency list, most recent at mHead
+      S32 nextInBucket;
+      Vector<Point> path;
+   };
+
+   Vector<Entry> mEntries;
+   Vector<S32> mBuckets;      // Hash of key -> first entry in bucket, -1 if empty; size is a power of 2
+   S32 mHead, mTail;
+   S32 mCapacity;
+   Mutex mMutex;
+
+   static U32 makeKey(U16 fromZone, U16 toZone);
+   S32 findEntry(U32 key) const;
+   void unlinkEntry(S32 index);
+   void linkEntryAtHead(S32 index);
+   void removeFromBucket(S32 index);
+
+public:
+   static const S32 DefaultCapacity = 1024;
+
+   explicit FlightPlanCache(S32 capacity = DefaultCapacity);   // Constructor
+
+   bool find(U16 fromZone, U16 toZone, Vector<Point> &path);         // Copies plan into path if found
+   void insert(U16 fromZone, U16 toZone, const Vector<Point> &path);
+   void clear();
+
+   S32 getSize();
+   S32 getCapacity() const;
+};
+
 };
 
 
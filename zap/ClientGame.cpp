@@ -260,6 +260,7 @@ void ClientGame::startLoadingLevel(bool engineerEnabled)
 
 void ClientGame::doneLoadingLevel()
 {
+   getLevel()->markAllObjectsStatic();       // What we have now is the level; what comes later mostly moves
    computeWorldObjectExtents();              // Make sure our world extents reflect all the objects we've loaded
    Barrier::prepareRenderingGeometry(this);  // Get walls ready to render
 
@@ -91,6 +91,10 @@
    SETTINGS_ITEM(YesNo,              GameRecordingDownload,    "Host",           "GameRecordingDownload",    No,                              NULL,     NULL,     "If Yes, other players can download")                                                                                           \
    SETTINGS_ITEM(U32,                MaxFpsServer,             "Host",           "MaxFPS",                   100,                             NULL,     NULL,     "Maximum FPS the dedicated server will run at.  Higher values use more CPU (and power), lower may increase lag.\n"              \
                                                                                                                                                                   "Specify 0 for no limit. Negative values will not make Bitfighter run backwards.  Sorry.  (default = 100)")                     \
+   SETTINGS_ITEM(U32,                NetWorkerThreads,         "Host",           "NetWorkerThreads",         0,                               NULL,     NULL,     "Number of extra threads used to find what each client can see.  May help busy servers on multi-core machines.")                \
+   SETTINGS_ITEM(U32,                RobotScriptThreads,       "Host",           "RobotScriptThreads",       0,                               NULL,     NULL,     "Number of extra threads used to run robot scripts.  If above 0, each robot gets its own Lua VM.")                              \
+   SETTINGS_ITEM(YesNo,              PreloadLevels,            "Host",           "PreloadLevels",            Yes,                             NULL,     NULL,     "If Yes, the next level is loaded, and its bot zones built, on a separate thread while the current one is played.")             \
+   SETTINGS_ITEM(U32,                ServerShards,             "Host",           "ServerShards",             1,                               NULL,     NULL,     "Number of games a dedicated server hosts, each on its own thread.  Extra games listen on the ports after the main one.")       \
    MYSQL_SETTINGS_TABLE_ENTRY                                                                                                                                                                                                                                                                     \
                                                                                                                                                                                                                                                                                                   \
    SETTINGS_ITEM(YesNo,              VotingEnabled,            "Host-Voting",    "VoteEnable",               No,                              NULL,     NULL,     "Enable voting on this server")                                                                                                 \
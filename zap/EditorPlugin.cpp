@@ -355,7 +355,7 @@ S32 EditorPlugin::lua_getAllObjects(lua_State *L)
 
    lua_createtable(L, count, 0);    // Create a table with enough slots for our objects
 
-   const Vector<DatabaseObject *> *objects = mGridDatabase->findObjects_fast();
+   const Vector<DatabaseObject *> *objects = mGridDatabase->findObjects_ordered();
 
    S32 pushed = 0;
 
@@ -954,6 +954,13 @@ U32 EngineeredItem::packUpdate(GhostConnection *connection, U32 updateMask, BitS
 }
 
 
+// Nothing in our updates depends on which client they go to, so all clients can share them
+S32 EngineeredItem::getUpdateCacheKey(GhostConnection *connection)
+{
+   return 0;
+}
+
+
 void EngineeredItem::unpackUpdate(GhostConnection *connection, BitStream *stream)
 {
    bool initial = false;
@@ -1045,7 +1052,7 @@ void EngineeredItem::getBufferForBotZone(F32 bufferRadius, Vector<Point> &points
 }
 
 
-static const F32 MAX_SNAP_DISTANCE = 100.0f;    // Max distance to look for a mount point
+const F32 EngineeredItem::MAX_SNAP_DISTANCE = 100.0f;
 
 // Figure out where to mount this item during construction; mountToWall() is similar, but used in editor.  
 // findDeployPoint() is version used during deployment of engineerered item.
@@ -1500,6 +1507,15 @@ void ForceFieldProjector::getForceFieldStartAndEndPoints(Point &start, Point &en
 }
 
 
+// Area a forcefield from this projector could cover if nothing were in its way
+Rect ForceFieldProjector::getForceFieldReach() const
+{
+   Point start = getForceFieldStartPoint(getPos(), mAnchorNormal);
+
+   return Rect(start, start + mAnchorNormal * (F32)ForceField::MAX_FORCEFIELD_LENGTH);
+}
+
+
 // Forcefield projector has been turned on some how; either at the beginning of a level, or via repairing, or deploying. 
 // Called on both client and server, does nothing on client.
 void ForceFieldProjector::onEnabled()
@@ -1851,6 +1867,13 @@ U32 ForceField::packUpdate(GhostConnection *connection, U32 updateMask, BitStrea
 }
 
 
+// Same updates go to everyone
+S32 ForceField::getUpdateCacheKey(GhostConnection *connection)
+{
+   return 0;
+}
+
+
 void ForceField::unpackUpdate(GhostConnection *connection, BitStream *stream)
 {
    bool initial = false;
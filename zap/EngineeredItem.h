@@ -58,6 +58,8 @@ protected:
    };
 
 public:
+   static const F32 MAX_SNAP_DISTANCE;    // Max distance to look for a mount point
+
    EngineeredItem(S32 team = TEAM_NEUTRAL, const Point &anchorPoint = Point(0,0), const Point &anchorNormal = Point(1,0));  // Constructor
    virtual ~EngineeredItem();                                                                                               // Destructor
 
@@ -88,6 +90,7 @@ public:
 
    U32 packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream);
    void unpackUpdate(GhostConnection *connection, BitStream *stream);
+   S32 getUpdateCacheKey(GhostConnection *connection);
 
    void setHealRate(S32 rate);
    S32 getHealRate() const;
@@ -195,6 +198,7 @@ public:
 
    U32 packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream);
    void unpackUpdate(GhostConnection *connection, BitStream *stream);
+   S32 getUpdateCacheKey(GhostConnection *connection);
 
    const Vector<Point> *getCollisionPoly() const;
 
@@ -246,6 +250,7 @@ public:
 
    // Get info about the forcfield that might be projected from this projector
    void getForceFieldStartAndEndPoints(Point &start, Point &end) const;
+   Rect getForceFieldReach() const;
 
    void onAddedToGame(Game *theGame);
    void onAddedToEditor();
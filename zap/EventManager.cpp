@@ -5,10 +5,15 @@
 
 #include "EventManager.h"
 
+#include "GameContext.h"
+
 #include "playerInfo.h"          // For RobotPlayerInfo constructor
 #include "robot.h"
 #include "Zone.h"
 
+#include "tnlThread.h"
+#include "tnlPlatform.h"
+
 //#include "../lua/luaprofiler-2.0.2/src/luaprofiler.h"      // For... the profiler!
 
 #ifndef ZAP_DEDICATED
@@ -30,13 +35,36 @@ struct Subscription {
 };
 
 
-// Statics:
-bool EventManager::anyPending = false; 
-static Vector<Subscription>      subscriptions         [EventManager::EventTypes];
-static Vector<Subscription>      pendingSubscriptions  [EventManager::EventTypes];
-static Vector<LuaScriptRunner *> pendingUnsubscriptions[EventManager::EventTypes];
-
-bool EventManager::mConstructed = false;  // Prevent duplicate instantiation
+// An event fired by a script while robot scripts are running in parallel.  Nothing is deleted until the
+// parallel scripts have finished and these have been fired, so holding raw pointers is safe.
+struct DeferredEvent
+{
+   EventManager::EventType eventType;
+   LuaScriptRunner *sender;
+   Ship *ship;
+   BfObject *damagingObject;
+   BfObject *shooter;
+   Zone *zone;
+   LuaPlayerInfo *playerInfo;
+   string message;
+   bool global;
+   S32 score;
+   S32 team;
+
+   explicit DeferredEvent(EventManager::EventType type)
+   {
+      eventType = type;
+      sender = NULL;
+      ship = NULL;
+      damagingObject = NULL;
+      shooter = NULL;
+      zone = NULL;
+      playerInfo = NULL;
+      global = false;
+      score = 0;
+      team = 0;
+   }
+};
 
 
 struct EventDef {
@@ -53,17 +81,16 @@ static const EventDef eventDefs[] = {
 #undef EVENT
 };
 
-static EventManager *eventManager = NULL;   // Singleton event manager, one copy is used by all listeners
-
-
 // C++ constructor
 EventManager::EventManager()
 {
-   TNLAssert(!mConstructed, "There is only one EventManager to rule them all!");
-
    mIsPaused = false;
    mStepCount = -1;
-   mConstructed = true;
+   mAnyPending = false;
+
+   mScriptWorkers = NULL;
+   mFiringInParallel = false;
+   resetTickStats();
 }
 
 
@@ -76,27 +103,29 @@ EventManager::EventManager(lua_State *L)
 // Destructor
 EventManager::~EventManager()
 {
-   // Do nothing
+   delete mScriptWorkers;
 }
 
 
 void EventManager::shutdown()
 {
-   if(eventManager)
-   {
-      delete eventManager;
-      eventManager = NULL;
-   }
+   GameContext *context = GameContext::get();
+
+   delete context->mEventManager;
+   context->mEventManager = NULL;
 }
 
 
-// Provide access to the single EventManager instance; lazily initialized
+// Each GameContext has its own EventManager, so games hosted on different threads don't see each other's events;
+// lazily initialized
 EventManager *EventManager::get()
 {
-   if(!eventManager)
-      eventManager = new EventManager();      // Deleted in shutdown(), which is called from Game destuctor
+   GameContext *context = GameContext::get();
 
-   return eventManager;
+   if(!context->mEventManager)
+      context->mEventManager = new EventManager();      // Deleted in shutdown(), which is called from Game destuctor
+
+   return context->mEventManager;
 }
 
 
@@ -106,7 +135,7 @@ void EventManager::subscribe(LuaScriptRunner *subscriber, EventType eventType, S
    if(isSubscribed(subscriber, eventType) || isPendingSubscribed(subscriber, eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
+   lua_State *L = subscriber->getLuaState();
 
    // Make sure the script has the proper event listener
    bool ok = LuaScriptRunner::loadFunction(L, subscriber->getScriptId(), eventDefs[eventType].function);     // -- function
@@ -127,8 +156,8 @@ void EventManager::subscribe(LuaScriptRunner *subscriber, EventType eventType, S
    s.subscriber = subscriber;
    s.context = context;
 
-   pendingSubscriptions[eventType].push_back(s);
-   anyPending = true;
+   mPendingSubscriptions[eventType].push_back(s);
+   mAnyPending = true;
 
    lua_pop(L, -1);    // Remove function from stack                                  -- <<empty stack>>
 }
@@ -140,18 +169,18 @@ void EventManager::unsubscribe(LuaScriptRunner *subscriber, EventType eventType)
    {
       removeFromPendingSubscribeList(subscriber, eventType);
 
-      pendingUnsubscriptions[eventType].push_back(subscriber);
-      anyPending = true;
+      mPendingUnsubscriptions[eventType].push_back(subscriber);
+      mAnyPending = true;
    }
 }
 
 
 void EventManager::removeFromPendingSubscribeList(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < pendingSubscriptions[eventType].size(); i++)
-      if(pendingSubscriptions[eventType][i].subscriber == subscriber)
+   for(S32 i = 0; i < mPendingSubscriptions[eventType].size(); i++)
+      if(mPendingSubscriptions[eventType][i].subscriber == subscriber)
       {
-         pendingSubscriptions[eventType].erase_fast(i);
+         mPendingSubscriptions[eventType].erase_fast(i);
          return;
       }
 }
@@ -159,10 +188,10 @@ void EventManager::removeFromPendingSubscribeList(LuaScriptRunner *subscriber, E
 
 void EventManager::removeFromPendingUnsubscribeList(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < pendingUnsubscriptions[eventType].size(); i++)
-      if(pendingUnsubscriptions[eventType][i] == subscriber)
+   for(S32 i = 0; i < mPendingUnsubscriptions[eventType].size(); i++)
+      if(mPendingUnsubscriptions[eventType][i] == subscriber)
       {
-         pendingUnsubscriptions[eventType].erase_fast(i);
+         mPendingUnsubscriptions[eventType].erase_fast(i);
          return;
       }
 }
@@ -170,10 +199,10 @@ void EventManager::removeFromPendingUnsubscribeList(LuaScriptRunner *subscriber,
 
 void EventManager::removeFromSubscribedList(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
-      if(subscriptions[eventType][i].subscriber == subscriber)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
+      if(mSubscriptions[eventType][i].subscriber == subscriber)
       {
-         subscriptions[eventType].erase_fast(i);
+         mSubscriptions[eventType].erase_fast(i);
          return;
       }
 }
@@ -191,8 +220,8 @@ void EventManager::unsubscribeImmediate(LuaScriptRunner *subscriber, EventType e
 // Check if we're subscribed to an event
 bool EventManager::isSubscribed(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
-      if(subscriptions[eventType][i].subscriber == subscriber)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
+      if(mSubscriptions[eventType][i].subscriber == subscriber)
          return true;
 
    return false;
@@ -201,8 +230,8 @@ bool EventManager::isSubscribed(LuaScriptRunner *subscriber, EventType eventType
 
 bool EventManager::isPendingSubscribed(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < pendingSubscriptions[eventType].size(); i++)
-      if(pendingSubscriptions[eventType][i].subscriber == subscriber)
+   for(S32 i = 0; i < mPendingSubscriptions[eventType].size(); i++)
+      if(mPendingSubscriptions[eventType][i].subscriber == subscriber)
          return true;
 
    return false;
@@ -211,8 +240,8 @@ bool EventManager::isPendingSubscribed(LuaScriptRunner *subscriber, EventType ev
 
 bool EventManager::isPendingUnsubscribed(LuaScriptRunner *subscriber, EventType eventType)
 {
-   for(S32 i = 0; i < pendingUnsubscriptions[eventType].size(); i++)
-      if(pendingUnsubscriptions[eventType][i] == subscriber)
+   for(S32 i = 0; i < mPendingUnsubscriptions[eventType].size(); i++)
+      if(mPendingUnsubscriptions[eventType][i] == subscriber)
          return true;
 
    return false;
@@ -222,59 +251,195 @@ bool EventManager::isPendingUnsubscribed(LuaScriptRunner *subscriber, EventType
 // Process all pending subscriptions and unsubscriptions
 void EventManager::update()
 {
-   if(anyPending)
+   if(mAnyPending)
    {
       for(S32 i = 0; i < EventTypes; i++)
-         for(S32 j = 0; j < pendingUnsubscriptions[i].size(); j++)     // Unsubscribing first means less searching!
-            removeFromSubscribedList(pendingUnsubscriptions[i][j], (EventType) i);
+         for(S32 j = 0; j < mPendingUnsubscriptions[i].size(); j++)     // Unsubscribing first means less searching!
+            removeFromSubscribedList(mPendingUnsubscriptions[i][j], (EventType) i);
 
       for(S32 i = 0; i < EventTypes; i++)
-         for(S32 j = 0; j < pendingSubscriptions[i].size(); j++)     
-            subscriptions[i].push_back(pendingSubscriptions[i][j]);
+         for(S32 j = 0; j < mPendingSubscriptions[i].size(); j++)     
+            mSubscriptions[i].push_back(mPendingSubscriptions[i][j]);
 
       for(S32 i = 0; i < EventTypes; i++)
       {
-         pendingSubscriptions[i].clear();
-         pendingUnsubscriptions[i].clear();
+         mPendingSubscriptions[i].clear();
+         mPendingUnsubscriptions[i].clear();
       }
 
-      anyPending = false;
+      mAnyPending = false;
    }
 }
 
 
-// onNexusOpened, onNexusClosed
+// onNexusOpened, onNexusClosed, onGameOver
 void EventManager::fireEvent(EventType eventType)
 {
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
+   if(mFiringInParallel)
+   {
+      deferEvent(DeferredEvent(eventType));
+      return;
+   }
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
+   {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, mSubscriptions[eventType][i].context);
+   }
 }
 
 
-// onTick
+// onTick -- robots with their own Lua VM run their handlers in parallel, after everyone else
 void EventManager::fireEvent(EventType eventType, U32 deltaT)
 {
    if(suppressEvents(eventType))   
       return;
 
+   TNLAssert(!mFiringInParallel, "Ticks can't be fired from a script!");
+
    if(eventType == TickEvent)
       mStepCount--;   
 
-   lua_State *L = LuaScriptRunner::getL();
+   S64 startTime = Platform::getHighPrecisionTimerValue();
+   S32 handlers = mSubscriptions[eventType].size();
 
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   mParallelTickSubscriptions.clear();
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      LuaScriptRunner *subscriber = mSubscriptions[eventType][i].subscriber;
+
+      if(mScriptWorkers && subscriber->hasPrivateLuaState())
+      {
+         mParallelTickSubscriptions.push_back(mSubscriptions[eventType][i]);
+         continue;
+      }
+
+      lua_State *L = subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       lua_pushinteger(L, deltaT);   // -- deltaT
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, subscriber, eventDefs[eventType].function, mSubscriptions[eventType][i].context);
+   }
+
+   if(mParallelTickSubscriptions.size() > 0)
+      fireTickEventInParallel(mParallelTickSubscriptions, deltaT);
+
+   mTickStats.ticks++;
+   mTickStats.handlers += handlers;
+   mTickStats.scriptTime += Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - startTime);
+}
+
+
+// Runs onTick for one robot per task index; each robot only touches its own VM
+class TickTask : public WorkerTask
+{
+   const Vector<Subscription> &mSubscriptions;
+   const char *mFunction;
+   U32 mDeltaT;
+
+public:
+   TickTask(const Vector<Subscription> &subscriptions, const char *function, U32 deltaT) :
+      mSubscriptions(subscriptions), mFunction(function), mDeltaT(deltaT) { }
+
+   void runTask(S32 index)
+   {
+      const Subscription &subscription = mSubscriptions[index];
+      lua_State *L = subscription.subscriber->getLuaState();
+
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
+      lua_pushinteger(L, mDeltaT);   // -- deltaT
+      setScriptContext(L, subscription.context);
+      subscription.subscriber->runCmd(mFunction, 0);
+   }
+};
+
+
+// The main thread is parked in run() until every handler has returned, so the game can't change under the scripts
+// except through their own calls back into c++, which take turns via the script lock (read-only ones share it).  Events those calls fire are
+// held until the end, so a handler never re-enters another robot's VM.
+void EventManager::fireTickEventInParallel(const Vector<Subscription> &subscribers, U32 deltaT)
+{
+   TickTask task(subscribers, eventDefs[TickEvent].function, deltaT);
+
+   mFiringInParallel = true;
+   setScriptThreadsActive(true);
+
+   mScriptWorkers->run(&task, subscribers.size());
+
+   setScriptThreadsActive(false);
+   mFiringInParallel = false;
+
+   fireDeferredEvents();
+}
+
+
+void EventManager::deferEvent(const DeferredEvent &event)
+{
+   mDeferredEventsMutex.lock();
+   mDeferredEvents.push_back(event);
+   mDeferredEventsMutex.unlock();
+}
+
+
+void EventManager::fireDeferredEvents()
+{
+   // Take the list before firing anything, so handlers that fire more events can't disturb the one we're walking
+   Vector<DeferredEvent> events;
+
+   mDeferredEventsMutex.lock();
+   events.getStlVector().swap(mDeferredEvents.getStlVector());
+   mDeferredEventsMutex.unlock();
+
+   for(S32 i = 0; i < events.size(); i++)
+   {
+      const DeferredEvent &event = events[i];
+
+      switch(event.eventType)
+      {
+         case ShipSpawnedEvent:
+            fireEvent(event.eventType, event.ship);
+            break;
+
+         case ShipKilledEvent:
+            fireEvent(event.eventType, event.ship, event.damagingObject, event.shooter);
+            break;
+
+         case PlayerJoinedEvent:
+         case PlayerLeftEvent:
+         case PlayerTeamChangedEvent:
+            fireEvent(event.sender, event.eventType, event.playerInfo);
+            break;
+
+         case MsgReceivedEvent:
+            fireEvent(event.sender, event.eventType, event.message.c_str(), event.playerInfo, event.global);
+            break;
+
+         case ShipEnteredZoneEvent:
+         case ShipLeftZoneEvent:
+            fireEvent(event.eventType, event.ship, event.zone);
+            break;
+
+         case ScoreChangedEvent:
+            fireEvent(event.eventType, event.score, event.team, event.playerInfo);
+            break;
+
+         case NexusOpenedEvent:
+         case NexusClosedEvent:
+         case GameOverEvent:
+            fireEvent(event.eventType);
+            break;
+
+         default:
+            TNLAssert(false, "Unexpected deferred event!");
+            break;
+      }
    }
 }
 
@@ -285,14 +450,21 @@ void EventManager::fireEvent(EventType eventType, Ship *ship)
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(mFiringInParallel)
+   {
+      DeferredEvent event(eventType);
+      event.ship = ship;
+      deferEvent(event);
+      return;
+   }
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       ship->push(L);                // -- ship
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, mSubscriptions[eventType][i].context);
    }
 }
 
@@ -303,12 +475,21 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, BfObject *damaging
    if(suppressEvents(eventType))
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(mFiringInParallel)
+   {
+      DeferredEvent event(eventType);
+      event.ship = ship;
+      event.damagingObject = damagingObject;
+      event.shooter = shooter;
+      deferEvent(event);
+      return;
+   }
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       ship->push(L);                // -- ship
 
       if(damagingObject)
@@ -321,7 +502,7 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, BfObject *damaging
       else
          lua_pushnil(L);
 
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, mSubscriptions[eventType][i].context);
    }
 }
 
@@ -333,15 +514,25 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(mFiringInParallel)
+   {
+      DeferredEvent event(eventType);
+      event.sender = sender;
+      event.message = message;
+      event.playerInfo = playerInfo;
+      event.global = global;
+      deferEvent(event);
+      return;
+   }
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
-      if(sender == subscriptions[eventType][i].subscriber)    // Don't alert sender about own message!
+      if(sender == mSubscriptions[eventType][i].subscriber)    // Don't alert sender about own message!
          continue;
 
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       lua_pushstring(L, message);   // -- message
 
       if(playerInfo)
@@ -351,7 +542,7 @@ void EventManager::fireEvent(LuaScriptRunner *sender, EventType eventType, const
 
       lua_pushboolean(L, global);   // -- message, player, isGlobal
 
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, mSubscriptions[eventType][i].context);
    }
 }
 
@@ -362,17 +553,25 @@ void EventManager::fireEvent(LuaScriptRunner *player, EventType eventType, LuaPl
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(mFiringInParallel)
+   {
+      DeferredEvent event(eventType);
+      event.sender = player;
+      event.playerInfo = playerInfo;
+      deferEvent(event);
+      return;
+   }
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
-      if(player == subscriptions[eventType][i].subscriber)    // Don't trouble player with own joinage or leavage!
+      if(player == mSubscriptions[eventType][i].subscriber)    // Don't trouble player with own joinage or leavage!
          continue;
 
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       playerInfo->push(L);          // -- playerInfo
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, mSubscriptions[eventType][i].context);
    }
 }
 
@@ -383,12 +582,20 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, Zone *zone)
    if(suppressEvents(eventType))   
       return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(mFiringInParallel)
+   {
+      DeferredEvent event(eventType);
+      event.ship = ship;
+      event.zone = zone;
+      deferEvent(event);
+      return;
+   }
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       try   
       {
          // Passing ship, zone, zoneType, zoneId
@@ -397,11 +604,11 @@ void EventManager::fireEvent(EventType eventType, Ship *ship, Zone *zone)
          lua_pushinteger(L, zone->getObjectTypeNumber());   // -- ship, zone, zone->objTypeNumber
          lua_pushinteger(L, zone->getUserAssignedId());     // -- ship, zone, zone->objTypeNumber, zone->id
 
-         fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+         fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, mSubscriptions[eventType][i].context);
       }
       catch(LuaException &e)
       {
-         handleEventFiringError(L, subscriptions[eventType][i], eventType, e.what());
+         handleEventFiringError(L, mSubscriptions[eventType][i], eventType, e.what());
          clearStack(L);
          return;
       }
@@ -415,12 +622,21 @@ void EventManager::fireEvent(EventType eventType, S32 score, S32 team, LuaPlayer
    if(suppressEvents(eventType))
          return;
 
-   lua_State *L = LuaScriptRunner::getL();
-
-   TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+   if(mFiringInParallel)
+   {
+      DeferredEvent event(eventType);
+      event.score = score;
+      event.team = team;
+      event.playerInfo = playerInfo;
+      deferEvent(event);
+      return;
+   }
 
-   for(S32 i = 0; i < subscriptions[eventType].size(); i++)
+   for(S32 i = 0; i < mSubscriptions[eventType].size(); i++)
    {
+      lua_State *L = mSubscriptions[eventType][i].subscriber->getLuaState();
+      TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
+
       lua_pushinteger(L, score);   // -- score
       lua_pushinteger(L, team);    // -- score, team
 
@@ -429,7 +645,7 @@ void EventManager::fireEvent(EventType eventType, S32 score, S32 team, LuaPlayer
       else
          lua_pushnil(L);
 
-      fire(L, subscriptions[eventType][i].subscriber, eventDefs[eventType].function, subscriptions[eventType][i].context);
+      fire(L, mSubscriptions[eventType][i].subscriber, eventDefs[eventType].function, mSubscriptions[eventType][i].context);
    }
 }
 
@@ -460,10 +676,41 @@ void EventManager::handleEventFiringError(lua_State *L, const Subscription &subs
 }
 
 
+void EventManager::setScriptThreadCount(U32 count)
+{
+   if(count == getScriptThreadCount())
+      return;
+
+   delete mScriptWorkers;
+   mScriptWorkers = count ? new WorkerPool(count) : NULL;
+   resetTickStats();
+}
+
+
+U32 EventManager::getScriptThreadCount() const
+{
+   return mScriptWorkers ? mScriptWorkers->getThreadCount() : 0;
+}
+
+
+const EventManager::TickStats &EventManager::getTickStats() const
+{
+   return mTickStats;
+}
+
+
+void EventManager::resetTickStats()
+{
+   mTickStats.ticks = 0;
+   mTickStats.handlers = 0;
+   mTickStats.scriptTime = 0;
+}
+
+
 // If true, events will not fire!
 bool EventManager::suppressEvents(EventType eventType)
 {
-   if(subscriptions[eventType].size() == 0)
+   if(mSubscriptions[eventType].size() == 0)
       return true;
 
    return mIsPaused && mStepCount <= 0;    // Paused bots should still respond to events as long as stepCount > 0
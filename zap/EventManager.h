@@ -8,9 +8,12 @@
 
 #include "LuaBase.h"    // For ScriptContext def
 
+#include "tnlThread.h"
 #include "tnlTypes.h"
 #include "tnlVector.h"
 
+namespace TNL{ class WorkerPool; }
+
 
 using namespace TNL;
 
@@ -22,8 +25,10 @@ class Ship;
 class LuaPlayerInfo;
 class LuaScriptRunner;
 class Zone;
+class BfObject;
 
 struct Subscription; 
+struct DeferredEvent;
 
 class EventManager
 {
@@ -77,10 +82,37 @@ private:
 
    void handleEventFiringError(lua_State *L, const Subscription &subscriber, EventType eventType, const char *errorMsg);
    bool fire(lua_State *L, LuaScriptRunner *scriptRunner, const char *function, ScriptContext context);
+
+   void fireTickEventInParallel(const Vector<Subscription> &subscribers, U32 deltaT);
+   void deferEvent(const DeferredEvent &event);    // Hold an event fired by a script running in parallel
+   void fireDeferredEvents();
       
    bool mIsPaused;
    S32 mStepCount;           // If running for a certain number of steps, this will be > 0, while mIsPaused will be true
-   static bool mConstructed;
+
+   Vector<Subscription>      mSubscriptions         [EventTypes];
+   Vector<Subscription>      mPendingSubscriptions  [EventTypes];
+   Vector<LuaScriptRunner *> mPendingUnsubscriptions[EventTypes];
+   bool mAnyPending;
+
+   Vector<DeferredEvent> mDeferredEvents;
+   Mutex mDeferredEventsMutex;      // Scripts on any worker may add to mDeferredEvents
+   Vector<Subscription>  mParallelTickSubscriptions;     // Reused every tick
+
+   WorkerPool *mScriptWorkers;      // Runs onTick for robots with their own Lua VMs; NULL if all scripts run on the main thread
+   bool mFiringInParallel;          // Events fired by scripts while this is set are held until all the scripts have finished
+
+public:
+   /// Time spent running onTick handlers, in ms
+   struct TickStats
+   {
+      U32 ticks;              ///< Number of TickEvents fired
+      U32 handlers;           ///< Number of onTick calls made
+      F64 scriptTime;         ///< Wall clock time spent in onTick handlers
+   };
+
+private:
+   TickStats mTickStats;
 
 public:
    EventManager();                       // C++ constructor
@@ -89,14 +121,9 @@ public:
 
    static void shutdown();
 
-   static EventManager *get();         // Provide access to the single EventManager instance
+   static EventManager *get();         // Provide access to the EventManager of the current GameContext
    bool suppressEvents(EventType eventType);
 
-   //static Vector<Subscription> subscriptions[EventTypes];
-   //static Vector<Subscription> pendingSubscriptions[EventTypes];
-   //static Vector<pendingUnsubscriptions *> pendingUnsubscriptions[EventTypes];
-   static bool anyPending;
-
    void subscribe  (LuaScriptRunner *subscriber, EventType eventType, ScriptContext context, bool failSilently = false);
    void unsubscribe(LuaScriptRunner *subscriber, EventType eventType);
 
@@ -114,6 +141,13 @@ public:
    void fireEvent(EventType eventType, Ship *ship, Zone *zone); // ShipEnteredZoneEvent, ShipLeftZoneEvent
    void fireEvent(EventType eventType, S32 score, S32 team, LuaPlayerInfo *playerInfo);
 
+   // Robots with their own Lua VM run their onTick handlers on this many extra threads
+   void setScriptThreadCount(U32 count);
+   U32 getScriptThreadCount() const;
+
+   const TickStats &getTickStats() const;
+   void resetTickStats();
+
    // Allow the pausing of event firing for debugging purposes
    void setPaused(bool isPaused);
    void togglePauseStatus();
@@ -0,0 +1,45 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "GameContext.h"
+
+namespace Zap
+{
+
+static GameContext gDefaultGameContext;      // For threads that haven't set a context of their own
+
+
+// Constructor
+GameContext::GameContext()
+{
+   mServerGame = NULL;
+   mHostingModePhase = GameManager::NotHosting;
+   mEventManager = NULL;
+
+   mSharedL = NULL;
+
+   mScriptThreadsActive = false;
+}
+
+
+// Destructor -- the game, EventManager and Lua are shut down by their owners, before we get here
+GameContext::~GameContext()
+{
+   // Do nothing
+}
+
+
+// Every context set by the game is a GameContext, so anything but TNL's default one can be cast
+GameContext *GameContext::get()
+{
+   ThreadContext *context = ThreadContext::getCurrent();
+
+   if(context == ThreadContext::getDefault())
+      return &gDefaultGameContext;
+
+   return static_cast<GameContext *>(context);
+}
+
+}
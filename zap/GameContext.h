@@ -0,0 +1,53 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _GAME_CONTEXT_H_
+#define _GAME_CONTEXT_H_
+
+#include "GameManager.h"      // For HostingModePhase
+
+#include "tnlThread.h"
+
+#include <deque>
+#include <string>
+
+struct lua_State;
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+class ServerGame;
+class EventManager;
+
+// Everything that used to be a process-wide singleton for the game being hosted: the ServerGame itself, its
+// EventManager and the shared Lua VM.  A process hosting several games runs each on its own thread with its own
+// GameContext; threads that never set one, like the main thread of a normal client or server, share a default.
+// Worker threads borrow the context of the thread that hands them work (see WorkerPool::run).
+class GameContext : public ThreadContext
+{
+public:
+   ServerGame *mServerGame;
+   GameManager::HostingModePhase mHostingModePhase;
+   EventManager *mEventManager;        // Created on first use
+
+   lua_State *mSharedL;                // Lua state shared by all scripts that don't have one of their own
+   deque<string> mCachedScripts;       // Scripts compiled into mSharedL
+
+   bool mScriptThreadsActive;          // Robot scripts are running on worker threads, so calls into c++ take turns
+   ReadWriteLock mScriptCallLock;      // Shared by read-only methods, exclusive for everything else
+   Mutex mLuaProxyMutex;               // Guards the objects' proxy lists, which every VM in the game links into
+
+   GameContext();             // Constructor
+   virtual ~GameContext();    // Destructor
+
+   static GameContext *get();          // Context of the calling thread; never NULL
+};
+
+}
+
+#endif
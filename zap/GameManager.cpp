@@ -5,9 +5,12 @@
 
 #include "GameManager.h"
 
+#include "GameContext.h"
+
 #include "DisplayManager.h"
 #include "FontManager.h"
 #include "ServerGame.h"
+#include "ServerShard.h"
 #include "SoundSystem.h"
 #include "VideoSystem.h"
 #include "Console.h"
@@ -27,11 +30,10 @@ namespace Zap
 {
 
 // Declare statics
-ServerGame *GameManager::mServerGame = NULL;
 #ifndef ZAP_DEDICATED
    Vector<ClientGame *> GameManager::mClientGames;
 #endif
-GameManager::HostingModePhase GameManager::mHostingModePhase = GameManager::NotHosting;
+Vector<ServerShard *> GameManager::mServerShards;
 Console *GameManager::gameConsole = NULL;    // For the moment, we'll just have one console for everything.  This may change later, but probably won't.
 
 static ConsoleLogConsumer *ConsoleLog;
@@ -65,9 +67,11 @@ void GameManager::initialize()
 // All levels loaded, we're ready to go
 bool GameManager::hostGame()
 {
-   TNLAssert(mServerGame, "Need a ServerGame to host, silly!");
+   ServerGame *serverGame = getServerGame();
+
+   TNLAssert(serverGame, "Need a ServerGame to host, silly!");
 
-   if(!mServerGame->startHosting())
+   if(!serverGame->startHosting())
    {
       abortHosting_noLevels();
       return false;
@@ -79,20 +83,77 @@ bool GameManager::hostGame()
    for(S32 i = 0; i < clientGames->size(); i++)
    {
       clientGames->get(i)->getUIManager()->disableLevelLoadDisplay(true);
-      clientGames->get(i)->joinLocalGame(mServerGame->getNetInterface());  // ...then we'll play, too!
+      clientGames->get(i)->joinLocalGame(serverGame->getNetInterface());  // ...then we'll play, too!
    }
 #endif
 
+   startServerShards();
+
    return true;
 }
 
 
+// Start any extra games a dedicated server has been asked to host.  Game i listens on the port i above ours.
+void GameManager::startServerShards()
+{
+   ServerGame *serverGame = getServerGame();
+   GameSettingsPtr settings = serverGame->getSettingsPtr();
+
+   U32 shardCount = settings->getSetting<U32>(IniKey::ServerShards);
+
+   if(shardCount <= 1 || !serverGame->isDedicated() || serverGame->isTestServer() || serverGame->mHostOnServer)
+      return;
+
+   Address address(IPProtocol, Address::Any, GameSettings::DEFAULT_GAME_PORT);   // Same as initHosting()
+   address.set(settings->getHostAddress());
+
+   // Shards create and destroy StringTableEntries for as long as they run, so the table stays locked (and
+   // uncompacted) until stopServerShards(); see ServerShard
+   StringTable::beginThreadedUse();
+
+   for(U32 i = 1; i < shardCount; i++)
+   {
+      Address shardAddress = address;
+      shardAddress.port = U16(address.port + i);
+
+      ServerShard *shard = new ServerShard(i, shardAddress, settings, serverGame->getLevelSource());
+
+      if(shard->start())
+         mServerShards.push_back(shard);
+      else
+         delete shard;
+   }
+
+   if(mServerShards.size() == 0)
+   {
+      StringTable::endThreadedUse();
+      return;
+   }
+
+   logprintf(LogConsumer::ServerFilter, "Hosting %d games", mServerShards.size() + 1);
+}
+
+
+// Shuts down the extra games, and waits until they're gone
+void GameManager::stopServerShards()
+{
+   if(mServerShards.size() == 0)
+      return;
+
+   mServerShards.deleteAndClear();
+
+   StringTable::endThreadedUse();
+}
+
+
 // If we can't load any levels, here's the plan...
 void GameManager::abortHosting_noLevels()
 {
-   if(mServerGame->isDedicated())
+   ServerGame *serverGame = getServerGame();
+
+   if(serverGame->isDedicated())
    {
-      FolderManager *folderManager = mServerGame->getSettings()->getFolderManager();
+      FolderManager *folderManager = serverGame->getSettings()->getFolderManager();
       const char *levelDir = folderManager->getLevelDir().c_str();
 
       logprintf(LogConsumer::LogError, "No levels found in folder %s.  Cannot host a game.", levelDir);
@@ -109,7 +170,7 @@ void GameManager::abortHosting_noLevels()
 
       ErrorMessageUserInterface *errUI = uiManager->getUI<ErrorMessageUserInterface>();
 
-      FolderManager *folderManager = mServerGame->getSettings()->getFolderManager();
+      FolderManager *folderManager = serverGame->getSettings()->getFolderManager();
       string levelDir = folderManager->getLevelDir();
 
       errUI->reset();
@@ -136,31 +197,37 @@ void GameManager::abortHosting_noLevels()
 
 ServerGame *GameManager::getServerGame()
 {
-   return mServerGame;
+   return GameContext::get()->mServerGame;
 }
 
 
 void GameManager::setServerGame(ServerGame *serverGame)
 {
+   GameContext *context = GameContext::get();
+
    TNLAssert(serverGame, "Expect a valid serverGame here!");
-   TNLAssert(!mServerGame, "Already have a ServerGame!");
+   TNLAssert(!context->mServerGame, "Already have a ServerGame!");
 
-   mServerGame = serverGame;
+   context->mServerGame = serverGame;
 }
 
 
 void GameManager::deleteServerGame()
 {
+   GameContext *context = GameContext::get();
+
    // mServerGame might be NULL here; for example when quitting after losing a connection to the game server
-   delete mServerGame;     // Kill the serverGame (leaving the clients running)
-   mServerGame = NULL;
+   delete context->mServerGame;     // Kill the serverGame (leaving the clients running)
+   context->mServerGame = NULL;
 }
 
 
 void GameManager::idleServerGame(U32 timeDelta)
 {
-   if(mServerGame)
-      mServerGame->idle(timeDelta);
+   ServerGame *serverGame = getServerGame();
+
+   if(serverGame)
+      serverGame->idle(timeDelta);
 }
 
 
@@ -219,13 +286,13 @@ void GameManager::idle(U32 timeDelta)
 
 void GameManager::setHostingModePhase(HostingModePhase phase)
 {
-   mHostingModePhase = phase;
+   GameContext::get()->mHostingModePhase = phase;
 }
 
 
 GameManager::HostingModePhase GameManager::getHostingModePhase()
 {
-   return mHostingModePhase;
+   return GameContext::get()->mHostingModePhase;
 }
 
 
@@ -246,6 +313,8 @@ void GameManager::shutdownBitfighter()
 {
    GameSettings *settings = NULL;
 
+   stopServerShards();     // They share our settings, which we're about to delete
+
    // Avoid this function being called twice when we exit via methods 1-4 above
 #ifndef ZAP_DEDICATED
    if(GameManager::getClientGames()->size() == 0)
@@ -15,12 +15,14 @@ namespace Zap
 {
 
 class ServerGame;
+class ServerShard;
 
 #ifndef ZAP_DEDICATED
    class ClientGame;
 #endif
 
-// Singleton class for keeping track of various Game objects
+// Singleton class for keeping track of various Game objects.  The ServerGame and hosting phase belong to the
+// calling thread's GameContext, so each thread hosting a game sees its own.
 class GameManager
 {
 public:
@@ -33,12 +35,14 @@ public:
    };
 
 private:
-   static ServerGame *mServerGame;
 #ifndef ZAP_DEDICATED
    static Vector<ClientGame *> mClientGames;
 #endif
 
-   static HostingModePhase mHostingModePhase;
+   static Vector<ServerShard *> mServerShards;     // Extra games hosted by a dedicated server, on their own threads
+
+   static void startServerShards();
+   static void stopServerShards();
 
 public:
    static ::Console *gameConsole;
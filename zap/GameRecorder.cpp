@@ -4,6 +4,7 @@
 //------------------------------------------------------------------------------
 
 #include "GameRecorder.h"
+#include "LzUtils.h"
 #include "tnlBitStream.h"
 #include "tnlNetObject.h"
 #include "gameType.h"
@@ -20,99 +21,493 @@
 #include "version.h"
 
 #include <algorithm>
+#include <string.h>
 
 namespace Zap
 {
 
 
 
+const U32 GameRecorderServer::SeekIndexTag = 0x49534642;    // "BFSI"
+const U32 GameRecorderServer::KeyframeInterval = 10000;
+const U32 GameRecorderServer::BlockSize = 65536;           // Offsets in compressed blocks only reach back this far
+const U32 GameRecorderServer::FlushInterval = 1000;        // Most a server crash loses
+const U32 GameRecorderServer::MaxQueuedSize = 4 * 1024 * 1024;
+
+
+static void putU32(U8 *dest, U32 value)
+{
+   dest[0] = U8(value);
+   dest[1] = U8(value >> 8);
+   dest[2] = U8(value >> 16);
+   dest[3] = U8(value >> 24);
+}
+
+
+U32 getRecordingU32(const U8 *src)
+{
+   return U32(src[0]) | (U32(src[1]) << 8) | (U32(src[2]) << 16) | (U32(src[3]) << 24);
+}
+
+
 // fwrite might have multiple 1-second freeze on VPS server or heavy disk access
 // Having fwrite in separate thread might fix the game from freezing/lagging
 // if run in VPS server or with heavy disk access
-
+//
+// The game thread gathers records into blocks, and hands each full one over, or a partial one every FlushInterval;
+// the writer thread sleeps until it gets one, then compresses and writes it.  It also keeps track of where the
+// keyframes land in the file, so it writes the seek index too.
+//
+// If the disk stalls long enough for MaxQueuedSize bytes to back up, we stop recording rather than let the queue
+// grow without bound.  Records run on from one block into the next, so we can't just skip a block; the file ends
+// after the last block that made it, with no seek index, and playback scans it like any unfinished recording.
 class WriteBufferThread : public Thread
 {
 private:
-   FILE *f;
-   U32 lastPos;
-   U32 currPos;
-   U8 buffer[1024*128];
-   TNL::Semaphore sem1;
-   U32 threadPos;
-   bool exitNow;
-public:
+   struct Block
+   {
+      U8 *data;                  // NULL when it's time to finish up
+      U32 size;
+      bool startsWithKeyframe;
+      U32 keyframeTime;
+      bool overflowed;           // On the final block: blocks were dropped, so leave out the seek index
+   };
+
+   FILE *mFile;
+   bool mRunning;
+
+   // Game thread only
+   U8 *mBlock;
+   U32 mBlockSize;
+   bool mBlockStartsWithKeyframe;
+   U32 mBlockKeyframeTime;
+
+   Mutex mMutex;
+   Vector<Block> mQueue;         // Protected by mMutex
+   U32 mQueuedSize;              // Bytes in mQueue; protected by mMutex
+   bool mOverflowed;             // Queue got too big and we gave up; game thread only
+   U32 mTotalTime;               // Set before the final block is queued, so the queue's lock covers it
+   Semaphore mQueueSemaphore;    // Incremented for each block queued
+   Semaphore mDoneSemaphore;     // Incremented when the file has been closed
+
+   // Writer thread only
+   U32 mFileOffset;
+   Vector<RecordingKeyframe> mKeyframes;
+   Vector<U8> mCompressed;
+
+   void queueBlock(U8 *data, U32 size)
+   {
+      Block block;
+      block.data = data;
+      block.size = size;
+      block.startsWithKeyframe = mBlockStartsWithKeyframe;
+      block.keyframeTime = mBlockKeyframeTime;
+      block.overflowed = mOverflowed;
+
+      mBlockStartsWithKeyframe = false;
+
+      if(!mRunning || (data && mOverflowed))
+      {
+         delete [] data;
+         return;
+      }
+
+      mMutex.lock();
 
-   WriteBufferThread(FILE *file)
+      // The finishing block (data == NULL) always goes through, so the file gets closed
+      if(data && mQueuedSize + size > GameRecorderServer::MaxQueuedSize)
+      {
+         mOverflowed = true;
+         mMutex.unlock();
+
+         logprintf(LogConsumer::LogWarning, "Recording fell too far behind the disk, and was stopped early");
+         delete [] data;
+         return;
+      }
+
+      mQueue.push_back(block);
+      mQueuedSize += size;
+      mMutex.unlock();
+
+      mQueueSemaphore.increment();
+   }
+
+   void flushBlock()
+   {
+      if(mBlockSize == 0)
+         return;
+
+      queueBlock(mBlock, mBlockSize);
+      mBlock = new U8[GameRecorderServer::BlockSize];
+      mBlockSize = 0;
+   }
+
+   void writeBlock(const U8 *data, U32 size)
+   {
+      mCompressed.resize(8 + Lz::getMaxCompressedSize(size));
+      U32 compressedSize = Lz::compress(data, size, &mCompressed[8]);
+
+      if(compressedSize >= size)    // Not worth it; store it as it is
+      {
+         compressedSize = size;
+         memcpy(&mCompressed[8], data, size);
+      }
+
+      putU32(&mCompressed[0], compressedSize);
+      putU32(&mCompressed[4], size);
+      fwrite(mCompressed.address(), 1, compressedSize + 8, mFile);
+      fflush(mFile);       // If the server dies, everything we were handed should be on the disk
+
+      mFileOffset += compressedSize + 8;
+   }
+
+   // Lists where the keyframes are, so playback doesn't have to read through the whole recording to find them.  The
+   // last 8 bytes of the file say where the index starts.
+   void writeSeekIndex()
+   {
+      U32 indexOffset = mFileOffset;
+
+      Vector<U8> index;
+      index.resize(15 + mKeyframes.size() * 8);
+
+      index[0] = 0;
+      index[1] = 0;
+      index[2] = U8(RecordSeekIndex);
+      putU32(&index[3], 8 + mKeyframes.size() * 8);
+      putU32(&index[7], mTotalTime);
+      putU32(&index[11], mKeyframes.size());
+
+      for(S32 i = 0; i < mKeyframes.size(); i++)
+      {
+         putU32(&index[15 + i * 8], mKeyframes[i].time);
+         putU32(&index[19 + i * 8], mKeyframes[i].offset);
+      }
+
+      for(U32 pos = 0; pos < U32(index.size()); pos += GameRecorderServer::BlockSize)
+         writeBlock(&index[pos], min(U32(index.size()) - pos, GameRecorderServer::BlockSize));
+
+      U8 trailer[8];
+      putU32(trailer, indexOffset);
+      putU32(&trailer[4], GameRecorderServer::SeekIndexTag);
+      fwrite(trailer, 1, 8, mFile);
+   }
+
+public:
+   // Constructor -- header goes into the file as it is, ahead of the blocks
+   WriteBufferThread(FILE *file, const U8 *header, U32 headerSize)
    {
       TNLAssert(file != 0, "Must have a file handle");
-      lastPos = 0;
-      currPos = 0;
-      threadPos = 0;
-      exitNow = false;
-      f = file;
-      if(!start())
+      mFile = file;
+      mBlock = new U8[GameRecorderServer::BlockSize];
+      mBlockSize = 0;
+      mBlockStartsWithKeyframe = false;
+      mBlockKeyframeTime = 0;
+      mTotalTime = 0;
+      mQueuedSize = 0;
+      mOverflowed = false;
+
+      fwrite(header, 1, headerSize, mFile);
+      mFileOffset = headerSize;
+
+      mRunning = start();
+
+      if(!mRunning)
       {
          logprintf(LogConsumer::LogWarning, "Failed to create thread for recorder, games may not record");
-         fclose(f);
-         f = NULL;
+         fclose(mFile);
+         mFile = NULL;
       }
    }
+
+   // Destructor
    ~WriteBufferThread()
    {
-      exitNow = true;
-      sem1.increment();
-      while(f != 0)         // Wait until the other thread is done
-         Platform::sleep(1);
+      TNLAssert(!mRunning, "Call finish() first!");
+      delete [] mBlock;
    }
 
-
-   U8 *getBuffer(U32 size)
+   void write(const U8 *data, U32 size)
    {
-      if(currPos + size > sizeof(buffer))
-      {
-         lastPos = currPos;
-         currPos = 0;
-      }
-      U32 t = threadPos;
-      while(t > currPos && t < currPos + size) // Buffer too full, waiting...
+      while(size > 0)
       {
-         Platform::sleep(1);
-         t = threadPos;
+         U32 chunkSize = min(size, GameRecorderServer::BlockSize - mBlockSize);
+         memcpy(&mBlock[mBlockSize], data, chunkSize);
+         mBlockSize += chunkSize;
+         data += chunkSize;
+         size -= chunkSize;
+
+         if(mBlockSize == GameRecorderServer::BlockSize)
+            flushBlock();
       }
-      return &buffer[currPos];
    }
-   void addBuffer(U32 size)
+
+   // Hands over what we have so far, full block or not
+   void flush()
+   {
+      flushBlock();
+   }
+
+   // What's written next will be a keyframe, so it goes at the start of a block
+   void startKeyframe(U32 time)
    {
-      currPos += size;
-      sem1.increment();
+      flushBlock();
+      mBlockStartsWithKeyframe = true;
+      mBlockKeyframeTime = time;
+   }
+
+   // Writes whatever is left, and the seek index, and waits until the file is closed
+   void finish(U32 totalTime)
+   {
+      flushBlock();
+
+      if(!mRunning)
+         return;
+
+      mTotalTime = totalTime;
+      queueBlock(NULL, 0);
+      mDoneSemaphore.wait();
+      mRunning = false;
    }
 
    U32 run()
    {
-      U32 currPos1 = currPos; // currPos could change anytime by other thread
-      while(!exitNow || currPos1 != threadPos)
+      while(true)
       {
-         if(currPos1 < threadPos)
-         {
+         mQueueSemaphore.wait();
+
+         mMutex.lock();
+         Block block = mQueue[0];
+         mQueue.erase(0);
+         mQueuedSize -= block.size;
+         mMutex.unlock();
 
-            fwrite(&buffer[threadPos], 1, lastPos - threadPos, f);
-            threadPos = 0;
+         if(!block.data)
+         {
+            if(!block.overflowed)
+               writeSeekIndex();
+            break;
          }
-         else if(currPos1 > threadPos)
+
+         if(block.startsWithKeyframe)
          {
-            fwrite(&buffer[threadPos], 1, currPos1 - threadPos, f);
-            threadPos = currPos1;
+            RecordingKeyframe keyframe;
+            keyframe.time = block.keyframeTime;
+            keyframe.offset = mFileOffset;
+            mKeyframes.push_back(keyframe);
          }
-         else
-            sem1.wait();  // Waits until sem1.increment
-         currPos1 = currPos;
+
+         writeBlock(block.data, block.size);
+         delete [] block.data;
       }
-      fclose(f);
-      f = 0;
+
+      fclose(mFile);
+      mFile = NULL;
+
+      mDoneSemaphore.increment();    // We may be deleted as soon as we signal
       return 0;
    }
 };
 
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+RecordingReader::RecordingReader(FILE *file, bool hasBlocks)
+{
+   mFile = file;
+   mHasBlocks = hasBlocks;
+   mBlockPos = 0;
+   mBlockOffset = 0;
+}
+
+
+// Reads the next block into mBlock
+bool RecordingReader::readBlock()
+{
+   mBlock.clear();
+   mBlockPos = 0;
+   mBlockOffset = ftell(mFile);
+
+   U8 header[8];
+   if(fread(header, 1, 8, mFile) != 8)
+      return false;
+
+   U32 compressedSize = getRecordingU32(header);
+   U32 size = getRecordingU32(&header[4]);
+
+   // The seek index's trailer fails here too, as its tag is far too big for a size
+   if(size == 0 || size > GameRecorderServer::BlockSize || compressedSize > Lz::getMaxCompressedSize(size))
+      return false;
+
+   mBlock.resize(size);
+
+   if(compressedSize == size)
+   {
+      if(fread(mBlock.address(), 1, size, mFile) != size)
+      {
+         mBlock.clear();
+         return false;
+      }
+
+      return true;
+   }
+
+   mCompressed.resize(compressedSize);
+
+   if(fread(mCompressed.address(), 1, compressedSize, mFile) != compressedSize ||
+         !Lz::decompress(mCompressed.address(), compressedSize, mBlock.address(), size))
+   {
+      mBlock.clear();
+      return false;
+   }
+
+   return true;
+}
+
+
+bool RecordingReader::read(U8 *dest, U32 size)
+{
+   if(!mHasBlocks)
+      return fread(dest, 1, size, mFile) == size;
+
+   while(size > 0)
+   {
+      if(mBlockPos == U32(mBlock.size()) && !readBlock())
+         return false;
+
+      U32 chunkSize = min(size, mBlock.size() - mBlockPos);
+      memcpy(dest, &mBlock[mBlockPos], chunkSize);
+      mBlockPos += chunkSize;
+      dest += chunkSize;
+      size -= chunkSize;
+   }
+
+   return true;
+}
+
+
+bool RecordingReader::skip(U32 size)
+{
+   if(!mHasBlocks)
+      return fseek(mFile, size, SEEK_CUR) == 0;
+
+   while(size > 0)
+   {
+      if(mBlockPos == U32(mBlock.size()) && !readBlock())
+         return false;
+
+      U32 chunkSize = min(size, mBlock.size() - mBlockPos);
+      mBlockPos += chunkSize;
+      size -= chunkSize;
+   }
+
+   return true;
+}
+
+
+// Anywhere in a recording without blocks, and at the start of a block in one with them
+U32 RecordingReader::getOffset() const
+{
+   if(mHasBlocks && mBlockPos < U32(mBlock.size()))
+      return mBlockOffset;
+
+   return ftell(mFile);
+}
+
+
+bool RecordingReader::seek(U32 offset)
+{
+   mBlock.clear();
+   mBlockPos = 0;
+
+   return fseek(mFile, offset, SEEK_SET) == 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Reads the seek index written at the end of a finished recording.  Returns false if there isn't one.
+bool readRecordingSeekIndex(FILE *file, bool hasBlocks, Vector<RecordingKeyframe> &keyframes, U32 &totalTime)
+{
+   U8 trailer[8];
+   if(fseek(file, -8, SEEK_END) != 0 || fread(trailer, 1, 8, file) != 8 || getRecordingU32(&trailer[4]) != GameRecorderServer::SeekIndexTag)
+      return false;
+
+   RecordingReader reader(file, hasBlocks);
+
+   U8 header[15];    // Record header, length, total time, keyframe count
+   if(!reader.seek(getRecordingU32(trailer)) || !reader.read(header, 15))
+      return false;
+
+   U32 count = getRecordingU32(&header[11]);
+
+   if(header[0] != 0 || header[1] != 0 || header[2] != RecordSeekIndex || getRecordingU32(&header[3]) != 8 + count * 8)
+      return false;
+
+   Vector<U8> entries;
+   entries.resize(count * 8);
+
+   if(count > 0 && !reader.read(entries.address(), count * 8))
+      return false;
+
+   totalTime = getRecordingU32(&header[7]);
+   keyframes.resize(count);
+
+   for(U32 i = 0; i < count; i++)
+   {
+      keyframes[i].time = getRecordingU32(&entries[i * 8]);
+      keyframes[i].offset = getRecordingU32(&entries[i * 8 + 4]);
+   }
+
+   return true;
+}
+
+
+// Finds the keyframes and length of a recording by reading through it, for recordings without a seek index -- older
+// ones, and ones that were never finished.  Reader should be just past the header.
+void scanRecording(RecordingReader &reader, bool hasKeyframes, Vector<RecordingKeyframe> &keyframes, U32 &totalTime)
+{
+   totalTime = 0;
+
+   while(true)
+   {
+      U32 offset = reader.getOffset();
+
+      U8 data[3];
+      if(!reader.read(data, 3))
+         break;
+
+      U32 size = (U32(data[1] & 63) << 8) + data[0];
+      U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
+
+      if(size != 0)
+      {
+         totalTime += milli;
+         if(!reader.skip(size))
+            break;
+         continue;
+      }
+
+      if(!hasKeyframes || milli != RecordKeyframe)
+         break;
+
+      U8 length[4];
+      if(!reader.read(length, 4))
+         break;
+
+      RecordingKeyframe keyframe;
+      keyframe.time = totalTime;
+      keyframe.offset = offset;
+      keyframes.push_back(keyframe);
+
+      if(!reader.skip(getRecordingU32(length)))
+         break;
+   }
+}
+
+
 static void gameRecorderScoping(GameRecorderServer *conn, Game *game)
 {
    GameType *gt = game->getGameType();
@@ -161,9 +556,15 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
    mWriter = NULL;
    mGame = game;
    mMilliSeconds = 0;
+   mRecordedTime = 0;
+   mLastKeyframeTime = 0;
+   mLastFlushTime = 0;
    mWriteMaxBitSize = U32_MAX;
    mPackUnpackShipEnergyMeter = true;
 
+   mEventClassCount = NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeEvent);   // Essentially a count of RPCs 
+   mGhostClassCount = NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeObject);
+
    {
       const string &dir = game->getSettings()->getFolderManager()->getRecordDir();
       mFileName = newRecordingFileName(dir, game->getGameType()->getLevelName(), game->getSettings()->getHostName()) +
@@ -171,7 +572,15 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
       string filename = joindir(dir, mFileName);
       FILE *file = fopen(filename.c_str(), "wb");
       if(file)
-         mWriter = new WriteBufferThread(file);
+      {
+         U8 header[4];
+         header[0] = CS_PROTOCOL_VERSION;
+         header[1] = U8(mGhostClassCount);
+         header[2] = U8(mEventClassCount);
+         header[3] = U8(mEventClassCount >> 8) | U8((ShipEnergyFlag | KeyframesFlag | BlocksFlag) >> 8);
+
+         mWriter = new WriteBufferThread(file, header, sizeof(header));
+      }
    }
 
    if(mWriter)
@@ -181,19 +590,11 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
       activateGhosting();
       rpcReadyForNormalGhosts_remote(mGhostingSequence);
       setScopeObject(&mNetObj);
-      mEventClassCount = NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeEvent);   // Essentially a count of RPCs 
       mEventClassBitSize = getNextBinLog2(mEventClassCount);
-      mGhostClassCount = NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeObject);
       mGhostClassBitSize = getNextBinLog2(mGhostClassCount);
       mConnectionParameters.mIsInitiator = false;
       mConnectionParameters.mDebugObjectSizes = false;
 
-      U8 *data = mWriter->getBuffer(4);
-      data[0] = CS_PROTOCOL_VERSION;
-      data[1] = U8(mGhostClassCount);
-      data[2] = U8(mEventClassCount);
-      data[3] = U8(mEventClassCount >> 8) | 0x10;
-      mWriter->addBuffer(4);
       gameRecorderScoping(this, game);
 
       s2cSetServerName(game->getSettings()->getHostName());
@@ -204,7 +605,10 @@ GameRecorderServer::GameRecorderServer(ServerGame *game)
 GameRecorderServer::~GameRecorderServer()
 {
    if(mWriter)
+   {
+      mWriter->finish(mRecordedTime);
       delete mWriter;
+   }
 }
 
 
@@ -236,7 +640,7 @@ void GameRecorderServer::idle(U32 MilliSeconds)
    GhostPacketNotify notify;
    mNotifyQueueTail = &notify;
 
-   U8 *data = mWriter->getBuffer(16383 + 3);
+   U8 data[16383 + 3];     // Copied into the current block once we know how much of it we used
    BitStream bstream(&data[3], 16383);
 
    prepareWritePacket();
@@ -252,7 +656,100 @@ void GameRecorderServer::idle(U32 MilliSeconds)
    data[0] = U8(size);
    data[1] = U8((size >> 8) & 63) | U8((ms >> 8) << 6);
    data[2] = U8(ms);
-   mWriter->addBuffer(bstream.getBytePosition() + 3);
+   mWriter->write(data, size + 3);
+
+   mRecordedTime += ms & 1023;      // All the header has room for
+
+   // A keyframe has to match what playback will have at this point, so wait until everything has gone out
+   GameType *gameType = mGame->getGameType();
+
+   if(mRecordedTime - mLastKeyframeTime >= KeyframeInterval && !GhostConnection::isDataToTransmit() &&
+         gameType && !gameType->isGameOver())
+      writeKeyframe();
+
+   // Don't let much sit in memory, where a crash would lose it
+   if(mRecordedTime - mLastFlushTime >= FlushInterval)
+   {
+      mWriter->flush();
+      mLastFlushTime = mRecordedTime;
+   }
+}
+
+
+void GameRecorderServer::writeRecordHeader(RecordingRecordType type, U32 length)
+{
+   U8 header[7];
+   header[0] = 0;
+   header[1] = 0;
+   header[2] = U8(type);
+   putU32(&header[3], length);
+
+   mWriter->write(header, sizeof(header));
+}
+
+
+// Writes everything playback needs to pick up from here without reading what came before: every ghost's full state,
+// and the events a client is sent when it first sees each of them.  Some objects send part of their state only that
+// way -- a LineItem's geometry, for one.
+void GameRecorderServer::writeKeyframe()
+{
+   GameType *gameType = mGame->getGameType();
+
+   Vector<NetObject *> ghosts;
+   getGhostSnapshotObjects(ghosts);
+
+   Vector<RefPtr<NetEvent> > events;
+   setEventCapture(&events);
+   gameType->sendGameState(this);
+   gameType->updateClientScoreboard(this);
+   s2cSetServerName(mGame->getSettings()->getHostName());
+
+   // Some objects' RPCs don't pick a connection, and would otherwise go out to every client
+   NetObject::setRPCDestConnection(this);
+   for(S32 i = 0; i < ghosts.size(); i++)
+      if(ghosts[i] != gameType)        // Its part was sendGameState() above
+         ghosts[i]->onGhostAvailable(this);
+   NetObject::setRPCDestConnection(NULL);
+
+   setEventCapture(NULL);
+
+   GhostPacketNotify notify;
+   mNotifyQueueTail = &notify;
+
+   // Ghosts go in first, so the GameType is there for the events addressed to it
+   BitStream ghostPacket;
+   writeEventSnapshot(&ghostPacket, Vector<RefPtr<NetEvent> >());
+   writeGhostSnapshot(&ghostPacket);
+   ghostPacket.zeroToByteBoundary();
+
+   BitStream eventPacket;
+   writeEventSnapshot(&eventPacket, events);
+   if(mConnectionParameters.mDebugObjectSizes)
+      eventPacket.writeInt(DebugChecksum, 32);
+   eventPacket.writeFlag(false);      // No ghosts
+   eventPacket.zeroToByteBoundary();
+
+   mNotifyQueueTail = NULL;
+
+   U32 ghostSize = ghostPacket.getBytePosition();
+   U32 eventSize = eventPacket.getBytePosition();
+
+   mLastKeyframeTime = mRecordedTime;
+
+   mWriter->startKeyframe(mRecordedTime);
+   writeRecordHeader(RecordKeyframe, 12 + ghostSize + eventSize);
+
+   U8 data[4];
+   putU32(data, getNextSendEventSeq());
+   mWriter->write(data, 4);
+
+   putU32(data, ghostSize);
+   mWriter->write(data, 4);
+   mWriter->write(ghostPacket.getBuffer(), ghostSize);
+
+   putU32(data, eventSize);
+   mWriter->write(data, 4);
+   mWriter->write(eventPacket.getBuffer(), eventSize);
 }
 
 
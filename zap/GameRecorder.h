@@ -17,6 +17,58 @@ namespace Zap {
 class ServerGame;
 class WriteBufferThread;
 
+// A recording is a 4 byte header, then a series of records.  Each record starts with 3 bytes holding a 14 bit size
+// and 10 bits of elapsed ms, and records with a size hold a packet.  A size of 0 ends the recording, except in
+// recordings with keyframes, where the ms bits say what sort of record it is instead, and a U32 length follows.
+//
+// In recordings with blocks, the records after the header are split into blocks of up to BlockSize bytes, each
+// compressed on its own and stored after its U32 compressed size and U32 size.  A block whose two sizes match isn't
+// compressed.  Records can carry on from one block into the next, but keyframes always start a block, and their
+// offsets are those of the block.
+enum RecordingRecordType
+{
+   RecordEnd,
+   RecordKeyframe,         // Game state for seeking: U32 event sequence, then a ghost packet and an event packet, each after its U32 size
+   RecordSeekIndex,        // Written when recording stops: U32 total time, U32 keyframe count, then each keyframe's time and offset
+};
+
+struct RecordingKeyframe
+{
+   U32 time;      // Recorded time the keyframe brings playback up to, in ms
+   U32 offset;    // Start of its record in the file, or of its block
+};
+
+
+// Reads the records in a recording from the current position in file, decompressing blocks as it goes in recordings
+// that have them
+class RecordingReader
+{
+private:
+   FILE *mFile;
+   bool mHasBlocks;
+   Vector<U8> mBlock;
+   U32 mBlockPos;             // Next byte to read from mBlock
+   U32 mBlockOffset;          // Where mBlock starts in the file
+   Vector<U8> mCompressed;
+
+   bool readBlock();
+
+public:
+   RecordingReader(FILE *file, bool hasBlocks);     // Constructor
+
+   bool read(U8 *dest, U32 size);
+   bool skip(U32 size);
+
+   U32 getOffset() const;     // Only meaningful where a keyframe could start
+   bool seek(U32 offset);
+};
+
+
+U32 getRecordingU32(const U8 *src);      // Lengths and offsets are stored little-endian
+bool readRecordingSeekIndex(FILE *file, bool hasBlocks, Vector<RecordingKeyframe> &keyframes, U32 &totalTime);
+void scanRecording(RecordingReader &reader, bool hasKeyframes, Vector<RecordingKeyframe> &keyframes, U32 &totalTime);
+
+
 class GameRecorderServer : public GameConnection
 {
    typedef GhostConnection Parent;
@@ -27,7 +79,27 @@ private:
    TNL::NetObject mNetObj;
    U32 mMilliSeconds;
 
+   U32 mRecordedTime;                     // ms of game recorded so far
+   U32 mLastKeyframeTime;
+   U32 mLastFlushTime;                    // mRecordedTime when we last handed the writer a partial block
+
+   void writeKeyframe();
+   void writeRecordHeader(RecordingRecordType type, U32 length);
+
 public:
+   enum HeaderFlags
+   {
+      ShipEnergyFlag = 0x1000,            // Set in the header's event class count
+      KeyframesFlag = 0x2000,
+      BlocksFlag = 0x4000,
+   };
+
+   static const U32 SeekIndexTag;         // After the seek index's offset, at the very end of the file
+   static const U32 KeyframeInterval;     // ms of recorded game between keyframes
+   static const U32 BlockSize;            // Most uncompressed bytes in a block
+   static const U32 FlushInterval;        // ms of recorded game we'll hold onto before writing a partial block
+   static const U32 MaxQueuedSize;        // Bytes waiting for the disk before we give up on the recording
+
    string mFileName;
 
    static string buildGameRecorderExtension();
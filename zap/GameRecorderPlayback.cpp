@@ -25,6 +25,8 @@
 namespace Zap
 {
 
+const U32 GameRecorderPlayback::SeekStep = 16;
+
 
 static S32 QSORT_CALLBACK alphaNumberSort(string *a, string *b)
 {
@@ -88,12 +90,15 @@ static void resetRenderState(ClientGame *game)
 GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filename) : GameConnection(game, false)
 {
    mFile = NULL;
+   mReader = NULL;
    mGame = game;
    mMilliSeconds = 0;
    mSizeToRead = 0;
    mCurrentTime = 0;
    mTotalTime = 0;
    mIsButtonHeldDown = false;
+   mHasKeyframes = false;
+   bool hasBlocks = false;
 
    if(!mFile)
       mFile = fopen(filename, "rb");
@@ -105,10 +110,20 @@ GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filenam
       fread(data, 1, 4, mFile);
       mGhostClassCount = data[1];
       mEventClassCount = U32(data[2]) | (U32(data[3]) << 8);
-      if(mEventClassCount & 0x1000)
+      if(mEventClassCount & GameRecorderServer::ShipEnergyFlag)
       {
          mPackUnpackShipEnergyMeter = true;
-         mEventClassCount &= ~0x1000;
+         mEventClassCount &= ~GameRecorderServer::ShipEnergyFlag;
+      }
+      if(mEventClassCount & GameRecorderServer::KeyframesFlag)
+      {
+         mHasKeyframes = true;
+         mEventClassCount &= ~GameRecorderServer::KeyframesFlag;
+      }
+      if(mEventClassCount & GameRecorderServer::BlocksFlag)
+      {
+         hasBlocks = true;
+         mEventClassCount &= ~GameRecorderServer::BlocksFlag;
       }
       if(data[0] != CS_PROTOCOL_VERSION || 
          mEventClassCount > NetClassRep::getNetClassCount(getNetClassGroup(), NetClassTypeEvent) || 
@@ -131,25 +146,26 @@ GameRecorderPlayback::GameRecorderPlayback(ClientGame *game, const char *filenam
    if(mFile)
    {
       S32 filepos = ftell(mFile);
-      while(true)
+
+      mReader = new RecordingReader(mFile, hasBlocks);
+
+      // Recordings that weren't finished have no index, but we can still find their keyframes
+      if(!mHasKeyframes || !readRecordingSeekIndex(mFile, hasBlocks, mKeyframes, mTotalTime))
       {
-         U8 data[3];
-         if(fread(data, 1, 3, mFile) != 3)
-            break;
-         U32 size = (U32(data[1] & 63) << 8) + data[0];
-         U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
-         if(size == 0)
-            break;
-         mTotalTime += milli;
-         fseek(mFile, size, SEEK_CUR);
+         mKeyframes.clear();
+         mReader->seek(filepos);
+         scanRecording(*mReader, mHasKeyframes, mKeyframes, mTotalTime);
       }
-      fseek(mFile, filepos, SEEK_SET);
+
+      mReader->seek(filepos);
    }
 }
 
 
 GameRecorderPlayback::~GameRecorderPlayback()
 {
+   delete mReader;
+
    if(mFile)
       fclose(mFile);
 }
@@ -243,7 +259,7 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
          mPacketRecvBytesTotal += mSizeToRead;
          mPacketRecvCount++;
 
-         if(fread(data, 1, mSizeToRead, mFile) == mSizeToRead)
+         if(mReader->read(data, mSizeToRead))
          {
             BitStream bstream(data, mSizeToRead);
             GhostConnection::readPacket(&bstream);
@@ -251,11 +267,21 @@ void GameRecorderPlayback::processMoreData(U32 MilliSeconds)
          mSizeToRead = 0;
       }
 
-      if(fread(data, 1, 3, mFile) != 3)
+      if(!mReader->read(data, 3))
          break; // Could not read 3 bytes
 
       U32 size = (U32(data[1] & 63) << 8) + data[0];
       U32 milli = S32((U32(data[1] >> 6) << 8) + data[2]);
+
+      // Keyframes are only for seeking; we already have everything in them
+      if(size == 0 && mHasKeyframes && milli == RecordKeyframe)
+      {
+         if(!mReader->read(data, 4) || !mReader->skip(getRecordingU32(data)))
+            break;
+
+         continue;
+      }
+
       mCurrentTime += milli;
       mMilliSeconds += milli;
 
@@ -284,8 +310,89 @@ void GameRecorderPlayback::restart()
    clearRecvEvents();
    mGame->clearClientList();
 
-   if(mFile)
-      fseek(mFile, 4, SEEK_SET);
+   if(mReader)
+      mReader->seek(4);
+}
+
+
+// Moves playback to time.  Starts from the last keyframe before then, unless playing on from where we are gets
+// there sooner.
+void GameRecorderPlayback::seek(U32 time)
+{
+   S32 keyframe = findKeyframe(time);
+
+   if(time < mCurrentTime || (keyframe != -1 && mKeyframes[keyframe].time > mCurrentTime))
+   {
+      if(keyframe == -1 || !loadKeyframe(keyframe))
+         restart();
+   }
+
+   // Play the rest a step at a time, as playback would.  In one go, everything would be idled before the first
+   // packet was read, and nothing would move on from the last one.
+   U32 remaining = time > mCurrentTime ? time - mCurrentTime : 0;
+
+   while(remaining > 0)
+   {
+      U32 step = min(remaining, SeekStep);
+      processMoreData(step);
+      remaining -= step;
+   }
+}
+
+
+// Returns the index of the last keyframe at or before time, or -1 if there isn't one
+S32 GameRecorderPlayback::findKeyframe(U32 time) const
+{
+   for(S32 i = mKeyframes.size() - 1; i >= 0; i--)
+      if(mKeyframes[i].time <= time)
+         return i;
+
+   return -1;
+}
+
+
+// Throws out what we have and replaces it with the game as it was at a keyframe, leaving the file ready to carry on
+// reading from there
+bool GameRecorderPlayback::loadKeyframe(S32 index)
+{
+   restart();
+
+   const RecordingKeyframe &keyframe = mKeyframes[index];
+
+   U8 header[7];
+   if(!mReader->seek(keyframe.offset) || !mReader->read(header, 7) ||
+         header[0] != 0 || header[1] != 0 || header[2] != RecordKeyframe)
+      return false;
+
+   U32 length = getRecordingU32(&header[3]);
+   if(length < 12)
+      return false;
+
+   Vector<U8> data;
+   data.resize(length);
+   if(!mReader->read(data.address(), length))
+      return false;
+
+   U32 ghostSize = getRecordingU32(&data[4]);
+   if(ghostSize > length - 12)
+      return false;
+
+   U32 eventSize = getRecordingU32(&data[8 + ghostSize]);
+   if(eventSize != length - 12 - ghostSize)
+      return false;
+
+   // Events in the keyframe aren't sequenced, so this is the first one we'll see after it
+   setNextRecvEventSeq(getRecordingU32(&data[0]));
+
+   // Ghosts first, so the GameType is there for the events addressed to it
+   BitStream ghostPacket(&data[8], ghostSize);
+   GhostConnection::readPacket(&ghostPacket);
+
+   BitStream eventPacket(&data[12 + ghostSize], eventSize);
+   GhostConnection::readPacket(&eventPacket);
+
+   mCurrentTime = keyframe.time;
+   return true;
 }
 
 // --------
@@ -529,11 +636,7 @@ bool PlaybackGameUserInterface::onKeyDown(InputCode inputCode)
 
          U32 time = U32(x2 * mPlaybackConnection->mTotalTime);
 
-         // TODO: maybe we need to seek more efficiency by avoiding having to start all over from the beginning
-         if(time < mPlaybackConnection->mCurrentTime)
-            mPlaybackConnection->restart();
-
-         mPlaybackConnection->processMoreData(time - mPlaybackConnection->mCurrentTime);
+         mPlaybackConnection->seek(time);
          resetRenderState(getGame());
 
          return true;
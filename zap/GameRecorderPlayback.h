@@ -11,6 +11,7 @@
 #include "tnlNetObject.h"
 #include "gameConnection.h"
 
+#include "GameRecorder.h"
 #include "UIMenus.h"
 
 namespace Zap {
@@ -22,12 +23,21 @@ class GameRecorderPlayback : public GameConnection
 {
    typedef GameConnection Parent;
    FILE *mFile;
+   RecordingReader *mReader;
    ClientGame *mGame;
    S32 mMilliSeconds;
    U32 mSizeToRead;
    SafePtr<ClientInfo> mClientInfoSpectating;
 
+   bool mHasKeyframes;
+   Vector<RecordingKeyframe> mKeyframes;
+
+   S32 findKeyframe(U32 time) const;
+   bool loadKeyframe(S32 index);
+
 public:
+   static const U32 SeekStep;    // ms of game played per step when seeking, about what a frame of playback covers
+
    GameRecorderPlayback(ClientGame *game, const char *filename);
    ~GameRecorderPlayback();
 
@@ -46,6 +56,7 @@ public:
    void updateSpectate();
    void processMoreData(TNL::U32 MilliSeconds);
    void restart();
+   void seek(U32 time);
 };
 
 
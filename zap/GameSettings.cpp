@@ -217,91 +217,133 @@ void GameSettings::setExecutablePath(const string &executablePath)
 
 string GameSettings::getHostName()
 {
-   return mHostName;
+   mRuntimeSettingsMutex.lock();
+   string val = mHostName;
+   mRuntimeSettingsMutex.unlock();
+
+   return val;
 }
 
 
 void GameSettings::setHostName(const string &serverName, bool updateINI) 
 { 
+   mRuntimeSettingsMutex.lock();
    mHostName = serverName; 
 
    if(updateINI)
       mIniSettings.mSettings.setVal(IniKey::ServerName, serverName);
+
+   mRuntimeSettingsMutex.unlock();
 }
 
 
 string GameSettings::getHostDescr()
 {
-   return mHostDescr;
+   mRuntimeSettingsMutex.lock();
+   string val = mHostDescr;
+   mRuntimeSettingsMutex.unlock();
+
+   return val;
 }
 
 
 void GameSettings::setHostDescr(const string &serverDescription, bool updateINI) 
 { 
+   mRuntimeSettingsMutex.lock();
    mHostDescr = serverDescription;
    
    if(updateINI)
       mIniSettings.mSettings.setVal(IniKey::ServerDescription, serverDescription);
+
+   mRuntimeSettingsMutex.unlock();
 }
 
 
 string GameSettings::getServerPassword()
 {
-   return mServerPassword;
+   mRuntimeSettingsMutex.lock();
+   string val = mServerPassword;
+   mRuntimeSettingsMutex.unlock();
+
+   return val;
 }
 
 
 void GameSettings::setServerPassword(const string &serverPassword, bool updateINI) 
 { 
+   mRuntimeSettingsMutex.lock();
    mServerPassword = serverPassword; 
 
    if(updateINI)
       mIniSettings.mSettings.setVal(IniKey::ServerPassword, serverPassword);
+
+   mRuntimeSettingsMutex.unlock();
 }
 
 
 string GameSettings::getOwnerPassword()
 {
-   return mOwnerPassword;
+   mRuntimeSettingsMutex.lock();
+   string val = mOwnerPassword;
+   mRuntimeSettingsMutex.unlock();
+
+   return val;
 }
 
 
 void GameSettings::setOwnerPassword(const string &ownerPassword, bool updateINI)
 {
+   mRuntimeSettingsMutex.lock();
    mOwnerPassword = ownerPassword;
 
    if(updateINI)
       mIniSettings.mSettings.setVal(IniKey::OwnerPassword, ownerPassword);
+
+   mRuntimeSettingsMutex.unlock();
 }
 
 
 string GameSettings::getAdminPassword()
 {
-   return mAdminPassword;
+   mRuntimeSettingsMutex.lock();
+   string val = mAdminPassword;
+   mRuntimeSettingsMutex.unlock();
+
+   return val;
 }
 
 
 void GameSettings::setAdminPassword(const string &adminPassword, bool updateINI) 
 { 
+   mRuntimeSettingsMutex.lock();
    mAdminPassword = adminPassword; 
 
    if(updateINI)
       mIniSettings.mSettings.setVal(IniKey::AdminPassword, adminPassword);
+
+   mRuntimeSettingsMutex.unlock();
 }
 
 
 string GameSettings::getLevelChangePassword()
 {
-   return mLevelChangePassword;
+   mRuntimeSettingsMutex.lock();
+   string val = mLevelChangePassword;
+   mRuntimeSettingsMutex.unlock();
+
+   return val;
 }
 
 
 void GameSettings::setLevelChangePassword(const string &levelChangePassword, bool updateINI) 
 { 
+   mRuntimeSettingsMutex.lock();
    mLevelChangePassword = levelChangePassword;     // Update our working copy
 
    if(updateINI)
-      mIniSettings.mSettings.setVal(IniKey::LevelChangePassword, levelChangePassword);        
+      mIniSettings.mSettings.setVal(IniKey::LevelChangePassword, levelChangePassword);
+
+   mRuntimeSettingsMutex.unlock();
 }
 
 
@@ -713,6 +755,7 @@ Vector<string> GameSettings::getLevelList(const string &levelDir, bool ignoreCmd
 
 
    // Now, remove any levels listed in the skip list from levelList.  Not foolproof!
+   mRuntimeSettingsMutex.lock();
    for(S32 i = 0; i < levelList.size(); i++)
    {
       // Make sure we have the right extension
@@ -729,6 +772,7 @@ Vector<string> GameSettings::getLevelList(const string &levelDir, bool ignoreCmd
             break;
          }
    }
+   mRuntimeSettingsMutex.unlock();
 
    return levelList;
 }
@@ -1322,23 +1366,33 @@ void GameSettings::deleteServerPassword(const string &serverName)
 
 bool GameSettings::isLevelOnSkipList(const string &filename) const
 {
+   bool found = false;
+
+   mRuntimeSettingsMutex.lock();
    for(S32 i = 0; i < mLevelSkipList.size(); i++)
       if(mLevelSkipList[i] == filename)    // Already on our list!
-         return true;
+      {
+         found = true;
+         break;
+      }
+   mRuntimeSettingsMutex.unlock();
 
-   return false;
+   return found;
 }
 
 
 void GameSettings::addLevelToSkipList(const string &filename)
 {
+   mRuntimeSettingsMutex.lock();
    mLevelSkipList.push_back(filename);
    saveSkipList();
+   mRuntimeSettingsMutex.unlock();
 }
 
 
 void GameSettings::removeLevelFromSkipList(const string &filename)
 {
+   mRuntimeSettingsMutex.lock();
    for(S32 i = 0; i < mLevelSkipList.size(); i++)
       if(mLevelSkipList[i] == filename)
       {
@@ -1346,14 +1400,35 @@ void GameSettings::removeLevelFromSkipList(const string &filename)
          saveSkipList();
          break;
       }
+   mRuntimeSettingsMutex.unlock();
+}
+
+
+// Returns the name of the level taken off the list, or "" if the list was empty
+string GameSettings::removeLastLevelFromSkipList()
+{
+   string filename;
+
+   mRuntimeSettingsMutex.lock();
+   if(mLevelSkipList.size() > 0)
+   {
+      filename = mLevelSkipList.last();
+      mLevelSkipList.erase(mLevelSkipList.size() - 1);
+      saveSkipList();
+   }
+   mRuntimeSettingsMutex.unlock();
+
+   return filename;
 }
 
 
 // Do we still need to do this at this point?  This will get done when INI is saved through regular channels...
 void GameSettings::saveSkipList() const
 {
+   mRuntimeSettingsMutex.lock();
    writeSkipList(&iniFile, &mLevelSkipList);  // Write skipped levels to INI
    iniFile.WriteFile();                       // Save new INI settings to disk
+   mRuntimeSettingsMutex.unlock();
 }
 
 
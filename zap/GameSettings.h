@@ -11,6 +11,7 @@
 #include "LevelSource.h"
 #include "LoadoutTracker.h"
 
+#include "tnlThread.h"
 #include "tnlTypes.h"
 #include "tnlVector.h"
 
@@ -123,6 +124,10 @@ private:
    string mLevelChangePassword;
 
    Vector<string> mLevelSkipList;      // Levels we'll never load, to create a pseudo delete function for remote server mgt  <=== does this ever get loaded???
+
+   // Admins can change the host name, passwords and skip list from any of the games a process hosts
+   mutable Mutex mRuntimeSettingsMutex;
+
    static FolderManager *mFolderManager;
    InputCodeManager mInputCodeManager;
 
@@ -301,6 +306,7 @@ public:
    bool isLevelOnSkipList(const string &filename) const;
    void addLevelToSkipList(const string &filename);
    void removeLevelFromSkipList(const string &filename);
+   string removeLastLevelFromSkipList();
    void saveSkipList() const;
 
    // InputCode related
@@ -488,8 +488,6 @@ void PointGeometry::readGeom(S32 argc, const char **argv, S32 firstCoord, F32 gr
 ////////////////////////////////////////
 ////////////////////////////////////////
 
-static Vector<Point> outlinePoints(2);    // Reusable container
-
 // Constructor
 SimpleLineGeometry::SimpleLineGeometry()
 {
@@ -636,11 +634,11 @@ F32 SimpleLineGeometry::getLabelAngle() const
 
 const Vector<Point> *SimpleLineGeometry::getOutline() const
 {
-   outlinePoints.resize(2);
-   outlinePoints[0] = mFromPos;
-   outlinePoints[1] = mToPos;
+   mOutlinePoints.resize(2);
+   mOutlinePoints[0] = mFromPos;
+   mOutlinePoints[1] = mToPos;
 
-   return &outlinePoints;
+   return &mOutlinePoints;
 }
 
 
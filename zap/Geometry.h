@@ -90,6 +90,7 @@ class SimpleLineGeometry : public Geometry
 private:
    Point mFromPos, mToPos;
    bool mFromSelected, mToSelected;
+   mutable Vector<Point> mOutlinePoints;     // Filled by getOutline(); per object so levels can be loaded on other threads
 
 public:
    SimpleLineGeometry();           // Constructor
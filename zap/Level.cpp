@@ -31,14 +31,14 @@ namespace Zap
 
 
 // Constructor
-Level::Level()
+Level::Level() : mBotZoneDatabase(SpatialIndex::LooseQuadtree)
 { 
    initialize();
 }
 
 
 // Constructor, with passed level code, mainly used for testing
-Level::Level(const string &levelCode)
+Level::Level(const string &levelCode) : mBotZoneDatabase(SpatialIndex::LooseQuadtree)
 {
    initialize();
    loadLevelFromString(levelCode);
@@ -114,12 +114,16 @@ void Level::beginBatchGeomUpdate()
 }
 
 
-void Level::endBatchGeomUpdate(GridDatabase *gameObjectDatabase, 
-                               const Vector<WallSegment const *> &wallSegments, 
-                               Vector<Point> &wallEdgePoints,    // <== gets modified!
+// If walls were modified during the batch, their edges are updated and affected items remounted
+void Level::endBatchGeomUpdate(Vector<Point> &wallEdgePoints,    // <== gets modified!
                                bool modifiedWalls)
 {
-   mWallEdgeManager.endBatchGeomUpdate(gameObjectDatabase, wallSegments, wallEdgePoints, modifiedWalls);
+   Vector<WallSegment const *> wallSegments;
+
+   if(modifiedWalls)
+      getWallSegments(wallSegments);
+
+   mWallEdgeManager.endBatchGeomUpdate(this, wallSegments, wallEdgePoints, modifiedWalls);
 }
 
 
@@ -173,6 +177,10 @@ void Level::loadLevelFromString(const string &contents, const string &filename)
 
 	mLevelHash = md5.getHash();
 
+   // Now that we know how big the level is, let our spatial index size itself to fit
+   if(getObjectCount() > 0)
+      setSpatialIndexExtents(getExtents());
+
    // Build wall edge geometry
    Vector<Point> wallEdgePoints;  // <== not used
    buildWallEdgeGeometry(wallEdgePoints);
@@ -181,6 +189,9 @@ void Level::loadLevelFromString(const string &contents, const string &filename)
    snapAllEngineeredItems(false);
 
    validateLevel();
+
+   // Anything added from here on is probably something that moves
+   markAllObjectsStatic();
 }
 
 
@@ -188,7 +199,30 @@ void Level::loadLevelFromString(const string &contents, const string &filename)
 void Level::buildWallEdgeGeometry(Vector<Point> &wallEdgePoints)
 {
    Vector<const WallSegment *> wallSegments;
+   getWallSegments(wallSegments);
+
+   mWallEdgeManager.rebuildEdges(wallSegments, wallEdgePoints);      // Fills wallEdgePoints
+}
+
+
+// Like buildWallEdgeGeometry(), but only rebuilds edges of walls that have changed since the last time, and only remounts
+// engineered items near those walls.  Used by the editor, which calls this after every change; does nothing during a
+// batch update, which will do this when it ends.  Populates wallEdgePoints.
+void Level::updateWallEdgeGeometry(Vector<Point> &wallEdgePoints)
+{
+   if(mWallEdgeManager.isBatchUpdatingGeom())
+      return;
 
+   Vector<const WallSegment *> wallSegments;
+   getWallSegments(wallSegments);
+
+   mWallEdgeManager.finishedChangingWalls(this, wallSegments, wallEdgePoints);
+}
+
+
+// Private method
+void Level::getWallSegments(Vector<WallSegment const *> &wallSegments) const
+{
    const Vector<DatabaseObject *> *polyWalls = findObjects_fast(PolyWallTypeNumber);
    const Vector<DatabaseObject *> *wallItems = findObjects_fast(WallItemTypeNumber);
 
@@ -208,9 +242,6 @@ void Level::buildWallEdgeGeometry(Vector<Point> &wallEdgePoints)
       for(S32 j = 0; j < barrier->getSegmentCount(); j++)
          wallSegments.push_back(barrier->getSegment(j));
    }
-
-
-   mWallEdgeManager.rebuildEdges(wallSegments, wallEdgePoints);      // Fills wallEdgePoints
 }
 
 
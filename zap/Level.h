@@ -63,6 +63,7 @@ private:
    void parseLevelLine(const string &line, const string &levelFileName);
    bool processLevelLoadLine(U32 argc, S32 id, const char **argv, string &errorMsg);  
    bool processLevelParam(S32 argc, const char **argv);
+   void getWallSegments(Vector<WallSegment const *> &wallSegments) const;
 
 public:
    Level();                         // Constructor
@@ -80,6 +81,7 @@ public:
    void validateLevel();
 
    void buildWallEdgeGeometry(Vector<Point> &wallEdgePoints);
+   void updateWallEdgeGeometry(Vector<Point> &wallEdgePoints);
    void snapAllEngineeredItems(bool onlyUnsnapped);
 
    string toLevelCode() const;
@@ -92,9 +94,7 @@ public:
    const WallEdgeManager *getWallEdgeManager() const;
 
    void beginBatchGeomUpdate();                                     
-   void endBatchGeomUpdate(GridDatabase *gameObjectDatabase, 
-                           const Vector<WallSegment const *> &wallSegments, 
-                           Vector<Point> &wallEdgePoints,    // <== gets modified!
+   void endBatchGeomUpdate(Vector<Point> &wallEdgePoints,    // <== gets modified!
                            bool modifiedWalls);
 
    string getHash() const;
@@ -0,0 +1,257 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelAutoSaver.h"
+
+#include "BfObject.h"
+
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+#include "tnlNetStringTable.h"
+#include "tnlPlatform.h"
+
+#include <fstream>
+#include <stdio.h>
+
+namespace Zap
+{
+
+// Constructor
+LevelAutoSaver::WriterThread::WriterThread(LevelAutoSaver *saver)
+{
+   mSaver = saver;
+}
+
+
+U32 LevelAutoSaver::WriterThread::run()
+{
+   LevelAutoSaver *saver = mSaver;
+
+   while(true)
+   {
+      saver->mStartSemaphore.wait();
+
+      if(saver->mShuttingDown)
+         break;
+
+      saver->write();
+
+      saver->mFinishedMutex.lock();
+      saver->mFinished = true;
+      saver->mFinishedMutex.unlock();
+
+      saver->mDoneSemaphore.increment();
+   }
+
+   saver->mDoneSemaphore.increment();    // We may be deleted as soon as we signal
+
+   return 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LevelAutoSaver::LevelAutoSaver(U32 quietPeriod, U32 maxDelay)
+{
+   mFinished = false;
+   mShuttingDown = false;
+   mRunning = false;
+
+   mQuietPeriod = quietPeriod;
+   mMaxDelay = maxDelay;
+   mChanged = false;
+
+   mWriteSucceeded = true;
+   mWriteTime = 0;
+}
+
+
+// Destructor
+LevelAutoSaver::~LevelAutoSaver()
+{
+   flush();
+
+   if(mThread.isValid())
+   {
+      mShuttingDown = true;
+      mStartSemaphore.increment();
+      mDoneSemaphore.wait();
+   }
+}
+
+
+// Call whenever the level changes; the save happens once things have been quiet for a bit
+void LevelAutoSaver::levelChanged()
+{
+   if(!mChanged)
+      mMaxDelayTimer.reset(mMaxDelay);
+
+   mQuietTimer.reset(mQuietPeriod);
+   mChanged = true;
+}
+
+
+bool LevelAutoSaver::hasUnsavedChanges() const
+{
+   return mChanged;
+}
+
+
+// Call every frame.  Returns true when it's time to hand over a fresh copy of the level with save().  Also cleans
+// up after a save that has finished.
+bool LevelAutoSaver::idle(U32 timeDelta)
+{
+   mQuietTimer.update(timeDelta);
+   mMaxDelayTimer.update(timeDelta);
+
+   if(!mChanged || isWriting())
+      return false;
+
+   return mQuietTimer.getCurrent() == 0 || mMaxDelayTimer.getCurrent() == 0;
+}
+
+
+// Returns true if the previous save is still being written.  Never blocks.
+bool LevelAutoSaver::isWriting()
+{
+   if(mRunning && isFinished())
+      collect();
+
+   return mRunning;
+}
+
+
+// Starts writing the level to filename in the background: header, then each object's level code, one per line.
+// We take ownership of objects, which must not be part of any database -- normally clones of the level's objects,
+// so the editor can carry on changing the originals.  Waits for the previous save if it hasn't finished.
+void LevelAutoSaver::save(const string &filename, const string &header, const Vector<BfObject *> &objects)
+{
+   flush();
+
+   mChanged = false;
+   mQuietTimer.clear();
+   mMaxDelayTimer.clear();
+
+   mFilename = filename;
+   mHeader = header;
+   mObjects = objects;
+
+   if(mThread.isNull())
+   {
+      mThread = new WriterThread(this);
+
+      if(!mThread->start())
+      {
+         logprintf(LogConsumer::LogError, "Could not start autosave thread; saving on this one instead");
+         mThread = NULL;
+      }
+   }
+
+   // Writing the objects out reads their StringTableEntries; the table has to be locked until we're done
+   StringTable::beginThreadedUse();
+
+   mRunning = true;
+   mFinished = false;
+
+   if(mThread.isValid())
+      mStartSemaphore.increment();
+   else
+   {
+      write();
+      mDoneSemaphore.increment();
+      collect();
+   }
+}
+
+
+// Waits for the save in progress, if there is one, to finish
+void LevelAutoSaver::flush()
+{
+   if(mRunning)
+      collect();
+}
+
+
+bool LevelAutoSaver::getLastWriteSucceeded() const
+{
+   return mWriteSucceeded;
+}
+
+
+// How long the writing thread took with the last save, in ms
+F64 LevelAutoSaver::getLastWriteTime() const
+{
+   return mWriteTime;
+}
+
+
+bool LevelAutoSaver::isFinished()
+{
+   mFinishedMutex.lock();
+   bool finished = mFinished;
+   mFinishedMutex.unlock();
+
+   return finished;
+}
+
+
+void LevelAutoSaver::wait()
+{
+   mDoneSemaphore.wait();
+   mRunning = false;
+
+   StringTable::endThreadedUse();
+}
+
+
+// Waits for the save to finish, then deletes the copies it was working from.  They're deleted here rather than on
+// the writing thread because destroying an object can reach back into the objects it refers to.
+void LevelAutoSaver::collect()
+{
+   wait();
+
+   mObjects.deleteAndClear();
+   mHeader = "";
+
+   if(!mWriteSucceeded)
+      logprintf(LogConsumer::LogWarning, "Could not write autosave file %s", mFilename.c_str());
+}
+
+
+// Runs on the writing thread.  Streams everything to a temporary file, then swaps it in, so the last good autosave
+// is still there if we don't make it to the end.
+void LevelAutoSaver::write()
+{
+   S64 startTime = Platform::getHighPrecisionTimerValue();
+
+   string tempFilename = mFilename + ".tmp";
+   mWriteSucceeded = false;
+
+   ofstream file(tempFilename.c_str());
+
+   if(file.is_open())
+   {
+      file << mHeader;
+
+      for(S32 i = 0; i < mObjects.size() && file.good(); i++)
+         file << mObjects[i]->toLevelCode() << "\n";
+
+      bool written = file.good();
+      file.close();
+
+      mWriteSucceeded = written && replaceFile(tempFilename, mFilename);
+
+      if(!mWriteSucceeded)
+         remove(tempFilename.c_str());
+   }
+
+   mWriteTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - startTime);
+}
+
+
+};
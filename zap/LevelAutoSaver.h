@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LEVEL_AUTO_SAVER_H_
+#define _LEVEL_AUTO_SAVER_H_
+
+#include "Timer.h"
+
+#include "tnlThread.h"
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <string>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+class BfObject;
+
+// Keeps the editor's autosave file up to date without holding up the editor.  Bursts of edits are collapsed into a
+// single save, made once the level has been left alone for a moment (or has been changing for too long without
+// one).  The editor hands over copies of the level's objects, and they are written out on a background thread to a
+// temporary file that then replaces the old autosave, so a crash partway through never leaves a half-written file.
+class LevelAutoSaver
+{
+private:
+   class WriterThread : public Thread
+   {
+   private:
+      LevelAutoSaver *mSaver;
+
+   public:
+      explicit WriterThread(LevelAutoSaver *saver);     // Constructor
+      U32 run();
+   };
+
+   friend class WriterThread;
+
+   RefPtr<WriterThread> mThread;    // Started with the first save, and kept for the next ones
+   Semaphore mStartSemaphore;       // Signaled when there's something to write, or when shutting down
+   Semaphore mDoneSemaphore;        // Signaled by the thread when it's done with either
+   Mutex mFinishedMutex;
+   bool mFinished;                  // Set by the thread when the write is done, so we can check without blocking
+   bool mShuttingDown;
+   bool mRunning;                   // Thread is writing a level we haven't collected yet
+
+   U32 mQuietPeriod;
+   U32 mMaxDelay;
+   Timer mQuietTimer;               // Runs out when the level has been left alone for mQuietPeriod
+   Timer mMaxDelayTimer;            // Runs out mMaxDelay after the first change since the last save
+   bool mChanged;                   // Level has changed since the last save was started
+
+   // Set before the work is handed off
+   string mFilename;
+   string mHeader;                  // Level parameters and anything else that goes before the objects
+   Vector<BfObject *> mObjects;     // We own these
+
+   // Set by the writing thread
+   bool mWriteSucceeded;
+   F64 mWriteTime;
+
+   void write();                    // Runs on the writing thread
+   bool isFinished();
+
+   void wait();
+   void collect();
+
+public:
+   static const U32 DefaultQuietPeriod = 1500;     // ms
+   static const U32 DefaultMaxDelay = 10000;       // ms
+
+   explicit LevelAutoSaver(U32 quietPeriod = DefaultQuietPeriod, U32 maxDelay = DefaultMaxDelay);   // Constructor
+   virtual ~LevelAutoSaver();       // Destructor
+
+   void levelChanged();
+   bool hasUnsavedChanges() const;
+
+   bool idle(U32 timeDelta);
+   bool isWriting();
+
+   void save(const string &filename, const string &header, const Vector<BfObject *> &objects);
+   void flush();
+
+   bool getLastWriteSucceeded() const;
+   F64 getLastWriteTime() const;
+};
+
+
+};
+
+#endif
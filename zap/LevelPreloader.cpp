@@ -0,0 +1,302 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LevelPreloader.h"
+
+#include "barrier.h"
+#include "gameType.h"
+#include "Level.h"
+#include "Teleporter.h"
+#include "WallItem.h"
+
+#include "stringUtils.h"
+
+#include "tnlLog.h"
+#include "tnlNetStringTable.h"
+#include "tnlPlatform.h"
+
+namespace Zap
+{
+
+// Constructor
+LevelLoadStats::LevelLoadStats()
+{
+   preloaded = false;
+   preloadedBotZones = false;
+   ranLevelgens = false;
+
+   parseTime = 0;
+   wallTime = 0;
+   objectTime = 0;
+   levelgenTime = 0;
+   waitTime = 0;
+   gameThreadTime = 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LevelPreloader::PreloadThread::PreloadThread(LevelPreloader *preloader)
+{
+   mPreloader = preloader;
+}
+
+
+U32 LevelPreloader::PreloadThread::run()
+{
+   LevelPreloader *preloader = mPreloader;
+
+   while(true)
+   {
+      preloader->mStartSemaphore.wait();
+
+      if(preloader->mShuttingDown)
+         break;
+
+      preloader->preload();
+      preloader->mDoneSemaphore.increment();
+   }
+
+   preloader->mDoneSemaphore.increment();    // We may be deleted as soon as we signal
+
+   return 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LevelPreloader::LevelPreloader()
+{
+   mShuttingDown = false;
+   mRunning = false;
+
+   mLevelIndex = -1;
+   mBuildBotZones = false;
+   mTriangulateZones = false;
+
+   mFileModTime = 0;
+   mFileSize = 0;
+   mLevel = NULL;
+}
+
+
+// Destructor
+LevelPreloader::~LevelPreloader()
+{
+   discard();
+
+   if(mThread.isValid())
+   {
+      mShuttingDown = true;
+      mStartSemaphore.increment();
+      mDoneSemaphore.wait();
+   }
+}
+
+
+// Starts loading the specified level in the background; anything preloaded earlier and not claimed is thrown
+// away.  fullFilename is the level's file, or "" if levelCode holds the level itself.  Returns false if the level
+// can't be preloaded, in which case it will just be loaded the normal way when its time comes.
+bool LevelPreloader::start(S32 levelIndex, const string &fullFilename, const string &levelCode, bool buildBotZones,
+                           bool triangulateZones)
+{
+   discard();
+
+   if(levelIndex < 0 || (fullFilename == "" && levelCode == ""))
+      return false;
+
+   if(mThread.isNull())
+   {
+      mThread = new PreloadThread(this);
+
+      if(!mThread->start())
+      {
+         logprintf(LogConsumer::LogError, "Could not start level preloading thread; levels will be loaded when needed");
+         mThread = NULL;
+         return false;
+      }
+   }
+
+   mLevelIndex = levelIndex;
+   mFilename = fullFilename;
+   mLevelCode = levelCode;
+   mBuildBotZones = buildBotZones;
+   mTriangulateZones = triangulateZones;
+   mStats = LevelLoadStats();
+
+   // Level parsing creates StringTableEntries; the table has to be locked until we're done
+   StringTable::beginThreadedUse();
+
+   mRunning = true;
+   mStartSemaphore.increment();
+
+   return true;
+}
+
+
+// Index of the level being (or that has been) preloaded, or -1 if there isn't one
+S32 LevelPreloader::getLevelIndex() const
+{
+   return mLevelIndex;
+}
+
+
+// Hands over the preloaded level if it's the one asked for, and is still the same as it was when it was read.
+// Waits for the preload to finish if it's still running.  Caller gets ownership of the returned level; returns
+// NULL if there's no suitable level, in which case it should be loaded the normal way.
+Level *LevelPreloader::claim(S32 levelIndex, const string &fullFilename, const string &levelCode, LevelLoadStats &stats)
+{
+   if(mLevelIndex == -1)
+      return NULL;
+
+   S64 startTime = Platform::getHighPrecisionTimerValue();
+   wait();
+   F64 waitTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - startTime);
+
+   bool valid = mLevel && levelIndex == mLevelIndex && fullFilename == mFilename && levelCode == mLevelCode;
+
+   // Someone may have replaced the file since we read it (e.g. by uploading a new version)
+   if(valid && fullFilename != "")
+   {
+      S64 modTime, fileSize;
+      valid = getFileStamp(fullFilename, modTime, fileSize) && modTime == mFileModTime && fileSize == mFileSize;
+   }
+
+   if(!valid)
+   {
+      discard();
+      return NULL;
+   }
+
+   Level *level = mLevel;
+   mLevel = NULL;
+   mLevelIndex = -1;
+
+   stats = mStats;
+   stats.waitTime = waitTime;
+
+   return level;
+}
+
+
+// Throws away anything that's been preloaded, waiting for the preloading thread to finish with it if need be
+void LevelPreloader::cancel()
+{
+   discard();
+}
+
+
+void LevelPreloader::wait()
+{
+   if(!mRunning)
+      return;
+
+   mDoneSemaphore.wait();
+   mRunning = false;
+
+   StringTable::endThreadedUse();
+}
+
+
+void LevelPreloader::discard()
+{
+   wait();
+
+   delete mLevel;
+   mLevel = NULL;
+   mLevelIndex = -1;
+}
+
+
+// Runs on the preloading thread
+void LevelPreloader::preload()
+{
+   S64 startTime = Platform::getHighPrecisionTimerValue();
+
+   Level *level = new Level();
+
+   if(mFilename != "")
+   {
+      // Stamp the file before reading it, so a change while we're reading won't go unnoticed
+      if(!getFileStamp(mFilename, mFileModTime, mFileSize) || !level->loadLevelFromFile(mFilename))
+      {
+         delete level;     // Game thread will try again, and report the problem, when it gets to this level
+         return;
+      }
+   }
+   else
+      level->loadLevelFromString(mLevelCode, "");
+
+   mStats.preloaded = true;
+   mStats.parseTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - startTime);
+
+   // A levelgen can add and remove walls, so zones for a level with one have to wait until it has run
+   if(mBuildBotZones && level->getGameType()->getScriptName() == "")
+      buildBotZones(level);
+
+   mLevel = level;
+}
+
+
+// Builds zones from the level's own objects, with stand-ins for the barriers the game will make from its walls.
+// Runs on the preloading thread.
+void LevelPreloader::buildBotZones(Level *level)
+{
+   Vector<Barrier *> barriers;
+   const Vector<DatabaseObject *> *walls = level->findObjects_fast(WallItemTypeNumber);
+
+   for(S32 i = 0; i < walls->size(); i++)
+   {
+      WallItem *wallItem = static_cast<WallItem *>(walls->get(i));
+      Barrier::constructBarriers(*wallItem->getOutline(), (F32)wallItem->getWidth(), barriers);
+   }
+
+   // The same extents the game will have once the barriers have been added to it
+   Rect extents = level->getExtents();
+   Vector<DatabaseObject *> barrierList(barriers.size());
+
+   for(S32 i = 0; i < barriers.size(); i++)
+   {
+      extents.unionRect(barriers[i]->getExtent());
+      barrierList.push_back(barriers[i]);
+   }
+
+   Vector<DatabaseObject *> teleporters;
+   level->findObjects(TeleporterTypeNumber, teleporters);
+
+   Vector<pair<Point, const Vector<Point> *> > teleporterData(teleporters.size());
+
+   for(S32 i = 0; i < teleporters.size(); i++)
+   {
+      Teleporter *teleporter = static_cast<Teleporter *>(teleporters[i]);
+      teleporterData.push_back(pair<Point, const Vector<Point> *>(teleporter->getPos(), teleporter->getDestList()));
+   }
+
+   Vector<DatabaseObject *> turretList;
+   level->findObjects(TurretTypeNumber, turretList, extents);
+
+   Vector<DatabaseObject *> forceFieldProjectorList;
+   level->findObjects(ForceFieldProjectorTypeNumber, forceFieldProjectorList, extents);
+
+   GameType *gameType = level->getGameType();
+
+   gameType->mBotZoneCreationFailed = !BotNavMeshZone::buildBotMeshZones(level->getBotZoneDatabase(), level->getBotZoneList(),
+                                                                         &extents, barrierList, turretList,
+                                                                         forceFieldProjectorList, teleporterData,
+                                                                         mTriangulateZones, &mStats.botZoneStats);
+   if(!gameType->mBotZoneCreationFailed)
+      gameType->botZoneNextHops.build(level->getBotZoneList());
+
+   mStats.preloadedBotZones = true;
+
+   barriers.deleteAndClear();
+}
+
+
+};
@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _LEVEL_PRELOADER_H_
+#define _LEVEL_PRELOADER_H_
+
+#include "BotNavMeshZone.h"      // For BotZoneBuildStats
+
+#include "tnlThread.h"
+#include "tnlTypes.h"
+
+#include <string>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+class Level;
+
+// How long each part of getting a level into play took, in ms.  Work done on the preloading thread is timed there,
+// and costs the game thread nothing but waitTime.
+struct LevelLoadStats
+{
+   bool preloaded;                  // Level was parsed on the preloading thread...
+   bool preloadedBotZones;          // ...and its bot zones were built there too
+   bool ranLevelgens;               // Levelgens ran, so preloaded bot zones (if any) were thrown out
+
+   F64 parseTime;                   // Reading and parsing the level, including building its wall edges
+   F64 wallTime;                    // Building barriers from the level's walls, and their edges if not preloaded
+   F64 objectTime;                  // Adding the level's objects to the game
+   F64 levelgenTime;                // Running levelgen scripts
+   F64 waitTime;                    // Game thread waiting for a preload that hadn't finished
+   F64 gameThreadTime;              // Everything the game thread did to get the level into play
+
+   BotZoneBuildStats botZoneStats;
+
+   LevelLoadStats();                // Constructor
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Loads the next level on a background thread while the current one is being played.  If nothing can change the
+// level's walls once it's in the game (i.e. no levelgens will run), its bot zones are built there too, and the game
+// thread only has to add the finished level to the game.
+class LevelPreloader
+{
+private:
+   class PreloadThread : public Thread
+   {
+   private:
+      LevelPreloader *mPreloader;
+
+   public:
+      explicit PreloadThread(LevelPreloader *preloader);    // Constructor
+      U32 run();
+   };
+
+   friend class PreloadThread;
+
+   RefPtr<PreloadThread> mThread;   // Started with the first preload, and kept for the next ones
+   Semaphore mStartSemaphore;       // Signaled when there's a level to load, or when shutting down
+   Semaphore mDoneSemaphore;        // Signaled by the thread when it's done with either
+   bool mShuttingDown;
+   bool mRunning;                   // Thread is working on a level we haven't waited for yet
+
+   // Set by the game thread before the work is handed off
+   S32 mLevelIndex;                 // -1 if nothing has been preloaded
+   string mFilename;                // Full path of the level file, or "" if the level came as a string
+   string mLevelCode;
+   bool mBuildBotZones;
+   bool mTriangulateZones;
+
+   // Set by the preloading thread
+   S64 mFileModTime;
+   S64 mFileSize;
+   Level *mLevel;                   // NULL if the level couldn't be loaded
+   LevelLoadStats mStats;
+
+   void preload();                  // These run on the preloading thread
+   void buildBotZones(Level *level);
+
+   void wait();
+   void discard();
+
+public:
+   LevelPreloader();                // Constructor
+   virtual ~LevelPreloader();       // Destructor
+
+   bool start(S32 levelIndex, const string &fullFilename, const string &levelCode, bool buildBotZones,
+              bool triangulateZones);
+
+   S32 getLevelIndex() const;
+
+   Level *claim(S32 levelIndex, const string &fullFilename, const string &levelCode, LevelLoadStats &stats);
+   void cancel();
+};
+
+
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include "stringUtils.h"
 
 #include "tnlAssert.h"
+#include "tnlThread.h"
 
 #include <sstream>
 
@@ -95,6 +96,333 @@ void LevelInfo::ensureLevelInfoHasValidName()
 }
 
 
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LevelHeader::LevelHeader()
+{
+   levelType = BitmatchGame;
+   minRecPlayers = 0;
+   maxRecPlayers = 0;
+}
+
+
+// Constructor
+LevelHeader::LevelHeader(const LevelInfo &levelInfo)
+{
+   levelName      = levelInfo.mLevelName.getString();
+   levelType      = levelInfo.mLevelType;
+   minRecPlayers  = levelInfo.minRecPlayers;
+   maxRecPlayers  = levelInfo.maxRecPlayers;
+   scriptFileName = levelInfo.mScriptFileName;
+}
+
+
+void LevelHeader::copyTo(LevelInfo &levelInfo) const
+{
+   levelInfo.mLevelName       = levelName;
+   levelInfo.mLevelType       = levelType;
+   levelInfo.minRecPlayers    = minRecPlayers;
+   levelInfo.maxRecPlayers    = maxRecPlayers;
+   levelInfo.mScriptFileName  = scriptFileName;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Statics
+const string LevelInfoCache::CacheFileName = "levelinfo.cache";
+
+static const char *LevelInfoCacheVersion = "Bitfighter level info cache 1";
+
+static const S32 LevelHeaderChunkSize = 1024 * 4;     // Should be enough to fit all parameters at the beginning of level
+
+
+// Unlike parseString(), doesn't trim or truncate anything, which would mangle paths and level names
+static void splitString(const string &str, char separator, Vector<string> &words)
+{
+   words.clear();
+
+   string::size_type start = 0;
+   while(true)
+   {
+      string::size_type end = str.find(separator, start);
+      words.push_back(str.substr(start, end == string::npos ? string::npos : end - start));
+
+      if(end == string::npos)
+         break;
+
+      start = end + 1;
+   }
+}
+
+
+static S64 stringToS64(const string &str)
+{
+   S64 value = 0;
+   istringstream(str) >> value;
+   return value;
+}
+
+
+// Reads entries for a list of paths, with each worker thread taking the next unread path
+class LevelInfoCache::ReadEntriesTask : public WorkerTask
+{
+public:
+   // One per path, so each is only ever written by one thread (which is also why this isn't a Vector<bool>)
+   struct Result
+   {
+      Entry entry;
+      bool succeeded;
+      bool readFromDisk;
+   };
+
+   const Vector<string> *paths;
+   Vector<const Entry *> cachedEntries;   // Only read while the task runs, so safe to share
+   Vector<Result> results;
+
+   void runTask(S32 index)
+   {
+      Result &result = results[index];
+      result.succeeded = readEntry((*paths)[index], cachedEntries[index], result.entry, result.readFromDisk);
+   }
+};
+
+
+// Constructor
+LevelInfoCache::LevelInfoCache(const string &cacheFile)
+{
+   mCacheFile = cacheFile;
+   mDirty = false;
+}
+
+
+// Destructor
+LevelInfoCache::~LevelInfoCache()
+{
+   // Do nothing
+}
+
+
+// Fills entry with what's in the file at path, using cachedEntry (which may be NULL) where the file hasn't changed.
+// Doesn't touch any shared state, so may be called from any thread.  Static method.
+bool LevelInfoCache::readEntry(const string &path, const Entry *cachedEntry, Entry &entry, bool &readFromDisk)
+{
+   readFromDisk = false;
+
+   if(!getFileStamp(path, entry.modTime, entry.fileSize))
+      return false;
+
+   if(cachedEntry && cachedEntry->modTime == entry.modTime && cachedEntry->fileSize == entry.fileSize)
+   {
+      entry.hash   = cachedEntry->hash;
+      entry.header = cachedEntry->header;
+      return true;
+   }
+
+   string contents;
+   if(!readFile(path, contents))
+      return false;
+
+   readFromDisk = true;
+   entry.hash = Md5::getHashFromString(contents);
+
+   // Touched, but not changed
+   if(cachedEntry && cachedEntry->hash == entry.hash)
+   {
+      entry.header = cachedEntry->header;
+      return true;
+   }
+
+   entry.header = LevelHeader();
+   LevelSource::getLevelHeaderFromCodeChunk(contents.substr(0, LevelHeaderChunkSize), entry.header);
+
+   return true;
+}
+
+
+// Stores entry for path; returns true if it differs from what we had
+bool LevelInfoCache::updateEntry(const string &path, const Entry &entry)
+{
+   EntryMap::iterator it = mEntries.find(path);
+
+   if(it != mEntries.end() && it->second.modTime == entry.modTime && it->second.fileSize == entry.fileSize && 
+                              it->second.hash == entry.hash)
+      return false;
+
+   mEntries[path] = entry;
+   mDirty = true;
+
+   return true;
+}
+
+
+// Reads the cache file, if there is one; returns false if there was nothing usable in it
+bool LevelInfoCache::load()
+{
+   mEntries.clear();
+   mDirty = false;
+
+   string contents;
+   if(!readFile(mCacheFile, contents))
+      return false;
+
+   Vector<string> lines;
+   splitString(contents, '\n', lines);
+
+   // A cache written by a different version might not mean what we think it means
+   if(lines.size() == 0 || trim(lines[0]) != LevelInfoCacheVersion)
+      return false;
+
+   enum Cols {
+      PathCol,
+      ModTimeCol,
+      FileSizeCol,
+      HashCol,
+      GameTypeCol,
+      MinPlayersCol,
+      MaxPlayersCol,
+      LevelNameCol,
+      ScriptCol,
+      ColsExpected
+   };
+
+   Vector<string> words;
+
+   for(S32 i = 1; i < lines.size(); i++)
+   {
+      splitString(trim_right(lines[i], "\r"), '\t', words);    // writeFile() uses text mode, so Windows adds \r
+
+      if(words.size() != ColsExpected)
+         continue;
+
+      Entry entry;
+      entry.modTime  = stringToS64(words[ModTimeCol]);
+      entry.fileSize = stringToS64(words[FileSizeCol]);
+      entry.hash     = words[HashCol];
+
+      entry.header.levelType = GameType::getGameTypeIdFromName(words[GameTypeCol]);
+      if(entry.header.levelType == NoGameType)
+         continue;
+
+      entry.header.minRecPlayers  = atoi(words[MinPlayersCol].c_str());
+      entry.header.maxRecPlayers  = atoi(words[MaxPlayersCol].c_str());
+      entry.header.levelName      = words[LevelNameCol];
+      entry.header.scriptFileName = words[ScriptCol];
+
+      mEntries[words[PathCol]] = entry;
+   }
+
+   return mEntries.size() > 0;
+}
+
+
+// Writes the cache file, if anything has changed since it was loaded
+bool LevelInfoCache::save()
+{
+   if(!mDirty)
+      return true;
+
+   string contents = string(LevelInfoCacheVersion) + "\n";
+
+   for(EntryMap::const_iterator it = mEntries.begin(); it != mEntries.end(); it++)
+   {
+      const Entry &entry = it->second;
+
+      // We don't escape anything; an entry we can't write cleanly will just get read again next time
+      string fields = it->first + entry.header.levelName + entry.header.scriptFileName;
+      if(fields.find_first_of("\t\r\n") != string::npos)
+         continue;
+
+      contents += it->first + "\t" + 
+                  itos(entry.modTime) + "\t" + itos(entry.fileSize) + "\t" + entry.hash + "\t" +
+                  GameType::getGameTypeClassName(entry.header.levelType) + "\t" +
+                  itos(entry.header.minRecPlayers) + "\t" + itos(entry.header.maxRecPlayers) + "\t" + 
+                  entry.header.levelName + "\t" + entry.header.scriptFileName + "\n";
+   }
+
+   if(!writeFileAtomically(mCacheFile, contents))
+   {
+      logprintf(LogConsumer::LogWarning, "Could not write level info cache %s", mCacheFile.c_str());
+      return false;
+   }
+
+   mDirty = false;
+   return true;
+}
+
+
+bool LevelInfoCache::lookup(const string &path, LevelHeader &header)
+{
+   EntryMap::const_iterator it = mEntries.find(path);
+
+   Entry entry;
+   bool readFromDisk;
+   if(!readEntry(path, it == mEntries.end() ? NULL : &it->second, entry, readFromDisk))
+      return false;
+
+   updateEntry(path, entry);
+   header = entry.header;
+
+   return true;
+}
+
+
+S32 LevelInfoCache::refresh(const Vector<string> &paths, U32 threadCount)
+{
+   ReadEntriesTask task;
+   task.paths = &paths;
+   task.cachedEntries.resize(paths.size());
+   task.results.resize(paths.size());
+
+   for(S32 i = 0; i < paths.size(); i++)
+   {
+      EntryMap::const_iterator it = mEntries.find(paths[i]);
+      task.cachedEntries[i] = (it == mEntries.end()) ? NULL : &it->second;
+   }
+
+   {
+      WorkerPool pool(threadCount);
+      pool.run(&task, paths.size());
+   }
+
+   S32 readCount = 0;
+
+   for(S32 i = 0; i < paths.size(); i++)
+   {
+      const ReadEntriesTask::Result &result = task.results[i];
+
+      if(result.readFromDisk)
+         readCount++;
+
+      if(result.succeeded)
+         updateEntry(paths[i], result.entry);
+   }
+
+   // Forget about files that have gone away; entries for other folders' levels are left alone
+   for(EntryMap::iterator it = mEntries.begin(); it != mEntries.end(); )
+   {
+      if(fileExists(it->first))
+         it++;
+      else
+      {
+         mEntries.erase(it++);
+         mDirty = true;
+      }
+   }
+
+   return readCount;
+}
+
+
+S32 LevelInfoCache::getEntryCount() const
+{
+   return (S32)mEntries.size();
+}
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -118,13 +446,21 @@ LevelSource::~LevelSource()
 
 S32 LevelSource::getLevelCount() const
 {
-   return mLevelInfos.size();
+   mLevelInfosMutex.lock();
+   S32 count = mLevelInfos.size();
+   mLevelInfosMutex.unlock();
+
+   return count;
 }
 
 
 LevelInfo LevelSource::getLevelInfo(S32 index)
 {
-   return mLevelInfos[index];
+   mLevelInfosMutex.lock();
+   LevelInfo levelInfo = mLevelInfos[index];
+   mLevelInfosMutex.unlock();
+
+   return levelInfo;
 }
 
 
@@ -146,6 +482,22 @@ bool LevelSource::getLevelInfoFromDatabase(const string &hash, LevelInfo &levelI
 // This is only used on the server to provide quick level information without having to load the level
 // (like with playlists or menus).  Static method.
 void LevelSource::getLevelInfoFromCodeChunk(const string &code, LevelInfo &levelInfo)
+{
+   LevelHeader header(levelInfo);
+   getLevelHeaderFromCodeChunk(code, header);
+   header.copyTo(levelInfo);
+}
+
+
+// Lengths of the parameter names we look for; set up before main so worker threads never race to initialize them
+static const S32 gameTypeLen      = strlen("GameType");
+static const S32 levelNameLen     = strlen("LevelName");
+static const S32 minMaxPlayersLen = strlen("MinPlayers");
+static const S32 scriptLen        = strlen("Script");
+
+
+// As above, but fills a LevelHeader, which is safe to do on any thread.  Static method.
+void LevelSource::getLevelHeaderFromCodeChunk(const string &code, LevelHeader &header)
 {
    istringstream stream(code);
    string line;
@@ -153,11 +505,6 @@ void LevelSource::getLevelInfoFromCodeChunk(const string &code, LevelInfo &level
    bool foundGameType   = false, foundLevelName  = false, foundMinPlayers = false, 
         foundMaxPlayers = false, foundScriptName = false;
 
-   static const S32 gameTypeLen      = strlen("GameType");
-   static const S32 levelNameLen     = strlen("LevelName");
-   static const S32 minMaxPlayersLen = strlen("MinPlayers");
-   static const S32 scriptLen        = strlen("Script");
-
    std::size_t pos;
 
    // Iterate until we've either exhausted all the lines, or found everything we're looking for
@@ -176,7 +523,7 @@ void LevelSource::getLevelInfoFromCodeChunk(const string &code, LevelInfo &level
             const string validatedName = GameType::validateGameType(gameTypeName);
 
             GameTypeId gameTypeId = GameType::getGameTypeIdFromName(validatedName);
-            levelInfo.mLevelType = gameTypeId;
+            header.levelType = gameTypeId;
 
             foundGameType = true;
             continue;
@@ -193,7 +540,7 @@ void LevelSource::getLevelInfoFromCodeChunk(const string &code, LevelInfo &level
             {
                string levelName = line.substr(pos);
                stripQuotes(levelName);
-               levelInfo.mLevelName = trim(levelName);
+               header.levelName = trim(levelName);
             }
 
             foundLevelName = true;
@@ -208,7 +555,7 @@ void LevelSource::getLevelInfoFromCodeChunk(const string &code, LevelInfo &level
          {
             pos = line.find_first_not_of(" ", minMaxPlayersLen + 1);
             if(pos != string::npos)
-               levelInfo.minRecPlayers = atoi(line.substr(pos).c_str());
+               header.minRecPlayers = atoi(line.substr(pos).c_str());
 
             foundMinPlayers = true;
             continue;
@@ -222,7 +569,7 @@ void LevelSource::getLevelInfoFromCodeChunk(const string &code, LevelInfo &level
          {
             pos = line.find_first_not_of(" ", minMaxPlayersLen + 1);
             if(pos != string::npos)
-               levelInfo.maxRecPlayers = atoi(line.substr(pos).c_str());
+               header.maxRecPlayers = atoi(line.substr(pos).c_str());
 
             foundMaxPlayers = true;
             continue;
@@ -239,7 +586,7 @@ void LevelSource::getLevelInfoFromCodeChunk(const string &code, LevelInfo &level
             {
                string scriptName = line.substr(pos);
                stripQuotes(scriptName);
-               levelInfo.mScriptFileName = scriptName;
+               header.scriptFileName = scriptName;
             }
             foundScriptName = true;
             continue;
@@ -252,57 +599,91 @@ void LevelSource::getLevelInfoFromCodeChunk(const string &code, LevelInfo &level
 // User has uploaded a file and wants to add it to the current playlist
 pair<S32, bool> LevelSource::addLevel(LevelInfo levelInfo)
 {
+   pair<S32, bool> ret;
+
+   mLevelInfosMutex.lock();
+
    // Check if we already have this one -- matches by filename and folder
+   S32 index = -1;
    for(S32 i = 0; i < mLevelInfos.size(); i++)
    {
       if(mLevelInfos[i].filename == levelInfo.filename && mLevelInfos[i].folder == levelInfo.folder)
-         return pair<S32, bool>(i, false);
+      {
+         index = i;
+         break;
+      }
    }
 
-   // We don't have it... so add it!
-   mLevelInfos.push_back(levelInfo);
+   if(index >= 0)
+      ret = pair<S32, bool>(index, false);
+   else
+   {
+      // We don't have it... so add it!
+      mLevelInfos.push_back(levelInfo);
+      ret = pair<S32, bool>(mLevelInfos.size() - 1, true);
+   }
+
+   mLevelInfosMutex.unlock();
 
-   return pair<S32, bool>(getLevelCount() - 1, true);
+   return ret;
 }
 void LevelSource::addNewLevel(const LevelInfo &levelInfo)
 {
+   mLevelInfosMutex.lock();
    mLevelInfos.push_back(levelInfo);
+   mLevelInfosMutex.unlock();
 }
 
 
 string LevelSource::getLevelName(S32 index)
 {
-   if(index < 0 || index >= mLevelInfos.size())
-      return "";
-   else
-      return mLevelInfos[index].mLevelName.getString(); 
+   string name;
+
+   mLevelInfosMutex.lock();
+   if(index >= 0 && index < mLevelInfos.size())
+      name = mLevelInfos[index].mLevelName.getString(); 
+   mLevelInfosMutex.unlock();
+
+   return name;
 }
 
 
 string LevelSource::getLevelFileName(S32 index)
 {
-   if(index < 0 || index >= mLevelInfos.size())
-      return "";
-   else
-      return mLevelInfos[index].filename;
+   string filename;
+
+   mLevelInfosMutex.lock();
+   if(index >= 0 && index < mLevelInfos.size())
+      filename = mLevelInfos[index].filename;
+   mLevelInfosMutex.unlock();
+
+   return filename;
 }
 
 
 void LevelSource::setLevelFileName(S32 index, const string &filename)
 {
+   mLevelInfosMutex.lock();
    mLevelInfos[index].filename = filename;
+   mLevelInfosMutex.unlock();
 }
 
 
 GameTypeId LevelSource::getLevelType(S32 index)
 {
-   return mLevelInfos[index].mLevelType;
+   mLevelInfosMutex.lock();
+   GameTypeId levelType = mLevelInfos[index].mLevelType;
+   mLevelInfosMutex.unlock();
+
+   return levelType;
 }
 
 
 void LevelSource::remove(S32 index)
 {
+   mLevelInfosMutex.lock();
    mLevelInfos.erase(index);
+   mLevelInfosMutex.unlock();
 }
 
 
@@ -348,13 +729,60 @@ bool LevelSource::loadLevels(FolderManager *folderManager)
 
 MultiLevelSource::MultiLevelSource()
 {
-   // Do nothing
+   mLevelInfoCache = NULL;
+   mLevelFilesScanned = false;
 }
 
 
 MultiLevelSource::~MultiLevelSource()
 {
-   // Do nothing
+   delete mLevelInfoCache;
+}
+
+
+LevelInfoCache *MultiLevelSource::getLevelInfoCache()
+{
+   if(!mLevelInfoCache)
+   {
+      string cacheFile = joindir(GameSettings::getFolderManager()->getIniDir(), LevelInfoCache::CacheFileName);
+
+      mLevelInfoCache = new LevelInfoCache(cacheFile);
+      mLevelInfoCache->load();
+   }
+
+   return mLevelInfoCache;
+}
+
+
+// Bring the cache up to date for all our levels at once, so the files that have changed are read in parallel,
+// and populating each levelInfo afterwards doesn't have to read anything
+void MultiLevelSource::scanLevelFiles()
+{
+   mLevelFilesScanned = true;
+
+   Vector<string> paths;
+   for(S32 i = 0; i < mLevelInfos.size(); i++)
+   {
+      string filename = FolderManager::findLevelFile(mLevelInfos[i].folder, mLevelInfos[i].filename);
+      if(filename != "")
+         paths.push_back(filename);
+   }
+
+   LevelInfoCache *cache = getLevelInfoCache();
+
+   S32 readCount = cache->refresh(paths, LevelScanThreads);
+   cache->save();
+
+   logprintf(LogConsumer::ServerFilter, "Scanned %d levels; %d were new or changed", paths.size(), readCount);
+}
+
+
+bool MultiLevelSource::populateLevelInfoFromSourceByIndex(S32 levelInfoIndex)
+{
+   if(!mLevelFilesScanned)
+      scanLevelFiles();
+
+   return Parent::populateLevelInfoFromSourceByIndex(levelInfoIndex);
 }
 
 
@@ -363,6 +791,8 @@ bool MultiLevelSource::loadLevels(FolderManager *folderManager)
 {
    bool anyLoaded = false;
 
+   scanLevelFiles();
+
    for(S32 i = 0; i < mLevelInfos.size(); i++)
    {
       if(Parent::populateLevelInfoFromSourceByIndex(i))
@@ -381,15 +811,16 @@ bool MultiLevelSource::loadLevels(FolderManager *folderManager)
 // Load specified level, put results in gameObjectDatabase.  Return md5 hash of level
 Level *MultiLevelSource::getLevel(S32 index) const
 {
+   mLevelInfosMutex.lock();
    TNLAssert(index >= 0 && index < mLevelInfos.size(), "Index out of bounds!");
+   string levelFileName = mLevelInfos[index].filename;      // Copied, as the list may change while we load
+   mLevelInfosMutex.unlock();
 
-   const LevelInfo *levelInfo = &mLevelInfos[index];
-
-   string filename = FolderManager::findLevelFile(levelInfo->folder, levelInfo->filename);
+   string filename, levelCode;
 
-   if(filename == "")
+   if(!getLevelOrigin(index, filename, levelCode))
    {
-      logprintf("Unable to find level file \"%s\".  Skipping...", levelInfo->filename.c_str());
+      logprintf("Unable to find level file \"%s\".  Skipping...", levelFileName.c_str());
       return NULL;
    }
 
@@ -397,7 +828,7 @@ Level *MultiLevelSource::getLevel(S32 index) const
 
    if(!level->loadLevelFromFile(filename))
    {
-      logprintf("Unable to process level file \"%s\".  Skipping...", levelInfo->filename.c_str());
+      logprintf("Unable to process level file \"%s\".  Skipping...", levelFileName.c_str());
       delete level;
       return NULL;
    }
@@ -406,32 +837,50 @@ Level *MultiLevelSource::getLevel(S32 index) const
 }
 
 
+bool MultiLevelSource::getLevelOrigin(S32 index, string &fullFilename, string &levelCode) const
+{
+   mLevelInfosMutex.lock();
+   TNLAssert(index >= 0 && index < mLevelInfos.size(), "Index out of bounds!");
+   string folder = mLevelInfos[index].folder;
+   string filename = mLevelInfos[index].filename;
+   mLevelInfosMutex.unlock();
+
+   fullFilename = FolderManager::findLevelFile(folder, filename);
+   levelCode = "";
+
+   return fullFilename != "";
+}
+
+
 // Returns a textual level descriptor good for logging and error messages and such
 string MultiLevelSource::getLevelFileDescriptor(S32 index) const
 {
-   return "levelfile \"" + mLevelInfos[index].filename + "\"";
+   mLevelInfosMutex.lock();
+   string filename = mLevelInfos[index].filename;
+   mLevelInfosMutex.unlock();
+
+   return "levelfile \"" + filename + "\"";
 }
 
 
 // Populates levelInfo with data from fullFilename -- returns true if successful, false otherwise
-// Reads 4kb of file and uses what it finds there to populate the levelInfo
+// Uses what the cache has for the file, or reads 4kb of it and uses what it finds there if the file has changed
 bool MultiLevelSource::populateLevelInfoFromSource(const string &fullFilename, LevelInfo &levelInfo)
 {
    // Check if we got a dud... (FolderManager::findLevelFile() will, for example, return "" if it fails)
    if(fullFilename.empty())
       return false;
 
-	FILE *f = fopen(fullFilename.c_str(), "rb");
-	if(!f)
+   LevelInfoCache *cache = getLevelInfoCache();
+
+   LevelHeader header;
+   if(!cache->lookup(fullFilename, header))
    {
       logprintf(LogConsumer::LogWarning, "Could not read level file %s [%s]... Skipping...",
                                           levelInfo.filename.c_str(), fullFilename.c_str());
       return false;
    }
 
-   Level level;
-   level.loadLevelFromFile(fullFilename);
-
 // some ideas for getting the area of a level:
 //   if(loadLevel())
 //      {
@@ -520,12 +969,8 @@ bool MultiLevelSource::populateLevelInfoFromSource(const string &fullFilename, L
 
 
 
-   char data[1024 * 4];  // Should be enough to fit all parameters at the beginning of level; we don't need to read everything
-   S32 size = (S32)fread(data, 1, sizeof(data), f);
-   fclose(f);
-
-   getLevelInfoFromCodeChunk(string(data, size), levelInfo);     // Fills levelInfo with data from file
-
+   header.copyTo(levelInfo);
+   cache->save();       // Only writes anything if this was a file we hadn't seen
 
    levelInfo.ensureLevelInfoHasValidName();
    return true;
@@ -578,30 +1023,18 @@ FileListLevelSource::~FileListLevelSource()
 
 
 // Load specified level, put results in gameObjectDatabase.  Return md5 hash of level.
-Level *FileListLevelSource::getLevel(S32 index) const
+// Playlists name files in the level folder
+bool FileListLevelSource::getLevelOrigin(S32 index, string &fullFilename, string &levelCode) const
 {
+   mLevelInfosMutex.lock();
    TNLAssert(index >= 0 && index < mLevelInfos.size(), "Index out of bounds!");
+   string filename = mLevelInfos[index].filename;
+   mLevelInfosMutex.unlock();
 
-   const LevelInfo *levelInfo = &mLevelInfos[index];
-
-   string filename = FolderManager::findLevelFile(GameSettings::getFolderManager()->getLevelDir(), levelInfo->filename);
-
-   if(filename == "")
-   {
-      logprintf("Unable to find level file \"%s\".  Skipping...", levelInfo->filename.c_str());
-      return NULL;
-   }
-
-   Level *level = new Level();      // Will be deleted by caller
-
-   if(!level->loadLevelFromFile(filename))
-   {
-      logprintf("Unable to process level file \"%s\".  Skipping...", levelInfo->filename.c_str());
-      delete level;
-      return NULL;
-   }
+   fullFilename = FolderManager::findLevelFile(GameSettings::getFolderManager()->getLevelDir(), filename);
+   levelCode = "";
 
-   return level;
+   return fullFilename != "";
 }
 
 
@@ -691,6 +1124,15 @@ Level *StringLevelSource::getLevel(S32 index) const
 }
 
 
+bool StringLevelSource::getLevelOrigin(S32 index, string &fullFilename, string &levelCode) const
+{
+   fullFilename = "";
+   levelCode = mLevelCodes[index];
+
+   return true;
+}
+
+
 // Returns a textual level descriptor good for logging and error messages and such
 string StringLevelSource::getLevelFileDescriptor(S32 index) const
 {
@@ -9,10 +9,12 @@
 #include "GameTypesEnum.h"       // For GameTypeId
 
 #include "tnlNetStringTable.h"
+#include "tnlThread.h"
 #include "tnlTypes.h"
 #include "tnlVector.h"
 
 #include <boost/shared_ptr.hpp>
+#include <map>
 #include <string>
 
 
@@ -59,6 +61,72 @@ public:
 };
 
 
+// The fields we read from the top of a level file, kept as plain strings so they can be filled in off the
+// main thread, where LevelInfo's StringTableEntry can't be touched
+struct LevelHeader
+{
+   string levelName;
+   GameTypeId levelType;
+   S32 minRecPlayers;
+   S32 maxRecPlayers;
+   string scriptFileName;
+
+   LevelHeader();                                     // Constructor
+   explicit LevelHeader(const LevelInfo &levelInfo);  // Constructor -- starts with levelInfo's values
+
+   void copyTo(LevelInfo &levelInfo) const;
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+
+// Remembers the headers of level files we've read before, so hosting a big level folder only means reading the
+// files that have changed since the last run.  Entries are keyed by path, and are trusted as long as the file's
+// modification time and size are unchanged; a file that has been touched is rehashed, and only reparsed if its
+// contents are actually different.
+class LevelInfoCache
+{
+   struct Entry
+   {
+      S64 modTime;
+      S64 fileSize;
+      string hash;
+      LevelHeader header;
+   };
+
+   typedef map<string, Entry> EntryMap;
+
+   class ReadEntriesTask;
+   friend class ReadEntriesTask;
+
+   string mCacheFile;
+   EntryMap mEntries;
+   bool mDirty;
+
+   static bool readEntry(const string &path, const Entry *cachedEntry, Entry &entry, bool &readFromDisk);
+   bool updateEntry(const string &path, const Entry &entry);
+
+public:
+   static const string CacheFileName;
+
+   explicit LevelInfoCache(const string &cacheFile);  // Constructor
+   virtual ~LevelInfoCache();                         // Destructor
+
+   bool load();
+   bool save();
+
+   // Gets the header for the level at path, reading the file only if our entry for it is out of date
+   bool lookup(const string &path, LevelHeader &header);
+
+   // Brings entries for all paths up to date, reading any changed files in parallel; returns number of files read
+   S32 refresh(const Vector<string> &paths, U32 threadCount);
+
+   S32 getEntryCount() const;
+};
+
+
 ////////////////////////////////////////
 ////////////////////////////////////////
 
@@ -69,10 +137,13 @@ class GameSettings;
 class FolderManager;
 class Level;
 
+// Several games hosted in one process can share a LevelSource, so once hosting starts, mLevelInfos is only
+// touched with mLevelInfosMutex held
 class LevelSource
 {
 protected:
    Vector<LevelInfo> mLevelInfos;   // Info about these levels
+   mutable Mutex mLevelInfosMutex;
 
 public:
    static const string TestFileName;
@@ -98,6 +169,11 @@ public:
    virtual bool populateLevelInfoFromSourceByIndex(S32 levelInfoIndex);
 
    virtual Level *getLevel(S32 index) const = 0;
+
+   // Where level index comes from: a full path to its file, or else its code.  Lets the level be loaded without going
+   // through the LevelSource, e.g. on a preloading thread.  Returns false if the level can't be found.
+   virtual bool getLevelOrigin(S32 index, string &fullFilename, string &levelCode) const = 0;
+
    virtual bool loadLevels(FolderManager *folderManager);
    virtual string getLevelFileDescriptor(S32 index) const = 0;
    virtual bool isEmptyLevelDirOk() const = 0;
@@ -108,6 +184,7 @@ public:
    // The following populate levelInfo
    static bool getLevelInfoFromDatabase(const string &hash, LevelInfo &levelInfo);
    static void getLevelInfoFromCodeChunk(const string &code, LevelInfo &levelInfo);     
+   static void getLevelHeaderFromCodeChunk(const string &code, LevelHeader &header);
 };
 
 
@@ -119,12 +196,23 @@ class MultiLevelSource : public LevelSource
 {
    typedef LevelSource Parent;
 
+private:
+   static const U32 LevelScanThreads = 4;    // Scanning is mostly waiting on the disk, so this needn't track core count
+
+   LevelInfoCache *mLevelInfoCache;          // Created when we first need level info
+   bool mLevelFilesScanned;
+
+   LevelInfoCache *getLevelInfoCache();
+   void scanLevelFiles();
+
 public:
    MultiLevelSource();              // Constructor
    virtual ~MultiLevelSource();     // Destructor
 
    bool loadLevels(FolderManager *folderManager);
+   bool populateLevelInfoFromSourceByIndex(S32 levelInfoIndex);
    Level *getLevel(S32 index) const;
+   bool getLevelOrigin(S32 index, string &fullFilename, string &levelCode) const;
    string getLevelFileDescriptor(S32 index) const;
    bool isEmptyLevelDirOk() const;
 
@@ -163,7 +251,7 @@ public:
    FileListLevelSource(const Vector<string> &levelList, const string &folder, GameSettings *settings);     // Constructor
    virtual ~FileListLevelSource();                                                                                                                // Destructor
 
-   Level *getLevel(S32 index) const;
+   bool getLevelOrigin(S32 index, string &fullFilename, string &levelCode) const;
 
    static Vector<string> findAllFilesInPlaylist(const string &fileName, const string &levelDir);
 };
@@ -187,6 +275,7 @@ public:
    virtual ~StringLevelSource();                         // Destructor
 
    Level *getLevel(S32 index) const;
+   bool getLevelOrigin(S32 index, string &fullFilename, string &levelCode) const;
    string getLevelFileDescriptor(S32 index) const;
    bool isEmptyLevelDirOk() const;
 
@@ -250,6 +250,13 @@ U32 LineItem::packUpdate(GhostConnection *connection, U32 updateMask, BitStream
 }
 
 
+// Same updates go to everyone
+S32 LineItem::getUpdateCacheKey(GhostConnection *connection)
+{
+   return 0;
+}
+
+
 void LineItem::unpackUpdate(GhostConnection *connection, BitStream *stream)
 {
    //mWidth = stream->readRangedU32(0, MAX_LINE_WIDTH);
@@ -48,6 +48,7 @@ public:
    void idle(BfObject::IdleCallPath path);
    U32 packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream);
    void unpackUpdate(GhostConnection *connection, BitStream *stream);
+   S32 getUpdateCacheKey(GhostConnection *connection);
    F32 getUpdatePriority(GhostConnection *connection, U32 updateMask, S32 updateSkips);
 
    virtual void setGeom(lua_State *L, S32 stackIndex);
@@ -7,6 +7,7 @@
 
 #include "LuaModule.h"
 #include "playerInfo.h"       // For access to PlayerInfo's push function
+#include "GameContext.h"
 #include "Level.h"
 #include "luaGameInfo.h"
 #include "LuaWrapper.h"
@@ -15,6 +16,8 @@
 
 #include "stringUtils.h"      // For itos
 
+#include "tnlThread.h"
+
 
 namespace Zap
 {
@@ -1010,4 +1013,112 @@ void setScriptContext(lua_State *L, ScriptContext context)
    lua_setfield(L, LUA_REGISTRYINDEX, SCRIPT_CONTEXT_KEY);     // Pops the int we just pushed from the stack
 }
 
+
+// Each GameContext has its own locks, so scripts in games hosted on different threads never wait on each other
+
+// Only flipped by the thread hosting the game while no scripts are running
+void setScriptThreadsActive(bool active)
+{
+   GameContext::get()->mScriptThreadsActive = active;
+}
+
+
+bool areScriptThreadsActive()
+{
+   return GameContext::get()->mScriptThreadsActive;
+}
+
+
+void lockScriptCalls()
+{
+   GameContext *context = GameContext::get();
+
+   if(context->mScriptThreadsActive)
+      context->mScriptCallLock.lockExclusive();
+}
+
+
+void unlockScriptCalls()
+{
+   GameContext *context = GameContext::get();
+
+   if(context->mScriptThreadsActive)
+      context->mScriptCallLock.unlockExclusive();
+}
+
+
+// Proxies are created and collected outside of any method call (Lua collects garbage whenever it likes), so
+// their lists get a lock of their own rather than the script lock
+void lockLuaProxies()
+{
+   GameContext *context = GameContext::get();
+
+   if(context->mScriptThreadsActive)
+      context->mLuaProxyMutex.lock();
+}
+
+
+void unlockLuaProxies()
+{
+   GameContext *context = GameContext::get();
+
+   if(context->mScriptThreadsActive)
+      context->mLuaProxyMutex.unlock();
+}
+
+
+// Methods that read a few fields of the game and return plain values -- no objects, no strings from the
+// StringTable, no lazily built caches -- so scripts on different threads can run them at the same time.  This
+// goes by name, so every class's method of that name has to qualify; check them all before adding one.  These
+// are the calls robots make most often.
+static const char *readOnlyScriptCalls[] = {
+   "getPos", "getVel", "getRad", "getAngle", "getId", "getObjType", "getTeamIndex", "getHealth", "getEnergy",
+   "getFlagCount", "isAlive", "isOnShip", "hasFlag", "hasWeapon", "hasModule", "canSeePoint",
+};
+
+
+bool isReadOnlyScriptCall(const char *methodName)
+{
+   for(U32 i = 0; i < ARRAYSIZE(readOnlyScriptCalls); i++)
+      if(strcmp(methodName, readOnlyScriptCalls[i]) == 0)
+         return true;
+
+   return false;
+}
+
+
+// Runs function with the script lock held, shared if readOnly.  Lua errors raised by function can't be allowed
+// to unwind past the lock, so the call goes through lua_pcall and any error is re-raised once the lock has been
+// released.
+S32 callWithScriptLock(lua_State *L, lua_CFunction function, bool readOnly)
+{
+   GameContext *context = GameContext::get();
+   bool locking = context->mScriptThreadsActive;
+
+   if(locking)
+   {
+      if(readOnly)
+         context->mScriptCallLock.lockShared();
+      else
+         context->mScriptCallLock.lockExclusive();
+   }
+
+   lua_pushcfunction(L, function);     // -- args, function
+   lua_insert(L, 1);                   // -- function, args
+   S32 status = lua_pcall(L, lua_gettop(L) - 1, LUA_MULTRET, 0);
+
+   if(locking)
+   {
+      if(readOnly)
+         context->mScriptCallLock.unlockShared();
+      else
+         context->mScriptCallLock.unlockExclusive();
+   }
+
+   if(status != 0)
+      return lua_error(L);             // Error message is on top of the stack
+
+   return lua_gettop(L);
+}
+
 };
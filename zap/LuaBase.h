@@ -193,6 +193,18 @@ bool luaIsPoint(lua_State *L, S32 index);
 ScriptContext getScriptContext(lua_State *L);
 void setScriptContext(lua_State *L, ScriptContext context);
 
+/////
+// Script threads -- while robot scripts run in parallel, calls from Lua into c++ take turns, except that
+// read-only methods can run alongside each other
+void setScriptThreadsActive(bool active);
+bool areScriptThreadsActive();
+void lockScriptCalls();
+void unlockScriptCalls();
+void lockLuaProxies();
+void unlockLuaProxies();
+bool isReadOnlyScriptCall(const char *methodName);
+S32 callWithScriptLock(lua_State *L, lua_CFunction function, bool readOnly = false);
+
 /////
 // Documenting and help
 S32 checkArgList(lua_State *L, const LuaFunctionProfile *functionInfos,   const char *className, const char *functionName);
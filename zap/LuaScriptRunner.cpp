@@ -9,6 +9,7 @@
 #include "BotNavMeshZone.h"
 #include "Engineerable.h"
 #include "game.h"
+#include "GameContext.h"
 #include "GeomUtils.h"
 #include "Level.h"
 #include "LuaModule.h"
@@ -41,17 +42,18 @@ namespace Zap
 ////////////////////////////////////////
 
 // Declare and Initialize statics:
-lua_State *LuaScriptRunner::L = NULL;
 string LuaScriptRunner::mScriptingDir;
 
-deque<string> LuaScriptRunner::mCachedScripts;
+static Mutex gNextScriptIdMutex;       // Games hosted on other threads create scripts too
 
 void LuaScriptRunner::clearScriptCache()
 {
-	while(mCachedScripts.size() != 0)
+   GameContext *context = GameContext::get();
+
+	while(context->mCachedScripts.size() != 0)
 	{
-		deleteScript(mCachedScripts.front().c_str());
-		mCachedScripts.pop_front();
+		deleteScript(context->mSharedL, context->mCachedScripts.front().c_str());
+		context->mCachedScripts.pop_front();
 	}
 }
 
@@ -69,9 +71,15 @@ LuaScriptRunner::LuaScriptRunner()
    for(S32 i = 0; i < EventManager::EventTypes; i++)
       mSubscriptions[i] = false;
 
+   gNextScriptIdMutex.lock();
    mScriptId = "script" + itos(mNextScriptId++);
+   gNextScriptIdMutex.unlock();
+
    mScriptType = ScriptTypeInvalid;
 
+   L = GameContext::get()->mSharedL;
+   mHasPrivateLuaState = false;
+
    LUAW_CONSTRUCTOR_INITIALIZATIONS;
 }
 
@@ -89,9 +97,16 @@ LuaScriptRunner::~LuaScriptRunner()
    // with bf:addItem()
 
    // And delete the script's environment table from the Lua instance
-   deleteScript(getScriptId());
+   if(!mHasPrivateLuaState)
+      L = GameContext::get()->mSharedL;     // Shared VM may have been restarted since we last ran
+
+   deleteScript(L, getScriptId());
 
    LUAW_DESTRUCTOR_CLEANUP;
+
+   // Closing the VM collects our proxies, unhooking them from any objects that are still alive
+   if(mHasPrivateLuaState)
+      lua_close(L);
 }
 
 
@@ -100,11 +115,44 @@ const char *LuaScriptRunner::getErrorMessagePrefix() { return "SCRIPT"; }
 
 lua_State *LuaScriptRunner::getL()
 {
-   TNLAssert(L, "L not yet instantiated!");
+   lua_State *sharedL = GameContext::get()->mSharedL;
+
+   TNLAssert(sharedL, "L not yet instantiated!");
+   return sharedL;
+}
+
+
+lua_State *LuaScriptRunner::getLuaState() const
+{
    return L;
 }
 
 
+bool LuaScriptRunner::hasPrivateLuaState() const
+{
+   return mHasPrivateLuaState;
+}
+
+
+// Give this script a Lua VM of its own, so it can run at the same time as other scripts.  Costs a fresh copy of
+// the whole scripting environment, so only robots do this, and only when RobotScriptThreads is set.
+bool LuaScriptRunner::usePrivateLuaState()
+{
+   TNLAssert(!mHasPrivateLuaState, "Already have a private VM!");
+
+   lua_State *privateL = createPrivateLuaState();
+   if(!privateL)
+      return false;
+
+   deleteScript(L, getScriptId());     // In case anything was set up in the shared VM already
+
+   L = privateL;
+   mHasPrivateLuaState = true;
+
+   return true;
+}
+
+
 Game *LuaScriptRunner::getLuaGame() const
 {
    return mLuaGame;
@@ -113,11 +161,15 @@ Game *LuaScriptRunner::getLuaGame() const
 
 void LuaScriptRunner::shutdown()
 {
-   if(L)
+   GameContext *context = GameContext::get();
+
+   if(context->mSharedL)
    {
-      lua_close(L);
-      L = NULL;
+      lua_close(context->mSharedL);
+      context->mSharedL = NULL;
    }
+
+   context->mCachedScripts.clear();     // Those went with the VM
 }
 
 
@@ -200,7 +252,7 @@ void LuaScriptRunner::pushStackTracer()
 // environment.  This loaded script will be cleared when the parent script terminates
 bool LuaScriptRunner::loadCompileRunEnvironmentScript(const string &scriptName) {
    // The timer is loaded in each script
-   loadCompileScript(joindir(mScriptingDir, scriptName).c_str());
+   loadCompileScript(L, joindir(mScriptingDir, scriptName).c_str());
    setEnvironment();
 
    S32 err = lua_pcall(L, 0, 0, 0);
@@ -237,17 +289,20 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
    {
       pushStackTracer();            // -- _stackTracer
 
-      if(!cacheScript)
-         loadCompileScript(mScriptName.c_str());
+      // The cache lives in the shared VM
+      if(!cacheScript || mHasPrivateLuaState)
+         loadCompileScript(L, mScriptName.c_str());
       else  
       {
          bool found = false;
 
+         deque<string> &cachedScripts = GameContext::get()->mCachedScripts;
+
          // Check if script is in our cache
-         S32 cacheSize = (S32)mCachedScripts.size();
+         S32 cacheSize = (S32)cachedScripts.size();
 
          for(S32 i = 0; i < cacheSize; i++)
-            if(mCachedScripts[i] == mScriptName)
+            if(cachedScripts[i] == mScriptName)
             {
                found = true;
                break;
@@ -258,13 +313,13 @@ bool LuaScriptRunner::loadScript(bool cacheScript)
             if(cacheSize > MAX_CACHE_SIZE)
             {
                // Remove oldest script from the cache
-               deleteScript(mCachedScripts.front().c_str());
-               mCachedScripts.pop_front();
+               deleteScript(L, cachedScripts.front().c_str());
+               cachedScripts.pop_front();
             }
 
             // Load new script into cache using full name as registry key
-            loadCompileSaveScript(mScriptName.c_str(), mScriptName.c_str());
-            mCachedScripts.push_back(mScriptName);
+            loadCompileSaveScript(L, mScriptName.c_str(), mScriptName.c_str());
+            cachedScripts.push_back(mScriptName);
          }
 
          lua_getfield(L, LUA_REGISTRYINDEX, mScriptName.c_str());    // Load script from cache
@@ -363,6 +418,9 @@ bool LuaScriptRunner::runCmd(const char *function, S32 returnValues)
 
    catch(const LuaException &e)
    {
+      // Killing a script touches the game, so wait our turn if other scripts are running
+      lockScriptCalls();
+
       logprintf(LogConsumer::LogError, "%s\n%s", getErrorMessagePrefix(), e.msg.c_str());
       logprintf(LogConsumer::LogError, "Dump of Lua/C++ stack:");
       dumpStack(L);
@@ -370,6 +428,8 @@ bool LuaScriptRunner::runCmd(const char *function, S32 returnValues)
 
       killScript();
       clearStack(L);
+
+      unlockScriptCalls();
       return true;
    }
 
@@ -380,20 +440,24 @@ bool LuaScriptRunner::runCmd(const char *function, S32 returnValues)
 // Start Lua and get everything configured
 bool LuaScriptRunner::startLua(const string &scriptingDir)
 {
-   TNLAssert(!L, "L should not have been created yet!");
+   lua_State *&sharedL = GameContext::get()->mSharedL;
 
-   mScriptingDir = scriptingDir;
+   TNLAssert(!sharedL, "L should not have been created yet!");
+
+   // Every game hosted by the process starts Lua with the same folder, so only the first one writes it
+   if(mScriptingDir != scriptingDir)
+      mScriptingDir = scriptingDir;
 
    // Prepare the Lua global environment
    try 
    {
-      L = lua_open();               // Create a new Lua interpreter; will be shutdown in the destructor
+      sharedL = lua_open();         // Create a new Lua interpreter; will be shutdown in the destructor
 
       // Failure here is likely to be something systemic, something bad.  Like smallpox.
-      if(!L)
+      if(!sharedL)
          throw LuaException("Could not instantiate the Lua interpreter.");
 
-      configureNewLuaInstance(L);   // Throws any errors it encounters
+      configureNewLuaInstance(sharedL);   // Throws any errors it encounters
 
       return true;
    }
@@ -402,8 +466,9 @@ bool LuaScriptRunner::startLua(const string &scriptingDir)
    {
       // Lua just isn't going to work out for this session.
       logprintf(LogConsumer::LogError, "=====FATAL LUA ERROR=====\n%s\n=========================", e.msg.c_str());
-      lua_close(L);
-      L = NULL;
+      if(sharedL)
+         lua_close(sharedL);
+      sharedL = NULL;
       return false;
    }
 
@@ -411,6 +476,32 @@ bool LuaScriptRunner::startLua(const string &scriptingDir)
 }
 
 
+// Create and configure a VM for a script that wants one of its own; startLua() must have been run first
+lua_State *LuaScriptRunner::createPrivateLuaState()
+{
+   lua_State *L = lua_open();
+
+   if(!L)
+   {
+      logprintf(LogConsumer::LogError, "Could not instantiate a Lua interpreter for a script.");
+      return NULL;
+   }
+
+   try
+   {
+      configureNewLuaInstance(L);
+   }
+   catch(const LuaException &e)
+   {
+      logprintf(LogConsumer::LogError, "Could not configure a Lua interpreter for a script: %s", e.msg.c_str());
+      lua_close(L);
+      return NULL;
+   }
+
+   return L;
+}
+
+
 // Prepare a new Lua environment ("L") for use -- called from startLua(), and testing.
 // This function will throw errors.  (Well, hopefully it won't, but it could!)
 void LuaScriptRunner::configureNewLuaInstance(lua_State *L)
@@ -424,10 +515,10 @@ void LuaScriptRunner::configureNewLuaInstance(lua_State *L)
    luaL_openlibs(L);    // Load the standard libraries
 
    // This allows the safe use of 'require' in our scripts
-   setModulePath();
+   setModulePath(L);
 
    // Register all our classes in the global namespace... they will be copied below when we copy the environment
-   registerClasses();            // Perform class and global function registration once per lua_State
+   registerClasses(L);           // Perform class and global function registration once per lua_State
    registerLooseFunctions(L);    // Register some functions not associated with a particular class
 
    // Set scads of global vars in the Lua instance that mimic the use of the enums we use everywhere.
@@ -436,34 +527,34 @@ void LuaScriptRunner::configureNewLuaInstance(lua_State *L)
    setGlobalObjectArrays(L);
 
    // Immediately execute the lua helper functions (these are global and need to be loaded before sandboxing)
-   loadCompileRunHelper("lua_helper_functions.lua");
+   loadCompileRunHelper(L, "lua_helper_functions.lua");
 
    // Load our vector library
-   loadCompileRunHelper("luavec.lua");
+   loadCompileRunHelper(L, "luavec.lua");
 
    // Load our helper functions and store copies of the compiled code in the registry where we can use them for starting new scripts
-   loadCompileSaveHelper("robot_helper_functions.lua",    ROBOT_HELPER_FUNCTIONS_KEY);
-   loadCompileSaveHelper("levelgen_helper_functions.lua", LEVELGEN_HELPER_FUNCTIONS_KEY);
-   loadCompileSaveHelper("timer.lua", SCRIPT_TIMER_KEY);
+   loadCompileSaveHelper(L, "robot_helper_functions.lua",    ROBOT_HELPER_FUNCTIONS_KEY);
+   loadCompileSaveHelper(L, "levelgen_helper_functions.lua", LEVELGEN_HELPER_FUNCTIONS_KEY);
+   loadCompileSaveHelper(L, "timer.lua", SCRIPT_TIMER_KEY);
 
 
    // Perform sandboxing now
    // Only code executed before this point can access dangerous functions
-   loadCompileRunHelper("sandbox.lua");
+   loadCompileRunHelper(L, "sandbox.lua");
 }
 
 
-void LuaScriptRunner::loadCompileSaveHelper(const string &scriptName, const char *registryKey)
+void LuaScriptRunner::loadCompileSaveHelper(lua_State *L, const string &scriptName, const char *registryKey)
 {
-   loadCompileSaveScript(joindir(mScriptingDir, scriptName).c_str(), registryKey);
+   loadCompileSaveScript(L, joindir(mScriptingDir, scriptName).c_str(), registryKey);
 }
 
 
 // Load a script from the scripting directory by basename (e.g. "my_script.lua").
 // Throws LuaException when there's an error compiling or running the script.
-void LuaScriptRunner::loadCompileRunHelper(const string &scriptName)
+void LuaScriptRunner::loadCompileRunHelper(lua_State *L, const string &scriptName)
 {
-   loadCompileScript(joindir(mScriptingDir, scriptName).c_str());
+   loadCompileScript(L, joindir(mScriptingDir, scriptName).c_str());
    if(lua_pcall(L, 0, 0, 0))
       throw LuaException("Error running " + scriptName + ": " + string(lua_tostring(L, -1)));
 }
@@ -471,16 +562,16 @@ void LuaScriptRunner::loadCompileRunHelper(const string &scriptName)
 
 // Load script from specified file, compile it, and store it in the registry.
 // All callers of this script have catch blocks, so we can throw errors if something goes wrong.
-void LuaScriptRunner::loadCompileSaveScript(const char *filename, const char *registryKey)
+void LuaScriptRunner::loadCompileSaveScript(lua_State *L, const char *filename, const char *registryKey)
 {
-   loadCompileScript(filename);                       // Throws if there is an error
+   loadCompileScript(L, filename);                    // Throws if there is an error
    lua_setfield(L, LUA_REGISTRYINDEX, registryKey);   // Save compiled code in registry
 }
 
 
 // Load script and place on top of the stack.
 // All callers of this script have catch blocks, so we can throw errors if something goes wrong.
-void LuaScriptRunner::loadCompileScript(const char *filename)
+void LuaScriptRunner::loadCompileScript(lua_State *L, const char *filename)
 {
    // luaL_loadfile: Loads a file as a Lua chunk. This function uses lua_load to load the chunk in the file named filename. 
    // If filename is NULL, then it loads from the standard input. The first line in the file is ignored if it starts with a #.
@@ -495,7 +586,7 @@ void LuaScriptRunner::loadCompileScript(const char *filename)
 
 
 // Delete script's environment from the registry -- actually set the registry entry to nil so the table can be collected
-void LuaScriptRunner::deleteScript(const char *name)
+void LuaScriptRunner::deleteScript(lua_State *L, const char *name)
 {
    // If a script is not found, or there is some other problem with the bot (or levelgen), we might get here before our L has been
    // set up.  If L hasn't been defined, there's no point in mucking with the registry, right?
@@ -509,6 +600,9 @@ void LuaScriptRunner::deleteScript(const char *name)
 
 bool LuaScriptRunner::prepareEnvironment()              
 {
+   if(!mHasPrivateLuaState)
+      L = GameContext::get()->mSharedL;     // Scripts can be created before Lua is started
+
    if(!L)
    {
       logprintf(LogConsumer::LogError, "%s %s.", getErrorMessagePrefix(), 
@@ -548,11 +642,11 @@ void LuaScriptRunner::logError(const char *format, ...)
    vsnprintf(buffer, sizeof(buffer), format, args);
    va_end(args);
 
-   logErrorHandler(buffer, getErrorMessagePrefix());
+   logErrorHandler(L, buffer, getErrorMessagePrefix());
 }
 
 
-void LuaScriptRunner::logErrorHandler(const char *msg, const char *prefix) 
+void LuaScriptRunner::logErrorHandler(lua_State *L, const char *msg, const char *prefix) 
 { 
    // Log the error to the logging system and also to the game console
    logprintf(LogConsumer::LogError, "%s %s", prefix, msg);
@@ -577,7 +671,7 @@ static string getStackTraceLine(lua_State *L, S32 level)
 */
 
 // Register classes needed by all script runners
-void LuaScriptRunner::registerClasses()
+void LuaScriptRunner::registerClasses(lua_State *L)
 {
    LuaW_Registrar::registerClasses(L);    // Register all objects that use our automatic registration scheme
 }
@@ -610,7 +704,7 @@ void LuaScriptRunner::setLuaArgs(const Vector<string> &args)
 
 
 // Set up paths so that we can use require to load code in our scripts 
-void LuaScriptRunner::setModulePath()   
+void LuaScriptRunner::setModulePath(lua_State *L)
 {
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack dirty!");
 
@@ -975,6 +1069,25 @@ void LuaScriptRunner::setGlobalObjectArrays(lua_State *L)
 GENERATE_LUA_FUNARGS_TABLE(LuaScriptRunner, LUA_METHODS);
 GENERATE_LUA_METHODS_TABLE(LuaScriptRunner, LUA_METHODS);
 
+// Loose functions are called through here so they get the same script lock as class methods
+static S32 callLooseFunction(lua_State *L)
+{
+   lua_CFunction function = lua_tocfunction(L, lua_upvalueindex(1));
+
+   if(!areScriptThreadsActive())
+      return function(L);
+
+   return callWithScriptLock(L, function);
+}
+
+
+static void pushLooseFunction(lua_State *L, lua_CFunction function)
+{
+   lua_pushcfunction(L, function);                 // -- fn
+   lua_pushcclosure(L, callLooseFunction, 1);      // -- closure
+}
+
+
 void LuaScriptRunner::registerLooseFunctions(lua_State *L)
 {
    ProfileMap moduleProfiles = LuaModuleRegistrarBase::getModuleProfiles();
@@ -988,7 +1101,7 @@ void LuaScriptRunner::registerLooseFunctions(lua_State *L)
          for(U32 i = 0; i < profiles.size(); i++)
          {
             LuaStaticFunctionProfile &profile = profiles[i];
-            lua_pushcfunction(L, profile.function);                 // -- fn
+            pushLooseFunction(L, profile.function);                 // -- fn
             lua_setglobal(L, profile.functionName);                 // --
          }
       }
@@ -1000,7 +1113,7 @@ void LuaScriptRunner::registerLooseFunctions(lua_State *L)
          for(U32 i = 0; i < profiles.size(); i++)
          {
             LuaStaticFunctionProfile &profile = profiles[i];
-            lua_pushcfunction(L, profile.function);                 // -- table, fn
+            pushLooseFunction(L, profile.function);                 // -- table, fn
             lua_setfield(L, -2, profile.functionName);              // -- table
          }
          lua_setglobal(L, (*it).first.c_str());                     // --
@@ -1105,7 +1218,7 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
    TNLAssert(mLevel != NULL, "Grid Database must not be NULL!");
 
    fillVector.clear();
-   static Vector<U8> types;
+   static ThreadLocalVector<U8> types;
 
    types.clear();
 
@@ -1131,7 +1244,7 @@ S32 LuaScriptRunner::lua_findAllObjects(lua_State *L)
    else
    {
       mLevel->findObjects(types, fillVector);
-      results = &fillVector;
+      results = &fillVector.get();
    }
    
    TNLAssert(lua_gettop(L) == 0 || dumpStack(L), "Stack not cleared!");
@@ -1173,7 +1286,7 @@ S32 LuaScriptRunner::lua_findAllObjectsInArea(lua_State *L)
 
    TNLAssert(mLevel != NULL, "Grid Database must not be NULL!");
 
-   static Vector<U8> types;
+   static ThreadLocalVector<U8> types;
 
    types.clear();
    fillVector.clear();
@@ -47,23 +47,22 @@ class LuaScriptRunner
 {
 
 private:
-   static deque<string> mCachedScripts;
-
+   // The shared Lua state and its script cache belong to the game being hosted; see GameContext
    static string mScriptingDir;
 
    void setLuaArgs(const Vector<string> &args);
-   static void setModulePath();
+   static void setModulePath(lua_State *L);
 
-   static void loadCompileSaveHelper(const string &scriptName, const char *registryKey);
-   static void loadCompileRunHelper(const string &scriptName);
-   static void loadCompileSaveScript(const char *filename, const char *registryKey);
-   static void loadCompileScript(const char *filename);
+   static void loadCompileSaveHelper(lua_State *L, const string &scriptName, const char *registryKey);
+   static void loadCompileRunHelper(lua_State *L, const string &scriptName);
+   static void loadCompileSaveScript(lua_State *L, const char *filename, const char *registryKey);
+   static void loadCompileScript(lua_State *L, const char *filename);
 
    void pushStackTracer();      // Put error handler function onto the stack
 
    static void setEnums(lua_State *L);                       // Set a whole slew of enum values that we want the scripts to have access to
    static void setGlobalObjectArrays(lua_State *L);          // And some objects
-   static void logErrorHandler(const char *msg, const char *prefix);
+   static void logErrorHandler(lua_State *L, const char *msg, const char *prefix);
 
 protected:
    enum ScriptType {
@@ -81,7 +80,8 @@ protected:
 
    Level *mLevel;                // Pointer to our current level
 
-   static lua_State *L;          // Main Lua state variable
+   lua_State *L;                 // Lua state this script runs in; the shared one unless usePrivateLuaState() was called
+   bool mHasPrivateLuaState;
    string mScriptName;           // Fully qualified script name, with path and everything
    Vector<string> mScriptArgs;   // List of arguments passed to the script
 
@@ -94,12 +94,12 @@ protected:
    virtual bool prepareEnvironment();
 
    static int luaPanicked(lua_State *L);  // Handle a total freakout by Lua
-   static void registerClasses();
+   static void registerClasses(lua_State *L);
    void setEnvironment();                 // Sets the environment for the function on the top of the stack to that associated with name
 
    bool loadCompileRunEnvironmentScript(const string &scriptName);
 
-   static void deleteScript(const char *name);  // Remove saved script from the Lua registry
+   static void deleteScript(lua_State *L, const char *name);  // Remove saved script from the Lua registry
 
    static void registerLooseFunctions(lua_State *L);   // Register some functions not associated with a particular class
 
@@ -140,6 +140,11 @@ public:
    static void shutdown();                            // Delete L
 
    static void configureNewLuaInstance(lua_State *L);    // Prepare a new Lua environment for use
+   static lua_State *createPrivateLuaState();            // Returns NULL if the new state couldn't be configured
+
+   bool usePrivateLuaState();                            // Switch this script to a VM of its own; call before runScript()
+   bool hasPrivateLuaState() const;
+   lua_State *getLuaState() const;
 
    bool runString(const string &code);
    bool runMain();                                    // Run a script's main() function
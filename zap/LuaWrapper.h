@@ -84,6 +84,14 @@ inline int luaW_correctindex(lua_State* L, int index, int correction)
 template <class T> class LuaProxy;
 
 
+// Identifies the Lua VM that L belongs to; coroutines share the registry of the state that created them.
+// An object pushed into several VMs gets one proxy per VM.
+inline const void *luaW_getVmKey(lua_State* L)
+{
+   return lua_topointer(L, LUA_REGISTRYINDEX);
+}
+
+
 // Here we will specify whether to use our proxy system for objects managed in LuaW
 // or use (mostly) upstream behavior
 inline bool luaW_shouldCreateProxy(lua_State* L)
@@ -244,7 +252,7 @@ void luaW_setUsingProxy(lua_State* L, T* obj, bool usingProxy)
    // will contain the proxy for proxied object otherwise it contains the object itself
    if(usingProxy)
    {
-      LuaProxy<T> *proxy = obj->getLuaProxy();
+      LuaProxy<T> *proxy = obj->getLuaProxy(L);
       lua_pushlightuserdata(L, proxy);                // -- ... usingproxy_table, &proxy
    }
    else
@@ -386,8 +394,11 @@ void luaW_push(lua_State* L, T* obj)
    // Should we be using proxies for our objects?
    if(luaW_shouldCreateProxy(L))
    {
+      // Proxy lists are shared between VMs, so they can only be touched by one script thread at a time
+      lockLuaProxies();
+
       // Get the object's proxy, or create one if it doesn't yet exist
-      LuaProxy<T> *proxy = obj->getLuaProxy();
+      LuaProxy<T> *proxy = obj->getLuaProxy(L);
 
       if(proxy)         // Retrieve the userdata for this proxy from our cache table
       {
@@ -410,7 +421,7 @@ void luaW_push(lua_State* L, T* obj)
       else
       {
          // Create a new proxy
-         proxy = new LuaProxy<T>(obj);
+         proxy = new LuaProxy<T>(obj, L);
 
          // Add a new entry to our cache table (a weak table; more about those here: http://lua-users.org/wiki/WeakTablesTutorial).
          // Note that from here on down, we'll fall back on the normal LuaW push code, except for the bit at the end where
@@ -441,6 +452,8 @@ void luaW_push(lua_State* L, T* obj)
          luaW_setUsingProxy(L, obj, true);
          luaW_hold<T>(L, obj);     // Tell luaW to collect the proxy when it's done with it
       }
+
+      unlockLuaProxies();
    }  // useLuaProxy
 
    // No proxy: Use upstream behavior
@@ -575,11 +588,20 @@ inline int luaW_new(lua_State* L, int args)
 }
 
 template <typename T>
-int luaW_new(lua_State* L)
+int luaW_newUnlocked(lua_State* L)
 {
     return luaW_new<T>(L, lua_gettop(L));
 }
 
+template <typename T>
+int luaW_new(lua_State* L)
+{
+    if(!areScriptThreadsActive())
+        return luaW_newUnlocked<T>(L);
+
+    return callWithScriptLock(L, luaW_newUnlocked<T>);
+}
+
 // This function is called from Lua, not C++
 //
 // The default metamethod to call when indexing into lua userdata representing
@@ -674,8 +696,11 @@ int luaW_gc(lua_State* L)
       LuaProxy<T>* proxy = luaW_toProxy<T>(L, 1);
       TNLAssert(proxy, "Expected a proxy!");
 
+      // Deleting a proxy unlinks it from its object's proxy list
+      lockLuaProxies();
       if(proxy)
          delete proxy;
+      unlockLuaProxies();
    }
 
    // Else we're not using proxies, handle the object with the upstream code.
@@ -728,6 +753,21 @@ inline void luaW_registerfuncs(lua_State* L, const luaL_Reg defaulttable[], cons
 #endif
 }
 
+// Like luaW_registerfuncs, but each method gets an upvalue saying whether it is read-only, which luaW_doMethod
+// uses to pick the script lock it needs
+inline void luaW_registermethods(lua_State* L, const luaL_Reg table[])
+{
+    if (!table)
+        return;
+
+    for (; table->name; table++)
+    {
+        lua_pushboolean(L, isReadOnlyScriptCall(table->name)); // ... T readonly
+        lua_pushcclosure(L, table->func, 1); // ... T func
+        lua_setfield(L, -2, table->name); // ... T
+    }
+}
+
 // Initializes the LuaWrapper tables used to track internal state. 
 //
 // This function is only called from LuaWrapper internally. 
@@ -862,7 +902,8 @@ void luaW_setfuncs(lua_State* L, const char* classname, const luaL_Reg* table,
     luaL_newmetatable(L, classname); // ... T mt
     lua_newtable(L); // ... T mt {}
     lua_setfield(L, -2, LUAW_EXTENDS_KEY); // ... T mt
-    luaW_registerfuncs(L, defaultmetatable, metatable); // ... T mt
+    luaW_registerfuncs(L, defaultmetatable, NULL); // ... T mt
+    luaW_registermethods(L, metatable); // ... T mt
     lua_setfield(L, -2, "metatable"); // ... T
 }
 
@@ -1155,21 +1196,26 @@ public:
 
 
 
+// Each object keeps a singly linked list of proxies, one for every VM it has been pushed into
 template <class T>
 class LuaProxy
 {
 private:
     bool mDefunct;
     T *mProxiedObject;
+    const void *mVmKey;
+    LuaProxy<T> *mNextProxy;
 
 public:
     // Default constructor
     LuaProxy() { TNLAssert(false, "Not used"); }
 
     // Typical constructor
-    explicit LuaProxy(T *obj)
+    LuaProxy(T *obj, lua_State *L)
     {
       mProxiedObject = obj;
+      mVmKey = luaW_getVmKey(L);
+      mNextProxy = obj->mLuaProxy;
       obj->setLuaProxy(this);
       mDefunct = false;
     }
@@ -1177,18 +1223,53 @@ public:
    // Destructor
    ~LuaProxy()
    {
-      if(!mDefunct)
-         mProxiedObject->mLuaProxy = NULL;
+      if(mDefunct)
+         return;
+
+      LuaProxy<T> **link = &mProxiedObject->mLuaProxy;
+      while(*link && *link != this)
+         link = &(*link)->mNextProxy;
+
+      if(*link)
+         *link = mNextProxy;
+   }
+
+
+   // Returns the proxy in the list starting at first that belongs to L's VM, or NULL
+   static LuaProxy<T> *find(LuaProxy<T> *first, lua_State *L)
+   {
+      const void *vmKey = luaW_getVmKey(L);
+
+      for(LuaProxy<T> *proxy = first; proxy; proxy = proxy->mNextProxy)
+         if(proxy->mVmKey == vmKey)
+            return proxy;
+
+      return NULL;
    }
 
 
    T   *getProxiedObject() { return mProxiedObject; }
    bool isDefunct()        { return mDefunct;       }
 
+   LuaProxy<T> *getNextProxy() { return mNextProxy; }
+
    void setDefunct(bool isDefunct) { mDefunct = isDefunct; }
 };
 
 
+// Marks every proxy of a dying object as defunct; Lua will collect them later
+template <class T>
+void luaW_setProxiesDefunct(LuaProxy<T> *first)
+{
+   lockLuaProxies();
+
+   for(LuaProxy<T> *proxy = first; proxy; proxy = proxy->getNextProxy())
+      proxy->setDefunct(true);
+
+   unlockLuaProxies();
+}
+
+
 // This goes in the constructor of the "wrapped class"
 #define LUAW_CONSTRUCTOR_INITIALIZATIONS \
    mLuaProxy = NULL
@@ -1202,21 +1283,21 @@ public:
 // instantiated and accessed from Lua (pushed from c++)
 #define  LUAW_DECLARE_CLASS_CUSTOM_CONSTRUCTOR(className) \
    LuaProxy<className> *mLuaProxy; \
-   LuaProxy<className> *getLuaProxy() { return mLuaProxy; } \
+   LuaProxy<className> *getLuaProxy(lua_State *L) { return LuaProxy<className>::find(mLuaProxy, L); } \
    virtual void setLuaProxy(LuaProxy<className> *obj) { mLuaProxy = obj; } \
    virtual void push(lua_State *L) { luaW_push(L, this); }
 
 // This one is for an abstract class and cannot be instantiated or returned as an object in Lua
 #define  LUAW_DECLARE_ABSTRACT_CLASS(className) \
    LuaProxy<className> *mLuaProxy; \
-   LuaProxy<className> *getLuaProxy() { return mLuaProxy; } \
+   LuaProxy<className> *getLuaProxy(lua_State *L) { return LuaProxy<className>::find(mLuaProxy, L); } \
    virtual void setLuaProxy(LuaProxy<className> *obj) { mLuaProxy = obj; } \
    className(lua_State *L) { THROW_LUA_EXCEPTION(L, "Illegal attempt to instantiate abstract class!"); }
 
 // This is used for a class that you want to access (return as an object) but NOT instantiated (like PlayerInfo)
 #define  LUAW_DECLARE_NON_INSTANTIABLE_CLASS(className) \
    LuaProxy<className> *mLuaProxy; \
-   LuaProxy<className> *getLuaProxy() { return mLuaProxy; } \
+   LuaProxy<className> *getLuaProxy(lua_State *L) { return LuaProxy<className>::find(mLuaProxy, L); } \
    virtual void setLuaProxy(LuaProxy<className> *obj) { mLuaProxy = obj; } \
    virtual void push(lua_State *L) { luaW_push(L, this); } \
    className(lua_State *L) { THROW_LUA_EXCEPTION(L, "Illegal attempt to instantiate a non-instantiable class!"); }
@@ -1232,14 +1313,14 @@ public:
 
 // And this goes in the destructor of the "wrapped class"
 #define LUAW_DESTRUCTOR_CLEANUP \
-   if(mLuaProxy) mLuaProxy->setDefunct(true)
+   luaW_setProxiesDefunct(mLuaProxy)
 
 
 
 // Runs a method on a proxied object.  Returns nil if the proxied object no longer exists, so Lua scripts may need to check for this.
 // Wraps a standard method (one that takes L as a single parameter) within a proxy check. 
 template <typename T, int (T::*methodName)(lua_State * )>
-int luaW_doMethod(lua_State *L)
+int luaW_doMethodUnlocked(lua_State *L)
 {
    T *w = luaW_check<T>(L, 1);
    if(w) 
@@ -1252,6 +1333,17 @@ int luaW_doMethod(lua_State *L)
    return 1;
 }
 
+// When robot scripts are running in parallel, methods touch shared game state, so they take turns.  Read-only
+// methods are registered with a true upvalue (see luaW_registermethods) and only have to keep writers out.
+template <typename T, int (T::*methodName)(lua_State * )>
+int luaW_doMethod(lua_State *L)
+{
+   if(!areScriptThreadsActive())
+      return luaW_doMethodUnlocked<T, methodName>(L);
+
+   return callWithScriptLock(L, luaW_doMethodUnlocked<T, methodName>, lua_toboolean(L, lua_upvalueindex(1)) != 0);
+}
+
 /*
  * Copyright (c) 2010-2013 Alexander Ames
  *
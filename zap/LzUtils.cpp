@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "LzUtils.h"
+
+#include <string.h>
+
+namespace Lz
+{
+
+// A block is a series of sequences.  Each starts with a token byte whose high nibble is a count of literal bytes and
+// low nibble a match length, less MinMatch.  A nibble of 15 means more length follows, in bytes that are added on
+// until one isn't 255.  Then come the literals, then a 2 byte little-endian offset back to the match, then any more
+// match length.  The last sequence stops after its literals.
+
+static const U32 MinMatch = 4;
+static const U32 MaxOffset = 65535;
+static const U32 HashBits = 14;
+
+
+static U32 read32(const U8 *src)
+{
+   U32 value;
+   memcpy(&value, src, 4);    // Only compared and hashed, so byte order doesn't matter
+   return value;
+}
+
+
+static U32 hash(U32 value)
+{
+   return (value * 2654435761u) >> (32 - HashBits);
+}
+
+
+static U8 *writeLength(U8 *dest, U32 length)
+{
+   while(length >= 255)
+   {
+      *dest++ = 255;
+      length -= 255;
+   }
+
+   *dest++ = U8(length);
+   return dest;
+}
+
+
+// A matchLength of 0 writes the last sequence, which is only literals
+static U8 *writeSequence(U8 *dest, const U8 *literals, U32 literalLength, U32 offset, U32 matchLength)
+{
+   U8 *token = dest++;
+
+   *token = U8((literalLength < 15 ? literalLength : 15) << 4);
+   if(literalLength >= 15)
+      dest = writeLength(dest, literalLength - 15);
+
+   memcpy(dest, literals, literalLength);
+   dest += literalLength;
+
+   if(matchLength == 0)
+      return dest;
+
+   dest[0] = U8(offset);
+   dest[1] = U8(offset >> 8);
+   dest += 2;
+
+   U32 code = matchLength - MinMatch;
+
+   *token |= U8(code < 15 ? code : 15);
+   if(code >= 15)
+      dest = writeLength(dest, code - 15);
+
+   return dest;
+}
+
+
+static bool readLength(const U8 *&src, const U8 *srcEnd, U32 &length)
+{
+   while(src < srcEnd)
+   {
+      U8 byte = *src++;
+      length += byte;
+
+      if(byte != 255)
+         return true;
+   }
+
+   return false;
+}
+
+
+U32 getMaxCompressedSize(U32 size)
+{
+   return size + size / 255 + 16;
+}
+
+
+U32 compress(const U8 *src, U32 size, U8 *dest)
+{
+   U32 table[1 << HashBits];     // Last place each hash of 4 bytes was seen
+   memset(table, 0, sizeof(table));
+
+   U8 *out = dest;
+   U32 pos = 0;
+   U32 anchor = 0;               // Start of the literals not yet written
+
+   while(pos + MinMatch <= size)
+   {
+      U32 value = read32(&src[pos]);
+      U32 slot = hash(value);
+      U32 candidate = table[slot];
+      table[slot] = pos;
+
+      if(candidate >= pos || pos - candidate > MaxOffset || read32(&src[candidate]) != value)
+      {
+         pos += 1 + ((pos - anchor) >> 6);      // Move faster through data that isn't compressing
+         continue;
+      }
+
+      U32 length = MinMatch;
+      while(pos + length < size && src[candidate + length] == src[pos + length])
+         length++;
+
+      while(pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1])
+      {
+         pos--;
+         candidate--;
+         length++;
+      }
+
+      out = writeSequence(out, &src[anchor], pos - anchor, pos - candidate, length);
+
+      pos += length;
+      anchor = pos;
+
+      if(pos + 2 <= size)
+         table[hash(read32(&src[pos - 2]))] = pos - 2;
+   }
+
+   out = writeSequence(out, &src[anchor], size - anchor, 0, 0);
+
+   return U32(out - dest);
+}
+
+
+bool decompress(const U8 *src, U32 size, U8 *dest, U32 destSize)
+{
+   const U8 *srcEnd = src + size;
+   U8 *out = dest;
+   U8 *outEnd = dest + destSize;
+
+   while(src < srcEnd)
+   {
+      U32 token = *src++;
+
+      U32 literalLength = token >> 4;
+      if(literalLength == 15 && !readLength(src, srcEnd, literalLength))
+         return false;
+
+      if(literalLength > U32(srcEnd - src) || literalLength > U32(outEnd - out))
+         return false;
+
+      memcpy(out, src, literalLength);
+      src += literalLength;
+      out += literalLength;
+
+      if(src == srcEnd)
+         break;
+
+      if(srcEnd - src < 2)
+         return false;
+
+      U32 offset = U32(src[0]) | (U32(src[1]) << 8);
+      src += 2;
+
+      if(offset == 0 || offset > U32(out - dest))
+         return false;
+
+      U32 matchLength = token & 15;
+      if(matchLength == 15 && !readLength(src, srcEnd, matchLength))
+         return false;
+
+      matchLength += MinMatch;
+      if(matchLength > U32(outEnd - out))
+         return false;
+
+      // Byte at a time, as a match can overlap what it's copying
+      const U8 *match = out - offset;
+      for(U32 i = 0; i < matchLength; i++)
+         out[i] = match[i];
+
+      out += matchLength;
+   }
+
+   return out == outEnd;
+}
+
+
+}
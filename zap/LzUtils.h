@@ -0,0 +1,32 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+// A small LZ77 codec in the style of LZ4, so the dedicated server can compress things without another library.  Fast
+// rather than tight; each call compresses one self-contained block.
+
+#ifndef LZ_UTILS_H
+#define LZ_UTILS_H
+
+#include "tnlTypes.h"
+
+namespace Lz
+{
+
+using TNL::U8;
+using TNL::U32;
+
+// Largest size compress() can produce for size bytes of input; dest must have room for this much
+U32 getMaxCompressedSize(U32 size);
+
+// Compresses size bytes from src into dest, and returns the compressed size
+U32 compress(const U8 *src, U32 size, U8 *dest);
+
+// Decompresses a block made by compress() into dest, which must be exactly as big as what was compressed.  Returns
+// false if the block is damaged.
+bool decompress(const U8 *src, U32 size, U8 *dest, U32 destSize);
+
+}
+
+#endif
@@ -385,9 +385,9 @@ bool NexusGameType::isNexusOpen() const
 
 
 // Runs on the server
-void NexusGameType::onGhostAvailable(GhostConnection *theConnection)
+void NexusGameType::sendGameState(GhostConnection *theConnection)
 {
-   Parent::onGhostAvailable(theConnection);
+   Parent::sendGameState(theConnection);
 
    NetObject::setRPCDestConnection(theConnection);
 
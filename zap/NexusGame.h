@@ -79,7 +79,7 @@ public:
 
    void addNexus(NexusZone *theObject);
    void shipTouchNexus(Ship *ship, NexusZone *nexus);
-   void onGhostAvailable(GhostConnection *connection);
+   void sendGameState(GhostConnection *connection);
    void idle(BfObject::IdleCallPath path, U32 deltaT);
 
    void releaseFlag(const Point &pos, const Point &vel = Point(0,0), S32 count = 1);
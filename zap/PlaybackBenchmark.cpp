@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "PlaybackBenchmark.h"
+
+#include "ClientGame.h"
+#include "GameRecorderPlayback.h"
+
+#include "tnlLog.h"
+#include "tnlNetBase.h"
+#include "tnlPlatform.h"
+
+namespace Zap
+{
+
+// Constructor
+PlaybackBenchmarkResults::PlaybackBenchmarkResults()
+{
+   recordedTime = 0;
+   ticks = 0;
+   packets = 0;
+   bytes = 0;
+   totalTime = 0;
+   tickP50 = 0;
+   tickP99 = 0;
+   tickMax = 0;
+   allocations = -1;
+}
+
+
+F64 PlaybackBenchmarkResults::getPacketsPerSecond() const
+{
+   return totalTime > 0 ? packets * 1000 / totalTime : 0;
+}
+
+
+void PlaybackBenchmarkResults::log() const
+{
+   logprintf("Playback benchmark: %s", filename.c_str());
+   logprintf("  %d s of game, %d ticks, %d packets (%d bytes) in %g ms -- %g packets per second",
+             recordedTime / 1000, ticks, packets, bytes, totalTime, getPacketsPerSecond());
+   logprintf("  Per tick: p50 %g ms, p99 %g ms, max %g ms", tickP50, tickP99, tickMax);
+
+   if(allocations >= 0)
+      logprintf("  Allocations: %.0f (%g per tick)", F64(allocations), ticks ? F64(allocations) / ticks : 0);
+
+   for(S32 i = 0; i < classCosts.size(); i++)
+      logprintf("  %-32s %8d unpacked, %10d bits, %8.2f ms, %6.2f us each", classCosts[i].className.c_str(),
+                classCosts[i].count, classCosts[i].bits, classCosts[i].time, classCosts[i].time * 1000 / classCosts[i].count);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+static S32 QSORT_CALLBACK tickTimeSort(F64 *a, F64 *b)
+{
+   return *a < *b ? -1 : *a > *b ? 1 : 0;
+}
+
+
+static S32 QSORT_CALLBACK classCostSort(PlaybackClassCost *a, PlaybackClassCost *b)
+{
+   return a->time > b->time ? -1 : a->time < b->time ? 1 : 0;
+}
+
+
+static F64 getPercentile(const Vector<F64> &sortedTimes, S32 percentile)
+{
+   if(sortedTimes.size() == 0)
+      return 0;
+
+   return sortedTimes[(sortedTimes.size() - 1) * percentile / 100];
+}
+
+
+// Adds up what unpacking cost for every class of ghost and event that was unpacked
+static void getClassCosts(Vector<PlaybackClassCost> &classCosts)
+{
+   const NetClassType types[] = { NetClassTypeObject, NetClassTypeEvent };
+
+   for(U32 i = 0; i < ARRAYSIZE(types); i++)
+      for(U32 j = 0; j < NetClassRep::getNetClassCount(NetClassGroupGame, types[i]); j++)
+      {
+         NetClassRep *classRep = NetClassRep::getClass(NetClassGroupGame, types[i], j);
+
+         if(classRep->getUnpackCount() == 0)
+            continue;
+
+         PlaybackClassCost cost;
+         cost.className = classRep->getClassName();
+         cost.count = classRep->getUnpackCount();
+         cost.bits = classRep->getUnpackBitsRead();
+         cost.time = Platform::getHighPrecisionMilliseconds(classRep->getUnpackTime());
+
+         classCosts.push_back(cost);
+      }
+
+   classCosts.sort(classCostSort);
+}
+
+
+// Constructor
+PlaybackBenchmark::PlaybackBenchmark(ClientGame *game, U32 tickLength)
+{
+   mGame = game;
+   mTickLength = tickLength;
+   mAllocationCounter = NULL;
+}
+
+
+// Lets us report allocations; counter is whatever the caller bumps in operator new
+void PlaybackBenchmark::setAllocationCounter(const U64 *counter)
+{
+   mAllocationCounter = counter;
+}
+
+
+// Plays filename from start to finish on our ClientGame, which should have no other connection to a server.  Returns
+// false if the file can't be played.
+bool PlaybackBenchmark::run(const string &filename, PlaybackBenchmarkResults &results)
+{
+   GameRecorderPlayback *playback = new GameRecorderPlayback(mGame, filename.c_str());
+
+   if(!playback->isValid())
+   {
+      delete playback;
+      return false;
+   }
+
+   mGame->setConnectionToServer(playback);
+
+   results = PlaybackBenchmarkResults();
+   results.filename = filename;
+   results.recordedTime = playback->mTotalTime;
+
+   Vector<F64> tickTimes(playback->mTotalTime / mTickLength + 1);
+
+   NetClassRep::resetUnpackStats();
+   NetClassRep::mCollectUnpackStats = true;
+
+   U64 startAllocations = mAllocationCounter ? *mAllocationCounter : 0;
+   S64 start = Platform::getHighPrecisionTimerValue();
+
+   // Run past the end, so the last packet is read
+   for(U32 elapsed = 0; elapsed <= playback->mTotalTime; elapsed += mTickLength)
+   {
+      S64 tickStart = Platform::getHighPrecisionTimerValue();
+      playback->processMoreData(mTickLength);
+      tickTimes.push_back(Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - tickStart));
+   }
+
+   results.totalTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - start);
+
+   if(mAllocationCounter)
+      results.allocations = S64(*mAllocationCounter - startAllocations);
+
+   NetClassRep::mCollectUnpackStats = false;
+
+   results.ticks = tickTimes.size();
+   results.packets = playback->mPacketRecvCount;
+   results.bytes = playback->mPacketRecvBytesTotal;
+
+   tickTimes.sort(tickTimeSort);
+   results.tickP50 = getPercentile(tickTimes, 50);
+   results.tickP99 = getPercentile(tickTimes, 99);
+   results.tickMax = getPercentile(tickTimes, 100);
+
+   getClassCosts(results.classCosts);
+
+   delete playback;     // Takes its ghosts with it, and clears the game's connection
+   mGame->clearClientList();
+
+   return true;
+}
+
+
+};
@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _PLAYBACK_BENCHMARK_H_
+#define _PLAYBACK_BENCHMARK_H_
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+#include <string>
+
+using namespace TNL;
+using namespace std;
+
+namespace Zap
+{
+
+class ClientGame;
+
+struct PlaybackClassCost
+{
+   string className;
+   U32 count;           // Ghost updates or events unpacked
+   U32 bits;
+   F64 time;            // ms
+};
+
+
+struct PlaybackBenchmarkResults
+{
+   string filename;
+   U32 recordedTime;    // ms of game in the recording
+   U32 ticks;
+   U32 packets;
+   U32 bytes;
+   F64 totalTime;       // ms it took to play it all
+   F64 tickP50;         // ms per tick
+   F64 tickP99;
+   F64 tickMax;
+   S64 allocations;     // -1 if nobody was counting
+   Vector<PlaybackClassCost> classCosts;     // Most expensive first
+
+   PlaybackBenchmarkResults();      // Constructor
+
+   F64 getPacketsPerSecond() const;
+   void log() const;
+};
+
+
+// Plays a recorded game through the client as fast as it will go, with nothing rendered or heard, and measures what
+// that costs: reading packets, unpacking ghosts and events, and idling objects.  Real games are the most
+// representative load we have, so this is how we catch client-side slowdowns in any of those.
+class PlaybackBenchmark
+{
+private:
+   ClientGame *mGame;
+   U32 mTickLength;
+   const U64 *mAllocationCounter;
+
+public:
+   static const U32 DefaultTickLength = 16;     // ms, about what a client gets at 60 fps
+
+   explicit PlaybackBenchmark(ClientGame *game, U32 tickLength = DefaultTickLength);    // Constructor
+
+   void setAllocationCounter(const U64 *counter);
+
+   bool run(const string &filename, PlaybackBenchmarkResults &results);
+};
+
+
+};
+
+#endif
@@ -36,18 +36,19 @@ namespace Zap
 {
 
 
-static bool instantiated;           // Just a little something to keep us from creating multiple ServerGames...
+static ThreadLocal<bool> instantiated;    // Just a little something to keep us from creating multiple ServerGames on one thread...
 
 
 // Constructor -- be sure to see Game constructor too!  Lots going on there!
 ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSourcePtr levelSource, bool testMode, bool dedicated, bool hostOnServer) : 
       Game(address, settings),
+      mDatabaseForBotZones(SpatialIndex::LooseQuadtree),
       mRobotManager(this, settings)
 {
-   TNLAssert(!instantiated, "Only one ServerGame at a time, please!  If this trips while testing, "
+   TNLAssert(!instantiated.get(), "Only one ServerGame at a time, please!  If this trips while testing, "
       "it is probably because a test failed before another instance could be deleted.  Try disabling "
       "this assert, see what test fails, and fix it.  Then re-enable it, please!");
-   instantiated = true;
+   instantiated.get() = true;
 
    mLevelSource = levelSource;
 
@@ -93,8 +94,16 @@ ServerGame::ServerGame(const Address &address, GameSettingsPtr settings, LevelSo
    mTestMode = testMode;
 
    mNetInterface->setAllowsConnections(true);
+   mNetInterface->setWorkerThreadCount(mSettings->getSetting<U32>(IniKey::NetWorkerThreads));
+   EventManager::get()->setScriptThreadCount(mSettings->getSetting<U32>(IniKey::RobotScriptThreads));
    mMasterUpdateTimer.reset(UpdateServerStatusTime);
 
+   mPrevStatusLevelType = NoGameType;
+   mPrevStatusRobotCount = 0;
+   mPrevStatusPlayerCount = -1;           // Forces our first update
+
+   mUpdatesBanList = true;
+
    // How long will teams stay locked after last admin departs?
    mNoAdminAutoUnlockTeamsTimer.setPeriod(TeamHistoryManager::LockedTeamsNoAdminsGracePeriod);
 
@@ -131,9 +140,10 @@ ServerGame::~ServerGame()
    if(getConnectionToMaster())   // Prevents errors when ServerGame is gone too soon
       getConnectionToMaster()->disconnect(NetConnection::ReasonSelfDisconnect, "");
 
+   mLevelPreloader.cancel();
    cleanUp();
 
-   instantiated = false;
+   instantiated.get() = false;
 
    delete mGameInfo;
 
@@ -259,6 +269,12 @@ LevelInfo ServerGame::getLevelInfo(S32 index)
 }
 
 
+LevelSourcePtr ServerGame::getLevelSource() const
+{
+   return mLevelSource;
+}
+
+
 // Creates a set of LevelInfos that are empty except for the filename.  They will be fleshed out later.
 // This gets called when you first load the host menu
 //void ServerGame::buildBasicLevelInfoList(const Vector<string> &levelList)
@@ -484,6 +500,105 @@ void ServerGame::makeEmptyLevelIfNoGameType()
 
 // Clear, prepare, and load the level given by the index \nextLevel. This
 // function respects meta-indices, and otherwise expects an absolute index.
+// Report how long building packets took over the last level, if we are doing it on worker threads
+void ServerGame::logPacketBuildStats()
+{
+   const NetInterface::PacketBuildStats &stats = mNetInterface->getPacketBuildStats();
+
+   if(stats.passes == 0)
+      return;
+
+   logprintf(LogConsumer::ServerFilter, "Packet building with %d worker threads: %d passes, %d packets; "
+             "avg ms per pass: prepare %.3f, scope %.3f, bookkeeping %.3f, prioritize %.3f, write %.3f",
+             mNetInterface->getWorkerThreadCount(), stats.passes, stats.packets,
+             stats.prepareTime / stats.passes, stats.scopeTime / stats.passes, stats.bookkeepingTime / stats.passes,
+             stats.prioritizeTime / stats.passes, stats.writeTime / stats.passes);
+
+   mNetInterface->resetPacketBuildStats();
+}
+
+
+void ServerGame::logRobotTickStats()
+{
+   const EventManager::TickStats &stats = EventManager::get()->getTickStats();
+
+   if(stats.ticks == 0)
+      return;
+
+   logprintf(LogConsumer::ServerFilter, "Script ticks with %d worker threads: %d ticks, %d onTick calls; avg ms per tick %.3f",
+             EventManager::get()->getScriptThreadCount(), stats.ticks, stats.handlers, stats.scriptTime / stats.ticks);
+
+   EventManager::get()->resetTickStats();
+}
+
+
+// Report where the time went getting the level we just loaded into play
+void ServerGame::logLevelLoadStats()
+{
+   const LevelLoadStats &stats = mLevelLoadStats;
+
+   logprintf(LogConsumer::ServerFilter, "Level load took %.1f ms on the game thread (%s): parse %.1f%s, waiting for preload %.1f, "
+             "walls %.1f, objects %.1f, levelgens %.1f, bot zones %.1f%s (%d zones)",
+             stats.gameThreadTime, stats.preloaded ? "preloaded" : "not preloaded",
+             stats.parseTime, stats.preloaded ? " in background" : "", stats.waitTime,
+             stats.wallTime, stats.objectTime, stats.levelgenTime,
+             stats.botZoneStats.getTotalTime(), stats.preloadedBotZones && !stats.ranLevelgens ? " in background" : "",
+             stats.botZoneStats.zoneCount);
+}
+
+
+// Zones are only triangulated when someone might want to look at them
+bool ServerGame::getTriangulateBotZones() const
+{
+#ifdef ZAP_DEDICATED
+   return false;
+#else
+   return !isDedicated();
+#endif
+}
+
+
+// Build bot zones from the walls, turrets, forcefield projectors, and teleporters in the current level
+void ServerGame::buildBotZones()
+{
+   fillVector.clear();
+   mLevel->findObjects(TeleporterTypeNumber, fillVector);
+
+   Vector<pair<Point, const Vector<Point> *> > teleporterData(fillVector.size());
+   pair<Point, const Vector<Point> *> teldat;
+
+   for(S32 i = 0; i < fillVector.size(); i++)
+   {
+      Teleporter *teleporter = static_cast<Teleporter *>(fillVector[i]);
+
+      teldat.first  = teleporter->getPos();
+      teldat.second = teleporter->getDestList();
+
+      teleporterData.push_back(teldat);
+   }
+
+   // Get our parameters together
+   Vector<DatabaseObject *> barrierList;
+   getLevel()->findObjects((TestFunc)isWallType, barrierList, *getWorldExtents());
+
+   Vector<DatabaseObject *> turretList;
+   getLevel()->findObjects(TurretTypeNumber, turretList, *getWorldExtents());
+
+   Vector<DatabaseObject *> forceFieldProjectorList;
+   getLevel()->findObjects(ForceFieldProjectorTypeNumber, forceFieldProjectorList, *getWorldExtents());
+
+   // Try and load Bot Zones for this level, set flag if failed
+   // We need to run buildBotMeshZones in order to set mAllZones properly, which is why I (sort of) disabled the use of hand-built zones in level files
+   TNLAssert(getGameType(), "Expect to have a GameType here!");
+   getGameType()->mBotZoneCreationFailed = !BotNavMeshZone::buildBotMeshZones(mLevel->getBotZoneDatabase(), mLevel->getBotZoneList(),
+                                                                              getWorldExtents(), barrierList, turretList,
+                                                                              forceFieldProjectorList, teleporterData, getTriangulateBotZones(),
+                                                                              &mLevelLoadStats.botZoneStats);
+   if(!getGameType()->mBotZoneCreationFailed)
+      getGameType()->botZoneNextHops.build(mLevel->getBotZoneList());
+}
+
+
 void ServerGame::cycleLevel(S32 nextLevel)
 {
    if(mHostOnServer)
@@ -526,6 +641,9 @@ void ServerGame::cycleLevel(S32 nextLevel)
    delete mGameRecorderServer;
    mGameRecorderServer = NULL;
 
+   logPacketBuildStats();
+   logRobotTickStats();
+
    // If mLevel is NULL, it's our first time here, and there won't be anything to clean up
    if(mLevel)
       cleanUp();
@@ -551,6 +669,8 @@ void ServerGame::cycleLevel(S32 nextLevel)
 
    mRobotManager.onLevelChanged();
 
+   S64 loadStartTime = Platform::getHighPrecisionTimerValue();
+
    if(!loadNextLevel(nextLevel))
       return;
 
@@ -558,47 +678,13 @@ void ServerGame::cycleLevel(S32 nextLevel)
       mGameRecorderServer = new GameRecorderServer(this);
 
 
-   ////// This block could easily be moved off somewhere else   
-   fillVector.clear();
-   mLevel->findObjects(TeleporterTypeNumber, fillVector);
-
-   Vector<pair<Point, const Vector<Point> *> > teleporterData(fillVector.size());
-   pair<Point, const Vector<Point> *> teldat;
-
-   for(S32 i = 0; i < fillVector.size(); i++)
-   {
-      Teleporter *teleporter = static_cast<Teleporter *>(fillVector[i]);
-
-      teldat.first  = teleporter->getPos();
-      teldat.second = teleporter->getDestList();
+   // Zones built along with a preloaded level are good as long as no levelgen has been at its walls since
+   if(!mLevelLoadStats.preloadedBotZones || mLevelLoadStats.ranLevelgens)
+      buildBotZones();
 
-      teleporterData.push_back(teldat);
-   }
+   mLevelLoadStats.gameThreadTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - loadStartTime);
+   logLevelLoadStats();
 
-   // Get our parameters together
-   Vector<DatabaseObject *> barrierList;
-   getLevel()->findObjects((TestFunc)isWallType, barrierList, *getWorldExtents());
-
-   Vector<DatabaseObject *> turretList;
-   getLevel()->findObjects(TurretTypeNumber, turretList, *getWorldExtents());
-
-   Vector<DatabaseObject *> forceFieldProjectorList;
-   getLevel()->findObjects(ForceFieldProjectorTypeNumber, forceFieldProjectorList, *getWorldExtents());
-
-   bool triangulate;
-
-   // Try and load Bot Zones for this level, set flag if failed
-   // We need to run buildBotMeshZones in order to set mAllZones properly, which is why I (sort of) disabled the use of hand-built zones in level files
-#ifdef ZAP_DEDICATED
-   triangulate = false;
-#else
-   triangulate = !isDedicated();
-#endif
-
-   TNLAssert(getGameType(), "Expect to have a GameType here!");
-   getGameType()->mBotZoneCreationFailed = !BotNavMeshZone::buildBotMeshZones(mLevel->getBotZoneDatabase(), mLevel->getBotZoneList(),
-                                                                              getWorldExtents(), barrierList, turretList,
-                                                                              forceFieldProjectorList, teleporterData, triangulate);
    // Clear team info for all clients
    resetAllClientTeams();
 
@@ -663,6 +749,32 @@ void ServerGame::cycleLevel(S32 nextLevel)
    sendLevelStatsToMaster();     // Give the master some information about this level for its database
 
    suspendIfNoActivePlayers();   // Does nothing if we're already suspended
+
+   preloadNextLevel();
+}
+
+
+// Start loading the level we expect to play next on the preloading thread, so it's ready when this one ends.  If
+// something else gets played instead, the preloaded level is just thrown away.
+void ServerGame::preloadNextLevel()
+{
+   // Levels from a hoster show up when they're needed, and test mode only ever plays one level
+   if(mTestMode || mHostOnServer || mShuttingDown || mLevelSource->getLevelCount() == 0)
+      return;
+
+   if(!getSettings()->getSetting<YesNo>(IniKey::PreloadLevels))
+      return;
+
+   S32 nextLevel = getAbsoluteLevelIndex(getSettings()->getSetting<YesNo>(IniKey::RandomLevels) ? +RANDOM_LEVEL : +NEXT_LEVEL);
+
+   string filename, levelCode;
+   if(!mLevelSource->getLevelOrigin(nextLevel, filename, levelCode))
+      return;
+
+   // Global levelgens run on every level, and can change its walls, so zones have to wait until they've run
+   bool buildBotZones = getSettings()->getSetting<string>(IniKey::GlobalLevelScript) == "";
+
+   mLevelPreloader.start(nextLevel, filename, levelCode, buildBotZones, getTriangulateBotZones());
 }
 
 
@@ -673,7 +785,13 @@ bool ServerGame::loadNextLevel(S32 nextLevel)
 
    while(!loaded)
    {
-      mCurrentLevelIndex = getAbsoluteLevelIndex(nextLevel); // Set mCurrentLevelIndex to refer to the next level we'll play
+      // Set mCurrentLevelIndex to refer to the next level we'll play.  If we preloaded a random level, that's the one.
+      S32 preloadedIndex = mLevelPreloader.getLevelIndex();
+
+      if(nextLevel == RANDOM_LEVEL && preloadedIndex >= 0 && preloadedIndex < mLevelSource->getLevelCount())
+         mCurrentLevelIndex = preloadedIndex;
+      else
+         mCurrentLevelIndex = getAbsoluteLevelIndex(nextLevel);
 
       logprintf(LogConsumer::ServerFilter, "Loading %s [%s]... \\", getLevelNameFromIndex(mCurrentLevelIndex).getString(),
          mLevelSource->getLevelFileDescriptor(mCurrentLevelIndex).c_str());
@@ -721,7 +839,25 @@ bool ServerGame::loadNextLevel(S32 nextLevel)
 // Returns true if the level is successfully loaded, false if it wasn't
 bool ServerGame::loadLevel()
 {
-   mLevel = boost::shared_ptr<Level>(mLevelSource->getLevel(mCurrentLevelIndex));
+   S64 startTime = Platform::getHighPrecisionTimerValue();
+
+   mLevelLoadStats = LevelLoadStats();
+
+   Level *level = NULL;
+   string filename, levelCode;
+
+   if(mLevelSource->getLevelOrigin(mCurrentLevelIndex, filename, levelCode))
+      level = mLevelPreloader.claim(mCurrentLevelIndex, filename, levelCode, mLevelLoadStats);
+
+   if(!level)
+   {
+      mLevelPreloader.cancel();     // Whatever was preloaded won't be played next
+
+      level = mLevelSource->getLevel(mCurrentLevelIndex);
+      mLevelLoadStats.parseTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - startTime);
+   }
+
+   mLevel = boost::shared_ptr<Level>(level);
 
    TNLAssert(!mLevel->getAddedToGame(), "Can't reuse Levels!");
 
@@ -737,16 +873,23 @@ bool ServerGame::loadLevel()
 
 
    // Add walls first, so engineered items will have something to snap to
+   startTime = Platform::getHighPrecisionTimerValue();
+
    Vector<DatabaseObject *> walls;
    mLevel->findObjects(WallItemTypeNumber, walls);
 
    for(S32 i = 0; i < walls.size(); i++)
       addWallItem(static_cast<WallItem *>(walls[i]), NULL);        // Just does this --> Barrier::constructBarriers(this, *wallItem->getOutline(), false, wallItem->getWidth());
 
+   // A preloaded level's wall edges were built when it was parsed, and adding it to the game hasn't changed them
+   if(!mLevelLoadStats.preloaded)
+   {
+      Vector<Point> points;
+      mLevel->buildWallEdgeGeometry(points);
+   }
 
-   Vector<Point> points;
-   mLevel->buildWallEdgeGeometry(points);
-
+   mLevelLoadStats.wallTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - startTime);
+   startTime = Platform::getHighPrecisionTimerValue();
 
    const Vector<DatabaseObject *> objects = *mLevel->findObjects_fast();
    for(S32 i = 0; i < objects.size(); i++)
@@ -767,6 +910,9 @@ bool ServerGame::loadLevel()
 
    mLevel->addBots(this);
 
+   mLevelLoadStats.objectTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - startTime);
+   startTime = Platform::getHighPrecisionTimerValue();
+
    // Levelgens:
    // Run level's levelgen script (if any)
    runLevelGenScript(getGameType()->getScriptName());
@@ -778,6 +924,9 @@ bool ServerGame::loadLevel()
    for(S32 i = 0; i < scriptList.size(); i++)
       runLevelGenScript(scriptList[i]);
 
+   mLevelLoadStats.ranLevelgens = getGameType()->getScriptName() != "" || scriptList.size() > 0;
+   mLevelLoadStats.levelgenTime = Platform::getHighPrecisionMilliseconds(Platform::getHighPrecisionTimerValue() - startTime);
+
    // Fire an update to make sure certain events run on level start (like onShipSpawned)
    EventManager::get()->update();
 
@@ -1450,6 +1599,12 @@ bool ServerGame::isServer() const
 }
 
 
+void ServerGame::setUpdatesBanList(bool updatesBanList)
+{
+   mUpdatesBanList = updatesBanList;
+}
+
+
 // Top-level idle loop for server, runs only on the server by definition
 void ServerGame::idle(U32 timeDelta)
 {
@@ -1480,7 +1635,8 @@ void ServerGame::idle(U32 timeDelta)
    mNetInterface->checkIncomingPackets();
    checkConnectionToMaster(timeDelta);                   // Connect to master server if not connected
 
-   mSettings->getBanList()->updateKickList(timeDelta);   // Unban players who's bans have expired
+   if(mUpdatesBanList)
+      mSettings->getBanList()->updateKickList(timeDelta);   // Unban players who's bans have expired
 
    // Periodically update our status on the master, so they know what we're doing...
    if(mMasterUpdateTimer.update(timeDelta))
@@ -1506,6 +1662,8 @@ void ServerGame::idle(U32 timeDelta)
 
    if(mGameSuspended)     // If game is suspended, we need do nothing more
    {
+      if(mLevel && mLevel->getGameType())
+         mLevel->getGameType()->updateTeamScopeSets();
       mNetInterface->processConnections();
       return;
    }
@@ -1539,8 +1697,8 @@ void ServerGame::idle(U32 timeDelta)
    }
 
    // Compute new world extents -- these might change if a ship flies far away, for example...
-   // In practice, we could probably just set it and forget it when we load a level.
    // Compute it here to save recomputing it for every robot and other method that relies on it.
+   // Cheap: the database caches the extents of things that don't move, and only visits the things that do.
    computeWorldObjectExtents();
 
    U32 botControlTickElapsed = botControlTickTimer.getElapsed();
@@ -1625,6 +1783,7 @@ void ServerGame::idle(U32 timeDelta)
    mTeamHistoryManager.idle(timeDelta);
 
    // Update to other clients right after idling everything else, so clients get more up to date information
+   getGameType()->updateTeamScopeSets();
    mNetInterface->processConnections(); 
 }
 
@@ -1850,28 +2009,23 @@ void ServerGame::updateStatusOnMaster()
 {
    MasterServerConnection *masterConn = getConnectionToMaster();
 
-   static string prevCurrentLevelName;      // Using static, so it holds the value when it comes back here
-   static GameTypeId prevCurrentLevelType;
-   static S32 prevRobotCount;
-   static S32 prevPlayerCount;
-
    if(masterConn && masterConn->isEstablished())
    {
       // Only update if something is different
-      if(prevCurrentLevelName != getGameType()->getLevelName() ||
-         prevCurrentLevelType != getGameType()->getGameTypeId() ||
-         prevRobotCount       != getRobotCount() ||
-         prevPlayerCount      != getPlayerCount())
+      if(mPrevStatusLevelName   != getGameType()->getLevelName() ||
+         mPrevStatusLevelType   != getGameType()->getGameTypeId() ||
+         mPrevStatusRobotCount  != getRobotCount() ||
+         mPrevStatusPlayerCount != getPlayerCount())
       {
-         prevCurrentLevelName = getGameType()->getLevelName();
-         prevCurrentLevelType = getGameType()->getGameTypeId();
-         prevRobotCount       = getRobotCount();
-         prevPlayerCount      = getPlayerCount();
-
-         masterConn->updateServerStatus(StringTableEntry(prevCurrentLevelName.c_str()), 
-                                        GameType::getGameTypeName(prevCurrentLevelType), 
-                                        prevRobotCount, 
-                                        prevPlayerCount, 
+         mPrevStatusLevelName   = getGameType()->getLevelName();
+         mPrevStatusLevelType   = getGameType()->getGameTypeId();
+         mPrevStatusRobotCount  = getRobotCount();
+         mPrevStatusPlayerCount = getPlayerCount();
+
+         masterConn->updateServerStatus(StringTableEntry(mPrevStatusLevelName.c_str()), 
+                                        GameType::getGameTypeName(mPrevStatusLevelType), 
+                                        mPrevStatusRobotCount, 
+                                        mPrevStatusPlayerCount, 
                                         mSettings->getMaxPlayers(), 
                                         mInfoFlags);
 
@@ -1882,7 +2036,7 @@ void ServerGame::updateStatusOnMaster()
    }
    else
    {
-      prevPlayerCount = -1;   // Not sure if needed, but if we're disconnected, we need to update to master when we reconnect
+      mPrevStatusPlayerCount = -1;   // Not sure if needed, but if we're disconnected, we need to update to master when we reconnect
       mMasterUpdateTimer.reset(CheckServerStatusTime);
    }
 }
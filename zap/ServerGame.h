@@ -10,6 +10,7 @@
 
 #include "BotNavMeshZone.h"
 #include "dataConnection.h"
+#include "LevelPreloader.h"
 #include "LevelSource.h"         // For LevelSourcePtr def
 #include "LevelSpecifierEnum.h"
 #include "RobotManager.h"
@@ -57,6 +58,14 @@ private:
    Timer mLevelSwitchTimer;               // Track how long after game has ended before we actually switch levels
    Timer mMasterUpdateTimer;              // Periodically let the master know how we're doing
 
+   // What we last told the master, so we only send changes
+   string mPrevStatusLevelName;
+   GameTypeId mPrevStatusLevelType;
+   S32 mPrevStatusRobotCount;
+   S32 mPrevStatusPlayerCount;
+
+   bool mUpdatesBanList;                  // Expire kicks and bans as we idle; only one game in a process should
+
    bool mShuttingDown;
    string mShutdownReason;                // Message to local user about why we're shutting down, optional
 
@@ -77,6 +86,9 @@ private:
 
    TeamHistoryManager mTeamHistoryManager;
 
+   LevelPreloader mLevelPreloader;        // Loads the next level while this one is played
+   LevelLoadStats mLevelLoadStats;        // How long getting the current level going took
+
 public:
    bool mHostOnServer;
    SafePtr<GameConnection> mHoster;
@@ -113,6 +125,9 @@ private:
    void cleanUp();
    bool loadNextLevel(S32 nextLevel);                 // Find the next valid level, and load it with loadLevel()
    bool loadLevel();                                  // Load the level pointed to by mCurrentLevelIndex
+   void preloadNextLevel();                           // Start loading the level we'll probably play next
+   void buildBotZones();
+   bool getTriangulateBotZones() const;
    void runLevelGenScript(const string &scriptName);  // Run any levelgens specified by the level or in the INI
 
    AbstractTeam *getNewTeam();
@@ -181,6 +196,9 @@ public:
    void receivedLevelFromHoster(S32 levelIndex, const string &filename);
    void makeEmptyLevelIfNoGameType();
    void cycleLevel(S32 newLevelIndex = NEXT_LEVEL);
+   void logPacketBuildStats();
+   void logRobotTickStats();
+   void logLevelLoadStats();
    void sendLevelStatsToMaster();
 
    void onConnectedToMaster();
@@ -220,6 +238,7 @@ public:
    StringTableEntry getCurrentLevelTypeName();     // Return name of type of level currently in play
 
    bool isServer() const;
+   void setUpdatesBanList(bool updatesBanList);    // Games sharing a GameSettings should leave this to one of them
    void idle(U32 timeDelta);
    bool isReadyToShutdown(U32 timeDelta, string &shutdownReason);
    void gameEnded();
@@ -227,6 +246,7 @@ public:
    S32 getCurrentLevelIndex();
    S32 getLevelCount();
    LevelInfo getLevelInfo(S32 index);
+   LevelSourcePtr getLevelSource() const;
    void clearLevelInfos();
    void sendLevelListToLevelChangers(const string &message = "");
 
@@ -0,0 +1,168 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "ServerShard.h"
+
+#include "ClientInfo.h"
+#include "EventManager.h"
+#include "gameConnection.h"
+#include "GameManager.h"
+#include "LuaScriptRunner.h"
+#include "ServerGame.h"
+
+#include "tnlLog.h"
+#include "tnlPlatform.h"
+
+namespace Zap
+{
+
+// Constructor
+ServerShard::ShardThread::ShardThread(ServerShard *shard)
+{
+   mShard = shard;
+}
+
+
+U32 ServerShard::ShardThread::run()
+{
+   ServerShard *shard = mShard;
+
+   ThreadContext::setCurrent(&shard->mContext);
+
+   // Our scripts get a VM of their own; see GameContext
+   if(LuaScriptRunner::startLua(GameSettings::getFolderManager()->getLuaDir()))
+      shard->host();
+   else
+      logprintf(LogConsumer::LogError, "Could not start Lua for game %d; it will not be hosted", shard->mIndex);
+
+   GameManager::deleteServerGame();
+   EventManager::shutdown();
+   LuaScriptRunner::shutdown();
+
+   ThreadContext::setCurrent(NULL);
+
+   shard->mDoneSemaphore.increment();     // We may be deleted as soon as we signal
+
+   return 0;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+ServerShard::ServerShard(S32 index, const Address &address, GameSettingsPtr settings, LevelSourcePtr levelSource)
+{
+   mStopped = false;
+
+   mIndex = index;
+   mAddress = address;
+   mSettings = settings;
+   mLevelSource = levelSource;
+}
+
+
+// Destructor
+ServerShard::~ServerShard()
+{
+   stop();
+}
+
+
+// Returns false if the thread couldn't be started
+bool ServerShard::start()
+{
+   TNLAssert(mThread.isNull(), "Shard already started!");
+
+   mThread = new ShardThread(this);
+
+   if(!mThread->start())
+   {
+      logprintf(LogConsumer::LogError, "Could not start thread for game %d", mIndex);
+      mThread = NULL;
+      return false;
+   }
+
+   return true;
+}
+
+
+void ServerShard::stop()
+{
+   if(mThread.isNull() || mStopped)
+      return;
+
+   mStopSemaphore.increment();
+   mDoneSemaphore.wait();     // Returns right away if the game already shut itself down
+
+   mStopped = true;
+}
+
+
+// Our version of the main thread's idle loop: the same frame pacing, without all the client bits
+void ServerShard::host()
+{
+   ServerGame *serverGame = new ServerGame(mAddress, mSettings, mLevelSource, false, true);
+
+   serverGame->setUpdatesBanList(false);     // The main game does that
+   GameManager::setServerGame(serverGame);
+   serverGame->setReadyToConnectToMaster(true);
+
+   if(!serverGame->startHosting())
+   {
+      logprintf(LogConsumer::LogError, "Game %d could not start hosting", mIndex);
+      return;
+   }
+
+   logprintf(LogConsumer::ServerFilter, "Game %d hosting on %s", mIndex, mAddress.toString());
+
+   U32 maxFPS = mSettings->getSetting<U32>(IniKey::MaxFpsServer);
+
+   S32 deltaT = 0;
+   U32 prevTimer = Platform::getRealMilliseconds();
+
+   while(true)
+   {
+      U32 currentTimer = Platform::getRealMilliseconds();
+      deltaT += currentTimer - prevTimer;    // Time elapsed since previous tick
+      prevTimer = currentTimer;
+
+      // Do some sanity checks
+      if(deltaT < -500 || deltaT > 5000)
+         deltaT = 10;
+
+      // If user specifies 0, run full-bore!
+      if(maxFPS == 0 || deltaT >= S32(1000 / maxFPS))
+      {
+         string shutdownReason;
+         if(serverGame->isReadyToShutdown(U32(deltaT), shutdownReason))
+         {
+            logprintf(LogConsumer::ServerFilter, "Game %d shut down", mIndex);
+            break;
+         }
+
+         serverGame->idle(U32(deltaT));
+         deltaT = 0;
+      }
+
+      // Same as the main loop: sleep longer when nobody is playing.  Waiting on the semaphore instead of sleeping
+      // means stop() doesn't have to wait for us to notice.
+      if(mStopSemaphore.wait(serverGame->isSuspended() ? 40 : 1))
+         break;
+   }
+
+   // Unlike the main game, we usually stop with players still connected; let them go while the game can still
+   // handle them leaving, rather than from the middle of its destructor
+   for(S32 i = serverGame->getClientCount() - 1; i >= 0; i--)
+   {
+      ClientInfo *clientInfo = serverGame->getClientInfo(i);
+
+      if(!clientInfo->isRobot() && clientInfo->getConnection())
+         clientInfo->getConnection()->disconnect(NetConnection::ReasonShutdown, "");
+   }
+}
+
+
+};
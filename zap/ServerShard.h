@@ -0,0 +1,69 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _SERVER_SHARD_H_
+#define _SERVER_SHARD_H_
+
+#include "GameContext.h"
+#include "GameSettings.h"     // For GameSettingsPtr def
+#include "LevelSource.h"      // For LevelSourcePtr def
+
+#include "tnlThread.h"
+#include "tnlUDP.h"
+
+using namespace TNL;
+
+namespace Zap
+{
+
+// Hosts one of the extra games of a dedicated server started with ServerShards > 1.  Each shard runs its own
+// ServerGame on its own thread, listening on its own port, with its own GameContext, so its EventManager and Lua
+// VM are its own too.  The settings, level list and ban list are shared with the main game, which is still hosted
+// by the main thread; the main game ticks the ban list for everyone.
+//
+// While any shard is running the StringTable is in threaded mode, which costs every game, the main one included, a
+// mutex lock on each StringTableEntry it creates, copies or drops, and puts off compacting the table until the last
+// shard has stopped.
+class ServerShard
+{
+private:
+   class ShardThread : public Thread
+   {
+   private:
+      ServerShard *mShard;
+
+   public:
+      explicit ShardThread(ServerShard *shard);    // Constructor
+      U32 run();
+   };
+
+   friend class ShardThread;
+
+   RefPtr<ShardThread> mThread;
+   Semaphore mStopSemaphore;        // Signaled by the main thread to make the shard stop; the shard waits on it between ticks
+   Semaphore mDoneSemaphore;        // Signaled by the thread once its game is gone
+   bool mStopped;                   // We've already waited for the thread
+
+   GameContext mContext;            // Current on the shard's thread for as long as it runs
+
+   S32 mIndex;                      // 1 for the first extra game; the main game is 0
+   Address mAddress;
+   GameSettingsPtr mSettings;
+   LevelSourcePtr mLevelSource;
+
+   void host();                     // Runs on the shard's thread
+
+public:
+   ServerShard(S32 index, const Address &address, GameSettingsPtr settings, LevelSourcePtr levelSource);   // Constructor
+   virtual ~ServerShard();          // Destructor
+
+   bool start();
+   void stop();                     // Shuts the game down, and waits for it to go
+};
+
+
+};
+
+#endif
@@ -0,0 +1,536 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#include "SpatialIndex.h"
+
+#include "tnlAssert.h"
+
+#include <math.h>
+
+
+namespace Zap
+{
+
+// Rect::intersects() is not const, and we need to use it on const rects
+static bool overlaps(const Rect &a, const Rect &b)
+{
+   return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+          a.min.y <= b.max.y && a.max.y >= b.min.y;
+}
+
+
+// Remove a single object from an unordered list
+static void eraseFromCell(SpatialCell &cell, DatabaseObject *object)
+{
+   for(S32 i = 0; i < cell.size(); i++)
+      if(cell[i] == object)
+      {
+         cell.erase_fast(i);
+         return;
+      }
+
+   TNLAssert(false, "Object not found in spatial index!");
+}
+
+
+// Destructor
+SpatialIndex::~SpatialIndex()
+{
+   // Do nothing
+}
+
+
+SpatialIndex *SpatialIndex::create(IndexType type)
+{
+   if(type == LooseQuadtree)
+      return new Zap::LooseQuadtree();
+
+   return new Zap::SparseHashGrid();
+}
+
+
+// Default implementation; subclasses can do better if they know the object will land in the same place
+void SpatialIndex::update(DatabaseObject *object, const Rect &oldExtents, const Rect &newExtents)
+{
+   remove(object, oldExtents);
+   insert(object, newExtents);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Keep coords well inside S32 range so we can safely shift them, even if someone passes a crazy extent
+static S32 clampCoord(F32 coord)
+{
+   static const F32 MaxCoord = F32(1 << 30);
+
+   if(coord >  MaxCoord) return  S32(MaxCoord);
+   if(coord < -MaxCoord) return -S32(MaxCoord);
+
+   return S32(floor(coord));
+}
+
+
+// Constructor
+SparseHashGrid::Cell::Cell()
+{
+   x = 0;
+   y = 0;
+   used = false;
+}
+
+
+// Constructor
+SparseHashGrid::SparseHashGrid()
+{
+   mCellSizeBitShift = DefaultCellSizeBitShift;
+   mUsedCellCount = 0;
+   mCells.resize(64);
+}
+
+
+// Destructor
+SparseHashGrid::~SparseHashGrid()
+{
+   // Do nothing
+}
+
+
+SpatialIndex::IndexType SparseHashGrid::getType() const
+{
+   return SpatialIndex::SparseHashGrid;
+}
+
+
+S32 SparseHashGrid::getCellSize() const
+{
+   return 1 << mCellSizeBitShift;
+}
+
+
+S32 SparseHashGrid::getUsedCellCount() const
+{
+   return mUsedCellCount;
+}
+
+
+// Translates extents into range of cells to search
+void SparseHashGrid::getCellRange(const Rect &extents, IntRect &range) const
+{
+   range.minx = clampCoord(extents.min.x) >> mCellSizeBitShift;
+   range.miny = clampCoord(extents.min.y) >> mCellSizeBitShift;
+   range.maxx = clampCoord(extents.max.x) >> mCellSizeBitShift;
+   range.maxy = clampCoord(extents.max.y) >> mCellSizeBitShift;
+}
+
+
+bool SparseHashGrid::isOversize(const IntRect &range) const
+{
+   S32 width  = range.maxx - range.minx + 1;
+   S32 height = range.maxy - range.miny + 1;
+
+   return width > MaxCellsPerObject || height > MaxCellsPerObject || width * height > MaxCellsPerObject;
+}
+
+
+static inline U32 hashCell(S32 x, S32 y)
+{
+   return (U32(x) * 73856093u) ^ (U32(y) * 19349663u);
+}
+
+
+S32 SparseHashGrid::findCellIndex(S32 x, S32 y) const
+{
+   U32 mask = mCells.size() - 1;
+
+   for(U32 i = hashCell(x, y) & mask; ; i = (i + 1) & mask)
+   {
+      const Cell &cell = mCells[i];
+
+      if(!cell.used)
+         return -1;
+
+      if(cell.x == x && cell.y == y)
+         return i;
+   }
+}
+
+
+SparseHashGrid::Cell *SparseHashGrid::findOrCreateCell(S32 x, S32 y)
+{
+   // Keep load factor under 1/2 so probe chains stay short
+   if((mUsedCellCount + 1) * 2 > mCells.size())
+      growTable();
+
+   U32 mask = mCells.size() - 1;
+
+   for(U32 i = hashCell(x, y) & mask; ; i = (i + 1) & mask)
+   {
+      Cell &cell = mCells[i];
+
+      if(!cell.used)
+      {
+         cell.used = true;
+         cell.x = x;
+         cell.y = y;
+         mUsedCellCount++;
+         return &cell;
+      }
+
+      if(cell.x == x && cell.y == y)
+         return &cell;
+   }
+}
+
+
+// Frees a cell that no longer holds anything, so roaming objects don't leave a trail of empty cells behind them.
+// Uses backward-shift deletion: later cells in the probe chain that could live in the freed slot are moved up, so
+// lookups never need tombstones.  Their object lists are swapped, not copied, and the emptied list's storage stays
+// in the table for the next cell created there.
+void SparseHashGrid::releaseCell(S32 index)
+{
+   U32 mask = mCells.size() - 1;
+   U32 hole = index;
+
+   for(U32 i = (hole + 1) & mask; mCells[i].used; i = (i + 1) & mask)
+   {
+      U32 home = hashCell(mCells[i].x, mCells[i].y) & mask;
+
+      // Cell i can only move back to the hole if its home slot is not cyclically in (hole, i]
+      bool homeBetween = hole <= i ? (home > hole && home <= i) : (home > hole || home <= i);
+      if(homeBetween)
+         continue;
+
+      mCells[hole].x = mCells[i].x;
+      mCells[hole].y = mCells[i].y;
+      mCells[hole].objects.getStlVector().swap(mCells[i].objects.getStlVector());
+      hole = i;
+   }
+
+   mCells[hole].used = false;
+   mUsedCellCount--;
+}
+
+
+// Double the size of our hash table, moving object lists rather than copying them
+void SparseHashGrid::growTable()
+{
+   Vector<Cell> oldCells;
+   oldCells.getStlVector().swap(mCells.getStlVector());
+
+   mCells.resize(oldCells.size() * 2);
+   mUsedCellCount = 0;
+
+   for(S32 i = 0; i < oldCells.size(); i++)
+   {
+      if(!oldCells[i].used)
+         continue;
+
+      Cell *cell = findOrCreateCell(oldCells[i].x, oldCells[i].y);
+      cell->objects.getStlVector().swap(oldCells[i].objects.getStlVector());
+   }
+}
+
+
+void SparseHashGrid::insert(DatabaseObject *object, const Rect &extents)
+{
+   IntRect range;
+   getCellRange(extents, range);
+
+   if(isOversize(range))
+   {
+      mOversize.push_back(object);
+      return;
+   }
+
+   // Don't use x <= maxx, it will endless loop if maxx = S32_MAX and x overflows
+   for(S32 x = range.minx; range.maxx - x >= 0; x++)
+      for(S32 y = range.miny; range.maxy - y >= 0; y++)
+         findOrCreateCell(x, y)->objects.push_back(object);
+}
+
+
+void SparseHashGrid::remove(DatabaseObject *object, const Rect &extents)
+{
+   IntRect range;
+   getCellRange(extents, range);
+
+   if(isOversize(range))
+   {
+      eraseFromCell(mOversize, object);
+      return;
+   }
+
+   for(S32 x = range.minx; range.maxx - x >= 0; x++)
+      for(S32 y = range.miny; range.maxy - y >= 0; y++)
+      {
+         S32 index = findCellIndex(x, y);
+         TNLAssert(index != -1, "Object's cell is missing!");
+
+         if(index != -1)
+         {
+            eraseFromCell(mCells[index].objects, object);
+
+            if(mCells[index].objects.size() == 0)
+               releaseCell(index);
+         }
+      }
+}
+
+
+// Most moves don't cross a cell boundary, so check that before doing any real work
+void SparseHashGrid::update(DatabaseObject *object, const Rect &oldExtents, const Rect &newExtents)
+{
+   IntRect oldRange, newRange;
+   getCellRange(oldExtents, oldRange);
+   getCellRange(newExtents, newRange);
+
+   if(oldRange.minx == newRange.minx && oldRange.miny == newRange.miny &&
+      oldRange.maxx == newRange.maxx && oldRange.maxy == newRange.maxy)
+      return;
+
+   Parent::update(object, oldExtents, newExtents);
+}
+
+
+void SparseHashGrid::clear()
+{
+   mCells.clear();
+   mCells.resize(64);
+   mUsedCellCount = 0;
+   mOversize.clear();
+}
+
+
+// Pick a cell size that keeps the world to roughly 128 cells across, but never smaller than the default,
+// and presize the hash table so a typical level never needs to rehash
+void SparseHashGrid::setWorldExtents(const Rect &extents)
+{
+   TNLAssert(mUsedCellCount == 0 && mOversize.size() == 0, "Index should be empty when resizing!");
+
+   F32 maxDim = max(extents.getWidth(), extents.getHeight());
+
+   mCellSizeBitShift = DefaultCellSizeBitShift;
+   while(mCellSizeBitShift < 16 && maxDim / F32(1 << mCellSizeBitShift) > 128)
+      mCellSizeBitShift++;
+
+   IntRect range;
+   getCellRange(extents, range);
+
+   U32 cellCount = U32(range.maxx - range.minx + 1) * U32(range.maxy - range.miny + 1);
+   cellCount = min(cellCount, U32(1 << 16));
+
+   mCells.clear();
+   mCells.resize(max(getNextPow2(cellCount * 2), U32(64)));
+   mUsedCellCount = 0;
+}
+
+
+void SparseHashGrid::findCells(const Rect &extents, Vector<const SpatialCell *> &cells) const
+{
+   if(mOversize.size() > 0)
+      cells.push_back(&mOversize);
+
+   IntRect range;
+   getCellRange(extents, range);
+
+   // Coords are clamped to +/- 2^30 cells, so these fit in a U64, and so does their product
+   U64 width  = U64(S64(range.maxx) - S64(range.minx) + 1);
+   U64 height = U64(S64(range.maxy) - S64(range.miny) + 1);
+
+   // If the query covers more cells than we have allocated, it's cheaper to just check the ones we have
+   if(isOversize(range) && width * height > U64(mUsedCellCount))
+   {
+      for(S32 i = 0; i < mCells.size(); i++)
+      {
+         const Cell &cell = mCells[i];
+         if(cell.used && cell.objects.size() > 0 &&
+            cell.x >= range.minx && cell.x <= range.maxx && cell.y >= range.miny && cell.y <= range.maxy)
+            cells.push_back(&cell.objects);
+      }
+
+      return;
+   }
+
+   for(S32 x = range.minx; range.maxx - x >= 0; x++)
+      for(S32 y = range.miny; range.maxy - y >= 0; y++)
+      {
+         S32 index = findCellIndex(x, y);
+         if(index != -1 && mCells[index].objects.size() > 0)
+            cells.push_back(&mCells[index].objects);
+      }
+}
+
+
+void SparseHashGrid::findAllCells(Vector<const SpatialCell *> &cells) const
+{
+   if(mOversize.size() > 0)
+      cells.push_back(&mOversize);
+
+   for(S32 i = 0; i < mCells.size(); i++)
+      if(mCells[i].used && mCells[i].objects.size() > 0)
+         cells.push_back(&mCells[i].objects);
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Constructor
+LooseQuadtree::Node::Node()
+{
+   for(S32 i = 0; i < 4; i++)
+      children[i] = -1;
+}
+
+
+// Constructor
+LooseQuadtree::LooseQuadtree()
+{
+   setWorldExtents(Rect(-4096, -4096, 4096, 4096));     // Reasonable default until we know better
+}
+
+
+// Destructor
+LooseQuadtree::~LooseQuadtree()
+{
+   // Do nothing
+}
+
+
+SpatialIndex::IndexType LooseQuadtree::getType() const
+{
+   return SpatialIndex::LooseQuadtree;
+}
+
+
+// Tight bounds are passed in; node stores loose bounds, which are the tight bounds grown by half their size on all sides
+S32 LooseQuadtree::createNode(const Rect &tightBounds)
+{
+   Node node;
+   node.looseBounds = tightBounds;
+   node.looseBounds.expand(Point(tightBounds.getWidth() / 2, tightBounds.getHeight() / 2));
+
+   mNodes.push_back(node);
+   return mNodes.size() - 1;
+}
+
+
+// Walk down from the root, picking the quadrant that holds the object's center, until the next level down would be
+// too small to hold the object within its loose bounds
+S32 LooseQuadtree::findNode(const Rect &extents, bool create)
+{
+   Point center = extents.getCenter();
+   F32 size = max(extents.getWidth(), extents.getHeight());
+
+   if(center.x < mRootBounds.min.x || center.x > mRootBounds.max.x ||
+      center.y < mRootBounds.min.y || center.y > mRootBounds.max.y)
+      return 0;
+
+   S32 nodeIndex = 0;
+   Rect tight = mRootBounds;
+
+   for(S32 depth = 0; depth < MaxDepth; depth++)
+   {
+      F32 childSize = tight.getWidth() / 2;
+
+      if(size > childSize)
+         break;
+
+      Point mid = tight.getCenter();
+      S32 quadrant = (center.x < mid.x ? 0 : 1) + (center.y < mid.y ? 0 : 2);
+
+      Rect childTight(quadrant & 1 ? mid.x : tight.min.x, quadrant & 2 ? mid.y : tight.min.y,
+                      quadrant & 1 ? tight.max.x : mid.x, quadrant & 2 ? tight.max.y : mid.y);
+
+      S32 childIndex = mNodes[nodeIndex].children[quadrant];
+
+      if(childIndex == -1)
+      {
+         if(!create)
+            return -1;
+
+         childIndex = createNode(childTight);
+         mNodes[nodeIndex].children[quadrant] = childIndex;
+      }
+
+      nodeIndex = childIndex;
+      tight = childTight;
+   }
+
+   return nodeIndex;
+}
+
+
+void LooseQuadtree::insert(DatabaseObject *object, const Rect &extents)
+{
+   mNodes[findNode(extents, true)].objects.push_back(object);
+}
+
+
+void LooseQuadtree::remove(DatabaseObject *object, const Rect &extents)
+{
+   S32 nodeIndex = findNode(extents, false);
+   TNLAssert(nodeIndex != -1, "Object's node is missing!");
+
+   if(nodeIndex != -1)
+      eraseFromCell(mNodes[nodeIndex].objects, object);
+}
+
+
+void LooseQuadtree::clear()
+{
+   mNodes.clear();
+   createNode(mRootBounds);
+}
+
+
+// Root is always square, so all nodes are square
+void LooseQuadtree::setWorldExtents(const Rect &extents)
+{
+   TNLAssert(mNodes.size() <= 1 && (mNodes.size() == 0 || mNodes[0].objects.size() == 0), "Index should be empty when resizing!");
+
+   F32 size = max(max(extents.getWidth(), extents.getHeight()), 1.0f);
+
+   mRootBounds.set(extents.min, extents.min + Point(size, size));
+
+   clear();
+}
+
+
+// Private helper
+void LooseQuadtree::findCells(S32 nodeIndex, const Rect &extents, Vector<const SpatialCell *> &cells) const
+{
+   const Node &node = mNodes[nodeIndex];
+
+   if(node.objects.size() > 0)
+      cells.push_back(&node.objects);
+
+   for(S32 i = 0; i < 4; i++)
+   {
+      S32 childIndex = node.children[i];
+      if(childIndex != -1 && overlaps(mNodes[childIndex].looseBounds, extents))
+         findCells(childIndex, extents, cells);
+   }
+}
+
+
+// Root is always searched, as it holds objects that lie outside the root bounds
+void LooseQuadtree::findCells(const Rect &extents, Vector<const SpatialCell *> &cells) const
+{
+   findCells(0, extents, cells);
+}
+
+
+void LooseQuadtree::findAllCells(Vector<const SpatialCell *> &cells) const
+{
+   for(S32 i = 0; i < mNodes.size(); i++)
+      if(mNodes[i].objects.size() > 0)
+         cells.push_back(&mNodes[i].objects);
+}
+
+
+};
@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------
+// Copyright Chris Eykamp
+// See LICENSE.txt for full copyright information
+//------------------------------------------------------------------------------
+
+#ifndef _SPATIAL_INDEX_H_
+#define _SPATIAL_INDEX_H_
+
+#include "Rect.h"
+
+#include "tnlTypes.h"
+#include "tnlVector.h"
+
+
+using namespace TNL;
+
+namespace Zap
+{
+
+class DatabaseObject;
+
+// Objects stored in a single cell or node of a spatial index, kept contiguous for fast scanning
+typedef Vector<DatabaseObject *> SpatialCell;
+
+
+// Interface between GridDatabase and whatever structure it uses to find objects by location.  An index only
+// knows about object pointers and their extents; it does no de-duplication or type filtering -- GridDatabase
+// handles that.  Placement of an object must be a pure function of its extents and the index parameters, so
+// an object can always be found again (for removal or update) from the extents it was inserted with.
+class SpatialIndex
+{
+public:
+   enum IndexType {
+      SparseHashGrid,      // Uniform cells, but only cells holding objects are allocated; best for lots of small moving objects
+      LooseQuadtree,       // Good for static objects of widely varying sizes, such as bot zones and wall edges
+   };
+
+   virtual ~SpatialIndex();      // Destructor
+
+   static SpatialIndex *create(IndexType type);    // Factory -- caller owns the result
+
+   virtual IndexType getType() const = 0;
+
+   virtual void insert(DatabaseObject *object, const Rect &extents) = 0;
+   virtual void remove(DatabaseObject *object, const Rect &extents) = 0;
+   virtual void update(DatabaseObject *object, const Rect &oldExtents, const Rect &newExtents);
+
+   virtual void clear() = 0;
+
+   // Resizes the index to suit a world of the specified extents.  Index must be empty when this is called.
+   virtual void setWorldExtents(const Rect &extents) = 0;
+
+   // Append every cell that might hold objects overlapping extents; cells may contain objects outside extents,
+   // and the same object may appear in several cells
+   virtual void findCells(const Rect &extents, Vector<const SpatialCell *> &cells) const = 0;
+   virtual void findAllCells(Vector<const SpatialCell *> &cells) const = 0;
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Uniform grid of square cells, stored in an open-addressed hash table keyed on cell coordinates.  Unlike the old
+// fixed 16x16 wrapped bucket array, objects far apart never share a cell.  Objects that would span too many cells
+// are kept in a separate oversize list which is returned with every query.
+class SparseHashGrid : public SpatialIndex
+{
+   typedef SpatialIndex Parent;
+
+private:
+   struct Cell
+   {
+      S32 x, y;
+      bool used;
+      SpatialCell objects;
+
+      Cell();
+   };
+
+   Vector<Cell> mCells;          // Hash table; size is always a power of 2
+   S32 mUsedCellCount;
+   S32 mCellSizeBitShift;        // Width/height of each cell in pixels, in a form of 2 ^ n
+   SpatialCell mOversize;        // Objects too big to be worth spreading over cells
+
+   void getCellRange(const Rect &extents, IntRect &range) const;
+   bool isOversize(const IntRect &range) const;
+
+   S32 findCellIndex(S32 x, S32 y) const;       // Returns -1 if no cell exists at (x,y)
+   Cell *findOrCreateCell(S32 x, S32 y);
+   void releaseCell(S32 index);                 // Call when a cell's object list becomes empty
+   void growTable();
+
+public:
+   static const S32 DefaultCellSizeBitShift = 8;      // 256 pixels, same as the old bucket grid
+   static const S32 MaxCellsPerObject = 64;
+
+   SparseHashGrid();             // Constructor
+   virtual ~SparseHashGrid();    // Destructor
+
+   IndexType getType() const;
+
+   void insert(DatabaseObject *object, const Rect &extents);
+   void remove(DatabaseObject *object, const Rect &extents);
+   void update(DatabaseObject *object, const Rect &oldExtents, const Rect &newExtents);
+
+   void clear();
+   void setWorldExtents(const Rect &extents);
+
+   void findCells(const Rect &extents, Vector<const SpatialCell *> &cells) const;
+   void findAllCells(Vector<const SpatialCell *> &cells) const;
+
+   S32 getCellSize() const;
+   S32 getUsedCellCount() const;
+};
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Loose quadtree: each node's "loose" bounds are twice the size of its tight bounds, so every object can be placed
+// purely by its center and size, and lives in exactly one node.  Objects whose center falls outside the root, or
+// that are too big for any child, stay in the root.  Nodes are created on demand and kept until clear().
+class LooseQuadtree : public SpatialIndex
+{
+   typedef SpatialIndex Parent;
+
+private:
+   struct Node
+   {
+      Rect looseBounds;
+      S32 children[4];           // Indices into mNodes, -1 if not yet created
+      SpatialCell objects;
+
+      Node();
+   };
+
+   Vector<Node> mNodes;          // mNodes[0] is the root
+   Rect mRootBounds;             // Tight bounds of the root
+
+   S32 findNode(const Rect &extents, bool create);    // Returns -1 if create is false and node does not exist
+   S32 createNode(const Rect &tightBounds);
+   void findCells(S32 nodeIndex, const Rect &extents, Vector<const SpatialCell *> &cells) const;
+
+public:
+   static const S32 MaxDepth = 8;
+
+   LooseQuadtree();              // Constructor
+   virtual ~LooseQuadtree();     // Destructor
+
+   IndexType getType() const;
+
+   void insert(DatabaseObject *object, const Rect &extents);
+   void remove(DatabaseObject *object, const Rect &extents);
+
+   void clear();
+   void setWorldExtents(const Rect &extents);
+
+   void findCells(const Rect &extents, Vector<const SpatialCell *> &cells) const;
+   void findAllCells(Vector<const SpatialCell *> &cells) const;
+};
+
+
+};
+
+#endif
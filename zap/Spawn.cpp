@@ -126,6 +126,12 @@ U32 AbstractSpawn::getPeriod()
 }
 
 
+U32 AbstractSpawn::getTimeUntilSpawn() const
+{
+   return mTimer.getCurrent();
+}
+
+
 // Render some attributes when item is selected but not being edited
 void AbstractSpawn::fillAttributesVectors(Vector<string> &keys, Vector<string> &values)
 {
@@ -321,23 +327,23 @@ void ItemSpawn::renderEditor(F32 currentScale, bool snappingToWallCornersEnabled
 void ItemSpawn::renderDock(const Color &color) const                              { TNLAssert(false, "Not implemented!"); }
 
 
-#ifndef ZAP_DEDICATED
-
-bool ItemSpawn::startEditingAttrs(EditorAttributeMenuUI *attributeMenu)
-{
+#ifndef ZAP_DEDICATED
+
+bool ItemSpawn::startEditingAttrs(EditorAttributeMenuUI *attributeMenu)
+{
    CounterMenuItem *menuItem = new CounterMenuItem("Spawn Timer:", getSpawnTime(), 1, 0, 1000, "secs", "Never spawns",
       "Time it takes for each item to be spawned");
    attributeMenu->addMenuItem(menuItem);
-
-   return true;
-}
-
-
-void ItemSpawn::doneEditingAttrs(EditorAttributeMenuUI *attributeMenu)
-{
-   setSpawnTime(attributeMenu->getMenuItem(0)->getIntValue());
-}
-
+
+   return true;
+}
+
+
+void ItemSpawn::doneEditingAttrs(EditorAttributeMenuUI *attributeMenu)
+{
+   setSpawnTime(attributeMenu->getMenuItem(0)->getIntValue());
+}
+
 #endif
 
 
@@ -487,7 +493,7 @@ const char *AsteroidSpawn::getOnDockName()       const  { return "ASP";
 const char *AsteroidSpawn::getPrettyNamePlural() const  { return "Asteroid Spawn Points"; }
 const char *AsteroidSpawn::getEditorHelpString() const  { return "Periodically spawns a new asteroid."; }
 
-
+
 const char *AsteroidSpawn::getClassName() const  { return "AsteroidSpawn"; }
 
 S32 AsteroidSpawn::getDefaultRespawnTime()
@@ -705,7 +711,7 @@ const char *FlagSpawn::getOnDockName()       const  { return "FlagSpawn";
 const char *FlagSpawn::getPrettyNamePlural() const  { return "Flag Spawn points"; }
 const char *FlagSpawn::getEditorHelpString() const  { return "Location where flags (or balls in Soccer) spawn after capture."; }
 
-
+
 const char *FlagSpawn::getClassName() const  { return "FlagSpawn"; }
 
 
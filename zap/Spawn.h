@@ -55,6 +55,7 @@ public:
    bool updateTimer(U32 deltaT);
    void resetTimer();
    U32 getPeriod();     // temp debugging
+   U32 getTimeUntilSpawn() const;
 
 
    ///// Editor methods
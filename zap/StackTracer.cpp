@@ -16,6 +16,8 @@
 #  include <cxxabi.h>
 #endif
 
+#include "tnlLog.h"
+
 #include <stdio.h>
 #include <signal.h>
 
@@ -148,6 +150,10 @@ static void abortHandler(S32 signum)
       fprintf(stderr, "Caught signal %d (%s)\n", signum, name);
    else
       fprintf(stderr, "Caught signal %d\n", signum);
+
+   // Get whatever the log writer thread hasn't written yet onto the disk; we may have crashed holding a log's
+   // lock, so this skips any log that's busy rather than deadlock
+   FileLogConsumer::flushAllForCrash();
  
    printStackTrace();
  
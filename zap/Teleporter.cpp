@@ -144,7 +144,7 @@ void DestManager::setOwner(Teleporter *owner)
 
 TNL_IMPLEMENT_NETOBJECT(Teleporter);
 
-static Vector<DatabaseObject *> foundObjects;      // Reusable container
+static ThreadLocalVector<DatabaseObject *> foundObjects;      // Reusable container, one per thread
 
 const F32 Teleporter::DamageReductionFactor = 0.5f;
 
@@ -258,12 +258,13 @@ bool Teleporter::processArguments(S32 argc2, const char **argv2, Level *level)
    // See if we already have any teleports with this pos... if so, this is a "multi-dest" teleporter.
    // Note that editor handles multi-dest teleporters as separate single dest items, so multi-dest teleporters will be
    // broken into a series of single-dest teleporters when the level is added to the editor.
-   foundObjects.clear();
-   level->findObjects(TeleporterTypeNumber, foundObjects, Rect(pos, 1));
+   // Levels can be parsed off the main thread, so this can't use the shared container
+   Vector<DatabaseObject *> teleporters;
+   level->findObjects(TeleporterTypeNumber, teleporters, Rect(pos, 1));
 
-   for(S32 i = 0; i < foundObjects.size(); i++)
+   for(S32 i = 0; i < teleporters.size(); i++)
    {
-      Teleporter *tel = static_cast<Teleporter *>(foundObjects[i]);
+      Teleporter *tel = static_cast<Teleporter *>(teleporters[i]);
       if(tel->getOrigin().distSquared(pos) < 1)     // i.e These are really close!  Must be the same!
       {
          tel->addDest(dest);
@@ -409,6 +410,13 @@ U32 Teleporter::packUpdate(GhostConnection *connection, U32 updateMask, BitStrea
 }
 
 
+// Nothing in our updates depends on which client they go to, so all clients can share them
+S32 Teleporter::getUpdateCacheKey(GhostConnection *connection)
+{
+   return 0;
+}
+
+
 void Teleporter::unpackUpdate(GhostConnection *connection, BitStream *stream)
 {
    if(stream->readFlag())                 // InitMask
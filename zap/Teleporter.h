@@ -126,6 +126,7 @@ public:
 
    U32 packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream);
    void unpackUpdate(GhostConnection *connection, BitStream *stream);
+   S32 getUpdateCacheKey(GhostConnection *connection);
 
    F32 getHealth() const;
    bool isDestroyed();
@@ -343,18 +343,20 @@ void EditorUserInterface::redo()
 }
 
 
+// Rebuilds edges of walls that have changed, and resnaps engineered items near them
 void EditorUserInterface::rebuildWallGeometry(Level *level)
 {
-   level->buildWallEdgeGeometry(mWallEdgePoints);     // Populates mWallEdgePoints
+   level->updateWallEdgeGeometry(mWallEdgePoints);    // Populates mWallEdgePoints
    rebuildSelectionOutline();  
-
-   level->snapAllEngineeredItems(false);
 }
 
 
 void EditorUserInterface::rebuildEverything(Level *level)
 {
-   rebuildWallGeometry(level);
+   level->buildWallEdgeGeometry(mWallEdgePoints);     // Populates mWallEdgePoints
+   rebuildSelectionOutline();  
+
+   level->snapAllEngineeredItems(false);
 
    // If we're rebuilding items in our levelgen database, no need to save anything!
    if(level != &mLevelGenDatabase)
@@ -372,6 +374,8 @@ void EditorUserInterface::setLevelFileName(const string &name)
 
 void EditorUserInterface::cleanUp()
 {
+   finishAutoSave();                // Get the last changes to the level we're leaving into the autosave
+
    getGame()->resetRatings();       // Move to mLevel?
 
    mUndoManager.clearAll();         // Clear up a little memory
@@ -466,6 +470,7 @@ void EditorUserInterface::copyScriptItemsToEditor()
    Vector<DatabaseObject *> tempList(*mLevelGenDatabase.findObjects_fast());
 
    mUndoManager.startTransaction();
+   mLevel->beginBatchGeomUpdate();     // Walls will all be rebuilt below
 
    // We can't call addToEditor immediately because it calls addToGame which will trigger
    // an assert since the levelGen items are already added to the game.  We must therefore
@@ -479,6 +484,7 @@ void EditorUserInterface::copyScriptItemsToEditor()
       mUndoManager.saveAction(ActionCreate, obj);
    }
 
+   mLevel->endBatchGeomUpdate(mWallEdgePoints, false);
    mUndoManager.endTransaction();
 
    mLevelGenDatabase.clearAllObjects();   // This will delete objects... is that what we want?
@@ -1054,21 +1060,6 @@ template void addSelectedSegmentsToList<WallItem>(const Vector<DatabaseObject *>
 template void addSelectedSegmentsToList<PolyWall>(const Vector<DatabaseObject *> *walls, bool, Vector<const WallSegment *> &segments);
                                           
 
-// Return a list of all selected segments
-static Vector<WallSegment const *> getSelectedWallsAndPolywallSegments(const Level *level)
-{
-   Vector<WallSegment const *> segments;
-
-   const Vector<DatabaseObject *> *walls = level->findObjects_fast(WallItemTypeNumber);
-   const Vector<DatabaseObject *> *polywalls = level->findObjects_fast(PolyWallTypeNumber);
-
-   addSelectedSegmentsToList<WallItem>(walls,     false, segments);
-   addSelectedSegmentsToList<PolyWall>(polywalls, false, segments);
-
-   return segments;
-}
-
-
 static Vector<WallSegment const *> getSelectedWallSegments(const Level *level)
 {
    Vector<WallSegment const *> segments;
@@ -1928,7 +1919,7 @@ void EditorUserInterface::render() const
 
 void EditorUserInterface::renderObjectIds(GridDatabase *database) const
 {
-   const Vector<DatabaseObject *> *objList = database->findObjects_fast();
+   const Vector<DatabaseObject *> *objList = database->findObjects_ordered();
 
    Point offset(50, 30);
 
@@ -1957,7 +1948,7 @@ void EditorUserInterface::setColor(bool isSelected, bool isLitUp, bool isScriptI
 // Render objects in the specified database
 void EditorUserInterface::renderObjects(const GridDatabase *database, RenderModes renderMode, bool isLevelgenOverlay) const
 {
-   const Vector<DatabaseObject *> *objList = database->findObjects_fast();
+   const Vector<DatabaseObject *> *objList = database->findObjects_ordered();
 
    bool wantSelected = (renderMode == RENDER_SELECTED_NONWALLS || renderMode == RENDER_SELECTED_WALLS);
    bool wantWalls =    (renderMode == RENDER_UNSELECTED_WALLS  || renderMode == RENDER_SELECTED_WALLS);
@@ -2270,7 +2261,7 @@ void EditorUserInterface::copySelection()
 
    mClipboard.clear();     
 
-   const Vector<DatabaseObject *> *objList = getLevel()->findObjects_fast();
+   const Vector<DatabaseObject *> *objList = getLevel()->findObjects_ordered();
 
    for(S32 i = 0; i < objList->size(); i++)
    {
@@ -2375,9 +2366,7 @@ void EditorUserInterface::scaleSelection(F32 scale)
 
    mUndoManager.endTransaction();
    
-   Vector<WallSegment const *> segments = getSelectedWallsAndPolywallSegments(mLevel.get());
-
-   mLevel->endBatchGeomUpdate(mLevel.get(), segments, mWallEdgePoints, modifiedWalls);
+   mLevel->endBatchGeomUpdate(mWallEdgePoints, modifiedWalls);
    rebuildSelectionOutline();
 
    autoSave();
@@ -2610,9 +2599,7 @@ void EditorUserInterface::flipSelection(F32 center, bool isHoriz)
 
    mUndoManager.endTransaction();
 
-   Vector<WallSegment const *> segments = getSelectedWallsAndPolywallSegments(mLevel.get());
-
-   mLevel->endBatchGeomUpdate(mLevel.get(), segments, mWallEdgePoints, modifiedWalls);
+   mLevel->endBatchGeomUpdate(mWallEdgePoints, modifiedWalls);
    rebuildSelectionOutline();
 
    autoSave();
@@ -4866,6 +4853,10 @@ void EditorUserInterface::idle(U32 timeDelta)
    mSaveMsgTimer.update(timeDelta);
    mWarnMsgTimer.update(timeDelta);
 
+   // Objects being dragged are in flux; wait till they're put down
+   if(mAutoSaver.idle(timeDelta) && !mDraggingObjects)
+      startAutoSave();
+
    // Process the messageBoxQueue
    if(mMessageBoxQueue.size() > 0)
    {
@@ -4956,9 +4947,48 @@ void EditorUserInterface::clearWarnMessage()
 }
 
 
+// Saving a big level takes long enough to notice, so rather than saving after every change, we wait for a lull and
+// let mAutoSaver write a copy of the level in the background
 void EditorUserInterface::autoSave()
 {
-   doSaveLevel("auto.save", false);
+   mAutoSaver.levelChanged();
+}
+
+
+// Copies the level and hands it to mAutoSaver to write out.  The copies are cheap next to the writing, and once they're
+// made, the editor is free to carry on changing the level.
+void EditorUserInterface::startAutoSave()
+{
+   string header = mLevel->toLevelCode();
+
+   for(S32 i = 0; i < mRobotLines.size(); i++)
+      header += mRobotLines[i] + "\n";
+
+   // Same order as getLevelText(): walls first, so mountable items have something to grab onto
+   const Vector<DatabaseObject *> *objList = getLevel()->findObjects_ordered();
+   Vector<BfObject *> objects(objList->size());
+
+   for(S32 j = 0; j < 2; j++)
+      for(S32 i = 0; i < objList->size(); i++)
+      {
+         BfObject *obj = static_cast<BfObject *>(objList->get(i));
+
+         if(isWallType(obj->getObjectTypeNumber()) == (j == 0))
+            objects.push_back(obj->clone());
+      }
+
+   FolderManager *folderManager = mGameSettings->getFolderManager();
+   mAutoSaver.save(joindir(folderManager->getLevelDir(), "auto.save"), header, objects);
+}
+
+
+// Makes sure every change made so far is on disk
+void EditorUserInterface::finishAutoSave()
+{
+   if(mLevel && mAutoSaver.hasUnsavedChanges())
+      startAutoSave();
+
+   mAutoSaver.flush();
 }
 
 
@@ -5017,7 +5047,7 @@ string EditorUserInterface::getLevelText() const
       result += mRobotLines[i] + "\n";
 
    // Write out all level items (do two passes; walls first, non-walls next, so turrets & forcefields have something to grab onto)
-   const Vector<DatabaseObject *> *objList = getLevel()->findObjects_fast();
+   const Vector<DatabaseObject *> *objList = getLevel()->findObjects_ordered();
 
    for(S32 j = 0; j < 2; j++)
    {
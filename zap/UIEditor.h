@@ -11,6 +11,7 @@
 
 #include "EditorPlugin.h"        // For plugin support
 #include "EditorUndoManager.h"   // To, like, undo stuff
+#include "LevelAutoSaver.h"
 
 #include "teamInfo.h"            // For TeamManager def
 #include "VertexStylesEnum.h"
@@ -124,6 +125,8 @@ private:
    Timer mSaveMsgTimer;
    Timer mWarnMsgTimer;
 
+   LevelAutoSaver mAutoSaver;
+
    SymbolString mLingeringMessage;
 
    Point mMoveOrigin;                              // Point representing where items were moved "from" for figuring out how far they moved
@@ -315,6 +318,8 @@ private:
 
 
    void autoSave();                    // Hope for the best, prepare for the worst
+   void startAutoSave();
+   void finishAutoSave();
    bool doSaveLevel(const string &saveName, bool showFailMessages);
 
    void onActivateReactivate();
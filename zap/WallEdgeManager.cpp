@@ -17,9 +17,88 @@ using namespace TNL;
 namespace Zap
 {
 
+// Segments whose extents come this close are treated as touching when working out which ones to re-clip together
+static const F32 SegmentTouchTolerance = 1.0f;
+
+
+// Endpoints of a wall edge, normalized so the same edge compares equal whichever way round it was built
+struct EdgeEnds
+{
+   Point start;
+   Point end;
+
+   EdgeEnds() { /* Do nothing */ }
+
+   EdgeEnds(const Point &p1, const Point &p2)
+   {
+      if(p1.x < p2.x || (p1.x == p2.x && p1.y <= p2.y))
+      {
+         start = p1;
+         end = p2;
+      }
+      else
+      {
+         start = p2;
+         end = p1;
+      }
+   }
+};
+
+
+static S32 comparePoints(const Point &a, const Point &b)
+{
+   if(a.x != b.x)
+      return a.x < b.x ? -1 : 1;
+   if(a.y != b.y)
+      return a.y < b.y ? -1 : 1;
+   return 0;
+}
+
+
+static S32 QSORT_CALLBACK edgeEndsSort(EdgeEnds *a, EdgeEnds *b)
+{
+   S32 order = comparePoints(a->start, b->start);
+   return order != 0 ? order : comparePoints(a->end, b->end);
+}
+
+
+// Adds the extent of every edge in one list but not the other to changedRegions; sorts both lists
+static void findChangedEdges(Vector<EdgeEnds> &oldEdges, Vector<EdgeEnds> &newEdges, Vector<Rect> &changedRegions)
+{
+   oldEdges.sort(edgeEndsSort);
+   newEdges.sort(edgeEndsSort);
+
+   S32 i = 0, j = 0;
+
+   while(i < oldEdges.size() || j < newEdges.size())
+   {
+      S32 order = i == oldEdges.size() ? 1 : j == newEdges.size() ? -1 : edgeEndsSort(&oldEdges[i], &newEdges[j]);
+
+      if(order < 0)
+      {
+         changedRegions.push_back(Rect(oldEdges[i].start, oldEdges[i].end));
+         i++;
+      }
+      else if(order > 0)
+      {
+         changedRegions.push_back(Rect(newEdges[j].start, newEdges[j].end));
+         j++;
+      }
+      else
+      {
+         i++;
+         j++;
+      }
+   }
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
 
 // Constructor
-WallEdgeManager::WallEdgeManager()
+WallEdgeManager::WallEdgeManager() : mWallEdgeDatabase(SpatialIndex::LooseQuadtree)
 {
    mBatchUpdatingGeom  = false;
 }
@@ -32,6 +111,12 @@ WallEdgeManager::~WallEdgeManager()
 }
 
 
+bool WallEdgeManager::isBatchUpdatingGeom() const
+{
+   return mBatchUpdatingGeom;
+}
+
+
 void WallEdgeManager::beginBatchGeomUpdate()
 {
    mBatchUpdatingGeom = true;
@@ -72,9 +157,9 @@ void WallEdgeManager::rebuildEdges(const Vector<WallSegment const *> &wallSegmen
 
 
 // Take geometry from all wall segments, and run them through clipper to generate new edge geometry.  Then use the results to create
-// a bunch of WallEdge objects, which will be stored in mWallEdgeDatabase for future reference.  The two key things to understand here
-// are that 1) it's all-or-nothing: all edges need to be recomputed at once; there is no way to do a partial rebuild.  And 2) the edges
-// cannot be associated with their source, so we'll need to rely on other tricks to find an associated wall when needed.
+// a bunch of WallEdge objects, which will be stored in mWallEdgeDatabase for future reference.  Note that the edges cannot be
+// associated with their source, so we'll need to rely on other tricks to find an associated wall when needed.  See
+// updateEdgesWithClipper() for a version that only redoes the parts of the level that have changed since the last time.
 // Private method
 void WallEdgeManager::rebuildEdgesWithClipper(const Vector<WallSegment const *> &wallSegments, Vector<Point> &wallEdgePoints)
 {
@@ -89,11 +174,270 @@ void WallEdgeManager::rebuildEdgesWithClipper(const Vector<WallSegment const *>
    // delete the object when it is ulitmately removed.
    mWallEdgeDatabase.removeEverythingFromDatabase();    // Remove the old edges
 
+   // Size the index to the new edges before adding them, so we only build it once
+   if(wallEdgePoints.size() > 0)
+      mWallEdgeDatabase.setSpatialIndexExtents(Rect(wallEdgePoints));
+
    for(S32 i = 0; i < wallEdgePoints.size(); i+=2)
    {
       WallEdge *newEdge = new WallEdge(wallEdgePoints[i], wallEdgePoints[i+1]);   // Create the edge object
       newEdge->addToDatabase(&mWallEdgeDatabase);                                 // And add it to the database
    }
+
+   // Remember what we built the edges from, so the next update can tell what has changed
+   recordSegments(wallSegments, mSegmentRecords, mSegmentCorners);
+}
+
+
+// Bring our edges up to date with wallSegments, redoing only the parts of the level that have changed since the edges
+// were last built.  Segments that have changed, and any segments that touch them (or touch those, and so on), are
+// re-clipped together; since clipper merges touching segments into a single outline, no other edges can be affected.
+// Fills changedRegions with the areas where walls or edges have changed, and wallEdgePoints with all edges.  Returns
+// false if so much has changed that we rebuilt everything, in which case changedRegions is left empty.
+bool WallEdgeManager::updateEdges(const Vector<WallSegment const *> &wallSegments, Vector<Point> &wallEdgePoints,
+                                  Vector<Rect> &changedRegions)
+{
+   return updateEdgesWithClipper(wallSegments, wallEdgePoints, changedRegions);
+}
+
+
+// Private method
+bool WallEdgeManager::updateEdgesWithClipper(const Vector<WallSegment const *> &wallSegments, Vector<Point> &wallEdgePoints,
+                                             Vector<Rect> &changedRegions)
+{
+   Vector<SegmentRecord> records;
+   Vector<Point> corners;
+
+   recordSegments(wallSegments, records, corners);
+
+   // Extents of segments that have appeared, disappeared, or changed shape
+   Vector<Rect> changedSegmentRects;
+   findChangedSegments(records, corners, changedSegmentRects);
+
+   // Nothing to build on, or so much has changed that it's quicker to start over
+   if(mSegmentRecords.size() == 0 || changedSegmentRects.size() > wallSegments.size() / 2)
+   {
+      rebuildEdgesWithClipper(wallSegments, wallEdgePoints);
+      return false;
+   }
+
+   S32 count = wallSegments.size();
+   Point tolerance(SegmentTouchTolerance, SegmentTouchTolerance);
+
+   Vector<Rect> extents;
+   extents.resize(count);
+
+   for(S32 i = 0; i < records.size(); i++)
+   {
+      extents[records[i].segmentIndex] = records[i].extent;
+      extents[records[i].segmentIndex].expand(tolerance);
+   }
+
+   for(S32 i = 0; i < changedSegmentRects.size(); i++)
+      changedSegmentRects[i].expand(tolerance);
+
+   // Find the segments touching the changes, then the segments touching those, until we've found them all
+   Vector<bool> affected;
+   affected.resize(count);
+
+   Vector<S32> toVisit;
+
+   for(S32 i = 0; i < count; i++)
+   {
+      affected[i] = false;
+
+      for(S32 j = 0; j < changedSegmentRects.size(); j++)
+         if(extents[i].intersectsOrBorders(changedSegmentRects[j]))
+         {
+            affected[i] = true;
+            toVisit.push_back(i);
+            break;
+         }
+   }
+
+   while(toVisit.size() > 0)
+   {
+      S32 index = toVisit.last();
+      toVisit.pop_back();
+
+      for(S32 i = 0; i < count; i++)
+         if(!affected[i] && extents[i].intersectsOrBorders(extents[index]))
+         {
+            affected[i] = true;
+            toVisit.push_back(i);
+         }
+   }
+
+   // Every edge built from the old versions of the affected segments lies inside one of their extents; edges of
+   // unaffected segments are at least twice our tolerance away from all of them
+   Vector<Rect> removalRects(changedSegmentRects);
+   Vector<WallSegment const *> affectedSegments;
+
+   for(S32 i = 0; i < count; i++)
+      if(affected[i])
+      {
+         removalRects.push_back(extents[i]);
+         affectedSegments.push_back(wallSegments[i]);
+      }
+
+   Vector<EdgeEnds> removedEdges;
+   Vector<DatabaseObject *> fillEdges;
+
+   for(S32 i = 0; i < removalRects.size(); i++)
+   {
+      fillEdges.clear();
+      mWallEdgeDatabase.findObjects(WallEdgeTypeNumber, fillEdges, removalRects[i]);
+
+      for(S32 j = 0; j < fillEdges.size(); j++)
+      {
+         WallEdge *edge = static_cast<WallEdge *>(fillEdges[j]);
+
+         if(removalRects[i].contains((*edge->getStart() + *edge->getEnd()) * 0.5f))
+         {
+            removedEdges.push_back(EdgeEnds(*edge->getStart(), *edge->getEnd()));
+            mWallEdgeDatabase.removeFromDatabase(edge, true);
+         }
+      }
+   }
+
+   // Re-clip the affected segments, and put their edges in place of the ones we removed
+   Vector<Point> newEdgePoints;
+   clipAllWallEdges(affectedSegments, newEdgePoints);
+
+   Vector<EdgeEnds> addedEdges;
+
+   for(S32 i = 0; i < newEdgePoints.size(); i += 2)
+   {
+      WallEdge *newEdge = new WallEdge(newEdgePoints[i], newEdgePoints[i+1]);
+      newEdge->addToDatabase(&mWallEdgeDatabase);
+
+      addedEdges.push_back(EdgeEnds(newEdgePoints[i], newEdgePoints[i+1]));
+   }
+
+   // Many of the edges we rebuilt will be just as they were; only report the ones that actually changed
+   changedRegions = changedSegmentRects;
+   findChangedEdges(removedEdges, addedEdges, changedRegions);
+
+   mSegmentRecords = records;
+   mSegmentCorners = corners;
+
+   // Our edges are in no particular order, but that's fine for drawing them
+   const Vector<DatabaseObject *> *allEdges = mWallEdgeDatabase.findObjects_fast();
+
+   wallEdgePoints.clear();
+   wallEdgePoints.reserve(allEdges->size() * 2);
+
+   for(S32 i = 0; i < allEdges->size(); i++)
+   {
+      WallEdge *edge = static_cast<WallEdge *>(allEdges->get(i));
+      wallEdgePoints.push_back(*edge->getStart());
+      wallEdgePoints.push_back(*edge->getEnd());
+   }
+
+   return true;
+}
+
+
+// Fills changedRects with the extents of every segment in records (which must be sorted) that isn't in mSegmentRecords,
+// and vice versa.  Segments are matched by their geometry, so a segment that has been recreated just as it was is not
+// a change.
+// Private method
+void WallEdgeManager::findChangedSegments(const Vector<SegmentRecord> &records, const Vector<Point> &corners,
+                                          Vector<Rect> &changedRects) const
+{
+   S32 i = 0, j = 0;
+
+   while(i < mSegmentRecords.size() || j < records.size())
+   {
+      S32 order = i == mSegmentRecords.size() ? 1 : 
+                  j == records.size()         ? -1 : compareRecordKeys(mSegmentRecords[i], records[j]);
+
+      if(order < 0)
+      {
+         changedRects.push_back(mSegmentRecords[i].extent);
+         i++;
+      }
+      else if(order > 0)
+      {
+         changedRects.push_back(records[j].extent);
+         j++;
+      }
+      else
+      {
+         const SegmentRecord &oldRecord = mSegmentRecords[i];
+         const SegmentRecord &newRecord = records[j];
+
+         for(S32 k = 0; k < newRecord.cornerCount; k++)
+            if(mSegmentCorners[oldRecord.firstCorner + k] != corners[newRecord.firstCorner + k])
+            {
+               changedRects.push_back(oldRecord.extent);
+               changedRects.push_back(newRecord.extent);
+               break;
+            }
+
+         i++;
+         j++;
+      }
+   }
+}
+
+
+// Orders records by everything but their corners; equal keys almost always means equal corners
+// Static method
+S32 WallEdgeManager::compareRecordKeys(const SegmentRecord &a, const SegmentRecord &b)
+{
+   if(a.hash != b.hash)
+      return a.hash < b.hash ? -1 : 1;
+   if(a.cornerCount != b.cornerCount)
+      return a.cornerCount < b.cornerCount ? -1 : 1;
+
+   S32 order = comparePoints(a.extent.min, b.extent.min);
+   return order != 0 ? order : comparePoints(a.extent.max, b.extent.max);
+}
+
+
+// Static method
+S32 QSORT_CALLBACK WallEdgeManager::segmentRecordSort(SegmentRecord *a, SegmentRecord *b)
+{
+   return compareRecordKeys(*a, *b);
+}
+
+
+// Copies the geometry of wallSegments into records and corners, with records sorted for findChangedSegments()
+// Static method
+void WallEdgeManager::recordSegments(const Vector<WallSegment const *> &wallSegments, Vector<SegmentRecord> &records,
+                                     Vector<Point> &corners)
+{
+   records.resize(wallSegments.size());
+   corners.clear();
+
+   for(S32 i = 0; i < wallSegments.size(); i++)
+   {
+      const Vector<Point> *segmentCorners = wallSegments[i]->getCorners();
+      SegmentRecord &record = records[i];
+
+      record.cornerCount = segmentCorners->size();
+      record.firstCorner = corners.size();
+      record.segmentIndex = i;
+      record.extent.set(*segmentCorners);
+
+      // FNV-1a, over the bits of the coordinates
+      record.hash = 2166136261u;
+
+      for(S32 j = 0; j < segmentCorners->size(); j++)
+      {
+         const Point &corner = segmentCorners->get(j);
+         corners.push_back(corner);
+
+         const U8 *bytes[2] = { (const U8 *)&corner.x, (const U8 *)&corner.y };
+
+         for(S32 k = 0; k < 2; k++)
+            for(U32 l = 0; l < sizeof(corner.x); l++)
+               record.hash = (record.hash ^ bytes[k][l]) * 16777619u;
+      }
+   }
+
+   records.sort(segmentRecordSort);
 }
 
 
@@ -136,12 +480,17 @@ void WallEdgeManager::rebuildEdgesWithClipper(const Vector<WallSegment const *>
 //}
 
 
+// Updates the edges of any walls that have changed, and remounts any items that might be affected
 void WallEdgeManager::finishedChangingWalls(GridDatabase *gameObjectDatabase, 
                                             const Vector<WallSegment const *> &wallSegments, 
                                             Vector<Point> &wallEdgePoints)
 {
-   rebuildEdgesWithClipper(wallSegments, wallEdgePoints);         // Rebuild all edges for all walls
-   updateAllMountedItems(gameObjectDatabase);
+   Vector<Rect> changedRegions;
+
+   if(updateEdgesWithClipper(wallSegments, wallEdgePoints, changedRegions))
+      updateMountedItems(gameObjectDatabase, changedRegions);
+   else
+      updateAllMountedItems(gameObjectDatabase);     // Rebuilt everything
 }
 
 
@@ -244,9 +593,40 @@ void WallEdgeManager::updateAllMountedItems(const GridDatabase *gameObjectDataba
 }
 
 
+// Remounts only the items close enough to changedRegions that their mount point, or where their forcefield ends,
+// might have changed
+void WallEdgeManager::updateMountedItems(const GridDatabase *gameObjectDatabase, const Vector<Rect> &changedRegions)
+{
+   if(changedRegions.size() == 0)
+      return;
+
+   Vector<DatabaseObject *> engrItems;
+   gameObjectDatabase->findObjects((TestFunc)isEngineeredType, engrItems);
+
+   for(S32 i = 0; i < engrItems.size(); i++)
+   {
+      EngineeredItem *engrItem = static_cast<EngineeredItem *>(engrItems[i]);
+
+      Rect reach(engrItem->getVert(0), EngineeredItem::MAX_SNAP_DISTANCE);
+
+      if(engrItem->getObjectTypeNumber() == ForceFieldProjectorTypeNumber)
+         reach.unionRect(static_cast<ForceFieldProjector *>(engrItem)->getForceFieldReach());
+
+      for(S32 j = 0; j < changedRegions.size(); j++)
+         if(reach.intersectsOrBorders(changedRegions[j]))
+         {
+            engrItem->mountToWall(engrItem->getVert(0), gameObjectDatabase, &mWallEdgeDatabase);
+            break;
+         }
+   }
+}
+
+
 void WallEdgeManager::clear()
 {
    mWallEdgeDatabase.removeEverythingFromDatabase();
+   mSegmentRecords.clear();
+   mSegmentCorners.clear();
 }
 
 
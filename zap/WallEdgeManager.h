@@ -8,6 +8,7 @@
 
 #include "gridDB.h"
 #include "Point.h"
+#include "Rect.h"
 
 #include "tnlVector.h"
 #include "tnlNetObject.h"
@@ -26,11 +27,35 @@ class EngineeredItem;
 class WallEdgeManager
 {
 private:
+   // Geometry of one of the segments our edges were built from; records are kept sorted so we can tell
+   // which segments have changed by comparing them with the current ones
+   struct SegmentRecord
+   {
+      U32 hash;               // Hash of the corners, so most records can be compared without looking at them
+      S32 cornerCount;
+      S32 firstCorner;        // Index of first corner in mSegmentCorners
+      S32 segmentIndex;       // Index into the segment list the record was made from
+      Rect extent;
+   };
+
    bool mBatchUpdatingGeom;     
 
    GridDatabase mWallEdgeDatabase;
 
+   Vector<SegmentRecord> mSegmentRecords;
+   Vector<Point> mSegmentCorners;
+
    void rebuildEdgesWithClipper(const Vector<WallSegment const *> &wallSegments, Vector<Point> &wallEdges);
+   bool updateEdgesWithClipper(const Vector<WallSegment const *> &wallSegments, Vector<Point> &wallEdgePoints,
+                               Vector<Rect> &changedRegions);
+
+   void findChangedSegments(const Vector<SegmentRecord> &records, const Vector<Point> &corners, 
+                            Vector<Rect> &changedRects) const;
+
+   static S32 compareRecordKeys(const SegmentRecord &a, const SegmentRecord &b);
+   static S32 QSORT_CALLBACK segmentRecordSort(SegmentRecord *a, SegmentRecord *b);
+   static void recordSegments(const Vector<WallSegment const *> &wallSegments, Vector<SegmentRecord> &records, 
+                              Vector<Point> &corners);
 
 public:
    WallEdgeManager();            // Constructor
@@ -39,6 +64,7 @@ public:
    const GridDatabase *getWallEdgeDatabase() const;
 
    // Suspend certain geometry operations for greater efficiency
+   bool isBatchUpdatingGeom() const;
    void beginBatchGeomUpdate();                                     
    void endBatchGeomUpdate(GridDatabase *gameObjectDatabase, 
                            const Vector<WallSegment const *> &wallSegments, 
@@ -57,9 +83,12 @@ public:
    void clear();                                // Delete everything from everywhere!
 
    void updateAllMountedItems(const GridDatabase *gameObjectDatabase);
+   void updateMountedItems(const GridDatabase *gameObjectDatabase, const Vector<Rect> &changedRegions);
 
    //void rebuildEdges(GridDatabase *database);
    void rebuildEdges(const Vector<WallSegment const *> &wallSegments, Vector<Point> &wallEdgePoints);
+   bool updateEdges(const Vector<WallSegment const *> &wallSegments, Vector<Point> &wallEdgePoints, 
+                    Vector<Rect> &changedRegions);
    static void buildWallSegmentEdgesAndPoints(DatabaseObject *object);
 
 
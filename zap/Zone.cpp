@@ -229,6 +229,14 @@ U32 GameZone::packUpdate(GhostConnection *connection, U32 updateMask, BitStream
 }
 
 
+// Geometry and team are the same for every client, so all clients can share our updates.  Subclasses
+// that write anything client-specific must override this to return UpdateNotCacheable.
+S32 GameZone::getUpdateCacheKey(GhostConnection *connection)
+{
+   return 0;
+}
+
+
 void GameZone::unpackUpdate(GhostConnection *connection, BitStream *stream)
 {
    if(stream->readFlag())                 // GeomMask
@@ -73,6 +73,7 @@ public:
 
    virtual U32 packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream);
    virtual void unpackUpdate(GhostConnection *connection, BitStream *stream);
+   virtual S32 getUpdateCacheKey(GhostConnection *connection);
 };
 
 
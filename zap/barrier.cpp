@@ -194,6 +194,20 @@ bool Barrier::collide(BfObject *otherObject)
 // On client, is called when a wall object is sent from the server.
 // static method
 void Barrier::constructBarriers(Game *game, const Vector<Point> &verts, F32 width)
+{
+   Vector<Barrier *> barriers;
+   constructBarriers(verts, width, barriers);
+
+   // Add individual segments to the game
+   for(S32 i = 0; i < barriers.size(); i++)
+      barriers[i]->addToGame(game, game->getLevel());
+}
+
+
+// Creates the barrier segments for a wall, without adding them to anything; caller takes ownership.  Used directly
+// when building bot zones for a level that isn't in a game yet.
+// static method
+void Barrier::constructBarriers(const Vector<Point> &verts, F32 width, Vector<Barrier *> &barriers)
 {
    if(verts.size() < 2)      // Enough verts?
       return;
@@ -204,15 +218,13 @@ void Barrier::constructBarriers(Game *game, const Vector<Point> &verts, F32 widt
 
    Vector<Point> pts;      // Reusable container
 
-   // Add individual segments to the game
    for(S32 i = 0; i < barrierEnds.size(); i += 2)
    {
       pts.clear();
       pts.push_back(barrierEnds[i]);
       pts.push_back(barrierEnds[i+1]);
 
-      Barrier *b = new Barrier(pts, width, false);    // false = not solid
-      b->addToGame(game, game->getLevel());
+      barriers.push_back(new Barrier(pts, width, false));    // false = not solid
    }
 }
 
@@ -81,6 +81,7 @@ public:
    Vector<Point> mBotZoneBufferLineSegments;       // The line segments representing a buffered barrier
 
    static void constructBarriers (Game *game, const Vector<Point> &verts, F32 width);
+   static void constructBarriers (const Vector<Point> &verts, F32 width, Vector<Barrier *> &barriers);
    static void constructPolyWalls(Game *game, const Vector<Point> &verts);
 
    void renderLayer(S32 layerIndex);                                          // Renders barrier fill barrier-by-barrier
@@ -5,40 +5,55 @@ option(BITFIGHTER_COVERAGE "Add coverage information to the test executable and
 
 set(TEST_SOURCES
 	${CMAKE_SOURCE_DIR}/bitfighter_test/LevelFilesForTesting.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestBanList.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestBitStream.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestBotNavMeshZone.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestColor.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestDatabaseWriter.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestEditor.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestFileLogConsumer.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGame.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGameRecorder.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGameType.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGameUserInterface.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGeomUtils.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestGridDatabase.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestHelpItemManager.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestHttpRequest.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestINISettings.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestInputCode.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestIntegration.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLevelAutoSaver.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLevelLoader.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLevelPreloader.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLevelSource.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLevelMenuSelectUserInterface.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLoadoutIndicator.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLoadoutTracker.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLuaEnvironment.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestLzUtils.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestMaster.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestMove.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestObjectCleanup.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestObjects.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestObjectScope.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestPlaybackBenchmark.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestPolylineGeometry.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestRenderUtils.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestRobot.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestRobotManager.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestServerGame.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestServerShards.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestSettings.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestShip.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestSocket.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestSpawnDelay.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestStringUtils.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestSymbolStrings.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestTeamChanging.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/TestUtils.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestWallEdgeManager.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkWallEdgeManager.cpp
 	${CMAKE_SOURCE_DIR}/bitfighter_test/main_test.cpp
 )
 
@@ -68,6 +83,85 @@ set_target_properties(bitfighter_test
 )
 
 
+#
+# Benchmarks -- gtest timing runs that log their numbers rather than pass or fail on them, kept out of bitfighter_test
+# so it only holds behavior tests.  Not built by default; run from exe like bitfighter_test.
+#
+set(BENCHMARK_SOURCES
+	${CMAKE_SOURCE_DIR}/bitfighter_test/LevelFilesForTesting.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/TestUtils.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkBanList.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkBitStream.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkDatabaseWriter.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkFileLogConsumer.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkGridDatabase.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkLevelPreloader.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkLevelSource.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkRobot.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/BenchmarkWallEdgeManager.cpp
+	${CMAKE_SOURCE_DIR}/bitfighter_test/main_test.cpp
+)
+
+add_executable(bitfighter_benchmark EXCLUDE_FROM_ALL
+	$<TARGET_OBJECTS:bitfighter_client>
+	$<TARGET_OBJECTS:master_lib>
+	${BENCHMARK_SOURCES}
+)
+
+target_link_libraries(bitfighter_benchmark
+	${CLIENT_LIBS}
+	${SHARED_LIBS}
+	gtest
+)
+
+add_dependencies(bitfighter_benchmark
+	bitfighter_client
+	master_lib
+	gtest
+)
+
+set_target_properties(bitfighter_benchmark
+	PROPERTIES
+	RUNTIME_OUTPUT_DIRECTORY ${CMAKE_SOURCE_DIR}/exe
+	COMPILE_DEFINITIONS BITFIGHTER_TEST
+)
+
+
+# master_lib was built against MySQL++, so the tests have to see the same database.h, and link what it needs
+if(MYSQL_FOUND AND NOT MASTER_MINIMAL)
+	foreach(TEST_TARGET bitfighter_test bitfighter_benchmark)
+		set_property(TARGET ${TEST_TARGET} APPEND PROPERTY INCLUDE_DIRECTORIES ${CMAKE_SOURCE_DIR}/mysql++ ${MYSQL_INCLUDE_DIR})
+		target_link_libraries(${TEST_TARGET} mysql++ ${MYSQL_LIBRARIES})
+		set_property(TARGET ${TEST_TARGET} APPEND PROPERTY COMPILE_DEFINITIONS BF_WRITE_TO_MYSQL)
+	endforeach()
+endif()
+
+
+#
+# Playback benchmark -- plays recorded games through the client with nothing rendered, and reports the cost
+#
+add_executable(bitfighter_playback_benchmark EXCLUDE_FROM_ALL
+	$<TARGET_OBJECTS:bitfighter_client>
+	${CMAKE_SOURCE_DIR}/bitfighter_test/main_playback_benchmark.cpp
+)
+
+target_link_libraries(bitfighter_playback_benchmark
+	${CLIENT_LIBS}
+	${SHARED_LIBS}
+)
+
+add_dependencies(bitfighter_playback_benchmark
+	bitfighter_client
+)
+
+set_target_properties(bitfighter_playback_benchmark
+	PROPERTIES
+	RUNTIME_OUTPUT_DIRECTORY ${CMAKE_SOURCE_DIR}/exe
+)
+
+BF_PLATFORM_SET_TARGET_PROPERTIES(bitfighter_playback_benchmark)
+
+
 # to use the coverage target, install lcov, enable BITFIGHTER_COVERAGE, and run it
 # coverage data is output to the 'cov' directory in html format.
 if(BITFIGHTER_COVERAGE)
@@ -87,11 +181,13 @@ if(BITFIGHTER_COVERAGE)
 endif()
 
 
-set_target_properties(bitfighter_test PROPERTIES COMPILE_DEFINITIONS_DEBUG "TNL_DEBUG")
+set_target_properties(bitfighter_test bitfighter_benchmark PROPERTIES COMPILE_DEFINITIONS_DEBUG "TNL_DEBUG")
 
 BF_PLATFORM_SET_TARGET_PROPERTIES(bitfighter_test)
+BF_PLATFORM_SET_TARGET_PROPERTIES(bitfighter_benchmark)
 
 BF_PLATFORM_POST_BUILD_INSTALL_RESOURCES(bitfighter_test)
+BF_PLATFORM_POST_BUILD_INSTALL_RESOURCES(bitfighter_benchmark)
 
 # BF_PLATFORM_INSTALL(bitfighter_test)
 
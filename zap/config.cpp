@@ -873,6 +873,9 @@ void writeServerBanList(CIniFile *ini, BanList *banList)
       ini->sectionComment("ServerBanList", " ");
       ini->sectionComment("ServerBanList", " Note: Wildcards (" + wildcard +") may be used for IP address and nickname" );
       ini->sectionComment("ServerBanList", " ");
+      ini->sectionComment("ServerBanList", " Note: A whole network can be banned by giving the IP address a prefix length,");
+      ini->sectionComment("ServerBanList", "   e.g. BanItem3=123.123.0.0/16" + delim + wildcard + delim + "20110131T123000" + delim + "30");
+      ini->sectionComment("ServerBanList", " ");
       ini->sectionComment("ServerBanList", " Note: ISO time format is in the following format: YYYYMMDDTHH24MISS");
       ini->sectionComment("ServerBanList", "   YYYY = four digit year, (e.g. 2011)");
       ini->sectionComment("ServerBanList", "     MM = month (01 - 12), (e.g. 01)");
@@ -62,7 +62,7 @@ U32 NameToAddressThread::run()
 ////////////////////////////////////////
 ////////////////////////////////////////
 
-static Vector<DatabaseObject *> fillVector2;
+static ThreadLocalVector<DatabaseObject *> fillVector2;
 
 ////////////////////////////////////
 ////////////////////////////////////
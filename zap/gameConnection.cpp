@@ -858,17 +858,7 @@ void GameConnection::markCurrentLevelAsDeleted()
 
 string GameConnection::undeleteMostRecentlyDeletedLevel()
 {
-   Vector<string> *skipList = mSettings->getLevelSkipList();
-
-   if(skipList->size() == 0)     // No deleted items to undelete
-      return "";
-
-   string name = skipList->last();
-   skipList->erase(skipList->size() - 1);
-
-   mSettings->saveSkipList();
-
-   return name;
+   return mSettings->removeLastLevelFromSkipList();     // "" if there are no deleted items to undelete
 }
 
 
@@ -2087,7 +2077,7 @@ bool GameConnection::readConnectRequest(BitStream *stream, NetConnection::Termin
    {
       // Now that we have the name, check if the client is banned,
       // can't use isAuthenticated() until after waiting for m2sSetAuthenticated, using needToCheckAuthentication instead.
-      if(mServerGame->getSettings()->getBanList()->isBanned(getNetAddress().toString(), string(name), needToCheckAuthentication))
+      if(mServerGame->getSettings()->getBanList()->isBanned(getNetAddress(), string(name), needToCheckAuthentication))
       {
          reason = ReasonBanned;
          return false;
@@ -1150,7 +1150,7 @@ void GameType::achievementAchieved(U8 achievement, const StringTableEntry &playe
 }
 
 
-static Vector<StringTableEntry> messageVals;     // Reusable container
+static ThreadLocalVector<StringTableEntry> messageVals;     // Reusable container, one per thread
 
 // Handle the end-of-game...  handles all games... not in any subclasses.
 // Can be overridden for any game-specific game over stuff.
@@ -1572,6 +1572,7 @@ void GameType::performScopeQuery(GhostConnection *connection)
 
    // What does the spy bug see?
    bool sameQuery = false;  // helps speed up by not repeatedly finding same objects
+   Vector<DatabaseObject *> spyBugObjects;   // Not fillVector; this may run on a worker thread
 
 
    const Vector<DatabaseObject *> *spyBugs = mLevel->findObjects_fast(SpyBugTypeNumber);
@@ -1588,21 +1589,108 @@ void GameType::performScopeQuery(GhostConnection *connection)
          Point scopeRange(SpyBug::SPY_BUG_RANGE, SpyBug::SPY_BUG_RANGE);
          queryRect.expand(scopeRange);
 
-         fillVector.clear();
-         mLevel->findObjects((TestFunc)isAnyObjectType, fillVector, queryRect, sameQuery);
+         spyBugObjects.clear();
+         mLevel->findObjects((TestFunc)isAnyObjectType, spyBugObjects, queryRect, sameQuery);
          sameQuery = true;
 
-         for(S32 j = 0; j < fillVector.size(); j++)
+         for(S32 j = 0; j < spyBugObjects.size(); j++)
          {
-            connection->objectInScope(static_cast<BfObject *>(fillVector[j]));
-            if(isShipType(fillVector[j]->getObjectTypeNumber()))
-               markAllMountedItemsAsBeingInScope(static_cast<Ship *>(fillVector[j]), conn);
+            connection->objectInScope(static_cast<BfObject *>(spyBugObjects[j]));
+            if(isShipType(spyBugObjects[j]->getObjectTypeNumber()))
+               markAllMountedItemsAsBeingInScope(static_cast<Ship *>(spyBugObjects[j]), conn);
          }
       }
    }
 }
 
 
+// Finds, once per team, everything that team's ships show on the commander's map, so players viewing the map
+// share one set of queries rather than each querying around every teammate.  Results are already filtered by
+// team visibility, and include anything carried by ships found.  Only teams with a player in the commander's
+// map are gathered.  Server only; ServerGame runs this right before sending packets, so the sets are only
+// valid while scoping for that send.
+void GameType::updateTeamScopeSets()
+{
+   S32 teamCount = isTeamGame() ? mGame->getTeamCount() : 0;
+
+   mTeamScopeSets.resize(teamCount);
+   for(S32 teamId = 0; teamId < teamCount; teamId++)
+      updateTeamScopeSet(teamId);
+}
+
+
+// Rebuilds a single team's set; see updateTeamScopeSets().  Anyone scoping outside of the send, such as
+// changeClientTeam(), needs to call this first, or they'll get whatever the team could see last tick.
+void GameType::updateTeamScopeSet(S32 teamId)
+{
+   if(teamId < 0 || teamId >= mTeamScopeSets.size())
+      return;
+
+   Vector<BfObject *> &teamScopeSet = mTeamScopeSets[teamId];
+   teamScopeSet.clear();
+
+   // Only gather the set if someone on the team will use it
+   bool teamNeedsSet = false;
+
+   for(S32 i = 0; i < mGame->getClientCount(); i++)
+   {
+      ClientInfo *clientInfo = mGame->getClientInfo(i);
+      GameConnection *conn = clientInfo->getConnection();
+
+      if(conn && conn->isInCommanderMap() && clientInfo->getTeamIndex() == teamId)
+      {
+         teamNeedsSet = true;
+         break;
+      }
+   }
+
+   if(!teamNeedsSet)
+      return;
+
+   Vector<DatabaseObject *> foundObjects;
+   bool sameQuery = false;  // Helps speed up by not repeatedly finding same objects
+
+   for(S32 i = 0; i < mGame->getClientCount(); i++)
+   {
+      ClientInfo *clientInfo = mGame->getClientInfo(i);
+
+      if(clientInfo->getTeamIndex() != teamId)      // Wrong team
+         continue;
+
+      Ship *ship = clientInfo->getShip();
+      if(!ship)            // Can happen!
+         continue;
+
+      Rect queryRect(ship->getActualPos(), ship->getActualPos());
+      queryRect.expand(Game::getScopeRange(ship->hasModule(ModuleSensor)));
+
+      TestFunc testFunc = ship->hasModule(ModuleSensor) ? &isVisibleOnCmdrsMapWithSensorType : &isVisibleOnCmdrsMapType;
+
+      mLevel->findObjects(testFunc, foundObjects, queryRect, sameQuery);
+      sameQuery = true;
+   }
+
+   for(S32 i = 0; i < foundObjects.size(); i++)
+   {
+      BfObject *obj = static_cast<BfObject *>(foundObjects[i]);
+
+      if(!obj->isVisibleToTeam(teamId))
+         continue;
+
+      teamScopeSet.push_back(obj);
+
+      // If a ship is in scope, anything it is carrying is also in scope
+      if(isShipType(obj->getObjectTypeNumber()))
+      {
+         Ship *ship = static_cast<Ship *>(obj);
+         for(S32 j = 0; j < ship->getMountedItemCount(); j++)
+            if(ship->getMountedItem(j))
+               teamScopeSet.push_back(ship->getMountedItem(j));
+      }
+   }
+}
+
+
 // Here is where we determine which objects are visible from player's ships.  Marks items as in-scope so they 
 // will be sent to client.
 // Only runs on server. 
@@ -1625,63 +1713,26 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
    //   }
    //}
 
-   // If we're in commander's map mode, then we can see what our teammates can see.  
-   // This will also scope what we can see.
-
    GameConnection *connection = clientInfo->getConnection();
    TNLAssert(connection, "NULL gameConnection!");
 
-   if(isTeamGame() && connection->isInCommanderMap())
-   {
-      S32 teamId = clientInfo->getTeamIndex();
-      fillVector.clear();
-      bool sameQuery = false;  // Helps speed up by not repeatedly finding same objects
-
-      for(S32 i = 0; i < mGame->getClientCount(); i++)
-      {
-         ClientInfo *clientInfo = mGame->getClientInfo(i);
-
-         if(clientInfo->getTeamIndex() != teamId)      // Wrong team
-            continue;
-
-         Ship *ship = clientInfo->getShip();
-         if(!ship)            // Can happen!
-            continue;
-
-         Rect queryRect(ship->getActualPos(), ship->getActualPos());
-         queryRect.expand(Game::getScopeRange(ship->hasModule(ModuleSensor)));
-
-         TestFunc testFunc;
-         if(scopeObject == ship)    
-            testFunc = &isAnyObjectType;
-         else
-            if(ship && ship->hasModule(ModuleSensor))
-               testFunc = &isVisibleOnCmdrsMapWithSensorType;
-            else     // No sensor
-               testFunc = &isVisibleOnCmdrsMapType;
+   Vector<DatabaseObject *> scopeObjects;    // Not fillVector; this may run on a worker thread
 
-         mLevel->findObjects(testFunc, fillVector, queryRect, sameQuery);
-         sameQuery = true;
-      }
-   }
-   else     // Not a team game OR not in commander's map -- Do a simple query of the objects within scope range of the ship
-   {
-      // Note that if we make mine visibility controlled by server, here's where we'd put the code
-      Point pos = scopeObject->getPos();
-      TNLAssert(dynamic_cast<Ship *>(scopeObject), "Control object is not a ship!");
-      Ship *ship = static_cast<Ship *>(scopeObject);
+   // Start with a simple query of the objects within scope range of the ship
+   // Note that if we make mine visibility controlled by server, here's where we'd put the code
+   Point pos = scopeObject->getPos();
+   TNLAssert(dynamic_cast<Ship *>(scopeObject), "Control object is not a ship!");
+   Ship *ship = static_cast<Ship *>(scopeObject);
 
-      Rect queryRect(pos, pos);
-      queryRect.expand(Game::getScopeRange(ship->hasModule(ModuleSensor)));
+   Rect queryRect(pos, pos);
+   queryRect.expand(Game::getScopeRange(ship->hasModule(ModuleSensor)));
 
-      fillVector.clear();
-      mLevel->findObjects((TestFunc)isAnyObjectType, fillVector, queryRect);
-   }
+   mLevel->findObjects((TestFunc)isAnyObjectType, scopeObjects, queryRect);
 
    // Set object-in-scope for all objects found above
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < scopeObjects.size(); i++)
    {
-      BfObject *obj = static_cast<BfObject *>(fillVector[i]);
+      BfObject *obj = static_cast<BfObject *>(scopeObjects[i]);
 
       if(!obj->isVisibleToTeam(connection->getClientInfo()->getTeamIndex()))
          continue;
@@ -1689,10 +1740,21 @@ void GameType::performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientI
       connection->objectInScope(obj);
 
       // If a ship is in scope, anything it is carrying is also in scope
-      if(isShipType(fillVector[i]->getObjectTypeNumber()))
+      if(isShipType(scopeObjects[i]->getObjectTypeNumber()))
          markAllMountedItemsAsBeingInScope(static_cast<Ship *>(obj), connection);
    }
 
+   // If we're in commander's map mode, then we can also see what our teammates can see
+   S32 teamId = clientInfo->getTeamIndex();
+
+   if(isTeamGame() && connection->isInCommanderMap() && teamId >= 0 && teamId < mTeamScopeSets.size())
+   {
+      const Vector<BfObject *> &teamScopeSet = mTeamScopeSets[teamId];
+
+      for(S32 i = 0; i < teamScopeSet.size(); i++)
+         connection->objectInScope(teamScopeSet[i]);
+   }
+
    // Make bots visible if showAllBots has been activated
    if(mShowAllBots && connection->isInCommanderMap())
       for(S32 i = 0; i < mGame->getBotCount(); i++)
@@ -2365,6 +2427,8 @@ void GameType::changeClientTeam(ClientInfo *client, S32 team)
    S32 teamIndex = team >= 0 ? team : (client->getTeamIndex() + 1) % mLevel->getTeamCount();  
    client->setTeamIndex(teamIndex);
 
+   // The team sets were built for the last send, before this client joined its new team
+   updateTeamScopeSet(teamIndex);
    client->getConnection()->clearUnscopedObjects();
 
    if(client->getTeamIndex() >= 0)                                                     // But if we know the team...
@@ -2654,6 +2718,17 @@ GAMETYPE_RPC_S2C(GameType, s2cClientChangedRoles, (StringTableEntry name, Ranged
 // Runs after the server knows that the client is available and addressable via the getGhostIndex()
 // Server only, obviously
 void GameType::onGhostAvailable(GhostConnection *theConnection)
+{
+   TNLAssert(!mGameOver, "Is this ever true here?");     // Not for clients, anyway.  4/26/2014
+
+   sendGameState(theConnection);
+}
+
+
+// Everything a client is told about the game, beyond its ghosts, when it first sees the GameType.  Also written
+// into each keyframe of a game recording, which can happen at any point in the game, including after it's over.
+// Server only
+void GameType::sendGameState(GhostConnection *theConnection)
 {
    NetObject::setRPCDestConnection(theConnection);    // Focus all RPCs on client only
 
@@ -2694,8 +2769,7 @@ void GameType::onGhostAvailable(GhostConnection *theConnection)
    sendWallsToClient();
 
    broadcastNewRemainingTime();
-   s2cSetGameOver(mGameOver);    // TODO: Is this really needed?
-   TNLAssert(!mGameOver, "Is this ever true here?");     // If this assert never trips... then we can get rid of the s2c above.  4/26/2014
+   s2cSetGameOver(mGameOver);    // Clients only ever see false here, but a keyframe written after the game ends doesn't
 
    s2cSyncMessagesComplete(theConnection->getGhostingSequence());
 
@@ -3730,11 +3804,6 @@ GAMETYPE_RPC_C2S(GameType, c2sSelectWeapon, (RangedU32<0, ShipWeaponCount> indx)
 }
 
 
-Vector<RangedU32<0, GameType::MaxPing> > GameType::mPingTimes; ///< Static vector used for constructing update RPCs
-Vector<SignedInt<24> > GameType::mScores;
-Vector<SignedFloat<8> > GameType::mRatings;  // 8 bits for 255 gradations between -1 and 1 ~ about 1 value per .01
-
-
 void GameType::updateClientScoreboard(GameConnection *gc)
 {
    mPingTimes.clear();
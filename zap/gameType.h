@@ -14,6 +14,7 @@
 #include "gameConnection.h"      // For MessageColors enum
 #include "GameTypesEnum.h"
 #include "DismountModesEnum.h"
+#include "BotNavMeshZone.h"     // For FlightPlanCache and ZoneNextHopTable
 
 #include "Timer.h"
 
@@ -69,6 +70,8 @@ private:
 
    bool mShowAllBots;
 
+   Vector<Vector<BfObject *> > mTeamScopeSets;  // Per team, what its ships show on the commander's map; see updateTeamScopeSets()
+
    bool mEngineerEnabled;
    bool mEngineerUnrestrictedEnabled;
 
@@ -255,12 +258,12 @@ public:
    virtual S32 getEventScore(ScoringGroup scoreGroup, ScoringEvent scoreEvent, S32 data);
    static string getScoringEventDescr(ScoringEvent event);
 
-   // Static vectors used for constructing update RPCs
+   // Reusable vectors used for constructing update RPCs -- per game, as a process can host several at once
    static const S32 MaxPing = 999;
 
-   static Vector<RangedU32<0, MaxPing> > mPingTimes;
-   static Vector<SignedInt<24> > mScores;
-   static Vector<SignedFloat<8> > mRatings;
+   Vector<RangedU32<0, MaxPing> > mPingTimes;
+   Vector<SignedInt<24> > mScores;
+   Vector<SignedFloat<8> > mRatings;       // 8 bits for 255 gradations between -1 and 1 ~ about 1 value per .01
 
    void addToGame(Game *game);
    virtual void addToGame(Game *game, Level *level);
@@ -371,8 +374,11 @@ public:
 
    void performScopeQuery(GhostConnection *connection);
    virtual void performProxyScopeQuery(BfObject *scopeObject, ClientInfo *clientInfo);
+   void updateTeamScopeSets();
+   void updateTeamScopeSet(S32 teamId);
 
    virtual void onGhostAvailable(GhostConnection *theConnection);
+   virtual void sendGameState(GhostConnection *theConnection);
    TNL_DECLARE_RPC(s2cSetLevelInfo, (StringTableEntry levelName, StringPtr levelDesc, StringPtr musicName, S32 teamScoreLimit,
                                      StringTableEntry levelCreds, S32 objectCount, 
                                      bool levelHasLoadoutZone, bool engineerEnabled, bool engineerAbuseEnabled, U32 levelDatabaseId));
@@ -506,7 +512,8 @@ public:
 
    void announceTeamsLocked(bool locked);
 
-   map <pair<U16,U16>, Vector<Point> > cachedBotFlightPlans;  // cache of zone-to-zone flight plans, shared for all bots
+   FlightPlanCache cachedBotFlightPlans;     // cache of zone-to-zone flight plans, shared for all bots
+   ZoneNextHopTable botZoneNextHops;         // Precomputed zone-to-zone routes, only built for small meshes
 };
 
 #define GAMETYPE_RPC_S2C(className, methodName, args, argNames) \
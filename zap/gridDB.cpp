@@ -10,33 +10,190 @@
 #include "GeomUtils.h"
 
 #include "tnlLog.h"
+#include "tnlThread.h"
 
 namespace Zap
 {
 
-U32 GridDatabase::mQueryId = 0;
-ClassChunker<DatabaseBucketEntry> *GridDatabase::mChunker = NULL;
-U32 GridDatabase::mCountGridDatabase = 0;
+// Slot bookkeeping shared by all DatabaseQueries; only touched when a query is created or destroyed
+static Mutex gQuerySlotMutex;
+static bool gQuerySlotInUse[DatabaseQuery::MaxSlots];
+static U32 gQuerySlotLastId[DatabaseQuery::MaxSlots];    // So a reused slot doesn't match stamps left by its previous owner
+static bool gQuerySlotWarned = false;
 
-static U32 getNextId() 
+// Frees a thread's default query, and with it its slot, when the thread exits
+static void deleteThreadQuery(void *query)
 {
-   static U32 nextId = 0;
-   return nextId++;
+   delete (DatabaseQuery *)query;
 }
 
+static ThreadStorage gThreadQuery(deleteThreadQuery);
+
+
 // Constructor
-GridDatabase::GridDatabase()
+DatabaseQuery::DatabaseQuery()
+{
+   mSlot = -1;
+   mQueryId = 0;
+   mVisitedCount = 0;
+
+   gQuerySlotMutex.lock();
+
+   for(S32 i = 0; i < MaxSlots; i++)
+      if(!gQuerySlotInUse[i])
+      {
+         gQuerySlotInUse[i] = true;
+         mSlot = i;
+         mQueryId = gQuerySlotLastId[i];
+         break;
+      }
+
+   bool warn = mSlot == -1 && !gQuerySlotWarned;
+   if(warn)
+      gQuerySlotWarned = true;
+
+   gQuerySlotMutex.unlock();
+
+   if(warn)
+      logprintf(LogConsumer::LogWarning, "Out of database query slots; queries will be a little slower");
+}
+
+
+// Destructor
+DatabaseQuery::~DatabaseQuery()
+{
+   if(mSlot == -1)
+      return;
+
+   gQuerySlotMutex.lock();
+   gQuerySlotLastId[mSlot] = mQueryId;
+   gQuerySlotInUse[mSlot] = false;
+   gQuerySlotMutex.unlock();
+}
+
+
+bool DatabaseQuery::hasSlot() const
+{
+   return mSlot != -1;
+}
+
+
+static inline U32 hashVisited(const DatabaseObject *object)
+{
+   return U32(size_t(object) >> 3) * 2654435761u;     // Knuth's multiplicative hash; objects are at least 8 aligned
+}
+
+
+bool DatabaseQuery::markVisited(DatabaseObject *object)
+{
+   if((mVisitedCount + 1) * 2 > mVisited.size())      // Keep it at most half full
+      growVisited();
+
+   const U32 mask = mVisited.size() - 1;
+
+   for(U32 i = hashVisited(object) & mask; ; i = (i + 1) & mask)
+   {
+      VisitedEntry &entry = mVisited[i];
+
+      if(entry.queryId != mQueryId)    // Empty, or left over from an earlier query
+      {
+         entry.object = object;
+         entry.queryId = mQueryId;
+         mVisitedCount++;
+         return true;
+      }
+
+      if(entry.object == object)
+         return false;
+   }
+}
+
+
+void DatabaseQuery::growVisited()
+{
+   Vector<VisitedEntry> old = mVisited;
+
+   mVisited.resize(max(old.size() * 2, 64));    // Stays a power of 2
+   for(S32 i = 0; i < mVisited.size(); i++)
+      mVisited[i].queryId = mQueryId - 1;
+
+   mVisitedCount = 0;
+
+   for(S32 i = 0; i < old.size(); i++)
+      if(old[i].queryId == mQueryId)
+         markVisited(old[i].object);
+}
+
+
+DatabaseQuery &DatabaseQuery::getThreadQuery()
+{
+   DatabaseQuery *query = (DatabaseQuery *)gThreadQuery.get();
+
+   if(!query)
+   {
+      query = new DatabaseQuery();
+      gThreadQuery.set(query);
+   }
+
+   return *query;
+}
+
+
+////////////////////////////////////////
+////////////////////////////////////////
+
+// Which object types a query is looking for; exactly one of the ways of specifying them is used
+struct QueryTypeFilter
+{
+   U8 typeNumber;
+   TestFunc testFunc;
+   const Vector<U8> *typeNumbers;
+
+   QueryTypeFilter(U8 typeNumber)                  { this->typeNumber = typeNumber; testFunc = NULL;     typeNumbers = NULL; }
+   QueryTypeFilter(TestFunc testFunc)              { typeNumber = 0; this->testFunc = testFunc;          typeNumbers = NULL; }
+   QueryTypeFilter(const Vector<U8> *typeNumbers)  { typeNumber = 0; testFunc = NULL; this->typeNumbers = typeNumbers; }
+
+   bool matches(U8 objectType) const
+   {
+      if(testFunc)
+         return testFunc(objectType);
+
+      if(typeNumbers)
+      {
+         for(S32 i = 0; i < typeNumbers->size(); i++)
+            if(typeNumbers->get(i) == objectType)
+               return true;
+
+         return false;
+      }
+
+      return objectType == typeNumber;
+   }
+};
+
+
+static Mutex gNextIdMutex;
+
+static U32 getNextId() 
 {
-   if(mChunker == NULL)
-      mChunker = new ClassChunker<DatabaseBucketEntry>();        // Static shared by all databases, reference counted and deleted in destructor
+   static U32 nextId = 0;
 
-   mCountGridDatabase++;
+   gNextIdMutex.lock();
+   U32 id = nextId++;
+   gNextIdMutex.unlock();
 
-   for(U32 i = 0; i < BucketRowCount; i++)
-      for(U32 j = 0; j < BucketRowCount; j++)
-         mBuckets[i][j].nextInBucket = NULL;
+   return id;
+}
 
+// Constructor
+GridDatabase::GridDatabase(SpatialIndex::IndexType indexType)
+{
+   mSpatialIndex = SpatialIndex::create(indexType);
    mDatabaseId = getNextId();
+   mNextInsertionOrder = 0;
+   mOrderedObjectsValid = true;
+   mStaticExtentsValid = true;
+   mNewObjectsAreDynamic = false;
 }
 
 
@@ -45,15 +202,39 @@ GridDatabase::~GridDatabase()
 {
    removeEverythingFromDatabase();
 
-   TNLAssert(mChunker != NULL || mCountGridDatabase != 0, "Running GridDatabase destructor without initalizing?");
+   delete mSpatialIndex;
+}
 
-   mCountGridDatabase--;
 
-   if(mCountGridDatabase == 0)
-   {
-      delete mChunker;
-      mChunker = NULL;
-   }
+SpatialIndex::IndexType GridDatabase::getSpatialIndexType() const
+{
+   return mSpatialIndex->getType();
+}
+
+
+// Swap in a different kind of spatial index, and move all our objects into it
+void GridDatabase::setSpatialIndexType(SpatialIndex::IndexType indexType)
+{
+   if(indexType == mSpatialIndex->getType())
+      return;
+
+   delete mSpatialIndex;
+   mSpatialIndex = SpatialIndex::create(indexType);
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+      mSpatialIndex->insert(mAllObjects[i], mAllObjects[i]->mExtent);
+}
+
+
+// Let the index size itself to the level; all objects are reinserted, so this is best done before the db is populated,
+// or just after a bulk load
+void GridDatabase::setSpatialIndexExtents(const Rect &worldExtents)
+{
+   mSpatialIndex->clear();
+   mSpatialIndex->setWorldExtents(worldExtents);
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
+      mSpatialIndex->insert(mAllObjects[i], mAllObjects[i]->mExtent);
 }
 
 
@@ -80,21 +261,27 @@ static void sortObjects(Vector<DatabaseObject *> &objects)
 }
 
 
+static S32 QSORT_CALLBACK insertionOrderSort(DatabaseObject **a, DatabaseObject **b)
+{
+   U32 orderA = (*a)->getInsertionOrder();
+   U32 orderB = (*b)->getInsertionOrder();
+
+   return orderA < orderB ? -1 : (orderA > orderB ? 1 : 0);
+}
+
+
 // Fill this database with objects from existing database
 void GridDatabase::copyObjects(const GridDatabase *source)
 {
-   // Preallocate some memory to make copying a little more efficient
-   mAllObjects.reserve(source->mAllObjects.size());
-   mGoalZones .reserve(source->mGoalZones.size());
-   mFlags     .reserve(source->mFlags.size());
-   mSpyBugs   .reserve(source->mSpyBugs.size());
-   mPolyWalls .reserve(source->mPolyWalls.size());
-   mWallitems .reserve(source->mWallitems.size());
+   // Add clones in geometric order, so that's the order findObjects_ordered() will give them back in
+   Vector<DatabaseObject *> sourceObjects(*source->findObjects_ordered());
+   sortObjects(sourceObjects);
 
-   for(S32 i = 0; i < source->mAllObjects.size(); i++)
-      addToDatabase(source->mAllObjects[i]->clone());
+   // Preallocate some memory to make copying a little more efficient
+   mAllObjects.reserve(sourceObjects.size());
 
-   sortObjects(mAllObjects);
+   for(S32 i = 0; i < sourceObjects.size(); i++)
+      addToDatabase(sourceObjects[i]->clone());
 }
 
 
@@ -105,7 +292,6 @@ void GridDatabase::addToDatabase(DatabaseObject *object)
    TNLAssert(object->mDatabase != this, "Already added to database, trying to add to same database again!");
    TNLAssert(!object->mDatabase,        "Already added to database, trying to add to different database!");
    TNLAssert(object->getExtentSet(),    "Object extents were never set!");
-   TNLAssert(!object->mBucketList,      "BucketList must be NULL");
 
    // WallItems should not be added to the database during a regular game, but the editor will add them...
    //TNLAssert(object->getObjectTypeNumber() != WallItemTypeNumber, "Should not add wall items to the database!");
@@ -115,41 +301,93 @@ void GridDatabase::addToDatabase(DatabaseObject *object)
 
    object->mDatabase = this;
 
-   static IntRect bins;
-   fillBins(object->getExtent(), bins);
+   mSpatialIndex->insert(object, object->mExtent);
 
-   for(S32 x = bins.minx; bins.maxx - x >= 0; x++)
-      for(S32 y = bins.miny; bins.maxy - y >= 0; y++)
-      {
-         DatabaseBucketEntry *be = mChunker->alloc();
-         DatabaseBucketEntryBase *base = &mBuckets[x & BucketMask][y & BucketMask];
-         be->theObject = object;
-         if(base->nextInBucket)
-            base->nextInBucket->prevInBucket = be;
-         be->nextInBucket = base->nextInBucket;
-         be->prevInBucket = base;
-         base->nextInBucket = be;
-         be->nextInBucketForThisObject = object->mBucketList;
-         object->mBucketList = be;
-      }
+   if(mNewObjectsAreDynamic)
+      addToDynamicList(object);
+   else if(getStaticObjectCount() == 0)
+   {
+      mStaticExtents = object->mExtent;
+      mStaticExtentsValid = true;
+   }
+   else if(mStaticExtentsValid)
+      mStaticExtents.unionRect(object->mExtent);
 
    // Add the object to our non-spatial "database" as well
+   object->mDatabaseIndex = mAllObjects.size();
+   object->mInsertionOrder = mNextInsertionOrder++;
    mAllObjects.push_back(object);
 
+   addToTypeList(object);
+
+   mOrderedObjectsValid = false;
+}
+
+
+// Private helper
+void GridDatabase::addToTypeList(DatabaseObject *object)
+{
    U8 type = object->getObjectTypeNumber();
+   Vector<DatabaseObject *> &typeList = mObjectsByType[type];
 
-   if(type == GoalZoneTypeNumber)
-      mGoalZones.push_back(object);
-   else if(type == FlagTypeNumber)
-      mFlags.push_back(object);
-   else if(type == SpyBugTypeNumber)
-      mSpyBugs.push_back(object);
-   else if(type == PolyWallTypeNumber)
-      mPolyWalls.push_back(object);
-   else if(type == WallItemTypeNumber)
-      mWallitems.push_back(object);
+   object->mDatabaseTypeNumber = type;
+   object->mTypeListIndex = typeList.size();
+   typeList.push_back(object);
+}
 
-   //sortObjects(mAllObjects);  // problem: Barriers in-game don't have mGeometry (it is NULL)
+
+// Private helper
+void GridDatabase::addToDynamicList(DatabaseObject *object)
+{
+   object->mDynamicListIndex = mDynamicObjects.size();
+   mDynamicObjects.push_back(object);
+}
+
+
+// Private helper
+void GridDatabase::removeFromDynamicList(DatabaseObject *object)
+{
+   S32 index = object->mDynamicListIndex;
+   TNLAssert(mDynamicObjects[index] == object, "Dynamic object list is out of sync!");
+
+   mDynamicObjects[index] = mDynamicObjects.last();
+   mDynamicObjects[index]->mDynamicListIndex = index;
+   mDynamicObjects.pop_back();
+
+   object->mDynamicListIndex = -1;
+}
+
+
+// Private helper -- a static object with the specified extents is being removed or is becoming dynamic.  If it
+// was on the edge of the static extents, they may shrink, so we'll need to recompute them.
+void GridDatabase::staticExtentsLosing(const Rect &extents)
+{
+   if(extents.min.x <= mStaticExtents.min.x || extents.min.y <= mStaticExtents.min.y ||
+      extents.max.x >= mStaticExtents.max.x || extents.max.y >= mStaticExtents.max.y)
+      mStaticExtentsValid = false;
+}
+
+
+// Private helper
+S32 GridDatabase::getStaticObjectCount() const
+{
+   return mAllObjects.size() - mDynamicObjects.size();
+}
+
+
+// Private helper -- uses the type the object was filed under, which may not match its current type
+void GridDatabase::removeFromTypeList(DatabaseObject *object)
+{
+   Vector<DatabaseObject *> &typeList = mObjectsByType[object->mDatabaseTypeNumber];
+   S32 index = object->mTypeListIndex;
+
+   TNLAssert(typeList[index] == object, "Type list is out of sync!");
+
+   typeList[index] = typeList.last();
+   typeList[index]->mTypeListIndex = index;
+   typeList.pop_back();
+
+   object->mTypeListIndex = -1;
 }
 
 
@@ -173,45 +411,33 @@ void GridDatabase::addToDatabase(const Vector<BfObject *> &objects)
 // Removes and deletes all objects in database
 void GridDatabase::removeEverythingFromDatabase()
 {
-   for(S32 x = 0; x < BucketRowCount; x++)
+   mSpatialIndex->clear();
+
+   for(S32 i = 0; i < mAllObjects.size(); i++)
    {
-      for(S32 y = 0; y < BucketRowCount; y++)
-      {
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; )
-         {
-            DatabaseBucketEntry *rem = walk;
-            walk->theObject->mDatabase = NULL;  // make sure object don't point to this database anymore
-            walk->theObject->mBucketList = NULL;
-            walk = rem->nextInBucket;
-            mChunker->free(rem);
-         }
-         mBuckets[x & BucketMask][y & BucketMask].nextInBucket = NULL;
-      }
+      mAllObjects[i]->mDatabase = NULL;     // Make sure objects don't point to this database anymore
+      mAllObjects[i]->mDatabaseIndex = -1;
+      mAllObjects[i]->mTypeListIndex = -1;
+      mAllObjects[i]->mDynamicListIndex = -1;
    }
 
-   // Clear out our specialty lists -- since objects are also in mAllObjects, they'll be deleted below
-   mGoalZones.clear();
-   mFlags.clear();
-   mSpyBugs.clear();
-   mPolyWalls.clear();
-   mWallitems.clear();
+   mDynamicObjects.clear();
+   mStaticExtentsValid = true;
+   mNewObjectsAreDynamic = false;
 
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      mAllObjects[i]->deleteThyself();
+   // Clear out our type lists -- since objects are also in mAllObjects, they'll be deleted below
+   for(S32 i = 0; i < TypeListCount; i++)
+      mObjectsByType[i].clear();
 
-   mAllObjects.clear();
-}
+   mOrderedObjects.clear();
+   mOrderedObjectsValid = true;
 
+   // Grab our list before deleting anything, in case deleting an object tries to remove it from the database again
+   Vector<DatabaseObject *> objects;
+   objects.getStlVector().swap(mAllObjects.getStlVector());
 
-// Don't use this with a sorted list!
-static void eraseObject_fast(Vector<DatabaseObject *> *objects, DatabaseObject *objectToDelete)
-{
-   for(S32 i = 0; i < objects->size(); i++)
-      if(objects->get(i) == objectToDelete)
-      {
-         objects->erase_fast(i);     
-         return;
-      }
+   for(S32 i = 0; i < objects.size(); i++)
+      objects[i]->deleteThyself();
 }
 
 
@@ -231,45 +457,28 @@ void GridDatabase::removeFromDatabase(DatabaseObject *object, bool deleteObject)
    if(object->mDatabase != this)
       return;
 
-   const Rect &extents = object->mExtent;
    object->mDatabase = NULL;
 
-   static IntRect bins;
-   fillBins(extents, bins);
+   mSpatialIndex->remove(object, object->mExtent);
 
-   while(object->mBucketList)
-   {
-      DatabaseBucketEntry *b = object->mBucketList;
-      TNLAssert(b->theObject == object, "Object mismatch");
-      TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
-      if(b->nextInBucket)
-         b->nextInBucket->prevInBucket = b->prevInBucket;
-      b->prevInBucket->nextInBucket = b->nextInBucket;
-      object->mBucketList = b->nextInBucketForThisObject;
-      mChunker->free(b);
-   }
+   // Remove object from our non-spatial databases by moving the last item into its slot
+   S32 index = object->mDatabaseIndex;
+   TNLAssert(mAllObjects[index] == object, "Object list is out of sync!");
 
-   // Find and delete object from our non-spatial databases
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(mAllObjects[i] == object)
-      {
-         mAllObjects.erase(i);            // mAllObjects is sorted, so we can't use erase_fast
-         break;
-      }
+   mAllObjects[index] = mAllObjects.last();
+   mAllObjects[index]->mDatabaseIndex = index;
+   mAllObjects.pop_back();
 
+   object->mDatabaseIndex = -1;
 
-   U8 type = object->getObjectTypeNumber();
+   removeFromTypeList(object);
+
+   if(object->mDynamicListIndex != -1)
+      removeFromDynamicList(object);
+   else if(mStaticExtentsValid)
+      staticExtentsLosing(object->mExtent);
 
-   if(type == GoalZoneTypeNumber)
-      eraseObject_fast(&mGoalZones, object);
-   else if(type == FlagTypeNumber)
-      eraseObject_fast(&mFlags, object);
-   else if(type == SpyBugTypeNumber)
-      eraseObject_fast(&mSpyBugs, object);
-   else if(type == PolyWallTypeNumber)
-      eraseObject_fast(&mPolyWalls, object);
-   else if(type == WallItemTypeNumber)
-      eraseObject_fast(&mWallitems, object);
+   mOrderedObjectsValid = false;
 
    if(deleteObject)
       object->deleteThyself();
@@ -285,156 +494,141 @@ void GridDatabase::findObjects(Vector<DatabaseObject *> &fillVector) const
 }
 
 
-// Faster than above, but results can't be modified
+// Faster than above, but results can't be modified.  Order will change as objects are removed.
 const Vector<DatabaseObject *> *GridDatabase::findObjects_fast() const
 {
    return &mAllObjects;
 }
 
 
-// Faster than above, but results can't be modified, and only works with selected types at the moment
+// Faster than above, but results can't be modified.  Note that objects that have been marked for deletion,
+// but not yet removed from the database, will still be in this list.
 const Vector<DatabaseObject *> *GridDatabase::findObjects_fast(U8 typeNumber) const
 {
-   if(typeNumber == GoalZoneTypeNumber)
-      return &mGoalZones;
+   return &mObjectsByType[typeNumber];
+}
 
-   if(typeNumber == FlagTypeNumber)
-      return &mFlags;
 
-   if(typeNumber == SpyBugTypeNumber)
-      return &mSpyBugs;
+// Returns all objects in the order they were added (or, after copyObjects(), in geometric order).  The editor needs
+// a stable order for rendering and saving; everyone else should use findObjects_fast().  The list is rebuilt lazily
+// after objects have been added or removed, so don't modify the database while iterating over it, and don't call it
+// from worker threads.
+const Vector<DatabaseObject *> *GridDatabase::findObjects_ordered() const
+{
+   if(!mOrderedObjectsValid)
+   {
+      mOrderedObjects = mAllObjects;
 
-   if(typeNumber == PolyWallTypeNumber)
-      return &mPolyWalls;
+      if(mOrderedObjects.size() >= 2)
+         qsort(&mOrderedObjects[0], mOrderedObjects.size(), sizeof(DatabaseObject *), (qsort_compare_func) insertionOrderSort);
 
-   if(typeNumber == WallItemTypeNumber)
-      return &mWallitems;
+      mOrderedObjectsValid = true;
+   }
 
-   TNLAssert(false, "This type not currently supported!  Sorry dude!");
-   return NULL;
+   return &mOrderedObjects;
 }
 
 
-void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const
+// All spatial queries end up here.  With sameQuery set, objects found by the previous query made with this
+// DatabaseQuery won't be found again, so results of several queries can be combined without duplicates.
+void GridDatabase::findObjects(DatabaseQuery &query, const QueryTypeFilter &filter, Vector<DatabaseObject *> &fillVector,
+                               const Rect &extents, bool sameQuery) const
 {
-   static Vector<U8> types;
-   types.resize(1);
+   TNLAssert(this, "findObjects 'this' is NULL");
 
-   types[0] = typeNumber;
+   query.mCells.clear();
+   mSpatialIndex->findCells(extents, query.mCells);
 
-   findObjects(types, fillVector, extents, bins);
-}
+   if(!sameQuery)
+   {
+      query.mQueryId++;    // Used to prevent the same item from being found in multiple cells
+      query.mVisitedCount = 0;
+   }
 
+   const S32 slot = query.mSlot;
+   const U32 queryId = query.mQueryId;
 
-void GridDatabase::findObjects(Vector<U8> typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const
-{
-   mQueryId++;    // Used to prevent the same item from being found in multiple buckets
+   for(S32 i = 0; i < query.mCells.size(); i++)
+   {
+      const SpatialCell &cell = *query.mCells[i];
 
-   for(S32 x = bins->minx; bins->maxx - x >= 0; x++)
-      for(S32 y = bins->miny; bins->maxy - y >= 0; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
-         {
-            DatabaseObject *theObject = walk->theObject;
-
-            if(theObject->mLastQueryId != mQueryId &&                         // Object hasn't been queried; and
-               testTypes(typeNumbers, theObject->getObjectTypeNumber()) &&    // is of the right type; and
-               (!extents || theObject->mExtent.intersects(*extents)) )        // overlaps our extents (if passed)
-            {
-               walk->theObject->mLastQueryId = mQueryId;    // Flag the object so we know we've already visited it
-               fillVector.push_back(walk->theObject);       // And save it as a found item
-            }
-         }
-}
+      for(S32 j = 0; j < cell.size(); j++)
+      {
+         DatabaseObject *theObject = cell[j];
 
+         if(slot >= 0 && theObject->mLastQueryId[slot] == queryId)     // Already found this one
+            continue;
 
-// Find all objects in database of type typeNumber
-void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector) const
-{
-   // If the user is looking for a type we maintain a list for, it will be faster to use that list than to cycle through the general item list.
-   TNLAssert(typeNumber != GoalZoneTypeNumber && typeNumber != FlagTypeNumber && 
-             typeNumber != SpyBugTypeNumber   && typeNumber != PolyWallTypeNumber, 
-             "Can use findObjects_fast()?  If not, uncomment the appropriate block below; it will perform better!");
+         if(filter.matches(theObject->getObjectTypeNumber()) &&        // Object is of the right type; and
+            theObject->mExtent.intersects(extents))                    // overlaps our extents
+         {
+            if(slot >= 0)
+               theObject->mLastQueryId[slot] = queryId;     // Flag the object so we know we've already visited it
+            else if(!query.markVisited(theObject))          // No stamps available, so we keep track ourselves
+               continue;
 
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(mAllObjects[i]->getObjectTypeNumber() == typeNumber)
-         fillVector.push_back(mAllObjects[i]);
+            fillVector.push_back(theObject);       // Save it as a found item
+         }
+      }
+   }
 }
 
 
-// Translates extents into bins to search
-void GridDatabase::fillBins(const Rect &extents, IntRect &bins) const
+// Find all objects in database of type typeNumber; skips objects whose type has changed since they were added
+// (i.e. those marked for deletion)
+void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector) const
 {
-   bins.minx = S32(extents.min.x) >> BucketWidthBitShift;
-   bins.miny = S32(extents.min.y) >> BucketWidthBitShift;
-   bins.maxx = S32(extents.max.x) >> BucketWidthBitShift;
-   bins.maxy = S32(extents.max.y) >> BucketWidthBitShift;
+   const Vector<DatabaseObject *> &typeList = mObjectsByType[typeNumber];
 
-   if(U32(bins.maxx - bins.minx) >= BucketRowCount)
-      bins.maxx = bins.minx + BucketRowCount - 1;
-
-   if(U32(bins.maxy - bins.miny) >= BucketRowCount)
-      bins.maxy = bins.miny + BucketRowCount - 1;
+   for(S32 i = 0; i < typeList.size(); i++)
+      if(typeList[i]->getObjectTypeNumber() == typeNumber)
+         fillVector.push_back(typeList[i]);
 }
 
 
 // Find all objects in &extents that are of type typeNumber
 void GridDatabase::findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   static IntRect bins;
-   fillBins(extents, bins);
-
-   findObjects(typeNumber, fillVector, &extents, &bins);
+   findObjects(DatabaseQuery::getThreadQuery(), QueryTypeFilter(typeNumber), fillVector, extents, false);
 }
 
 
-void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins, bool sameQuery) const
+void GridDatabase::findObjects(DatabaseQuery &query, U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   TNLAssert(this, "findObjects 'this' is NULL");
-   if(!sameQuery)
-      mQueryId++;    // Used to prevent the same item from being found in multiple buckets
-
-   for(S32 x = bins->minx; bins->maxx - x >= 0; x++)
-      for(S32 y = bins->miny; bins->maxy - y >= 0; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
-         {
-            DatabaseObject *theObject = walk->theObject;
-
-            if(theObject->mLastQueryId != mQueryId &&                      // Object hasn't been queried; and
-               (testFunc(theObject->getObjectTypeNumber())) &&             // is of the right type; and
-               (!extents || theObject->mExtent.intersects(*extents)) )     // overlaps our extents (if passed)
-            {
-               walk->theObject->mLastQueryId = mQueryId;    // Flag the object so we know we've already visited it
-               fillVector.push_back(walk->theObject);       // And save it as a found item
-            }
-         }
+   findObjects(query, QueryTypeFilter(typeNumber), fillVector, extents, false);
 }
 
 
 // Find all objects in database using derived type test function
 void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector) const
 {
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(testFunc(mAllObjects[i]->getObjectTypeNumber()))
-         fillVector.push_back(mAllObjects[i]);
+   // Test each type once, rather than each object
+   for(S32 i = 0; i < TypeListCount; i++)
+      if(mObjectsByType[i].size() > 0 && testFunc(U8(i)))
+         findObjects(U8(i), fillVector);
 }
 
 
 // Find all objects in database using derived type test function
 void GridDatabase::findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const
 {
-   static IntRect bins;
-   fillBins(extents, bins);
+   findObjects(DatabaseQuery::getThreadQuery(), QueryTypeFilter(&types), fillVector, extents, false);
+}
+
 
-   findObjects(types, fillVector, &extents, &bins);
+void GridDatabase::findObjects(DatabaseQuery &query, const Vector<U8> &types, Vector<DatabaseObject *> &fillVector,
+                               const Rect &extents) const
+{
+   findObjects(query, QueryTypeFilter(&types), fillVector, extents, false);
 }
 
 
 // Find all objects in database using derived type test function
 void GridDatabase::findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector) const
 {
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(testTypes(types, mAllObjects[i]->getObjectTypeNumber()))
-         fillVector.push_back(mAllObjects[i]);
+   for(S32 i = 0; i < types.size(); i++)
+      if(types.getIndex(types[i]) == i)     // Skip dupes in types
+         findObjects(types[i], fillVector);
 }
 
 
@@ -451,23 +645,29 @@ bool GridDatabase::testTypes(const Vector<U8> &types, U8 objectType) const
 // Find all objects in &extents derived type test function
 void GridDatabase::findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents, bool sameQuery) const
 {
-   static IntRect bins;
-   fillBins(extents, bins);
+   findObjects(DatabaseQuery::getThreadQuery(), QueryTypeFilter(testFunc), fillVector, extents, sameQuery);
+}
 
-   findObjects(testFunc, fillVector, &extents, &bins, sameQuery);
+
+void GridDatabase::findObjects(DatabaseQuery &query, TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents,
+                               bool sameQuery) const
+{
+   findObjects(query, QueryTypeFilter(testFunc), fillVector, extents, sameQuery);
 }
 
 
 void GridDatabase::dumpObjects()
 {
-   for(S32 x = 0; x < BucketRowCount; x++)
-      for(S32 y = 0; y < BucketRowCount; y++)
-         for(DatabaseBucketEntry *walk = mBuckets[x & BucketMask][y & BucketMask].nextInBucket; walk; walk = walk->nextInBucket)
-         {
-            DatabaseObject *object = walk->theObject;
-            logprintf("Found object in (%d,%d) with extents %s", x, y, object->getExtent().toString().c_str());
-            logprintf("Obj coords: %s", static_cast<BfObject *>(object)->getPos().toString().c_str());
-         }
+   Vector<const SpatialCell *> cells;
+   mSpatialIndex->findAllCells(cells);
+
+   for(S32 i = 0; i < cells.size(); i++)
+      for(S32 j = 0; j < cells[i]->size(); j++)
+      {
+         DatabaseObject *object = cells[i]->get(j);
+         logprintf("Found object in cell %d with extents %s", i, object->getExtent().toString().c_str());
+         logprintf("Obj coords: %s", static_cast<BfObject *>(object)->getPos().toString().c_str());
+      }
 }
 
 
@@ -482,41 +682,53 @@ static S32 findFirstNonUnknownTypeObject(const Vector<DatabaseObject *> &allObje
 }
 
 
-// Get the extents of every object in the database
+// Get the extents of every object in the database.  Static extents are cached, and only recomputed when a static
+// object on their edge goes away; we only have to visit the dynamic objects each time.
 Rect GridDatabase::getExtents()
 {
    if(mAllObjects.size() == 0)     // No objects ==> no extents!
       return Rect();
 
-   Rect rect;
-
-   // Think we can delete from HERE...   inserted this comment 27-Jan-2012  #########################################
    // To the best of my knowledge, the assert below has never fired 5/24/2014 -Wat
-
-   // All this rigamarole is to make world extent correct for levels that do not overlap (0,0)
-   // The problem is that the GameType is treated as an object, and has the extent (0,0), and
-   // a mask of UnknownType.  Fortunately, the GameType tends to be first, so what we do is skip
-   // all objects until we find an UnknownType object, then start creating our extent from there.
-   // We have to assign theRect to an extent object initially to avoid getting the default coords
-   // of (0,0) that are assigned by the constructor.
-
-
-   //S32 first = findFirstNonUnknownTypeObject(mAllObjects);
-
    TNLAssert(findFirstNonUnknownTypeObject(mAllObjects) == 0, 
              "I think this should never happen -- how would an object with UnknownTypeNumber get in the database?? \
-             if it does, please document it and remove this assert, along withthe rect = line below -Wat");
+             if it does, please document it and remove this assert -Wat");
 
-   //if(first == -1)      // No suitable objects found, return empty extents
-   //   return Rect();
+   Rect rect;
+   bool haveRect = false;
 
-   // ...to HERE
+   if(getStaticObjectCount() > 0)
+   {
+      if(!mStaticExtentsValid)
+      {
+         bool first = true;
+         for(S32 i = 0; i < mAllObjects.size(); i++)
+         {
+            if(mAllObjects[i]->mDynamicListIndex != -1)
+               continue;
+
+            if(first)
+               mStaticExtents = mAllObjects[i]->getExtent();
+            else
+               mStaticExtents.unionRect(mAllObjects[i]->getExtent());
+            first = false;
+         }
+         mStaticExtentsValid = true;
+      }
 
-   rect = mAllObjects[0]->getExtent();
+      rect = mStaticExtents;
+      haveRect = true;
+   }
 
-   // Now start unioning the extents of remaining objects.  Should be all of them.
-   for(S32 i = 1; i < mAllObjects.size(); i++)
-      rect.unionRect(mAllObjects[i]->getExtent());
+   // Now union in everything that moves
+   for(S32 i = 0; i < mDynamicObjects.size(); i++)
+   {
+      if(haveRect)
+         rect.unionRect(mDynamicObjects[i]->getExtent());
+      else
+         rect = mDynamicObjects[i]->getExtent();
+      haveRect = true;
+   }
 
    return rect;
 }
@@ -553,11 +765,17 @@ DatabaseObject::~DatabaseObject()
 // Code that needs to run for both constructor and copy constructor
 void DatabaseObject::initialize() 
 {
-   mLastQueryId = 0; 
+   for(S32 i = 0; i < DatabaseQuery::MaxSlots; i++)
+      mLastQueryId[i] = 0; 
+
    mExtent = Rect(); 
    mExtentSet = false;
    mDatabase = NULL;
-   mBucketList = NULL;
+   mDatabaseIndex = -1;
+   mTypeListIndex = -1;
+   mDatabaseTypeNumber = UnknownTypeNumber;
+   mInsertionOrder = 0;
+   mDynamicListIndex = -1;
 }
 
 
@@ -577,15 +795,8 @@ DatabaseObject *GridDatabase::findObjectLOS(U8 typeNumber, U32 stateIndex, bool
                                             const Point &rayStart, const Point &rayEnd,
                                             float &collisionTime, Point &surfaceNormal) const
 {
-   Rect queryRect(rayStart, rayEnd);
-
-   // Use a local copy here, most callers expect our global fillVector to remain unchanged
-   static Vector<DatabaseObject *> fillVector;  
-   fillVector.clear();
-
-   findObjects(typeNumber, fillVector, queryRect);
-
-   return findObjectLOS(fillVector, stateIndex, format, rayStart, rayEnd, collisionTime, surfaceNormal);
+   return findObjectLOS(DatabaseQuery::getThreadQuery(), typeNumber, stateIndex, format, rayStart, rayEnd, 
+                        collisionTime, surfaceNormal);
 }
 
 
@@ -593,15 +804,31 @@ DatabaseObject *GridDatabase::findObjectLOS(TestFunc testFunc, U32 stateIndex, b
                                             const Point &rayStart, const Point &rayEnd, 
                                             F32 &collisionTime, Point &surfaceNormal) const
 {
-   Rect queryRect(rayStart, rayEnd);
+   return findObjectLOS(DatabaseQuery::getThreadQuery(), testFunc, stateIndex, format, rayStart, rayEnd, 
+                        collisionTime, surfaceNormal);
+}
 
-   // Use a local copy here, most callers expect our global fillVector to remain unchanged
-   static Vector<DatabaseObject *> fillVector;  
-   fillVector.clear();
 
-   findObjects(testFunc, fillVector, queryRect);
+// Candidates are gathered in the query's own list, so callers' vectors (including the global fillVector) are left alone
+DatabaseObject *GridDatabase::findObjectLOS(DatabaseQuery &query, U8 typeNumber, U32 stateIndex, bool format,
+                                            const Point &rayStart, const Point &rayEnd,
+                                            F32 &collisionTime, Point &surfaceNormal) const
+{
+   query.mLosCandidates.clear();
+   findObjects(query, QueryTypeFilter(typeNumber), query.mLosCandidates, Rect(rayStart, rayEnd), false);
 
-   return findObjectLOS(fillVector, stateIndex, format, rayStart, rayEnd, collisionTime, surfaceNormal);
+   return findObjectLOS(query.mLosCandidates, stateIndex, format, rayStart, rayEnd, collisionTime, surfaceNormal);
+}
+
+
+DatabaseObject *GridDatabase::findObjectLOS(DatabaseQuery &query, TestFunc testFunc, U32 stateIndex, bool format,
+                                            const Point &rayStart, const Point &rayEnd,
+                                            F32 &collisionTime, Point &surfaceNormal) const
+{
+   query.mLosCandidates.clear();
+   findObjects(query, QueryTypeFilter(testFunc), query.mLosCandidates, Rect(rayStart, rayEnd), false);
+
+   return findObjectLOS(query.mLosCandidates, stateIndex, format, rayStart, rayEnd, collisionTime, surfaceNormal);
 }
 
 
@@ -696,130 +923,69 @@ S32 GridDatabase::getObjectCount() const
 }
 
 
-// Return count of objects of specified type.  Only supports certain types at the moment.
+// Return count of objects of specified type, including any marked for deletion but not yet removed
 S32 GridDatabase::getObjectCount(U8 typeNumber) const
 {
-   if(typeNumber == GoalZoneTypeNumber)
-      return mGoalZones.size();
-
-   if(typeNumber == FlagTypeNumber)
-      return mFlags.size();
-
-   if(typeNumber == SpyBugTypeNumber)
-      return mSpyBugs.size();
-
-   if(typeNumber == PolyWallTypeNumber)
-      return mPolyWalls.size();
-
-   if(typeNumber == WallItemTypeNumber)
-      return mWallitems.size();
-
-
-   TNLAssert(false, "Unsupported type!");
-   return 0;
+   return mObjectsByType[typeNumber].size();
 }
 
 
 bool GridDatabase::hasObjectOfType(U8 typeNumber) const
 {
-   if(typeNumber == GoalZoneTypeNumber)
-      return mGoalZones.size() > 0;
-
-   if(typeNumber == FlagTypeNumber)
-      return mFlags.size() > 0;
-
-   if(typeNumber == SpyBugTypeNumber)
-      return mSpyBugs.size() > 0;
+   const Vector<DatabaseObject *> &typeList = mObjectsByType[typeNumber];
 
-   if(typeNumber == PolyWallTypeNumber)
-      return mPolyWalls.size() > 0;
-
-   if(typeNumber == WallItemTypeNumber)
-      return mWallitems.size() > 0;
-
-   for(S32 i = 0; i < mAllObjects.size(); i++)
-      if(mAllObjects[i]->getObjectTypeNumber() == typeNumber)
+   for(S32 i = 0; i < typeList.size(); i++)
+      if(typeList[i]->getObjectTypeNumber() == typeNumber)
          return true;
 
    return false;
 }
 
 
-// Kind of hacky, kind of useful.  Only used by BotZones, and ony works because all zones are added at one time, the list does not change,
-// and the index of the bot zones is stored as an ID by the zone.  If we added and removed zones from our list, this would probably not
-// be a reliable way to access a specific item.  We could probably phase this out by passing pointers to zones rather than indices.
+// Kind of hacky, kind of useful.  Used by the editor dock, and only works because items there are added at one time and
+// the list does not change.  If we added and removed items from our list, this would probably not be a reliable way to
+// access a specific item.  Index is into the insertion-ordered list, so removals don't shuffle things around.
 DatabaseObject *GridDatabase::getObjectByIndex(S32 index) const
 {  
-   if(index < 0 || index >= mAllObjects.size())
+   const Vector<DatabaseObject *> *objects = findObjects_ordered();
+
+   if(index < 0 || index >= objects->size())
       return NULL;
    else
-      return mAllObjects[index]; 
+      return objects->get(index); 
 } 
 
 
 void GridDatabase::updateExtents(DatabaseObject *object, const Rect &newExtents)
 {
-   // Does the equivalent of the following, but more efficiently:
-   // removeFromDatabase();    
-   // addToDatabase();
+   // Does the equivalent of removeFromDatabase() followed by addToDatabase(), but lets the index skip
+   // the work when the object stays in the same cells, and doesn't touch mAllObjects
+   mSpatialIndex->update(object, object->getExtent(), newExtents);
 
-   S32 minxold, minyold, maxxold, maxyold;
-   S32 minx, miny, maxx, maxy;
-
-   Rect oldExtents = object->getExtent();
-
-   minxold = S32(oldExtents.min.x) >> BucketWidthBitShift;
-   minyold = S32(oldExtents.min.y) >> BucketWidthBitShift;
-   maxxold = S32(oldExtents.max.x) >> BucketWidthBitShift;
-   maxyold = S32(oldExtents.max.y) >> BucketWidthBitShift;
-
-   minx    = S32(newExtents.min.x) >> BucketWidthBitShift;
-   miny    = S32(newExtents.min.y) >> BucketWidthBitShift;
-   maxx    = S32(newExtents.max.x) >> BucketWidthBitShift;
-   maxy    = S32(newExtents.max.y) >> BucketWidthBitShift;
-
-   // Don't do anything if the buckets haven't changed...
-   if((minxold - minx) | (minyold - miny) | (maxxold - maxx) | (maxyold - maxy))
+   // Objects that move stop counting towards the static extents.  Lots of objects get their extents set
+   // to the same thing over and over, so don't let that count.
+   if(object->mDynamicListIndex == -1 && !(object->getExtent() == newExtents))
    {
-      // They are different... remove and readd to database, but don't touch mAllObjects
-      if(U32(maxx - minx) >= BucketRowCount)        maxx    = minx    + BucketRowCount - 1;
-      if(U32(maxy - miny) >= BucketRowCount)        maxy    = miny    + BucketRowCount - 1;
-      if(U32(maxxold >= minxold) + BucketRowCount)  maxxold = minxold + BucketRowCount - 1;
-      if(U32(maxyold >= minyold) + BucketRowCount)  maxyold = minyold + BucketRowCount - 1;
+      if(mStaticExtentsValid)
+         staticExtentsLosing(object->getExtent());
 
+      addToDynamicList(object);
+   }
+}
 
-      // Don't use x <= maxx, it will endless loop if maxx = S32_MAX and x overflows
-      // Instead, use maxx - x >= 0, it will better handle overflows and avoid endless loop (MIN_S32 - MAX_S32 = +1)
 
-      // Remove from the extents database for current extents...
-      while(object->mBucketList)
-      {
-         DatabaseBucketEntry *b = object->mBucketList;
-         TNLAssert(b->theObject == object, "Object mismatch");
-         TNLAssert(b->prevInBucket->nextInBucket == b, "Broken linked list");
-         if(b->nextInBucket)
-            b->nextInBucket->prevInBucket = b->prevInBucket;
-         b->prevInBucket->nextInBucket = b->nextInBucket;
-         object->mBucketList = b->nextInBucketForThisObject;
-         mChunker->free(b);
-      }
+// Treats everything currently in the database as static, and anything added from now on as dynamic.  We expect
+// what's there when a level finishes loading -- walls, zones, turrets and the like -- to stay put, while ships,
+// projectiles and the like come and go.  This isn't required for correctness, it just keeps the list of objects
+// getExtents() has to visit short.
+void GridDatabase::markAllObjectsStatic()
+{
+   for(S32 i = 0; i < mDynamicObjects.size(); i++)
+      mDynamicObjects[i]->mDynamicListIndex = -1;
 
-      // ...and re-add for the new extent
-      for(S32 x = minx; maxx - x >= 0; x++)
-         for(S32 y = miny; maxy - y >= 0; y++)
-         {
-            DatabaseBucketEntry *be = mChunker->alloc();
-            DatabaseBucketEntryBase *base = &mBuckets[x & BucketMask][y & BucketMask];
-            be->theObject = object;
-            if(base->nextInBucket)
-               base->nextInBucket->prevInBucket = be;
-            be->nextInBucket = base->nextInBucket;
-            be->prevInBucket = base;
-            base->nextInBucket = be;
-            be->nextInBucketForThisObject = object->mBucketList;
-            object->mBucketList = be;
-         }
-   }
+   mDynamicObjects.clear();
+   mStaticExtentsValid = false;
+   mNewObjectsAreDynamic = true;
 }
 
 
@@ -927,6 +1093,12 @@ U8 DatabaseObject::getObjectTypeNumber() const
 }
 
 
+U32 DatabaseObject::getInsertionOrder() const
+{
+   return mInsertionOrder;
+}
+
+
 GridDatabase *DatabaseObject::getDatabase() const
 {
    return mDatabase;
@@ -977,7 +1149,7 @@ DatabaseObject *DatabaseObject::clone() const
 
 // Reusable container for searching gridDatabases
 // Has to be outside of Zap namespace seems to help with debugging showing what's inside fillVector  (debugger forgets to add Zap::)
-Vector<Zap::DatabaseObject *> fillVector;
-Vector<Zap::DatabaseObject *> fillVector2;
+ThreadLocalVector<Zap::DatabaseObject *> fillVector;
+ThreadLocalVector<Zap::DatabaseObject *> fillVector2;
 
 
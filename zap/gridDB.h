@@ -7,9 +7,10 @@
 #define _GRIDDB_H_
 
 #include "GeomObject.h"    // Base class
+#include "SpatialIndex.h"
 
+#include "tnlThread.h"
 #include "tnlTypes.h"
-#include "tnlDataChunker.h"
 #include "tnlVector.h"
 
 #include "Rect.h"
@@ -27,18 +28,51 @@ class BfObject;
 class GridDatabase;
 class EditorObjectDatabase;
 class Level;
-struct DatabaseBucketEntry;
 class DatabaseObject;
+struct QueryTypeFilter;
 
-struct DatabaseBucketEntryBase
-{
-   DatabaseBucketEntry *nextInBucket;
-};
-struct DatabaseBucketEntry : public DatabaseBucketEntryBase
+
+// Scratch state for spatial queries.  A query writes nothing shared except its own slot in each object's visit
+// stamps, so any number of threads can search the same databases at once, each with its own DatabaseQuery, as long
+// as nobody is modifying those databases at the same time.  Query methods that don't take one use a per-thread default.
+class DatabaseQuery
 {
-   DatabaseObject *theObject;
-   DatabaseBucketEntryBase *prevInBucket;
-   DatabaseBucketEntry *nextInBucketForThisObject;
+   friend class GridDatabase;
+
+private:
+   S32 mSlot;                 // Which of DatabaseObject::mLastQueryId we stamp; -1 if all slots are taken
+   U32 mQueryId;              // Stamp for the current query
+
+   Vector<const SpatialCell *> mCells;
+   Vector<DatabaseObject *> mLosCandidates;     // Used by findObjectLOS()
+
+   // Without a slot, we remember what we've found here instead: an open-addressed hash set whose entries only count
+   // if they carry the current mQueryId, so a new query doesn't have to clear it
+   struct VisitedEntry
+   {
+      DatabaseObject *object;
+      U32 queryId;
+   };
+
+   Vector<VisitedEntry> mVisited;
+   S32 mVisitedCount;         // Entries belonging to the current query
+
+   bool markVisited(DatabaseObject *object);    // Returns false if the current query has already found object
+   void growVisited();
+
+   DatabaseQuery(const DatabaseQuery &);              // Not copyable -- we own a slot
+   DatabaseQuery &operator=(const DatabaseQuery &);
+
+public:
+   // Max number of DatabaseQueries that can dedupe using visit stamps at one time.  Every thread that searches gets
+   // one, and shards, robot script workers and level loaders add up, so the rest fall back to their visited set.
+   static const S32 MaxSlots = 16;
+
+   DatabaseQuery();     // Constructor
+   ~DatabaseQuery();    // Destructor
+
+   bool hasSlot() const;                     // False if we fell back to our visited set for want of a slot
+   static DatabaseQuery &getThreadQuery();   // Default query for the calling thread; created on first use, freed when the thread exits
 };
 
 
@@ -51,11 +85,17 @@ class DatabaseObject : public GeomObject
 
 
 private:
-   U32 mLastQueryId;
+   U32 mLastQueryId[DatabaseQuery::MaxSlots];      // Visit stamps, one per DatabaseQuery slot
    Rect mExtent;
    bool mExtentSet;     // A flag to mark whether extent has been set on this object
    GridDatabase *mDatabase;
-   DatabaseBucketEntry *mBucketList;
+
+   // Bookkeeping so GridDatabase can find and remove us in constant time
+   S32 mDatabaseIndex;        // Our slot in mAllObjects
+   S32 mTypeListIndex;        // Our slot in the per-type list
+   U8 mDatabaseTypeNumber;    // Type list we were filed under; our type number can change while we're in the database
+   U32 mInsertionOrder;       // Used to rebuild the database's ordered view
+   S32 mDynamicListIndex;     // Our slot in the database's list of moving objects; -1 if we count as static
 
 protected:
    U8 mObjectTypeNumber;
@@ -90,6 +130,7 @@ public:
    void removeFromDatabase(bool deleteObject);
 
    U8 getObjectTypeNumber() const;
+   U32 getInsertionOrder() const;
 
    virtual bool isDatabasable();    // Can this item actually be inserted into a database?
 
@@ -109,37 +150,46 @@ class GridDatabase
 {
 private:
    U32 mDatabaseId;
-   static U32 mQueryId;
-   static U32 mCountGridDatabase;      // Reference counter for destruction of mChunker
 
-   Vector<DatabaseObject *> mAllObjects;
-   Vector<DatabaseObject *> mGoalZones;
-   Vector<DatabaseObject *> mFlags;
-   Vector<DatabaseObject *> mSpyBugs;
-   Vector<DatabaseObject *> mPolyWalls;
-   Vector<DatabaseObject *> mWallitems;
+   SpatialIndex *mSpatialIndex;        // Owned by us; finds objects by location
 
-   void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
-   void findObjects(Vector<U8> typeNumbers, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins) const;
-   void findObjects(TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect *extents, const IntRect *bins, bool sameQuery = false) const;
+   static const S32 TypeListCount = U8_MAX + 1;
 
-   void fillBins(const Rect &extents, IntRect &bins) const;    // Helper function -- translates extents into bins to search
+   Vector<DatabaseObject *> mAllObjects;                       // Unordered; removal swaps the last object into the hole
+   Vector<DatabaseObject *> mObjectsByType[TypeListCount];     // Unordered, one list per type number
 
-public:
-   enum {
-      BucketRowCount = 16,    // Number of buckets per grid row, and number of rows; should be power of 2
-      BucketMask = BucketRowCount - 1,
-   };
+   U32 mNextInsertionOrder;
+   mutable Vector<DatabaseObject *> mOrderedObjects;     // Objects in insertion order, rebuilt on demand
+   mutable bool mOrderedObjectsValid;
 
-   static ClassChunker<DatabaseBucketEntry> *mChunker;
+   // So getExtents() doesn't have to visit every object, objects are split into static ones, whose combined extents
+   // we cache, and dynamic ones, which we union on demand.  Objects are static until their extents change.
+   Vector<DatabaseObject *> mDynamicObjects;    // Unordered
+   Rect mStaticExtents;                         // Combined extents of static objects; stale if !mStaticExtentsValid
+   bool mStaticExtentsValid;
+   bool mNewObjectsAreDynamic;                  // Set by markAllObjectsStatic() -- anything added later probably moves
 
-   DatabaseBucketEntryBase mBuckets[BucketRowCount][BucketRowCount];
+   void addToTypeList(DatabaseObject *object);
+   void removeFromTypeList(DatabaseObject *object);
 
-   explicit GridDatabase();   // Constructor
-   virtual ~GridDatabase();   // Destructor
+   void addToDynamicList(DatabaseObject *object);
+   void removeFromDynamicList(DatabaseObject *object);
+   void staticExtentsLosing(const Rect &extents);
+   S32 getStaticObjectCount() const;
 
+   void findObjects(DatabaseQuery &query, const QueryTypeFilter &filter, Vector<DatabaseObject *> &fillVector,
+                    const Rect &extents, bool sameQuery) const;
 
-   static const S32 BucketWidthBitShift = 8;    // Width/height of each bucket in pixels, in a form of 2 ^ n, 8 is 256 pixels
+   GridDatabase(const GridDatabase &);               // Not copyable -- we own our index
+   GridDatabase &operator=(const GridDatabase &);
+
+public:
+   explicit GridDatabase(SpatialIndex::IndexType indexType = SpatialIndex::SparseHashGrid);   // Constructor
+   virtual ~GridDatabase();   // Destructor
+
+   SpatialIndex::IndexType getSpatialIndexType() const;
+   void setSpatialIndexType(SpatialIndex::IndexType indexType);
+   void setSpatialIndexExtents(const Rect &worldExtents);      // Resize index to fit level; cheapest when db is empty
 
    DatabaseObject *findObjectLOS(U8 typeNumber, U32 stateIndex, bool format, const Point &rayStart, const Point &rayEnd,
                                  F32 &collisionTime, Point &surfaceNormal) const;
@@ -150,6 +200,11 @@ public:
    DatabaseObject *findObjectLOS(TestFunc testFunc, U32 stateIndex, const Point &rayStart, const Point &rayEnd,
                                  F32 &collisionTime, Point &surfaceNormal) const;
 
+   DatabaseObject *findObjectLOS(DatabaseQuery &query, U8 typeNumber, U32 stateIndex, bool format,
+                                 const Point &rayStart, const Point &rayEnd, F32 &collisionTime, Point &surfaceNormal) const;
+   DatabaseObject *findObjectLOS(DatabaseQuery &query, TestFunc testFunc, U32 stateIndex, bool format,
+                                 const Point &rayStart, const Point &rayEnd, F32 &collisionTime, Point &surfaceNormal) const;
+
    DatabaseObject *findObjectLOS(const Vector<DatabaseObject *> &objList, U32 stateIndex, bool format,
                                  const Point &rayStart, const Point &rayEnd, 
                                  F32 &collisionTime, Point &surfaceNormal) const;
@@ -158,8 +213,9 @@ public:
    void computeSelectionMinMax(Point &min, Point &max);
 
    void findObjects(Vector<DatabaseObject *> &fillVector) const;     // Returns all objects in the database
-   const Vector<DatabaseObject *> *findObjects_fast() const;         // Faster than above, but results can't be modified
-   const Vector<DatabaseObject *> *findObjects_fast(U8 typeNumber) const;   // Currently only works with goalZones, may be expanded in the future
+   const Vector<DatabaseObject *> *findObjects_fast() const;         // Faster than above, but results can't be modified, and are unordered
+   const Vector<DatabaseObject *> *findObjects_fast(U8 typeNumber) const;   // All objects of the specified type, unordered
+   const Vector<DatabaseObject *> *findObjects_ordered() const;      // All objects in the order they were added; for the editor
 
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector) const;
    void findObjects(U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
@@ -170,6 +226,12 @@ public:
    void findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector) const;
    void findObjects(const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
 
+   // Same as above, but using the specified query's scratch space; safe to call from worker threads
+   void findObjects(DatabaseQuery &query, U8 typeNumber, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
+   void findObjects(DatabaseQuery &query, TestFunc testFunc, Vector<DatabaseObject *> &fillVector, const Rect &extents,
+                    bool sameQuery = false) const;
+   void findObjects(DatabaseQuery &query, const Vector<U8> &types, Vector<DatabaseObject *> &fillVector, const Rect &extents) const;
+
    void copyObjects(const GridDatabase *source);
 
    bool testTypes(const Vector<U8> &types, U8 objectType) const;
@@ -180,6 +242,7 @@ public:
    
    Rect getExtents();      // Get the combined extents of every object in the database
    void updateExtents(DatabaseObject *object, const Rect &newExtents);
+   void markAllObjectsStatic();     // Call once a level is loaded; see comments in cpp
 
    void addToDatabase(DatabaseObject *databaseObject);
    void addToDatabase(const Vector<DatabaseObject *> &objects);
@@ -194,16 +257,16 @@ public:
    S32 getObjectCount() const;                          // Return the number of objects currently in the database
    S32 getObjectCount(U8 typeNumber) const;             // Return the number of objects currently in the database of specified type
    bool hasObjectOfType(U8 typeNumber) const;
-   DatabaseObject *getObjectByIndex(S32 index) const;   // Kind of hacky, kind of useful
+   DatabaseObject *getObjectByIndex(S32 index) const;   // Kind of hacky, kind of useful; index is into findObjects_ordered()
 };
 
 
 };
 
 
-// Reusable container for searching gridDatabases
+// Reusable container for searching gridDatabases -- each thread gets its own, so games hosted on other threads can use them too
 // putting it outside of Zap namespace seems to help with visual C++ debugging showing whats inside fillVector  (debugger forgets to add Zap::)
-extern Vector<Zap::DatabaseObject *> fillVector;
-extern Vector<Zap::DatabaseObject *> fillVector2;
+extern ThreadLocalVector<Zap::DatabaseObject *> fillVector;
+extern ThreadLocalVector<Zap::DatabaseObject *> fillVector2;
 
 #endif
@@ -327,15 +327,26 @@ const F32 velocityEpsilon = 0.00001f;
 // Apply mMoveState info to an object to compute it's new position.  Used for ships et. al.
 // isBeingDisplaced is true when the object is being pushed by something else, which will only happen in a collision
 // Remember: stateIndex will be one of 0-ActualState, 1-RenderState, or 2-LastProcessState
-F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector<SafePtr<MoveObject> > displacerList)
+// displacers is the chain of objects pushing on this one, and is only walked when isBeingDisplaced is true.
+F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, const DisplacerChain *displacers)
 {
    U32 tryCount = 0;
    const U32 TRY_COUNT_MAX = 8;
-   Vector<SafePtr<BfObject> > disabledList;
    F32 moveTimeStart = moveTime;
 
-   static Point origPos;   // Reusable container
-   origPos = getPos(stateIndex);
+   // Objects whose collisions we disable while moving; the first few live on the stack, so the usual case never
+   // touches the heap.  Collisions handled by collided() don't count against TRY_COUNT_MAX, so we can't bound this.
+   const S32 DISABLED_STACK_MAX = 8;
+   SafePtr<BfObject> disabledStack[DISABLED_STACK_MAX];
+   S32 disabledCount = 0;
+   Vector<SafePtr<BfObject> > disabledOverflow;
+
+   // Link for objects we displace: everything already pushing on us, plus ourselves
+   DisplacerChain displacerLink;
+   displacerLink.prev = displacers;
+   displacerLink.object = this;
+
+   Point origPos = getPos(stateIndex);
 
    while(moveTime > moveTimeEpsilon && tryCount < TRY_COUNT_MAX)     // moveTimeEpsilon is a very short, but non-zero, bit of time
    {
@@ -346,7 +357,7 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
          break;
 
       F32 collisionTime = moveTime;
-      static Point collisionPoint, newPos;     // Reusable containers
+      Point collisionPoint, newPos;
 
       BfObject *objectHit = findFirstCollision(stateIndex, collisionTime, collisionPoint);
       if(!objectHit)    // No collision (or if isBeingDisplaced is true, we haven't been pushed into another object)
@@ -363,7 +374,10 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
       // Collided is a sort of collision pre-handler; it will return true if the collision was dealt with, false if not
       if(collided(objectHit, stateIndex) || objectHit->collided(this, stateIndex))
       {
-         disabledList.push_back(objectHit);
+         if(disabledCount < DISABLED_STACK_MAX)
+            disabledStack[disabledCount++] = objectHit;
+         else
+            disabledOverflow.push_back(objectHit);
          objectHit->disableCollision();
          tryCount--;   // Don't count as tryCount
       }
@@ -372,16 +386,15 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
          TNLAssert(dynamic_cast<MoveObject *>(objectHit), "Not a MoveObject");
          MoveObject *moveObjectThatWasHit = static_cast<MoveObject *>(objectHit);
 
-         static Point velDelta, posDelta;    // Reusable containers
-         velDelta = moveObjectThatWasHit->getVel(stateIndex) - getVel(stateIndex);
-         posDelta = moveObjectThatWasHit->getPos(stateIndex) - getPos(stateIndex);
+         Point velDelta = moveObjectThatWasHit->getVel(stateIndex) - getVel(stateIndex);
+         Point posDelta = moveObjectThatWasHit->getPos(stateIndex) - getPos(stateIndex);
 
          // Prevent infinite loops with a series of objects trying to displace each other forever
          if(isBeingDisplaced)
          {
             bool hit = false;
-            for(S32 i = 0; i < displacerList.size(); i++)
-               if(moveObjectThatWasHit == displacerList[i])
+            for(const DisplacerChain *link = displacers; link; link = link->prev)
+               if(moveObjectThatWasHit == link->object)
                  hit = true;
             if(hit) break;
          }
@@ -404,13 +417,11 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
             // Note that we could end up with an infinite feedback loop here, if, for some reason, two objects keep trying to displace
             // one another, as this will just recurse deeper and deeper.
 
-            displacerList.push_back(this);
-
             // Only try a limited number of times to avoid dragging the game under the dark waves of infinity
             if(mHitLimit > 0) 
             {
                // Move the displaced object a tiny bit, true -> isBeingDisplaced
-               moveObjectThatWasHit->move(t + displaceEpsilon, stateIndex, true, displacerList); 
+               moveObjectThatWasHit->move(t + displaceEpsilon, stateIndex, true, &displacerLink); 
                mHitLimit--;
             }
          }
@@ -421,9 +432,13 @@ F32 MoveObject::move(F32 moveTime, U32 stateIndex, bool isBeingDisplaced, Vector
       moveTime -= collisionTime;
    }
 
-   for(S32 i = 0; i < disabledList.size(); i++)   // enable any disabled collision
-      if(disabledList[i].isValid())
-         disabledList[i]->enableCollision();
+   for(S32 i = 0; i < disabledCount; i++)         // enable any disabled collision
+      if(disabledStack[i].isValid())
+         disabledStack[i]->enableCollision();
+
+   for(S32 i = 0; i < disabledOverflow.size(); i++)
+      if(disabledOverflow[i].isValid())
+         disabledOverflow[i]->enableCollision();
 
    if(tryCount == TRY_COUNT_MAX && moveTime > moveTimeStart * 0.98f)
       setVel(stateIndex, Point(0,0));  // prevents some overload by not trying to move anymore
@@ -444,9 +459,53 @@ TestFunc MoveObject::collideTypes()
 }
 
 
-static S32 QSORT_CALLBACK sortBarriersFirst(DatabaseObject **a, DatabaseObject **b)
+// Scratch space for findFirstCollision.  Collision handlers can move objects, which can call back into
+// findFirstCollision, so each level of nesting gets its own buffer.  They are never freed; after the first few
+// frames they have grown as large as they need to be and collision checks stop allocating.
+struct CollisionCandidateStack
+{
+   Vector<Vector<DatabaseObject *> *> levels;
+   S32 depth;
+
+   CollisionCandidateStack() { depth = 0; }
+};
+
+static ThreadLocal<CollisionCandidateStack> collisionCandidateStack;    // Games hosted on other threads move things too
+
+// Claims the buffer for the current nesting level for the life of the enclosing scope
+struct CollisionCandidateScope
+{
+   CollisionCandidateStack &stack;
+   Vector<DatabaseObject *> *candidates;
+
+   CollisionCandidateScope() : stack(collisionCandidateStack.get())
+   {
+      if(stack.depth == stack.levels.size())
+         stack.levels.push_back(new Vector<DatabaseObject *>);
+
+      candidates = stack.levels[stack.depth++];
+   }
+
+   ~CollisionCandidateScope() { stack.depth--; }
+};
+
+
+// Barriers first, to prevent picking up a flag (FlagItem::collide) through a Barrier, especially when client does
+// /maxfps 10.  After that, newest objects first, which is the order the old bucket grid gave objects sharing a bucket.
+// When two candidates are hit at the same instant the later one wins, so the order has to be a fixed one, not
+// whatever order the database query happened to return them in.
+static S32 QSORT_CALLBACK collisionCandidateSort(DatabaseObject **a, DatabaseObject **b)
 {
-   return ((*b)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0) - ((*a)->getObjectTypeNumber() == BarrierTypeNumber ? 1 : 0);
+   bool barrierA = (*a)->getObjectTypeNumber() == BarrierTypeNumber;
+   bool barrierB = (*b)->getObjectTypeNumber() == BarrierTypeNumber;
+
+   if(barrierA != barrierB)
+      return barrierA ? -1 : 1;
+
+   U32 orderA = (*a)->getInsertionOrder();
+   U32 orderB = (*b)->getInsertionOrder();
+
+   return orderA > orderB ? -1 : (orderA < orderB ? 1 : 0);
 }
 
 
@@ -458,19 +517,20 @@ BfObject *MoveObject::findFirstCollision(U32 stateIndex, F32 &collisionTime, Poi
    Rect queryRect(getPos(stateIndex), getPos(stateIndex) + delta);
    queryRect.expand(Point(mRadius, mRadius));
 
-   fillVector.clear();
-
-   findObjects(collideTypes(), fillVector, queryRect);   // Free CPU for finding only the ones we care about
+   CollisionCandidateScope scope;
+   Vector<DatabaseObject *> &candidates = *scope.candidates;
 
-   fillVector.sort(sortBarriersFirst);  // Sort to do Barriers::Collide first, to prevent picking up flag (FlagItem::Collide) through Barriers, especially when client does /maxfps 10
+   candidates.clear();
+   findObjects(collideTypes(), candidates, queryRect);   // Free CPU for finding only the ones we care about
+   candidates.sort(collisionCandidateSort);
 
    F32 collisionFraction;
 
    BfObject *collisionObject = NULL;
 
-   for(S32 i = 0; i < fillVector.size(); i++)
+   for(S32 i = 0; i < candidates.size(); i++)
    {
-      BfObject *foundObject = static_cast<BfObject *>(fillVector[i]);
+      BfObject *foundObject = static_cast<BfObject *>(candidates[i]);
 
       if(!foundObject->isCollisionEnabled())
          continue;
@@ -135,7 +135,14 @@ public:
 
    virtual void playCollisionSound(U32 stateIndex, MoveObject *moveObjectThatWasHit, F32 velocity);
 
-   F32 move(F32 time, U32 stateIndex, bool displacing = false, Vector<SafePtr<MoveObject> > = Vector<SafePtr<MoveObject> >());
+   // Objects already pushing on a displaced object, linked through the stack frames of the enclosing move() calls
+   struct DisplacerChain
+   {
+      const DisplacerChain *prev;
+      SafePtr<MoveObject> object;
+   };
+
+   F32 move(F32 time, U32 stateIndex, bool displacing = false, const DisplacerChain *displacers = NULL);
    virtual bool collide(BfObject *otherObject);
 
    // CollideTypes is used to improve speed on findFirstCollision
@@ -237,7 +237,7 @@ void Projectile::idle(BfObject::IdleCallPath path)
          Point endPos = startPos + (mVelocity * .001f) * timeLeft;    // mVelocity in units/sec, timeLeft in ms
 
          // Check for collision along projected route of movement
-         static Vector<BfObject *> disabledList;
+         static ThreadLocalVector<BfObject *> disabledList;
 
          Rect queryRect(startPos, endPos);     // Bounding box of our travels
 
@@ -1558,7 +1558,7 @@ void Seeker::acquireTarget()
    F32 ourAngle = getActualAngle();
 
    // Used for wall detection
-   static Vector<DatabaseObject *> localFillVector;
+   static ThreadLocalVector<DatabaseObject *> localFillVector;
 
    Rect queryRect(getPos(), TargetAcquisitionRadius);
    fillVector.clear();
@@ -164,7 +164,15 @@ const char *Robot::getErrorMessagePrefix() { return "***ROBOT ERROR***"; }
 // Server only
 bool Robot::start()
 {
-   if(!getGame() || !runScript(!getGame()->isTestServer()))   // Load the script, execute the chunk to get it in memory, then run its main() function
+   if(!getGame())
+      return false;
+
+   // With threads available to run them, each robot gets its own VM so its onTick can run alongside the others.
+   // If the VM can't be created, the robot just runs in the shared one.
+   if(EventManager::get()->getScriptThreadCount() > 0 && !hasPrivateLuaState())
+      usePrivateLuaState();
+
+   if(!runScript(!getGame()->isTestServer()))   // Load the script, execute the chunk to get it in memory, then run its main() function
       return false;
 
    // Pass true so that if this bot doesn't have a TickEvent handler, we don't print a message
@@ -865,9 +873,11 @@ S32 Robot::lua_getWaypoint(lua_State *L)
 
       if(!canSeePoint(target, true))           // Possible, if we're just on a boundary, and a protrusion's blocking a ship edge
       {
-         BotNavMeshZone *zone = static_cast<BotNavMeshZone *>(getGame()->getBotZoneDatabase().getObjectByIndex(targetZone));
+         // Zone ids index the pre-cached zone list; the database's ordered view is rebuilt lazily, so other bots'
+         // worker threads could be rebuilding it under us
+         const Vector<BotNavMeshZone *> &zones = static_cast<ServerGame *>(getGame())->getBotZoneList();
 
-         p = zone->getCenter();
+         p = zones[targetZone]->getCenter();
          flightPlan.push_back(p);
       }
       else
@@ -881,20 +891,21 @@ S32 Robot::lua_getWaypoint(lua_State *L)
    flightPlanTo = targetZone;
 
    // check cache for path first
-   pair<S32,S32> pathIndex = pair<S32,S32>(currentZone, targetZone);
-
-   const Vector<BotNavMeshZone *> &zones = static_cast<ServerGame *>(getGame())->getBotZoneList();  // Our pre-cached list of nav zones
+   GameType *gameType = getGame()->getGameType();
 
-   if(getGame()->getGameType()->cachedBotFlightPlans.find(pathIndex) == getGame()->getGameType()->cachedBotFlightPlans.end())
+   if(!gameType->cachedBotFlightPlans.find(currentZone, targetZone, flightPlan))
    {
-      // Not found so calculate flight plan
-      flightPlan = AStar::findPath(&zones, currentZone, targetZone, target);
+      const Vector<BotNavMeshZone *> &zones = static_cast<ServerGame *>(getGame())->getBotZoneList();  // Our pre-cached list of nav zones
+
+      // Not found so calculate flight plan; small meshes have every route worked out already
+      if(gameType->botZoneNextHops.isValid())
+         flightPlan = gameType->botZoneNextHops.findPath(&zones, currentZone, targetZone, target);
+      else
+         flightPlan = AStar::findPath(&zones, currentZone, targetZone, target);
 
       // Add to cache
-      getGame()->getGameType()->cachedBotFlightPlans[pathIndex] = flightPlan;
+      gameType->cachedBotFlightPlans.insert(currentZone, targetZone, flightPlan);
    }
-   else
-      flightPlan = getGame()->getGameType()->cachedBotFlightPlans[pathIndex];
 
    if(flightPlan.size() > 0)
       return returnPoint(L, flightPlan.last());
@@ -1354,7 +1365,7 @@ S32 Robot::lua_findVisibleObjects(lua_State *L)
    queryRect.expand(getGame()->computePlayerVisArea(this));
 
    fillVector.clear();
-   static Vector<U8> types;
+   static ThreadLocalVector<U8> types;
 
    types.clear();
 
@@ -309,7 +309,7 @@ F32 Ship::processMove(U32 stateIndex)
 
    F32 time = mCurrentMove.time * 0.001f;
 
-   static Point requestVel, accel;     // Reusable containers
+   Point requestVel, accel;
 
    // This is what the client requested -- basically requestVel.len() will range from 0 to 1; any higher will be clipped
    requestVel.set(mCurrentMove.x, mCurrentMove.y);
@@ -411,8 +411,7 @@ bool Ship::isOnObject(BfObject *object, U32 stateIndex)
 {
    Point center;
    float radius;
-   static Vector<Point> polyPoints;
-   polyPoints.clear();
+   Vector<Point> polyPoints;
    Rect rect;
 
    // Ships don't have collisionPolys, so this first check is utterly unneeded unless we change that
@@ -591,9 +590,7 @@ void Ship::idle(IdleCallPath path)
          static const F32 ShipVarNormalizeMultiplier = 128;
          static const F32 ShipVarNormalizeFraction = 0.0078125; // 1/ShipVarNormalizeMultiplier
 
-         static Point p;
-         
-         p = getActualPos();
+         Point p = getActualPos();
          p.scaleFloorDiv(ShipVarNormalizeMultiplier, ShipVarNormalizeFraction);
          Parent::setActualPos(p);
 
@@ -758,7 +755,7 @@ void Ship::getZonesShipIsIn(Vector<SafePtr<Zone> > &zoneList)
 }
 
 
-static Vector<DatabaseObject *> foundObjects;      // Reusable container
+static ThreadLocalVector<DatabaseObject *> foundObjects;      // Reusable container, one per thread
 
 void Ship::findRepairTargets()
 {
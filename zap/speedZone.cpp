@@ -359,12 +359,12 @@ void SpeedZone::fillAttributesVectors(Vector<string> &keys, Vector<string> &valu
 #endif
 
 
-static bool ignoreThisCollision = false;
+static ThreadLocal<bool> ignoreThisCollision;    // Starts out false; one per thread, as games on other threads collide too
 
 // Checks collisions with a SpeedZone
 bool SpeedZone::collide(BfObject *hitObject)
 {
-   if(ignoreThisCollision)
+   if(ignoreThisCollision.get())
       return false;
 
    // This is run on both server and client side to reduce lag
@@ -392,7 +392,7 @@ bool SpeedZone::collided(BfObject *hitObject, U32 stateIndex)
    TNLAssert(dynamic_cast<MoveObject *>(hitObject), "Not a MoveObject");
    MoveObject *s = static_cast<MoveObject *>(hitObject);
 
-   static Point start, end, impulse, newVel;      // Reusable containers
+   Point start, end, impulse, newVel;
    start = getVert(0);
    end   = getVert(1);
 
@@ -425,7 +425,7 @@ bool SpeedZone::collided(BfObject *hitObject, U32 stateIndex)
    // within the zone so that their path out will be very predictable.
    if(mSnapLocation)
    {
-      static Point diffpos, thisAngle, newPos, oldPos, oldVel, collisionPoint, p;    // Reusable points
+      Point diffpos, thisAngle, newPos, oldPos, oldVel, collisionPoint, p;
 
       diffpos = s->getPos(stateIndex) - start;
       thisAngle = end - start;
@@ -435,7 +435,7 @@ bool SpeedZone::collided(BfObject *hitObject, U32 stateIndex)
       oldPos = s->getPos(stateIndex);
       oldVel = s->getVel(stateIndex);
 
-      ignoreThisCollision = true;  // Seem to need it to ignore collide to SpeedZone during a findFirstCollision
+      ignoreThisCollision.get() = true;  // Seem to need it to ignore collide to SpeedZone during a findFirstCollision
       s->setVel(stateIndex, newPos - oldPos);
 
       F32 collisionTime = 1;
@@ -444,7 +444,7 @@ bool SpeedZone::collided(BfObject *hitObject, U32 stateIndex)
       p = s->getPos(stateIndex) + s->getVel(stateIndex) * collisionTime;    // x = x + vt
       s->setPos(stateIndex, p);
 
-      ignoreThisCollision = false;
+      ignoreThisCollision.get() = false;
 
       if(collisionTime != 1)     // Don't allow using speed zone when could not line up due to going into wall?
       {
@@ -508,6 +508,13 @@ U32 SpeedZone::packUpdate(GhostConnection *connection, U32 updateMask, BitStream
 }
 
 
+// Nothing in our updates depends on which client they go to, so all clients can share them
+S32 SpeedZone::getUpdateCacheKey(GhostConnection *connection)
+{
+   return 0;
+}
+
+
 void SpeedZone::unpackUpdate(GhostConnection *connection, BitStream *stream)
 {
    if(stream->readFlag())     // InitMask
@@ -74,6 +74,7 @@ public:
    void idle(BfObject::IdleCallPath path);
    U32 packUpdate(GhostConnection *connection, U32 updateMask, BitStream *stream);
    void unpackUpdate(GhostConnection *connection, BitStream *stream);
+   S32 getUpdateCacheKey(GhostConnection *connection);
 
    ///// Editor methods 
    const Color &getEditorRenderColor() const;
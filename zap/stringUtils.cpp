@@ -546,6 +546,19 @@ bool fileExists(const string &path)
 }
 
 
+// Returns false if file doesn't exist or is a folder
+bool getFileStamp(const string &path, S64 &modTime, S64 &fileSize)
+{
+   struct stat st;
+   if(stat(path.c_str(), &st) != 0 || (st.st_mode & S_IFDIR))
+      return false;
+
+   modTime  = (S64)st.st_mtime;
+   fileSize = (S64)st.st_size;
+   return true;
+}
+
+
 // Checks if specified folder exists; creates it if not
 bool makeSureFolderExists(const string &folder)
 {
@@ -664,6 +677,18 @@ bool copyFileToDir(const string &sourceFilename, const string &destDir)
 }
 
 
+// Renames sourceFilename to destFilename in one step, replacing destFilename if it's already there
+bool replaceFile(const string &sourceFilename, const string &destFilename)
+{
+#ifdef TNL_OS_WIN32
+   // Windows' rename() won't replace an existing file
+   return MoveFileExA(sourceFilename.c_str(), destFilename.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+   return rename(sourceFilename.c_str(), destFilename.c_str()) == 0;
+#endif
+}
+
+
 // Join a directory and filename strings in a platform-specific way
 string joindir(const string &path, const string &filename)
 {
@@ -874,6 +899,27 @@ bool writeFile(const string &path, const string &contents, bool append)
 }
 
 
+// Writes contents to a temporary file next to path, then renames it over path
+bool writeFileAtomically(const string &path, const string &contents)
+{
+   string tempPath = path + ".tmp";
+
+   if(!writeFile(tempPath, contents))
+   {
+      remove(tempPath.c_str());
+      return false;
+   }
+
+   if(!replaceFile(tempPath, path))
+   {
+      remove(tempPath.c_str());
+      return false;
+   }
+
+   return true;
+}
+
+
 // Pass in a path, returns contents of file; if file does not exist, contents is set to an empty string
 // Function returns true if file exists, false if not
 bool readFile(const string &path, string &contents)
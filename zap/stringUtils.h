@@ -93,11 +93,13 @@ bool caseInsensitiveStringCompare(const string &str1, const string &str2);
 // File utils
 string getFileSeparator();
 bool fileExists(const string &path);               // Does file exist?
+bool getFileStamp(const string &path, S64 &modTime, S64 &fileSize);   // Last modification time and size of file
 bool makeSureFolderExists(const string &dir);      // Like the man said: Make sure folder exists
 bool getFilesFromFolder(const string &dir, Vector<string> &files, const string extensions[] = 0, S32 extensionCount = 0);
 bool safeFilename(const char *str);
 bool copyFile(const string &sourceFilename, const string &destFilename);
 bool copyFileToDir(const string &sourceFilename, const string &destDir);
+bool replaceFile(const string &sourceFilename, const string &destFilename);     // Rename, replacing dest if it exists
 
 
 // Different variations on joining file and folder names
@@ -132,6 +134,7 @@ string chopComment(const string &line);
 
 
 bool writeFile(const string &path, const string &contents, bool append = false);
+bool writeFileAtomically(const string &path, const string &contents);     // Readers see the old file or the new one, never a mix
 bool readFile(const string &path, string &contents);
 
 
@@ -92,7 +92,7 @@ void ZoneControlGameType::shipTouchZone(Ship *s, GoalZone *z)
    if(z->getTeam() == s->getTeam() || !s->isCarryingItem(FlagTypeNumber))
       return;
 
-   static Vector<StringTableEntry> e;
+   static ThreadLocalVector<StringTableEntry> e;
    e.clear();
 
    static const S32 MAX_ZONES_TO_NOTIFY = 50;   // Don't display messages when too many zones -- the flood of messages will get annoying!